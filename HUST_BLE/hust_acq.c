@@ -0,0 +1,163 @@
+#include "hust_acq.h"
+#include "nrfx_saadc.h"
+#include "nrfx_timer.h"
+#include "nrfx_ppi.h"
+#include "app_error.h"
+
+static const nrfx_timer_t acq_timer = NRFX_TIMER_INSTANCE(1);
+static nrf_ppi_channel_t acq_ppi_channel;
+static nrf_saadc_value_t acq_buffer[2][HUST_ACQ_BUFFER_FRAMES * HUST_ACQ_MAX_CHANNELS];
+static uint8_t acq_n_channels;
+static uint32_t acq_frame_us;                   // thoi gian chuyen doi 1 frame voi tACQ da chon
+static uint64_t acq_next_index;
+static hust_acq_handler_t acq_handler;
+
+// TIMER1 chi dung de tao su kien COMPARE0 cho PPI, khong bat ngat
+static void acq_timer_handler(nrf_timer_event_t event_type, void * p_context)
+{
+    (void)event_type;
+    (void)p_context;
+}
+
+static void acq_saadc_handler(nrfx_saadc_evt_t const * p_event)
+{
+    if(p_event->type == NRFX_SAADC_EVT_DONE)
+    {
+        uint16_t n_frames = p_event->data.done.size / acq_n_channels;
+        uint64_t first_index = acq_next_index;
+        acq_next_index += n_frames;
+
+        // tra buffer lai cho EasyDMA truoc, buffer con lai dang duoc ghi
+        ret_code_t err_code = nrfx_saadc_buffer_convert(p_event->data.done.p_buffer, p_event->data.done.size);
+        APP_ERROR_CHECK(err_code);
+        acq_handler(p_event->data.done.p_buffer, n_frames, first_index);
+    }
+}
+
+// tACQ giam dan, chon gia tri dau tien vua chu ky lay mau
+static const struct
+{
+    nrf_saadc_acqtime_t acq_time;
+    uint8_t us;
+} acq_time_table[] =
+{
+    {NRF_SAADC_ACQTIME_10US, 10}, {NRF_SAADC_ACQTIME_5US, 5}, {NRF_SAADC_ACQTIME_3US, 3}
+};
+
+ret_code_t hust_acq_init(uint32_t rate, const nrf_saadc_input_t * inputs, uint8_t n_channels,
+                         nrf_saadc_oversample_t oversample, hust_acq_handler_t handler)
+{
+    ret_code_t err_code;
+    int acq = -1;
+
+    if(rate == 0 || HUST_ACQ_TIMER_HZ % rate != 0 || n_channels == 0 || n_channels > HUST_ACQ_MAX_CHANNELS)
+    {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+    // thoi gian chuyen doi 1 frame phai nho hon chu ky lay mau (de 10% cho khoi dong SAADC)
+    for(unsigned i = 0; i < sizeof(acq_time_table) / sizeof(acq_time_table[0]); i++)
+    {
+        uint32_t frame_us = (uint32_t)n_channels * (1u << oversample) * (acq_time_table[i].us + HUST_ACQ_TCONV_US);
+        if(frame_us * 10 < 9 * (1000000 / rate))
+        {
+            acq = (int)i;
+            break;
+        }
+    }
+    if(acq < 0)
+    {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+    acq_n_channels = n_channels;
+    acq_frame_us = (uint32_t)n_channels * (1u << oversample) * (acq_time_table[acq].us + HUST_ACQ_TCONV_US);
+    acq_handler = handler;
+
+    // SAADC: scan n_channels input, 12 bit, moi task SAMPLE chuyen doi tat ca channel 1 lan
+    nrfx_saadc_config_t saadc_config = NRFX_SAADC_DEFAULT_CONFIG;
+    saadc_config.resolution = NRF_SAADC_RESOLUTION_12BIT;
+    saadc_config.oversample = oversample;
+    err_code = nrfx_saadc_init(&saadc_config, acq_saadc_handler);
+    if(err_code != NRF_SUCCESS)
+    {
+        return err_code;
+    }
+    for(uint8_t ch = 0; ch < n_channels; ch++)
+    {
+        nrf_saadc_channel_config_t channel_config = NRFX_SAADC_DEFAULT_CHANNEL_CONFIG_SE(inputs[ch]);
+        channel_config.acq_time = acq_time_table[acq].acq_time;
+        // oversampling voi nhieu channel: BURST de 2^k lan chuyen doi lien tiep tren cung channel
+        channel_config.burst = oversample != NRF_SAADC_OVERSAMPLE_DISABLED ? NRF_SAADC_BURST_ENABLED : NRF_SAADC_BURST_DISABLED;
+        err_code = nrfx_saadc_channel_init(ch, &channel_config);
+        if(err_code != NRF_SUCCESS)
+        {
+            return err_code;
+        }
+    }
+
+    // TIMER1: COMPARE0 moi 1/rate giay, tu xoa ve 0 (shortcut) nen chu ky chinh xac theo HFCLK
+    nrfx_timer_config_t timer_config = NRFX_TIMER_DEFAULT_CONFIG;
+    timer_config.frequency = NRF_TIMER_FREQ_16MHz;
+    timer_config.bit_width = NRF_TIMER_BIT_WIDTH_32;
+    err_code = nrfx_timer_init(&acq_timer, &timer_config, acq_timer_handler);
+    if(err_code != NRF_SUCCESS)
+    {
+        return err_code;
+    }
+    nrfx_timer_extended_compare(&acq_timer, NRF_TIMER_CC_CHANNEL0, HUST_ACQ_TIMER_HZ / rate,
+                                NRF_TIMER_SHORT_COMPARE0_CLEAR_MASK, false);
+
+    // PPI: TIMER1 COMPARE0 -> SAADC SAMPLE
+    err_code = nrfx_ppi_channel_alloc(&acq_ppi_channel);
+    if(err_code != NRF_SUCCESS)
+    {
+        return err_code;
+    }
+    return nrfx_ppi_channel_assign(acq_ppi_channel,
+                                   nrfx_timer_compare_event_address_get(&acq_timer, NRF_TIMER_CC_CHANNEL0),
+                                   nrfx_saadc_sample_task_get());
+}
+
+ret_code_t hust_acq_start(void)
+{
+    ret_code_t err_code;
+    uint16_t size = HUST_ACQ_BUFFER_FRAMES * acq_n_channels;
+
+    acq_next_index = 0;
+    // 2 buffer: nrfx_saadc tu chuyen sang buffer thu 2 khi buffer dau day
+    err_code = nrfx_saadc_buffer_convert(acq_buffer[0], size);
+    if(err_code != NRF_SUCCESS)
+    {
+        return err_code;
+    }
+    err_code = nrfx_saadc_buffer_convert(acq_buffer[1], size);
+    if(err_code != NRF_SUCCESS)
+    {
+        return err_code;
+    }
+    err_code = nrfx_ppi_channel_enable(acq_ppi_channel);
+    if(err_code != NRF_SUCCESS)
+    {
+        return err_code;
+    }
+    nrfx_timer_enable(&acq_timer);
+    return NRF_SUCCESS;
+}
+
+void hust_acq_stop(void)
+{
+    nrfx_timer_disable(&acq_timer);
+    (void)nrfx_ppi_channel_disable(acq_ppi_channel);
+    nrfx_saadc_abort();
+}
+
+ret_code_t hust_acq_set_rate(uint32_t rate)
+{
+    if(rate == 0 || HUST_ACQ_TIMER_HZ % rate != 0 || acq_frame_us * 10 >= 9 * (1000000 / rate))
+    {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+    nrfx_timer_extended_compare(&acq_timer, NRF_TIMER_CC_CHANNEL0, HUST_ACQ_TIMER_HZ / rate,
+                                NRF_TIMER_SHORT_COMPARE0_CLEAR_MASK, false);
+    nrfx_timer_clear(&acq_timer);
+    return NRF_SUCCESS;
+}
@@ -0,0 +1,35 @@
+#ifndef HUST_ACQ_H__
+#define HUST_ACQ_H__
+
+#include <stdint.h>
+
+#include "sdk_errors.h"
+#include "nrf_saadc.h"
+
+// lay mau theo phan cung: TIMER1 COMPARE0 --PPI--> SAADC SAMPLE, EasyDMA ghi vao 2 buffer luan phien
+// CPU chi bi ngat 1 lan / buffer (HUST_ACQ_BUFFER_FRAMES frame), khong ngat theo tung sample
+
+#define HUST_ACQ_BUFFER_FRAMES      32          // so frame / buffer DMA = so sample / lan ngat
+#define HUST_ACQ_MAX_CHANNELS       8           // so input SAADC toi da (AIN0..AIN7)
+#define HUST_ACQ_TIMER_HZ           16000000    // TIMER1 chay 16 MHz
+#define HUST_ACQ_TCONV_US           2           // thoi gian chuyen doi SAADC / mau, sau thoi gian lay mau (tACQ)
+
+// goi trong ngat SAADC khi 1 buffer day: n_frames frame interleaved [frame][channel],
+// first_index = chi so sample cua frame dau tien (dem tu luc start)
+typedef void (*hust_acq_handler_t)(const nrf_saadc_value_t * buffer, uint16_t n_frames, uint64_t first_index);
+
+// rate: tan so lay mau (16 MHz / rate phai la so nguyen), inputs: AIN cua tung channel
+// oversample: 2^k lan chuyen doi / channel / frame, lay trung binh trong SAADC (BURST tung channel nen
+// dung duoc voi scan mode), giam nhieu ~ sqrt(2^k). tACQ lon nhat (<= 10 us) sao cho
+// n_channels * 2^k * (tACQ + tCONV) vua 1 chu ky lay mau, NRF_ERROR_INVALID_PARAM neu khong vua
+ret_code_t hust_acq_init(uint32_t rate, const nrf_saadc_input_t * inputs, uint8_t n_channels,
+                         nrf_saadc_oversample_t oversample, hust_acq_handler_t handler);
+
+ret_code_t hust_acq_start(void);
+void hust_acq_stop(void);
+
+// doi tan so lay mau khi da stop, giu input/oversample/tACQ da cau hinh luc init
+// NRF_ERROR_INVALID_PARAM neu 16 MHz / rate khong nguyen hoac frame khong vua chu ky moi
+ret_code_t hust_acq_set_rate(uint32_t rate);
+
+#endif // HUST_ACQ_H__
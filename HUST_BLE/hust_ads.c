@@ -0,0 +1,256 @@
+#include <string.h>
+
+#include "hust_ads.h"
+
+// CONFIG1.DR theo rate (SPS), ADS1298 o che do high resolution
+static const uint32_t ads1298_rate[] = {32000, 16000, 8000, 4000, 2000, 1000, 500};
+static const uint32_t ads1299_rate[] = {16000, 8000, 4000, 2000, 1000, 500, 250};
+// CHnSET.GAIN theo ma 0..6
+static const uint8_t ads1298_gain[] = {6, 1, 2, 3, 4, 8, 12};
+static const uint8_t ads1299_gain[] = {1, 2, 4, 6, 8, 12, 24};
+
+int hust_ads_rate_code(hust_ads_device_t device, uint32_t rate)
+{
+    const uint32_t * table = device == HUST_ADS1298 ? ads1298_rate : ads1299_rate;
+    if(device == HUST_ADS_UNKNOWN)
+    {
+        return -1;
+    }
+    for(int i = 0; i < 7; i++)
+    {
+        if(table[i] == rate)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+int hust_ads_gain_code(hust_ads_device_t device, uint8_t gain)
+{
+    const uint8_t * table = device == HUST_ADS1298 ? ads1298_gain : ads1299_gain;
+    if(device == HUST_ADS_UNKNOWN)
+    {
+        return -1;
+    }
+    for(int i = 0; i < 7; i++)
+    {
+        if(table[i] == gain)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+int hust_ads_decode_id(uint8_t id, hust_ads_device_t * device, uint8_t * n_channels)
+{
+    if((id & 0xF0) == 0x30 && (id & 0x0C) == 0x0C && (id & 0x03) != 0x03)
+    {
+        // ADS1299: 0x3C / 0x3D / 0x3E = 4 / 6 / 8 channel
+        *device = HUST_ADS1299;
+        *n_channels = 4 + 2 * (id & 0x03);
+        return 0;
+    }
+    if(((id & 0xE0) == 0x80 || (id & 0xE0) == 0xC0) && (id & 0x18) == 0x10 && (id & 0x07) <= 2)
+    {
+        // ADS129x / ADS129xR: 0x90..0x92 / 0xD0..0xD2 = 4 / 6 / 8 channel
+        *device = HUST_ADS1298;
+        *n_channels = 4 + 2 * (id & 0x07);
+        return 0;
+    }
+    *device = HUST_ADS_UNKNOWN;
+    *n_channels = 0;
+    return -1;
+}
+
+int hust_ads_command(hust_ads_t * ads, uint8_t command)
+{
+    int err = ads->io.xfer(ads->io.p_context, &command, 1, NULL, 0);
+    ads->io.delay_us(ads->io.p_context, 4);     // 4 tCLK giua cac lenh (2.048 MHz)
+    return err;
+}
+
+int hust_ads_reg_read(hust_ads_t * ads, uint8_t addr, uint8_t * data, uint8_t n)
+{
+    uint8_t tx[2] = {(uint8_t)(HUST_ADS_CMD_RREG | addr), (uint8_t)(n - 1)};
+    uint8_t rx[2 + HUST_ADS_REG_COUNT];
+    if(n == 0 || addr + n > HUST_ADS_REG_COUNT)
+    {
+        return -1;
+    }
+    if(ads->io.xfer(ads->io.p_context, tx, 2, rx, 2 + n) != 0)
+    {
+        return -1;
+    }
+    memcpy(data, rx + 2, n);
+    return 0;
+}
+
+int hust_ads_reg_write(hust_ads_t * ads, uint8_t addr, const uint8_t * data, uint8_t n)
+{
+    uint8_t tx[2 + HUST_ADS_REG_COUNT];
+    if(n == 0 || addr + n > HUST_ADS_REG_COUNT)
+    {
+        return -1;
+    }
+    tx[0] = (uint8_t)(HUST_ADS_CMD_WREG | addr);
+    tx[1] = (uint8_t)(n - 1);
+    memcpy(tx + 2, data, n);
+    return ads->io.xfer(ads->io.p_context, tx, 2 + n, NULL, 0);
+}
+
+int hust_ads_init(hust_ads_t * ads, const hust_ads_io_t * io, uint8_t n_devices, uint32_t rate, uint8_t gain)
+{
+    uint8_t reg[HUST_ADS_MAX_CHANNELS];
+
+    if(n_devices == 0 || n_devices > HUST_ADS_MAX_DEVICES)
+    {
+        return -1;
+    }
+    ads->io = *io;
+    ads->rate = rate;
+    ads->n_devices = n_devices;
+
+    // reset cung: RESET thap >= 2 tCLK, cho 18 tCLK; START thap de tu dieu khien chuyen doi
+    io->set_pin(io->p_context, HUST_ADS_PIN_START, false);
+    io->set_pin(io->p_context, HUST_ADS_PIN_CS, false);
+    io->set_pin(io->p_context, HUST_ADS_PIN_RESET, false);
+    io->delay_us(io->p_context, 10);
+    io->set_pin(io->p_context, HUST_ADS_PIN_RESET, true);
+    io->delay_us(io->p_context, 20);
+
+    // sau reset chip o RDATAC, phai SDATAC moi doc/ghi thanh ghi duoc
+    if(hust_ads_command(ads, HUST_ADS_CMD_SDATAC) != 0
+       || hust_ads_reg_read(ads, HUST_ADS_REG_ID, &ads->id, 1) != 0
+       || hust_ads_decode_id(ads->id, &ads->device, &ads->chip_channels) != 0)
+    {
+        return -1;
+    }
+    ads->n_channels = n_devices * ads->chip_channels;
+    ads->chip_frame_size = HUST_ADS_FRAME_SIZE(ads->chip_channels);
+    ads->frame_size = n_devices * ads->chip_frame_size;
+
+    int rate_code = hust_ads_rate_code(ads->device, rate);
+    int gain_code = hust_ads_gain_code(ads->device, gain);
+    if(rate_code < 0 || gain_code < 0)
+    {
+        return -1;
+    }
+
+    // CONFIG3: bat buffer tham chieu noi + RLD/BIAS, cho tham chieu on dinh
+    reg[0] = ads->device == HUST_ADS1299 ? 0xEC : 0xCC;
+    if(hust_ads_reg_write(ads, HUST_ADS_REG_CONFIG3, reg, 1) != 0)
+    {
+        return -1;
+    }
+    io->delay_us(io->p_context, 150000);
+
+    // CONFIG1: DR (ADS1298: HR = 1), DAISY_EN = 0 (che do daisy, dung ca khi chi 1 chip), CONFIG2: tat test signal
+    reg[0] = (uint8_t)((ads->device == HUST_ADS1299 ? 0x90 : 0x80) | rate_code);
+    reg[1] = ads->device == HUST_ADS1299 ? 0xC0 : 0x00;
+    if(hust_ads_reg_write(ads, HUST_ADS_REG_CONFIG1, reg, 2) != 0)
+    {
+        return -1;
+    }
+
+    // CHnSET: input binh thuong, cung gain cho moi channel (WREG ghi dong thoi moi chip trong chuoi)
+    for(int ch = 0; ch < ads->chip_channels; ch++)
+    {
+        reg[ch] = (uint8_t)(gain_code << 4);
+    }
+    if(hust_ads_reg_write(ads, HUST_ADS_REG_CH1SET, reg, ads->chip_channels) != 0)
+    {
+        return -1;
+    }
+
+    // doc lai CONFIG1 de kiem tra bus SPI
+    uint8_t config1;
+    if(hust_ads_reg_read(ads, HUST_ADS_REG_CONFIG1, &config1, 1) != 0 || (config1 & 0x07) != rate_code)
+    {
+        return -1;
+    }
+    return hust_ads_command(ads, HUST_ADS_CMD_RDATAC);
+}
+
+int hust_ads_set_rate(hust_ads_t * ads, uint32_t rate)
+{
+    uint8_t config1;
+    int rate_code = hust_ads_rate_code(ads->device, rate);
+    if(rate_code < 0)
+    {
+        return -1;
+    }
+    // giu HR / DAISY_EN / CLK_EN, chi doi DR
+    if(hust_ads_command(ads, HUST_ADS_CMD_SDATAC) != 0
+       || hust_ads_reg_read(ads, HUST_ADS_REG_CONFIG1, &config1, 1) != 0)
+    {
+        return -1;
+    }
+    config1 = (uint8_t)((config1 & ~0x07) | rate_code);
+    if(hust_ads_reg_write(ads, HUST_ADS_REG_CONFIG1, &config1, 1) != 0
+       || hust_ads_reg_read(ads, HUST_ADS_REG_CONFIG1, &config1, 1) != 0 || (config1 & 0x07) != rate_code)
+    {
+        return -1;
+    }
+    ads->rate = rate;
+    return hust_ads_command(ads, HUST_ADS_CMD_RDATAC);
+}
+
+void hust_ads_start(hust_ads_t * ads)
+{
+    ads->io.set_pin(ads->io.p_context, HUST_ADS_PIN_START, true);
+}
+
+void hust_ads_stop(hust_ads_t * ads)
+{
+    ads->io.set_pin(ads->io.p_context, HUST_ADS_PIN_START, false);
+}
+
+int hust_ads_frame_to_ecg(const uint8_t * frame, ecg_data_t * ecg_data, uint32_t * status)
+{
+    *status = ((uint32_t)frame[0] << 16) | ((uint32_t)frame[1] << 8) | frame[2];
+    if((frame[0] & 0xF0) != HUST_ADS_STATUS_HEADER)
+    {
+        return -1;
+    }
+    // channel ADS va ecg_sample_data_t cung la 24 bit big-endian: chep thang
+    memcpy(ecg_data, frame + HUST_ADS_STATUS_SIZE, ECG_CHANNEL * HUST_ADS_SAMPLE_SIZE);
+    return 0;
+}
+
+static inline int32_t ads_sample(const uint8_t * p)
+{
+    int32_t value = ((int32_t)p[0] << 16) | ((int32_t)p[1] << 8) | p[2];
+    return (value ^ 0x800000) - 0x800000;
+}
+
+int32_t hust_ads_channel(const hust_ads_t * ads, const uint8_t * frame, int ch)
+{
+    int chip = ch / ads->chip_channels;
+    int chip_ch = ch - chip * ads->chip_channels;
+    return ads_sample(frame + chip * ads->chip_frame_size + HUST_ADS_STATUS_SIZE + HUST_ADS_SAMPLE_SIZE * chip_ch);
+}
+
+int hust_ads_demux(const hust_ads_t * ads, const uint8_t * frames, int n_frames, int32_t * out)
+{
+    int bad = 0;
+    for(int i = 0; i < n_frames; i++)
+    {
+        uint8_t header = HUST_ADS_STATUS_HEADER;
+        for(int chip = 0; chip < ads->n_devices; chip++)
+        {
+            const uint8_t * p = frames + chip * ads->chip_frame_size;
+            header &= (uint8_t)((p[0] & 0xF0) == HUST_ADS_STATUS_HEADER ? 0xFF : 0x00);
+            p += HUST_ADS_STATUS_SIZE;
+            for(int ch = 0; ch < ads->chip_channels; ch++)
+            {
+                *out++ = ads_sample(p);
+                p += HUST_ADS_SAMPLE_SIZE;
+            }
+        }
+        bad += header != HUST_ADS_STATUS_HEADER;
+        frames += ads->frame_size;
+    }
+    return bad;
+}
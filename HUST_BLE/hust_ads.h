@@ -0,0 +1,127 @@
+#ifndef HUST_ADS_H__
+#define HUST_ADS_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "hust_ble.h"
+
+/*
+ * Driver AFE TI ADS1298 / ADS1299 (24 bit, 4..8 channel), phan doc lap phan cung.
+ * Truy cap SPI/chan dieu khien qua hust_ads_io_t de chay duoc tren nRF (hust_ads_nrf.c)
+ * va tren host voi SPI gia lap (HUST_HOST/hust_ads_mock.c).
+ *
+ * Frame RDATAC: status 3 byte (1100 + LOFF_STATP + LOFF_STATN + GPIO) + 3 byte / channel,
+ * moi channel la so bu 2 big-endian, trung dinh dang voi ecg_sample_data_t.
+ *
+ * Daisy chain (ADS1299 x n, chung CS/SCLK/DIN/START, DOUT chip k -> DAISY_IN chip k-1): lenh va
+ * WREG di toi tat ca chip, RREG chi doc chip 1. 1 lan doc RDATAC tra ve frame cua chip 1, roi
+ * chip 2, ... (moi chip co status rieng), channel duoc danh so lien tiep 0..8n-1.
+ */
+
+#define HUST_ADS_MAX_CHANNELS       8           // channel / chip
+#ifndef HUST_ADS_MAX_DEVICES
+#define HUST_ADS_MAX_DEVICES        4           // so chip toi da trong daisy chain (32 channel), buffer DMA hust_ads_nrf ~7 KB
+#endif
+#define HUST_ADS_STATUS_SIZE        3
+#define HUST_ADS_SAMPLE_SIZE        3
+#define HUST_ADS_FRAME_SIZE(n_ch)   (HUST_ADS_STATUS_SIZE + HUST_ADS_SAMPLE_SIZE * (n_ch))
+#define HUST_ADS_MAX_FRAME_SIZE     (HUST_ADS_MAX_DEVICES * HUST_ADS_FRAME_SIZE(HUST_ADS_MAX_CHANNELS))
+#define HUST_ADS_MAX_TOTAL_CHANNELS (HUST_ADS_MAX_DEVICES * HUST_ADS_MAX_CHANNELS)
+
+// lenh SPI
+#define HUST_ADS_CMD_WAKEUP         0x02
+#define HUST_ADS_CMD_STANDBY        0x04
+#define HUST_ADS_CMD_RESET          0x06
+#define HUST_ADS_CMD_START          0x08
+#define HUST_ADS_CMD_STOP           0x0A
+#define HUST_ADS_CMD_RDATAC         0x10
+#define HUST_ADS_CMD_SDATAC         0x11
+#define HUST_ADS_CMD_RDATA          0x12
+#define HUST_ADS_CMD_RREG           0x20
+#define HUST_ADS_CMD_WREG           0x40
+
+// thanh ghi chung cua ADS1298 va ADS1299
+#define HUST_ADS_REG_ID             0x00
+#define HUST_ADS_REG_CONFIG1        0x01
+#define HUST_ADS_REG_CONFIG2        0x02
+#define HUST_ADS_REG_CONFIG3        0x03
+#define HUST_ADS_REG_LOFF           0x04
+#define HUST_ADS_REG_CH1SET         0x05
+#define HUST_ADS_REG_COUNT          0x1A
+
+#define HUST_ADS_CHSET_PD           0x80    // tat channel
+#define HUST_ADS_STATUS_HEADER      0xC0    // 4 bit cao cua byte status dau tien = 1100
+
+typedef enum
+{
+    HUST_ADS_UNKNOWN = 0,
+    HUST_ADS1298,                           // ADS1294/6/8(R), 500 SPS .. 32 kSPS (high resolution)
+    HUST_ADS1299                            // ADS1299(-4/-6), 250 SPS .. 16 kSPS
+} hust_ads_device_t;
+
+typedef enum
+{
+    HUST_ADS_PIN_CS = 0,
+    HUST_ADS_PIN_START,
+    HUST_ADS_PIN_RESET,                     // active low
+} hust_ads_pin_t;
+
+typedef struct
+{
+    // truyen SPI (CS da duoc giu thap): gui tx_len byte, nhan rx_len byte dong thoi (phan thieu cua tx la 0x00)
+    int (*xfer)(void * p_context, const uint8_t * tx, uint16_t tx_len, uint8_t * rx, uint16_t rx_len);
+    void (*set_pin)(void * p_context, hust_ads_pin_t pin, bool level);
+    void (*delay_us)(void * p_context, uint32_t us);
+    void * p_context;
+} hust_ads_io_t;
+
+typedef struct
+{
+    hust_ads_io_t io;
+    hust_ads_device_t device;
+    uint8_t id;
+    uint8_t n_devices;                      // so chip trong daisy chain
+    uint8_t chip_channels;                  // so channel cua 1 chip
+    uint8_t n_channels;                     // tong so channel = n_devices * chip_channels
+    uint8_t chip_frame_size;                // byte / frame cua 1 chip
+    uint16_t frame_size;                    // byte / frame RDATAC ca chuoi
+    uint32_t rate;
+} hust_ads_t;
+
+// reset, doc ID, cau hinh rate (SPS), gain (1, 2, 4, 6, 8, 12, 24 tuy chip), bat tham chieu noi
+// va vao che do RDATAC (chua START). n_devices: so chip trong daisy chain (1 = khong daisy),
+// khong doc duoc tu chip, kiem tra sau khi START bang hust_ads_demux (status tung chip)
+// tra ve 0 neu thanh cong, -1 neu ID/rate/gain/n_devices khong hop le
+int hust_ads_init(hust_ads_t * ads, const hust_ads_io_t * io, uint8_t n_devices, uint32_t rate, uint8_t gain);
+
+int hust_ads_reg_read(hust_ads_t * ads, uint8_t addr, uint8_t * data, uint8_t n);
+int hust_ads_reg_write(hust_ads_t * ads, uint8_t addr, const uint8_t * data, uint8_t n);
+int hust_ads_command(hust_ads_t * ads, uint8_t command);
+
+// doi rate (SPS) khi da STOP: SDATAC, ghi CONFIG1.DR tren ca chuoi, doc lai kiem tra, RDATAC
+// tra ve -1 neu chip khong ho tro rate hoac bus SPI loi
+int hust_ads_set_rate(hust_ads_t * ads, uint32_t rate);
+
+// START len cao: bat dau chuyen doi, DRDY xuong thap moi frame
+void hust_ads_start(hust_ads_t * ads);
+void hust_ads_stop(hust_ads_t * ads);
+
+// ma CONFIG1.DR / CHnSET.GAIN cho chip, -1 neu khong ho tro
+int hust_ads_rate_code(hust_ads_device_t device, uint32_t rate);
+int hust_ads_gain_code(hust_ads_device_t device, uint8_t gain);
+
+// giai ma ID -> loai chip va so channel, tra ve 0 neu nhan ra
+int hust_ads_decode_id(uint8_t id, hust_ads_device_t * device, uint8_t * n_channels);
+
+// tach 1 frame RDATAC: ECG_CHANNEL channel dau tien (chip 1) -> ecg_data, tra ve -1 neu header status sai
+int hust_ads_frame_to_ecg(const uint8_t * frame, ecg_data_t * ecg_data, uint32_t * status);
+
+// gia tri channel ch (bu 2, 24 bit, 0..n_channels-1 tren ca chuoi) cua 1 frame
+int32_t hust_ads_channel(const hust_ads_t * ads, const uint8_t * frame, int ch);
+
+// tach n_frames frame lien tiep thanh out[frame][channel] (n_channels int32 / frame)
+// tra ve so frame co it nhat 1 header status sai (chuoi daisy bi dut / lech byte)
+int hust_ads_demux(const hust_ads_t * ads, const uint8_t * frames, int n_frames, int32_t * out);
+
+#endif // HUST_ADS_H__
@@ -0,0 +1,238 @@
+#include <string.h>
+
+#include "hust_ads_nrf.h"
+#include "nrfx_spim.h"
+#include "nrfx_gpiote.h"
+#include "nrfx_timer.h"
+#include "nrfx_ppi.h"
+#include "nrf_gpio.h"
+#include "nrf_delay.h"
+#include "app_error.h"
+
+static const nrfx_spim_t ads_spim = NRFX_SPIM_INSTANCE(0);
+static const nrfx_timer_t ads_timer = NRFX_TIMER_INSTANCE(2);
+static nrf_ppi_channel_t ads_ppi_drdy;          // DRDY -> SPIM START
+static nrf_ppi_channel_t ads_ppi_end;           // SPIM END -> TIMER2 COUNT
+static uint8_t ads_buffer[(2 * HUST_ADS_BUFFER_FRAMES + HUST_ADS_GUARD_FRAMES) * HUST_ADS_MAX_FRAME_SIZE];
+static hust_ads_t * ads_dev;
+static hust_ads_nrf_handler_t ads_handler;
+static uint8_t ads_half;                        // nua buffer dang duoc DMA ghi
+static uint64_t ads_next_index;
+static uint32_t ads_overruns;
+static volatile bool ads_xfer_done;
+
+static const uint32_t ads_pin[] = {HUST_ADS_PIN_CS_GPIO, HUST_ADS_PIN_START_GPIO, HUST_ADS_PIN_RESET_GPIO};
+
+static void ads_spim_handler(nrfx_spim_evt_t const * p_event, void * p_context)
+{
+    (void)p_event;
+    (void)p_context;
+    ads_xfer_done = true;
+}
+
+// truyen cau hinh (lenh, thanh ghi), chi dung khi chua stream
+static int ads_xfer(void * p_context, const uint8_t * tx, uint16_t tx_len, uint8_t * rx, uint16_t rx_len)
+{
+    nrfx_spim_xfer_desc_t desc = NRFX_SPIM_XFER_TRX(tx, tx_len, rx, rx_len);
+    (void)p_context;
+
+    ads_xfer_done = false;
+    if(nrfx_spim_xfer(&ads_spim, &desc, 0) != NRFX_SUCCESS)
+    {
+        return -1;
+    }
+    while(!ads_xfer_done)
+    {
+    }
+    return 0;
+}
+
+static void ads_set_pin(void * p_context, hust_ads_pin_t pin, bool level)
+{
+    (void)p_context;
+    nrf_gpio_pin_write(ads_pin[pin], level);
+}
+
+static void ads_delay_us(void * p_context, uint32_t us)
+{
+    (void)p_context;
+    nrf_delay_us(us);
+}
+
+// TIMER2 COMPARE0: da nhan du HUST_ADS_BUFFER_FRAMES frame (bo dem tu xoa ve 0)
+static void ads_timer_handler(nrf_timer_event_t event_type, void * p_context)
+{
+    uint16_t frame_size = ads_dev->frame_size;
+    uint8_t * half = ads_buffer + ads_half * HUST_ADS_BUFFER_FRAMES * frame_size;
+    (void)p_context;
+
+    if(event_type != NRF_TIMER_EVENT_COMPARE0)
+    {
+        return;
+    }
+    if(ads_half == 1)
+    {
+        // quay RXD.PTR ve dau buffer. Frame nhan sau nua thu 2 (ngat tre) nam o vung guard:
+        // chuyen ve dau buffer de thu tu frame khong doi
+        uint32_t late = nrfx_timer_capture(&ads_timer, NRF_TIMER_CC_CHANNEL1);
+        if(late > HUST_ADS_GUARD_FRAMES - 1)
+        {
+            ads_overruns += late - (HUST_ADS_GUARD_FRAMES - 1);
+            late = HUST_ADS_GUARD_FRAMES - 1;
+        }
+        memmove(ads_buffer, ads_buffer + 2 * HUST_ADS_BUFFER_FRAMES * frame_size, late * frame_size);
+        nrf_spim_rx_buffer_set(ads_spim.p_reg, ads_buffer + late * frame_size, frame_size);
+    }
+    ads_half ^= 1;
+
+    uint64_t first_index = ads_next_index;
+    ads_next_index += HUST_ADS_BUFFER_FRAMES;
+    ads_handler(half, HUST_ADS_BUFFER_FRAMES, frame_size, first_index);
+}
+
+ret_code_t hust_ads_nrf_init(hust_ads_t * ads, uint8_t n_devices, uint32_t rate, uint8_t gain, hust_ads_nrf_handler_t handler)
+{
+    ret_code_t err_code;
+
+    ads_dev = ads;
+    ads_handler = handler;
+
+    nrf_gpio_pin_set(HUST_ADS_PIN_CS_GPIO);
+    nrf_gpio_cfg_output(HUST_ADS_PIN_CS_GPIO);
+    nrf_gpio_pin_clear(HUST_ADS_PIN_START_GPIO);
+    nrf_gpio_cfg_output(HUST_ADS_PIN_START_GPIO);
+    nrf_gpio_pin_set(HUST_ADS_PIN_RESET_GPIO);
+    nrf_gpio_cfg_output(HUST_ADS_PIN_RESET_GPIO);
+
+    // SPI mode 1 (CPOL 0, CPHA 1). Cau hinh o 1 MHz de moi byte lenh dai hon 4 tCLK (tSDECODE)
+    nrfx_spim_config_t spim_config = NRFX_SPIM_DEFAULT_CONFIG;
+    spim_config.sck_pin = HUST_ADS_PIN_SCK;
+    spim_config.mosi_pin = HUST_ADS_PIN_MOSI;
+    spim_config.miso_pin = HUST_ADS_PIN_MISO;
+    spim_config.ss_pin = NRFX_SPIM_PIN_NOT_USED;    // CS giu thap bang GPIO trong suot qua trinh stream
+    spim_config.mode = NRF_SPIM_MODE_1;
+    spim_config.frequency = NRF_SPIM_FREQ_1M;
+    spim_config.orc = 0x00;
+    err_code = nrfx_spim_init(&ads_spim, &spim_config, ads_spim_handler, NULL);
+    if(err_code != NRFX_SUCCESS)
+    {
+        return err_code;
+    }
+
+    hust_ads_io_t io = {
+        .xfer = ads_xfer,
+        .set_pin = ads_set_pin,
+        .delay_us = ads_delay_us,
+        .p_context = NULL
+    };
+    if(hust_ads_init(ads, &io, n_devices, rate, gain) != 0)
+    {
+        return NRF_ERROR_NOT_FOUND;
+    }
+    (void)hust_ads_command(ads, HUST_ADS_CMD_STANDBY);     // chi giu tham chieu noi den hust_ads_nrf_start
+
+    // DRDY: canh xuong, chi sinh su kien cho PPI, khong ngat
+    if(!nrfx_gpiote_is_init())
+    {
+        err_code = nrfx_gpiote_init();
+        if(err_code != NRFX_SUCCESS)
+        {
+            return err_code;
+        }
+    }
+    nrfx_gpiote_in_config_t drdy_config = NRFX_GPIOTE_CONFIG_IN_SENSE_HITOLO(true);
+    err_code = nrfx_gpiote_in_init(HUST_ADS_PIN_DRDY, &drdy_config, NULL);
+    if(err_code != NRFX_SUCCESS)
+    {
+        return err_code;
+    }
+
+    // TIMER2 o che do dem: COMPARE0 sau moi HUST_ADS_BUFFER_FRAMES lan SPIM END
+    nrfx_timer_config_t timer_config = NRFX_TIMER_DEFAULT_CONFIG;
+    timer_config.mode = NRF_TIMER_MODE_COUNTER;
+    timer_config.bit_width = NRF_TIMER_BIT_WIDTH_16;
+    err_code = nrfx_timer_init(&ads_timer, &timer_config, ads_timer_handler);
+    if(err_code != NRFX_SUCCESS)
+    {
+        return err_code;
+    }
+    nrfx_timer_extended_compare(&ads_timer, NRF_TIMER_CC_CHANNEL0, HUST_ADS_BUFFER_FRAMES,
+                                NRF_TIMER_SHORT_COMPARE0_CLEAR_MASK, true);
+
+    err_code = nrfx_ppi_channel_alloc(&ads_ppi_drdy);
+    if(err_code != NRFX_SUCCESS)
+    {
+        return err_code;
+    }
+    err_code = nrfx_ppi_channel_assign(ads_ppi_drdy,
+                                       nrfx_gpiote_in_event_addr_get(HUST_ADS_PIN_DRDY),
+                                       nrfx_spim_start_task_get(&ads_spim));
+    if(err_code != NRFX_SUCCESS)
+    {
+        return err_code;
+    }
+    err_code = nrfx_ppi_channel_alloc(&ads_ppi_end);
+    if(err_code != NRFX_SUCCESS)
+    {
+        return err_code;
+    }
+    return nrfx_ppi_channel_assign(ads_ppi_end,
+                                   nrfx_spim_end_event_get(&ads_spim),
+                                   nrfx_timer_task_address_get(&ads_timer, NRF_TIMER_TASK_COUNT));
+}
+
+ret_code_t hust_ads_nrf_start(void)
+{
+    ret_code_t err_code;
+    uint16_t frame_size = ads_dev->frame_size;
+
+    ads_half = 0;
+    ads_next_index = 0;
+    ads_overruns = 0;
+    if(hust_ads_command(ads_dev, HUST_ADS_CMD_WAKEUP) != 0)
+    {
+        return NRF_ERROR_INTERNAL;
+    }
+
+    // stream: chi doc (MOSI = ORC 0x00), RXD.PTR tang frame_size sau moi frame, SPIM START do PPI kich
+    nrfx_spim_xfer_desc_t desc = NRFX_SPIM_XFER_RX(ads_buffer, frame_size);
+    nrf_spim_frequency_set(ads_spim.p_reg, NRF_SPIM_FREQ_4M);
+    err_code = nrfx_spim_xfer(&ads_spim, &desc, NRFX_SPIM_FLAG_HOLD_XFER | NRFX_SPIM_FLAG_RX_POSTINC |
+                                                NRFX_SPIM_FLAG_NO_XFER_EVT_HANDLER | NRFX_SPIM_FLAG_REPEATED_XFER);
+    if(err_code != NRFX_SUCCESS)
+    {
+        return err_code;
+    }
+    nrfx_timer_clear(&ads_timer);
+    nrfx_timer_enable(&ads_timer);
+    err_code = nrfx_ppi_channel_enable(ads_ppi_end);
+    if(err_code != NRFX_SUCCESS)
+    {
+        return err_code;
+    }
+    err_code = nrfx_ppi_channel_enable(ads_ppi_drdy);
+    if(err_code != NRFX_SUCCESS)
+    {
+        return err_code;
+    }
+    nrfx_gpiote_in_event_enable(HUST_ADS_PIN_DRDY, false);
+    hust_ads_start(ads_dev);
+    return NRF_SUCCESS;
+}
+
+void hust_ads_nrf_stop(void)
+{
+    hust_ads_stop(ads_dev);
+    nrfx_gpiote_in_event_disable(HUST_ADS_PIN_DRDY);
+    (void)nrfx_ppi_channel_disable(ads_ppi_drdy);
+    (void)nrfx_ppi_channel_disable(ads_ppi_end);
+    nrfx_timer_disable(&ads_timer);
+    nrfx_spim_abort(&ads_spim);
+    nrf_spim_frequency_set(ads_spim.p_reg, NRF_SPIM_FREQ_1M);
+    (void)hust_ads_command(ads_dev, HUST_ADS_CMD_STANDBY);
+}
+
+uint32_t hust_ads_nrf_overruns(void)
+{
+    return ads_overruns;
+}
@@ -0,0 +1,53 @@
+#ifndef HUST_ADS_NRF_H__
+#define HUST_ADS_NRF_H__
+
+#include <stdint.h>
+
+#include "sdk_errors.h"
+#include "hust_ads.h"
+
+// ADS129x tren nRF52: DRDY --GPIOTE/PPI--> SPIM0 START, EasyDMA doc tung frame vao danh sach
+// (RXD.PTR tu tang), SPIM END --PPI--> TIMER2 COUNT dem frame. CPU chi bi ngat 1 lan /
+// HUST_ADS_BUFFER_FRAMES frame, giong hust_acq voi SAADC
+
+#define HUST_ADS_BUFFER_FRAMES      32
+#define HUST_ADS_GUARD_FRAMES       2           // frame du phong cuoi buffer khi ngat bi tre
+
+#ifndef HUST_ADS_PIN_SCK
+#define HUST_ADS_PIN_SCK            22
+#endif
+#ifndef HUST_ADS_PIN_MOSI
+#define HUST_ADS_PIN_MOSI           23
+#endif
+#ifndef HUST_ADS_PIN_MISO
+#define HUST_ADS_PIN_MISO           24
+#endif
+#ifndef HUST_ADS_PIN_CS_GPIO
+#define HUST_ADS_PIN_CS_GPIO        25
+#endif
+#ifndef HUST_ADS_PIN_DRDY
+#define HUST_ADS_PIN_DRDY           26
+#endif
+#ifndef HUST_ADS_PIN_START_GPIO
+#define HUST_ADS_PIN_START_GPIO     27
+#endif
+#ifndef HUST_ADS_PIN_RESET_GPIO
+#define HUST_ADS_PIN_RESET_GPIO     28
+#endif
+
+// goi trong ngat TIMER2 khi nua buffer day: n_frames frame lien tiep, moi frame frame_size byte
+// (status + channel cua tung chip trong chuoi, nhu doc tu chip), first_index = chi so sample cua frame dau tien
+typedef void (*hust_ads_nrf_handler_t)(const uint8_t * frames, uint16_t n_frames, uint16_t frame_size, uint64_t first_index);
+
+// cau hinh SPIM0/GPIOTE/PPI/TIMER2 va chip (hust_ads_init), ket qua doc chip luu vao ads
+// daisy chain: ca chuoi doc trong 1 lan DMA / DRDY (RXD.MAXCNT 8 bit: n_devices * 27 <= 255)
+ret_code_t hust_ads_nrf_init(hust_ads_t * ads, uint8_t n_devices, uint32_t rate, uint8_t gain, hust_ads_nrf_handler_t handler);
+
+// chip o STANDBY khi khong stream: start gui WAKEUP, stop gui STANDBY
+ret_code_t hust_ads_nrf_start(void);
+void hust_ads_nrf_stop(void);
+
+// so frame bi mat vi ngat tre qua HUST_ADS_GUARD_FRAMES chu ky lay mau
+uint32_t hust_ads_nrf_overruns(void);
+
+#endif // HUST_ADS_NRF_H__
@@ -0,0 +1,202 @@
+#include <string.h>
+
+#include "hust_bcast.h"
+
+#define AD_TYPE_MANUFACTURER    0xFF
+
+void hust_bcast_tx_init(hust_bcast_tx_t * tx, uint8_t decimation)
+{
+    tx->length = HUST_BCAST_HEADER;
+    tx->seq = 0;
+    tx->count = 0;
+    tx->decimation = decimation > 0 ? decimation : 1;
+    tx->phase = 0;
+    tx->offered = 0;
+    tx->published = 0;
+    tx->rejected = 0;
+}
+
+int hust_bcast_tx_offer(hust_bcast_tx_t * tx, const uint8_t * packet, uint16_t length)
+{
+    if(length == 0 || length > HUST_BCAST_PACKET_MAX)
+    {
+        return -2;
+    }
+    if(tx->phase != 0)
+    {
+        tx->phase = (uint8_t)((tx->phase + 1) % tx->decimation);
+        tx->offered++;
+        return 0;
+    }
+    if(tx->length + 1 + length > HUST_BCAST_ADV_MAX)
+    {
+        tx->rejected++;
+        return -1;
+    }
+    tx->pdu[tx->length] = (uint8_t)length;
+    memcpy(tx->pdu + tx->length + 1, packet, length);
+    tx->length += 1 + length;
+    tx->count++;
+    tx->phase = (uint8_t)(1 % tx->decimation);
+    tx->offered++;
+    return 0;
+}
+
+uint16_t hust_bcast_tx_publish(hust_bcast_tx_t * tx, uint8_t * out)
+{
+    uint16_t length = tx->length;
+
+    tx->pdu[0] = (uint8_t)(length - 1);
+    tx->pdu[1] = AD_TYPE_MANUFACTURER;
+    tx->pdu[2] = (uint8_t)HUST_BCAST_COMPANY_ID;
+    tx->pdu[3] = (uint8_t)(HUST_BCAST_COMPANY_ID >> 8);
+    tx->pdu[4] = HUST_BCAST_MAGIC;
+    tx->pdu[5] = (uint8_t)tx->seq;
+    tx->pdu[6] = (uint8_t)(tx->seq >> 8);
+    tx->pdu[7] = tx->decimation;
+    tx->pdu[8] = tx->count;
+    memcpy(out, tx->pdu, length);
+
+    tx->seq++;
+    tx->count = 0;
+    tx->length = HUST_BCAST_HEADER;
+    tx->published++;
+    return length;
+}
+
+void hust_bcast_rx_init(hust_bcast_rx_t * rx)
+{
+    memset(rx, 0, sizeof(*rx));
+}
+
+int hust_bcast_packet_next(const uint8_t * packets, uint16_t length, uint16_t * p_offset, const uint8_t ** p_packet)
+{
+    uint16_t offset = *p_offset;
+    if(offset >= length)
+    {
+        return 0;
+    }
+    uint8_t packet_length = packets[offset];
+    if(packet_length == 0 || offset + 1 + packet_length > length)
+    {
+        return -1;
+    }
+    *p_packet = packets + offset + 1;
+    *p_offset = (uint16_t)(offset + 1 + packet_length);
+    return packet_length;
+}
+
+// PDU dung dinh dang: dung count packet, het vung packet
+static bool pdu_valid(const uint8_t * packets, uint16_t length, uint8_t count)
+{
+    uint16_t offset = 0;
+    const uint8_t * packet;
+    int n = 0;
+    int packet_length;
+
+    while((packet_length = hust_bcast_packet_next(packets, length, &offset, &packet)) > 0)
+    {
+        n++;
+    }
+    return packet_length == 0 && n == count;
+}
+
+int hust_bcast_rx_report(hust_bcast_rx_t * rx, const uint8_t * adv, uint16_t length,
+                         const uint8_t ** p_packets, uint16_t * p_length)
+{
+    uint16_t i = 0;
+
+    while(i < length)
+    {
+        uint8_t ad_length = adv[i];
+        if(ad_length == 0)
+        {
+            break;                      // phan con lai la padding
+        }
+        if(i + 1 + ad_length > length)
+        {
+            rx->errors++;
+            return -1;
+        }
+        const uint8_t * ad = adv + i;
+        i += 1 + ad_length;
+        if(ad_length + 1 < HUST_BCAST_HEADER || ad[1] != AD_TYPE_MANUFACTURER
+           || (ad[2] | (ad[3] << 8)) != HUST_BCAST_COMPANY_ID || ad[4] != HUST_BCAST_MAGIC)
+        {
+            continue;                   // AD structure khac (ten, flags, thiet bi khac)
+        }
+        uint16_t seq = (uint16_t)(ad[5] | (ad[6] << 8));
+        uint8_t count = ad[8];
+        const uint8_t * packets = ad + HUST_BCAST_HEADER;
+        uint16_t packets_length = (uint16_t)(ad_length + 1 - HUST_BCAST_HEADER);
+        if(!pdu_valid(packets, packets_length, count))
+        {
+            rx->errors++;
+            return -1;
+        }
+        if(rx->synced && (int16_t)(seq - rx->seq) <= 0)
+        {
+            rx->duplicates++;           // advertising lap lai PDU cu
+            return 0;
+        }
+        if(rx->synced)
+        {
+            rx->lost += (uint16_t)(seq - rx->seq - 1);
+        }
+        rx->synced = true;
+        rx->seq = seq;
+        rx->decimation = ad[7];
+        rx->pdus++;
+        *p_packets = packets;
+        *p_length = packets_length;
+        return count;
+    }
+    return 0;
+}
+
+#if !defined(HUST_HOST_BUILD) && defined(S140)
+// du lieu advertising moi phai nam o buffer khac buffer SoftDevice dang phat
+static uint32_t adv_data_set(hust_bcast_t * bcast, bool configure)
+{
+    ble_gap_adv_data_t adv_data;
+    uint8_t next = bcast->adv_current ^ 1;
+
+    memset(&adv_data, 0, sizeof(adv_data));
+    adv_data.adv_data.p_data = bcast->adv_data[next];
+    adv_data.adv_data.len = hust_bcast_tx_publish(&bcast->tx, bcast->adv_data[next]);
+    uint32_t err_code = sd_ble_gap_adv_set_configure(&bcast->adv_handle, &adv_data,
+                                                     configure ? &bcast->adv_params : NULL);
+    if(err_code == NRF_SUCCESS)
+    {
+        bcast->adv_current = next;
+    }
+    return err_code;
+}
+
+uint32_t hust_bcast_init(hust_bcast_t * bcast, uint32_t interval, uint8_t decimation, uint8_t phy)
+{
+    hust_bcast_tx_init(&bcast->tx, decimation);
+    bcast->adv_handle = BLE_GAP_ADV_SET_HANDLE_NOT_SET;
+    bcast->adv_current = 0;
+
+    memset(&bcast->adv_params, 0, sizeof(bcast->adv_params));
+    bcast->adv_params.properties.type = BLE_GAP_ADV_TYPE_EXTENDED_NONCONNECTABLE_NONSCANNABLE_UNDIRECTED;
+    bcast->adv_params.p_peer_addr     = NULL;
+    bcast->adv_params.filter_policy   = BLE_GAP_ADV_FP_ANY;
+    bcast->adv_params.interval        = interval;
+    bcast->adv_params.duration        = BLE_GAP_ADV_TIMEOUT_GENERAL_UNLIMITED;
+    bcast->adv_params.primary_phy     = BLE_GAP_PHY_1MBPS;      // kenh quang cao chinh: moi may thu nghe duoc
+    bcast->adv_params.secondary_phy   = phy;
+    return adv_data_set(bcast, true);
+}
+
+uint32_t hust_bcast_start(hust_bcast_t * bcast)
+{
+    return sd_ble_gap_adv_start(bcast->adv_handle, BLE_CONN_CFG_TAG_DEFAULT);
+}
+
+uint32_t hust_bcast_publish(hust_bcast_t * bcast)
+{
+    return adv_data_set(bcast, false);
+}
+#endif
@@ -0,0 +1,98 @@
+#ifndef HUST_BCAST_H__
+#define HUST_BCAST_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Phat stream qua extended advertising khong ket noi (S140) cho nhieu may thu thu dong (phong do giac
+ * ngu, phong tap phuc hoi): khong ton ket noi, so may thu khong gioi han. Cu HUST_BCAST decimation
+ * ble packet (nguyen ven nhu NUS, ca count_packet) lay 1, gom vao PDU cua lan cap nhat du lieu
+ * advertising ke tiep, moi interval cap nhat 1 lan.
+ *
+ * Du lieu advertising = 1 AD structure manufacturer specific:
+ *
+ *   len (1) | 0xFF | company (2) | magic (1) | seq (2) | decimation (1) | count (1) |
+ *   length (1) | ble packet | length | ble packet | ...
+ *
+ * seq tang moi lan du lieu doi. Advertising lap lai du lieu cu den lan cap nhat sau nen may thu gap
+ * cung seq nhieu lan (bo qua), seq nhay coc la PDU may thu bo lo. count_packet trong tung ble packet
+ * nhay theo decimation.
+ */
+
+#define HUST_BCAST_COMPANY_ID       0xFFFF  // chua dang ky Bluetooth SIG, chi dung thu nghiem
+#define HUST_BCAST_MAGIC            0x48    // 'H'
+#define HUST_BCAST_ADV_MAX          255     // BLE_GAP_ADV_SET_DATA_SIZE_EXTENDED_MAX_SUPPORTED (S140)
+#define HUST_BCAST_HEADER           9       // len .. count
+#define HUST_BCAST_PACKET_MAX       (HUST_BCAST_ADV_MAX - HUST_BCAST_HEADER - 1)
+
+// PDU dang gom, vong lap main ghi va doc
+typedef struct
+{
+    uint8_t pdu[HUST_BCAST_ADV_MAX];
+    uint16_t length;                    // HUST_BCAST_HEADER neu chua co packet
+    uint16_t seq;                       // seq cua PDU dang gom
+    uint8_t count;                      // packet trong PDU dang gom
+    uint8_t decimation;
+    uint8_t phase;                      // packet da bo qua tu packet lay gan nhat
+    uint32_t offered;                   // packet dua vao
+    uint32_t published;                 // PDU da dua advertising
+    uint32_t rejected;                  // lan dua packet khi PDU day (nguon thu lai)
+} hust_bcast_tx_t;
+
+void hust_bcast_tx_init(hust_bcast_tx_t * tx, uint8_t decimation);
+
+// dua 1 ble packet. Tra ve 0 neu da gom hoac bo qua theo decimation, -1 neu PDU day (dua lai sau
+// hust_bcast_tx_publish, decimation khong tinh lan nay), -2 neu packet qua lon
+int hust_bcast_tx_offer(hust_bcast_tx_t * tx, const uint8_t * packet, uint16_t length);
+
+// dong PDU dang gom vao out (HUST_BCAST_ADV_MAX byte), tra ve do dai du lieu advertising. PDU khong co
+// packet van phat (may thu biet thiet bi con song), seq van tang
+uint16_t hust_bcast_tx_publish(hust_bcast_tx_t * tx, uint8_t * out);
+
+// may thu: bo PDU trung lap, dem PDU bo lo
+typedef struct
+{
+    bool synced;                        // da nhan PDU dau tien
+    uint16_t seq;                       // seq PDU moi nhat
+    uint8_t decimation;
+    uint32_t pdus;
+    uint32_t duplicates;                // report lap lai PDU da nhan
+    uint32_t lost;                      // PDU bo lo (seq nhay coc)
+    uint32_t errors;                    // PDU sai dinh dang
+} hust_bcast_rx_t;
+
+void hust_bcast_rx_init(hust_bcast_rx_t * rx);
+
+// tim PDU trong du lieu 1 advertising report (cac AD structure). Tra ve so packet cua PDU moi,
+// 0 neu khong phai PDU broadcast, PDU da nhan hoac PDU rong, -1 neu sai dinh dang. *p_packets / *p_length =
+// vung packet cua PDU, tach bang hust_bcast_packet_next
+int hust_bcast_rx_report(hust_bcast_rx_t * rx, const uint8_t * adv, uint16_t length,
+                         const uint8_t ** p_packets, uint16_t * p_length);
+
+// tach packet tu vung packet, bat dau voi *p_offset = 0. Tra ve do dai packet, 0 khi het, -1 neu sai
+int hust_bcast_packet_next(const uint8_t * packets, uint16_t length, uint16_t * p_offset, const uint8_t ** p_packet);
+
+#if !defined(HUST_HOST_BUILD) && defined(S140)
+#include "ble.h"
+#include "ble_gap.h"
+
+typedef struct
+{
+    hust_bcast_tx_t tx;
+    uint8_t adv_handle;
+    uint8_t adv_data[2][HUST_BCAST_ADV_MAX];    // SoftDevice doc buffer dang phat, PDU moi vao buffer kia
+    uint8_t adv_current;
+    ble_gap_adv_params_t adv_params;
+} hust_bcast_t;
+
+// cau hinh advertising set: interval (0.625 ms), PHY secondary channel (BLE_GAP_PHY_1MBPS / 2MBPS)
+uint32_t hust_bcast_init(hust_bcast_t * bcast, uint32_t interval, uint8_t decimation, uint8_t phy);
+
+uint32_t hust_bcast_start(hust_bcast_t * bcast);
+
+// dua PDU dang gom len advertising, goi moi interval (tu vong lap main)
+uint32_t hust_bcast_publish(hust_bcast_t * bcast);
+#endif
+
+#endif // HUST_BCAST_H__
@@ -0,0 +1,336 @@
+#include <string.h>
+
+#include "hust_bio.h"
+
+#define BIO_TICK_MASK   0xFFFFFFu
+
+void hust_bio_event_queue_init(hust_bio_event_queue_t * queue)
+{
+    memset(queue, 0, sizeof(hust_bio_event_queue_t));
+}
+
+int hust_bio_event_push(hust_bio_event_queue_t * queue, uint8_t type, uint32_t tick, const uint8_t * payload, uint8_t length)
+{
+    if(length > HUST_BIO_EVENT_MAX_PAYLOAD)
+    {
+        length = HUST_BIO_EVENT_MAX_PAYLOAD;
+    }
+    // DROP chua gui: chi cap nhat tong so, khong them event
+    if(type == HUST_BIO_EVENT_DROP)
+    {
+        for(uint32_t i = queue->tail; i != queue->head; i++)
+        {
+            hust_bio_event_t * event = &queue->event[i & (HUST_BIO_EVENT_QUEUE - 1)];
+            if(event->type == HUST_BIO_EVENT_DROP)
+            {
+                event->tick = tick & BIO_TICK_MASK;
+                event->length = length;
+                memcpy(event->payload, payload, length);
+                return 0;
+            }
+        }
+    }
+    if(queue->head - queue->tail >= HUST_BIO_EVENT_QUEUE)
+    {
+        queue->dropped++;
+        queue->seq++;                   // host thay lo hong seq
+        return -1;
+    }
+    hust_bio_event_t * event = &queue->event[queue->head & (HUST_BIO_EVENT_QUEUE - 1)];
+    event->type = type;
+    event->seq = queue->seq++;
+    event->tick = tick & BIO_TICK_MASK;
+    event->length = length;
+    if(length > 0)
+    {
+        memcpy(event->payload, payload, length);
+    }
+    queue->head++;
+    return 0;
+}
+
+const hust_bio_event_t * hust_bio_event_peek(const hust_bio_event_queue_t * queue)
+{
+    return queue->head != queue->tail ? &queue->event[queue->tail & (HUST_BIO_EVENT_QUEUE - 1)] : NULL;
+}
+
+void hust_bio_event_pop(hust_bio_event_queue_t * queue)
+{
+    if(queue->head != queue->tail)
+    {
+        queue->tail++;
+    }
+}
+
+int hust_bio_event_encode(const hust_bio_event_t * event, uint8_t * out)
+{
+    out[0] = event->type;
+    out[1] = event->seq;
+    out[2] = (uint8_t)event->tick;
+    out[3] = (uint8_t)(event->tick >> 8);
+    out[4] = (uint8_t)(event->tick >> 16);
+    out[5] = event->length;
+    memcpy(out + HUST_BIO_EVENT_HEADER, event->payload, event->length);
+    return HUST_BIO_EVENT_HEADER + event->length;
+}
+
+int hust_bio_event_decode(const uint8_t * in, int length, hust_bio_event_t * event)
+{
+    if(length < HUST_BIO_EVENT_HEADER || in[5] > HUST_BIO_EVENT_MAX_PAYLOAD || length < HUST_BIO_EVENT_HEADER + in[5])
+    {
+        return -1;
+    }
+    event->type = in[0];
+    event->seq = in[1];
+    event->tick = in[2] | ((uint32_t)in[3] << 8) | ((uint32_t)in[4] << 16);
+    event->length = in[5];
+    memcpy(event->payload, in + HUST_BIO_EVENT_HEADER, event->length);
+    return 0;
+}
+
+const char * hust_bio_event_name(uint8_t type)
+{
+    switch(type)
+    {
+        case HUST_BIO_EVENT_STATE:  return "STATE";
+        case HUST_BIO_EVENT_CONFIG: return "CONFIG";
+        case HUST_BIO_EVENT_DROP:   return "DROP";
+        case HUST_BIO_EVENT_LINK:   return "LINK";
+        default:                    return "?";
+    }
+}
+
+void hust_bio_schema_encode(const hust_bio_schema_t * schema, uint8_t * out)
+{
+    out[0] = HUST_BIO_SCHEMA_VERSION;
+    out[1] = schema->header_size;
+    out[2] = schema->sensor_type;
+    out[3] = (uint8_t)schema->rate;
+    out[4] = (uint8_t)(schema->rate >> 8);
+    for(int i = 0; i < 4; i++)
+    {
+        out[5 + i] = (uint8_t)(schema->channel_mask >> (8 * i));
+    }
+    out[9] = schema->codec;
+    out[10] = schema->codec_param;
+    out[11] = schema->samples_per_packet;
+    out[12] = (uint8_t)schema->max_packet;
+    out[13] = (uint8_t)(schema->max_packet >> 8);
+    out[14] = (uint8_t)schema->imu_rate;
+    out[15] = (uint8_t)(schema->imu_rate >> 8);
+}
+
+int hust_bio_schema_decode(const uint8_t * in, int length, hust_bio_schema_t * schema)
+{
+    if(length < HUST_BIO_SCHEMA_SIZE || in[0] != HUST_BIO_SCHEMA_VERSION)
+    {
+        return -1;
+    }
+    schema->header_size = in[1];
+    schema->sensor_type = in[2];
+    schema->rate = (uint16_t)(in[3] | (in[4] << 8));
+    schema->channel_mask = in[5] | ((uint32_t)in[6] << 8) | ((uint32_t)in[7] << 16) | ((uint32_t)in[8] << 24);
+    schema->codec = in[9];
+    schema->codec_param = in[10];
+    schema->samples_per_packet = in[11];
+    schema->max_packet = (uint16_t)(in[12] | (in[13] << 8));
+    schema->imu_rate = (uint16_t)(in[14] | (in[15] << 8));
+    return 0;
+}
+
+#ifndef HUST_HOST_BUILD
+static uint32_t char_add(hust_bio_service_t * service, uint8_t uuid_type, uint16_t uuid, uint16_t max_len,
+                         uint8_t * user_value, bool write, bool read, ble_gatts_char_handles_t * p_handles)
+{
+    ble_add_char_params_t add_char_params;
+
+    memset(&add_char_params, 0, sizeof(add_char_params));
+    add_char_params.uuid = uuid;
+    add_char_params.uuid_type = uuid_type;
+    add_char_params.max_len = max_len;
+    add_char_params.init_len = 0;
+    add_char_params.is_var_len = true;
+    add_char_params.p_init_value = user_value;
+    add_char_params.is_value_user = user_value != NULL;
+    add_char_params.char_props.notify = 1;
+    add_char_params.char_props.read = read;
+    add_char_params.char_props.write = write;
+    add_char_params.char_props.write_wo_resp = write;
+    add_char_params.read_access = SEC_OPEN;
+    add_char_params.write_access = write ? SEC_OPEN : SEC_NO_ACCESS;
+    add_char_params.cccd_write_access = SEC_OPEN;
+
+    return characteristic_add(service->service_handle, &add_char_params, p_handles);
+}
+
+uint32_t hust_bio_service_init(hust_bio_service_t * service, uint8_t uuid_type, hust_bio_control_handler_t control_handler)
+{
+    uint32_t err_code;
+    ble_uuid_t ble_uuid;
+
+    service->conn_handle = BLE_CONN_HANDLE_INVALID;
+    service->data_notify = false;
+    service->event_notify = false;
+    service->control_notify = false;
+    service->schema_notify = false;
+    service->stats_notify = false;
+    service->control_handler = control_handler;
+
+    ble_uuid.type = uuid_type;
+    ble_uuid.uuid = HUST_BIO_UUID_SERVICE;
+    err_code = sd_ble_gatts_service_add(BLE_GATTS_SRVC_TYPE_PRIMARY, &ble_uuid, &service->service_handle);
+    if(err_code != NRF_SUCCESS)
+    {
+        return err_code;
+    }
+    // data / control lon: gia tri trong RAM app
+    err_code = char_add(service, uuid_type, HUST_BIO_UUID_DATA, HUST_BIO_DATA_MAX, service->data_value,
+                        false, false, &service->data_handles);
+    if(err_code == NRF_SUCCESS)
+    {
+        err_code = char_add(service, uuid_type, HUST_BIO_UUID_EVENT, HUST_BIO_EVENT_MAX, NULL,
+                            false, false, &service->event_handles);
+    }
+    if(err_code == NRF_SUCCESS)
+    {
+        err_code = char_add(service, uuid_type, HUST_BIO_UUID_CONTROL, HUST_BIO_CONTROL_MAX, service->control_value,
+                            true, false, &service->control_handles);
+    }
+    if(err_code == NRF_SUCCESS)
+    {
+        err_code = char_add(service, uuid_type, HUST_BIO_UUID_SCHEMA, HUST_BIO_SCHEMA_SIZE, NULL,
+                            false, true, &service->schema_handles);
+    }
+    if(err_code == NRF_SUCCESS)
+    {
+        err_code = char_add(service, uuid_type, HUST_BIO_UUID_STATS, HUST_TELEMETRY_SIZE, NULL,
+                            false, true, &service->stats_handles);
+    }
+    return err_code;
+}
+
+void hust_bio_service_on_ble_evt(ble_evt_t const * p_ble_evt, void * p_context)
+{
+    hust_bio_service_t * service = (hust_bio_service_t *)p_context;
+
+    switch(p_ble_evt->header.evt_id)
+    {
+        case BLE_GAP_EVT_DISCONNECTED:
+            if(p_ble_evt->evt.gap_evt.conn_handle != service->conn_handle)
+            {
+                break;
+            }
+            service->conn_handle = BLE_CONN_HANDLE_INVALID;
+            service->data_notify = false;
+            service->event_notify = false;
+            service->control_notify = false;
+            service->schema_notify = false;
+            service->stats_notify = false;
+            break;
+
+        case BLE_GATTS_EVT_WRITE:
+        {
+            ble_gatts_evt_write_t const * p_write = &p_ble_evt->evt.gatts_evt.params.write;
+            bool cccd = p_write->len == 2;
+            if(service->conn_handle == BLE_CONN_HANDLE_INVALID)
+            {
+                service->conn_handle = p_ble_evt->evt.gatts_evt.conn_handle;    // central dau tien ghi vao service
+            }
+            else if(p_ble_evt->evt.gatts_evt.conn_handle != service->conn_handle)
+            {
+                break;                  // service thuoc 1 central, central khac stream qua NUS
+            }
+            if(p_write->handle == service->control_handles.value_handle && service->control_handler != NULL)
+            {
+                service->control_handler(p_write->data, p_write->len);
+            }
+            else if(cccd && p_write->handle == service->data_handles.cccd_handle)
+            {
+                service->data_notify = ble_srv_is_notification_enabled(p_write->data);
+            }
+            else if(cccd && p_write->handle == service->event_handles.cccd_handle)
+            {
+                service->event_notify = ble_srv_is_notification_enabled(p_write->data);
+            }
+            else if(cccd && p_write->handle == service->control_handles.cccd_handle)
+            {
+                service->control_notify = ble_srv_is_notification_enabled(p_write->data);
+            }
+            else if(cccd && p_write->handle == service->schema_handles.cccd_handle)
+            {
+                service->schema_notify = ble_srv_is_notification_enabled(p_write->data);
+            }
+            else if(cccd && p_write->handle == service->stats_handles.cccd_handle)
+            {
+                service->stats_notify = ble_srv_is_notification_enabled(p_write->data);
+            }
+        } break;
+
+        default:
+            break;
+    }
+}
+
+static uint32_t notify(hust_bio_service_t * service, uint16_t handle, bool enabled, const uint8_t * data, uint16_t * p_length)
+{
+    ble_gatts_hvx_params_t hvx_params;
+
+    if(service->conn_handle == BLE_CONN_HANDLE_INVALID || !enabled)
+    {
+        return NRF_ERROR_INVALID_STATE;
+    }
+    memset(&hvx_params, 0, sizeof(hvx_params));
+    hvx_params.handle = handle;
+    hvx_params.type = BLE_GATT_HVX_NOTIFICATION;
+    hvx_params.p_len = p_length;
+    hvx_params.p_data = data;
+    return sd_ble_gatts_hvx(service->conn_handle, &hvx_params);
+}
+
+// gia tri doc duoc + notify neu da bat CCCD
+static uint32_t value_update(hust_bio_service_t * service, uint16_t handle, bool enabled, const uint8_t * data, uint16_t length)
+{
+    ble_gatts_value_t gatts_value;
+
+    memset(&gatts_value, 0, sizeof(gatts_value));
+    gatts_value.len = length;
+    gatts_value.p_value = (uint8_t *)data;
+    uint32_t err_code = sd_ble_gatts_value_set(BLE_CONN_HANDLE_INVALID, handle, &gatts_value);
+    if(err_code != NRF_SUCCESS || service->conn_handle == BLE_CONN_HANDLE_INVALID || !enabled)
+    {
+        return err_code;
+    }
+    return notify(service, handle, enabled, data, &length);
+}
+
+uint32_t hust_bio_data_send(hust_bio_service_t * service, uint8_t * data, uint16_t * p_length)
+{
+    return notify(service, service->data_handles.value_handle, service->data_notify, data, p_length);
+}
+
+uint32_t hust_bio_event_send(hust_bio_service_t * service, const hust_bio_event_t * event)
+{
+    uint8_t data[HUST_BIO_EVENT_MAX];
+    uint16_t length = (uint16_t)hust_bio_event_encode(event, data);
+    return notify(service, service->event_handles.value_handle, service->event_notify, data, &length);
+}
+
+uint32_t hust_bio_control_send(hust_bio_service_t * service, uint8_t * data, uint16_t * p_length)
+{
+    return notify(service, service->control_handles.value_handle, service->control_notify, data, p_length);
+}
+
+uint32_t hust_bio_schema_update(hust_bio_service_t * service, const hust_bio_schema_t * schema)
+{
+    uint8_t value[HUST_BIO_SCHEMA_SIZE];
+    hust_bio_schema_encode(schema, value);
+    return value_update(service, service->schema_handles.value_handle, service->schema_notify, value, HUST_BIO_SCHEMA_SIZE);
+}
+
+uint32_t hust_bio_stats_update(hust_bio_service_t * service, const hust_telemetry_t * telemetry)
+{
+    uint8_t value[HUST_TELEMETRY_SIZE];
+    hust_telemetry_encode(telemetry, value);
+    return value_update(service, service->stats_handles.value_handle, service->stats_notify, value, HUST_TELEMETRY_SIZE);
+}
+#endif
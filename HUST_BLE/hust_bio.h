@@ -0,0 +1,174 @@
+#ifndef HUST_BIO_H__
+#define HUST_BIO_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "hust_telemetry.h"
+
+/*
+ * Service tin hieu sinh hoc thay NUS cho stream: moi characteristic 1 viec, moi cai CCCD rieng de
+ * central chi dang ky cai can dung. Dung chung base UUID voi NUS / telemetry.
+ *
+ *   data     notify          ble packet nhu NUS TX (convert_data_to_ble_packet, hust_mc, hust_sched)
+ *   event    notify          su kien uu tien cao, khong xep sau packet data (xem duoi)
+ *   control  write / notify  lenh hust_cmd.h; tra loi opcode (1) | status (1) | payload, khong co
+ *                            header ble packet
+ *   schema   read / notify   bo cuc packet data hien tai (HUST_BIO_SCHEMA_SIZE), notify khi doi
+ *   stats    read / notify   hust_telemetry_t (HUST_TELEMETRY_SIZE), moi HUST_TELEMETRY_INTERVAL_MS
+ *
+ * Event (little-endian nhu telemetry):
+ *
+ *   type (1) | seq (1) | tick (3, RTC 24 bit) | length (1) | payload (length)
+ *
+ *   STATE    state (1) | previous (1)      hust_state_id_t, ca khi mat / co ket noi
+ *   CONFIG   -                             cau hinh stream da doi, doc lai schema
+ *   DROP     samples_dropped (4)           tong sample bi bo, gop cac lan bo chua kip gui
+ *   LINK     phy (1) | interval (2)        PHY / connection interval (1.25 ms) moi
+ *
+ * Hang doi HVN cua SoftDevice dung chung cho moi characteristic va gui theo thu tu, nen packet
+ * data chi duoc chiem toi da (hang doi - HUST_BIO_EVENT_RESERVE) cho: event luon xep duoc ngay va
+ * di trong connection event ke tiep, khong doi het backlog data.
+ *
+ * Nhieu central ket noi cung luc: service thuoc central dau tien ghi vao no (CCCD / control) den khi
+ * central do ngat, central khac ghi vao thi bi bo qua.
+ */
+
+#define HUST_BIO_UUID_SERVICE       0x0020  // dung chung base UUID voi NUS
+#define HUST_BIO_UUID_DATA          0x0021
+#define HUST_BIO_UUID_EVENT         0x0022
+#define HUST_BIO_UUID_CONTROL       0x0023
+#define HUST_BIO_UUID_SCHEMA        0x0024
+#define HUST_BIO_UUID_STATS         0x0025
+
+#define HUST_BIO_EVENT_HEADER       6
+#define HUST_BIO_EVENT_MAX_PAYLOAD  8
+#define HUST_BIO_EVENT_MAX          (HUST_BIO_EVENT_HEADER + HUST_BIO_EVENT_MAX_PAYLOAD)
+#define HUST_BIO_EVENT_QUEUE        8       // luy thua cua 2
+#define HUST_BIO_EVENT_RESERVE      1       // cho trong hang doi HVN data khong duoc chiem
+
+#define HUST_BIO_CONTROL_MAX        (2 + HUST_TELEMETRY_SIZE)  // tra loi dai nhat (GET_STATS)
+#define HUST_BIO_DATA_MAX           244     // packet data dai nhat (MTU 247 - 3)
+
+#define HUST_BIO_SCHEMA_VERSION     1
+#define HUST_BIO_SCHEMA_SIZE        16
+
+typedef enum
+{
+    HUST_BIO_EVENT_STATE = 0x01,
+    HUST_BIO_EVENT_CONFIG,
+    HUST_BIO_EVENT_DROP,
+    HUST_BIO_EVENT_LINK
+} hust_bio_event_type_t;
+
+typedef struct
+{
+    uint8_t type;                       // hust_bio_event_type_t
+    uint8_t seq;                        // tang moi event, host phat hien event bi mat
+    uint32_t tick;                      // RTC 24 bit luc xay ra
+    uint8_t length;
+    uint8_t payload[HUST_BIO_EVENT_MAX_PAYLOAD];
+} hust_bio_event_t;
+
+// event cho gui: vong lap main ghi va doc
+typedef struct
+{
+    hust_bio_event_t event[HUST_BIO_EVENT_QUEUE];
+    uint32_t head;
+    uint32_t tail;
+    uint8_t seq;
+    uint32_t dropped;                   // event bi bo vi hang doi day
+} hust_bio_event_queue_t;
+
+// bo cuc packet data
+typedef struct
+{
+    uint8_t header_size;                // BLE_PACKET_HEADER_SIZE
+    uint8_t sensor_type;                // sensor_type_t
+    uint16_t rate;                      // Hz, stream chinh
+    uint32_t channel_mask;
+    uint8_t codec;                      // hust_codec_t, packet nhieu channel
+    uint8_t codec_param;
+    uint8_t samples_per_packet;         // 0 = thay doi theo packet (hust_mc / hust_sched)
+    uint16_t max_packet;                // byte toi da 1 packet (MTU - 3)
+    uint16_t imu_rate;                  // Hz, 0 neu khong co IMU
+} hust_bio_schema_t;
+
+void hust_bio_event_queue_init(hust_bio_event_queue_t * queue);
+
+// them event, DROP gop vao DROP chua gui neu co. Tra ve 0, -1 neu hang doi day (event bi bo)
+int hust_bio_event_push(hust_bio_event_queue_t * queue, uint8_t type, uint32_t tick, const uint8_t * payload, uint8_t length);
+
+// event cu nhat, NULL neu rong. Event van nam trong hang doi den khi hust_bio_event_pop
+const hust_bio_event_t * hust_bio_event_peek(const hust_bio_event_queue_t * queue);
+void hust_bio_event_pop(hust_bio_event_queue_t * queue);
+
+// tra ve so byte
+int hust_bio_event_encode(const hust_bio_event_t * event, uint8_t * out);
+
+// tra ve 0 neu thanh cong, -1 neu sai do dai
+int hust_bio_event_decode(const uint8_t * in, int length, hust_bio_event_t * event);
+
+const char * hust_bio_event_name(uint8_t type);
+
+// HUST_BIO_SCHEMA_SIZE byte
+void hust_bio_schema_encode(const hust_bio_schema_t * schema, uint8_t * out);
+
+// tra ve 0 neu thanh cong, -1 neu sai kich thuoc/version
+int hust_bio_schema_decode(const uint8_t * in, int length, hust_bio_schema_t * schema);
+
+#ifndef HUST_HOST_BUILD
+#include "ble.h"
+#include "ble_srv_common.h"
+#include "nrf_sdh_ble.h"
+
+#define HUST_BIO_BLE_OBSERVER_PRIO  2
+
+#define HUST_BIO_SERVICE_DEF(_name)                                             \
+static hust_bio_service_t _name;                                                \
+NRF_SDH_BLE_OBSERVER(_name ## _obs,                                             \
+                     HUST_BIO_BLE_OBSERVER_PRIO,                                \
+                     hust_bio_service_on_ble_evt, &_name)
+
+// du lieu ghi vao characteristic control (1 hoac nhieu lenh hust_cmd.h)
+typedef void (*hust_bio_control_handler_t)(const uint8_t * data, uint16_t length);
+
+typedef struct
+{
+    uint16_t service_handle;
+    ble_gatts_char_handles_t data_handles;
+    ble_gatts_char_handles_t event_handles;
+    ble_gatts_char_handles_t control_handles;
+    ble_gatts_char_handles_t schema_handles;
+    ble_gatts_char_handles_t stats_handles;
+    uint16_t conn_handle;               // central dang dung service
+    volatile bool data_notify;          // CCCD tung characteristic
+    volatile bool event_notify;
+    volatile bool control_notify;
+    volatile bool schema_notify;
+    volatile bool stats_notify;
+    hust_bio_control_handler_t control_handler;
+    uint8_t data_value[HUST_BIO_DATA_MAX];          // gia tri data / control nam trong RAM app (BLE_GATTS_VLOC_USER),
+    uint8_t control_value[HUST_BIO_CONTROL_MAX];    // khong chiem bang thuoc tinh cua SoftDevice
+} hust_bio_service_t;
+
+// them service, uuid_type = base UUID da dang ky (m_nus.uuid_type)
+uint32_t hust_bio_service_init(hust_bio_service_t * service, uint8_t uuid_type, hust_bio_control_handler_t control_handler);
+
+void hust_bio_service_on_ble_evt(ble_evt_t const * p_ble_evt, void * p_context);
+
+// notify 1 ble packet tren data. NRF_ERROR_INVALID_STATE neu central chua bat CCCD data
+uint32_t hust_bio_data_send(hust_bio_service_t * service, uint8_t * data, uint16_t * p_length);
+
+// notify 1 event. NRF_ERROR_INVALID_STATE neu central chua bat CCCD event
+uint32_t hust_bio_event_send(hust_bio_service_t * service, const hust_bio_event_t * event);
+
+// notify tra loi lenh tren control
+uint32_t hust_bio_control_send(hust_bio_service_t * service, uint8_t * data, uint16_t * p_length);
+
+// cap nhat gia tri schema / stats va notify neu central da bat CCCD
+uint32_t hust_bio_schema_update(hust_bio_service_t * service, const hust_bio_schema_t * schema);
+uint32_t hust_bio_stats_update(hust_bio_service_t * service, const hust_telemetry_t * telemetry);
+#endif
+
+#endif // HUST_BIO_H__
@@ -1,70 +1,279 @@
 #include "hust_ble.h"
+#ifndef HUST_HOST_BUILD
 #include "nrf_log.h"
+#endif
 
-// ham update so sample can truyen theo sensor_type
+static int bit_count(uint8_t v)
+{
+    int n = 0;
+    for(; v != 0; v &= (uint8_t)(v - 1))
+    {
+        n++;
+    }
+    return n;
+}
+
+int ecg_channel_count(uint8_t channel_mask)
+{
+    return bit_count(channel_mask & ECG_CHANNEL_MASK_ALL);
+}
+
+int imu_channel_count(uint8_t channel_mask)
+{
+    return bit_count(channel_mask & IMU_CHANNEL_MASK_ALL);
+}
+
+int ble_packet_masked(ble_packet_t ble_packet_m)
+{
+    switch(ble_packet_m.sensor_type)
+    {
+        case ECG_SENSOR_TYPE:
+            return ecg_channel_count(ble_packet_m.channel_mask) != ECG_CHANNEL;
+        case IMU_SENSOR_TYPE:
+            return imu_channel_count(ble_packet_m.channel_mask) != IMU_CHANNEL;
+        default:
+            return 0;
+    }
+}
+
+// ham update so sample can truyen theo sensor_type va channel_mask
 sample_transfer_t set_sample_transfer(ble_packet_t ble_packet_m)
 {
     sample_transfer_t sample_transfer_m;
+    int masked = ble_packet_masked(ble_packet_m);
+    int n;
     switch(ble_packet_m.sensor_type)
     {
         case ECG_SENSOR_TYPE:
-            sample_transfer_m.ecg_sample = ECG_SAMPLE_ECG_SENSOR_TYPE;
+            // thieu channel: lap day dung luong data cua packet du channel, tru byte channel_mask
+            n = ecg_channel_count(ble_packet_m.channel_mask);
+            sample_transfer_m.ecg_sample = !masked ? ECG_SAMPLE_ECG_SENSOR_TYPE
+                                         : n == 0 ? 0 : (ECG_DATA_CAPACITY - 1) / (n * ECG_DATA_LENGTH);
             sample_transfer_m.imu_sample = IMU_SAMPLE_ECG_SENSOR_TYPE;
             break;
         case IMU_SENSOR_TYPE:
+            n = imu_channel_count(ble_packet_m.channel_mask);
             sample_transfer_m.ecg_sample = ECG_SAMPLE_IMU_SENSOR_TYPE;
-            sample_transfer_m.imu_sample = IMU_SAMPLE_IMU_SENSOR_TYPE;
+            sample_transfer_m.imu_sample = !masked ? IMU_SAMPLE_IMU_SENSOR_TYPE
+                                         : n == 0 ? 0 : (IMU_DATA_CAPACITY - 1) / (n * IMU_DATA_LENGTH);
             break;
-        case ALL_SENSOR_TYPE:
-            sample_transfer_m.ecg_sample = ECG_SAMPLE_ALL_SENSOR_TYPE;
-            sample_transfer_m.imu_sample = IMU_SAMPLE_ALL_SENSOR_TYPE;
+        default:
+            // packet nhieu stream / nhieu channel / tra loi lenh: data do hust_sched / hust_mc / hust_cmd dong goi,
+            // khong co ecg_data/imu_data
+            sample_transfer_m.ecg_sample = 0;
+            sample_transfer_m.imu_sample = 0;
             break;
     }
     return sample_transfer_m;
 }
 
+int ble_packet_data_size(ble_packet_t ble_packet_m)
+{
+    sample_transfer_t sample_transfer_m = set_sample_transfer(ble_packet_m);
+    return (ble_packet_masked(ble_packet_m) ? 1 : 0)
+           + sample_transfer_m.ecg_sample * ECG_DATA_LENGTH * ecg_channel_count(ble_packet_m.channel_mask)
+           + sample_transfer_m.imu_sample * IMU_DATA_LENGTH * imu_channel_count(ble_packet_m.channel_mask);
+}
+
 void convert_data_to_ble_packet(ble_packet_t ble_packet_m, uint8_t ** ble_packet)
 {
     int count_ble_data = 0;
-    int ble_packet_size = 8 + 1 + 1 + ble_packet_m.data_size;     // sizeof(timestamp) + sizeof(sensor_type) + sizeof(data_size) + sizeof(data)
+    int ble_packet_size = BLE_PACKET_HEADER_SIZE + ble_packet_m.data_size;     // header + sizeof(data)
+    int masked = ble_packet_masked(ble_packet_m);
     *ble_packet = malloc(sizeof(uint8_t)*ble_packet_size);
     for(int i = 0; i < 8; i++)
     {
             *(*ble_packet + i) = ble_packet_m.timestamp.byte[i];
     }
     count_ble_data+=8;
-    *(*ble_packet + count_ble_data) = ble_packet_m.sensor_type;
+    *(*ble_packet + count_ble_data) = (uint8_t)(ble_packet_m.sensor_type | (masked ? SENSOR_TYPE_MASKED : 0));
     count_ble_data++;
     *(*ble_packet + count_ble_data) = ble_packet_m.data_size;
     count_ble_data++;
     *(*ble_packet + count_ble_data) = ble_packet_m.count_packet;
     count_ble_data++;
-   
-    
+    if(masked)
+    {
+        *(*ble_packet + count_ble_data) = ble_packet_m.channel_mask;
+        count_ble_data++;
+    }
+
     sample_transfer_t sample_transfer_m;
     sample_transfer_m = set_sample_transfer(ble_packet_m);
     for(int j = 0; j < sample_transfer_m.ecg_sample; j++)				//update cho tung sample
     {
-        for(int i = count_ble_data; i < count_ble_data + ECG_DATA_LENGTH; i++)		//update cho tung channel cua 1 lan lay sample
+        for(int ch = 0; ch < ECG_CHANNEL; ch++)		//update cho tung channel bat cua 1 lan lay sample
         {
-                *(*ble_packet + i) = (ble_packet_m.ecg_data+j)->ecg_channel1.byte[i - count_ble_data];
-                *(*ble_packet + i + ECG_DATA_LENGTH) = (ble_packet_m.ecg_data+j)->ecg_channel2.byte[i - count_ble_data];
-                *(*ble_packet + i + 2 * ECG_DATA_LENGTH) = (ble_packet_m.ecg_data+j)->ecg_channel3.byte[i - count_ble_data];
-                *(*ble_packet + i + 3 * ECG_DATA_LENGTH) = (ble_packet_m.ecg_data+j)->ecg_channel4.byte[i - count_ble_data];
+            if(ble_packet_m.channel_mask & (1 << ch))
+            {
+                memcpy(*ble_packet + count_ble_data, ecg_channel_get(ble_packet_m.ecg_data + j, ch)->byte, ECG_DATA_LENGTH);
+                count_ble_data+=ECG_DATA_LENGTH;
+            }
         }
-        count_ble_data+=(ECG_DATA_LENGTH*ECG_CHANNEL);
     }
     for(int j = 0; j < sample_transfer_m.imu_sample; j++)				//update cho tung sample
     {
-        for(int i = count_ble_data; i < count_ble_data + IMU_DATA_LENGTH; i++)
+        for(int a = 0; a < IMU_CHANNEL; a++)
+        {
+            if(ble_packet_m.channel_mask & (1 << (IMU_CHANNEL_MASK_SHIFT + a)))
+            {
+                memcpy(*ble_packet + count_ble_data, imu_channel_get(ble_packet_m.imu_data + j, a)->byte, IMU_DATA_LENGTH);
+                count_ble_data+=IMU_DATA_LENGTH;
+            }
+        }
+    }
+}
+
+int convert_ble_packet_to_data(const uint8_t * ble_packet, int ble_packet_size, ble_packet_t * ble_packet_m)
+{
+    if(ble_packet_size < BLE_PACKET_HEADER_SIZE)
+    {
+        return -1;
+    }
+    int count_ble_data = 0;
+    for(int i = 0; i < 8; i++)
+    {
+            ble_packet_m->timestamp.byte[i] = ble_packet[i];
+    }
+    count_ble_data+=8;
+    uint8_t sensor_type = ble_packet[count_ble_data];
+    ble_packet_m->sensor_type = (sensor_type_t)(sensor_type & ~SENSOR_TYPE_MASKED);
+    count_ble_data++;
+    ble_packet_m->data_size = ble_packet[count_ble_data];
+    count_ble_data++;
+    ble_packet_m->count_packet = ble_packet[count_ble_data];
+    count_ble_data++;
+    ble_packet_m->channel_mask = CHANNEL_MASK_ALL;
+
+    if(ble_packet_m->sensor_type < ECG_SENSOR_TYPE || ble_packet_m->sensor_type > CMD_SENSOR_TYPE)
+    {
+        return -1;
+    }
+    if(ble_packet_m->sensor_type >= ALL_SENSOR_TYPE)
+    {
+        if(sensor_type & SENSOR_TYPE_MASKED)
+        {
+            return -1;
+        }
+        return ble_packet_size < BLE_PACKET_HEADER_SIZE + ble_packet_m->data_size ? -1 : 0;
+    }
+    if(sensor_type & SENSOR_TYPE_MASKED)
+    {
+        if(ble_packet_m->data_size == 0 || ble_packet_size <= BLE_PACKET_HEADER_SIZE)
+        {
+            return -1;
+        }
+        ble_packet_m->channel_mask = ble_packet[count_ble_data];
+        count_ble_data++;
+        if(!ble_packet_masked(*ble_packet_m) || (ble_packet_m->channel_mask & ~CHANNEL_MASK_ALL) != 0)
+        {
+            return -1;          // mask du channel phai gui dinh dang cu
+        }
+    }
+    sample_transfer_t sample_transfer_m;
+    sample_transfer_m = set_sample_transfer(*ble_packet_m);
+    int data_size = ble_packet_data_size(*ble_packet_m);
+    if(data_size != ble_packet_m->data_size || ble_packet_size < BLE_PACKET_HEADER_SIZE + data_size
+       || (sample_transfer_m.ecg_sample + sample_transfer_m.imu_sample) == 0)
+    {
+        return -1;
+    }
+
+    for(int j = 0; j < sample_transfer_m.ecg_sample; j++)
+    {
+        for(int ch = 0; ch < ECG_CHANNEL; ch++)
+        {
+            ecg_sample_data_t * sample = ecg_channel_get(ble_packet_m->ecg_data + j, ch);
+            if(ble_packet_m->channel_mask & (1 << ch))
+            {
+                memcpy(sample->byte, ble_packet + count_ble_data, ECG_DATA_LENGTH);
+                count_ble_data+=ECG_DATA_LENGTH;
+            }
+            else
+            {
+                memset(sample->byte, 0, ECG_DATA_LENGTH);
+            }
+        }
+    }
+    for(int j = 0; j < sample_transfer_m.imu_sample; j++)
+    {
+        for(int a = 0; a < IMU_CHANNEL; a++)
         {
-                *(*ble_packet + i) = (ble_packet_m.imu_data+j)->imu_channel1.byte[i - count_ble_data];
-                *(*ble_packet + i + IMU_DATA_LENGTH) = (ble_packet_m.imu_data+j)->imu_channel2.byte[i - count_ble_data];
-                *(*ble_packet + i + 2*IMU_DATA_LENGTH) = (ble_packet_m.imu_data+j)->imu_channel3.byte[i - count_ble_data];
+            imu_sample_data_t * sample = imu_channel_get(ble_packet_m->imu_data + j, a);
+            if(ble_packet_m->channel_mask & (1 << (IMU_CHANNEL_MASK_SHIFT + a)))
+            {
+                memcpy(sample->byte, ble_packet + count_ble_data, IMU_DATA_LENGTH);
+                count_ble_data+=IMU_DATA_LENGTH;
+            }
+            else
+            {
+                memset(sample->byte, 0, IMU_DATA_LENGTH);
+            }
         }
-        count_ble_data+=(IMU_DATA_LENGTH*IMU_CHANNEL);
     }
+    return 0;
+}
+
+int32_t ecg_sample_to_int32(ecg_sample_data_t sample)
+{
+    int32_t value = ((int32_t)sample.byte[0] << 16) | ((int32_t)sample.byte[1] << 8) | sample.byte[2];
+    if(value & 0x800000)
+    {
+        value -= 0x1000000;     // mo rong dau 24 bit
+    }
+    return value;
+}
+
+ecg_sample_data_t int32_to_ecg_sample(int32_t value)
+{
+    ecg_sample_data_t sample;
+    sample.byte[0] = (uint8_t)(value >> 16);
+    sample.byte[1] = (uint8_t)(value >> 8);
+    sample.byte[2] = (uint8_t)value;
+    return sample;
+}
+
+int16_t imu_sample_to_int16(imu_sample_data_t sample)
+{
+    return (int16_t)((sample.byte[0] << 8) | sample.byte[1]);
+}
+
+imu_sample_data_t int16_to_imu_sample(int16_t value)
+{
+    imu_sample_data_t sample;
+    sample.byte[0] = (uint8_t)((uint16_t)value >> 8);
+    sample.byte[1] = (uint8_t)value;
+    return sample;
+}
+
+ecg_sample_data_t * ecg_channel_get(ecg_data_t * ecg_data, int ch)
+{
+    return &ecg_data->ecg_channel1 + ch;
+}
+
+imu_sample_data_t * imu_channel_get(imu_data_t * imu_data, int a)
+{
+    return &imu_data->imu_channel1 + a;
+}
+
+void timestamp_set(timestamp_t * timestamp, uint64_t sample_index)
+{
+    for(int i = 0; i < 8; i++)
+    {
+        timestamp->byte[i] = (uint8_t)(sample_index >> (56 - 8 * i));
+    }
+}
+
+uint64_t timestamp_get(const timestamp_t * timestamp)
+{
+    uint64_t sample_index = 0;
+    for(int i = 0; i < 8; i++)
+    {
+        sample_index = (sample_index << 8) | timestamp->byte[i];
+    }
+    return sample_index;
 }
+
 // ham in ra tung byte cua ble packet
 void print_ble_packet_data(uint8_t **ble_packet, int ble_packet_size)
 {
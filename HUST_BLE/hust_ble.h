@@ -6,6 +6,8 @@
 #include <stdint.h>
 #include <stdlib.h>
 
+#include "hust_latency.h"
+
 // doi thi phai update code
 #define ECG_DATA_LENGTH 3
 #define IMU_DATA_LENGTH 2
@@ -13,12 +15,33 @@
 #define IMU_CHANNEL 3
 
 // doi duoc ma khong can update code
+#if HUST_LATENCY_TRAILER_ENABLED
+#define ECG_SAMPLE_ECG_SENSOR_TYPE 18  // chua cho trailer latency trong MTU 247 (11 + 216 + 16 = 243 byte)
+#else
 #define ECG_SAMPLE_ECG_SENSOR_TYPE 19  // number of ecg samples in ble packet when sensor_type = ECG_SENSOR_TYPE
+#endif
 #define ECG_SAMPLE_IMU_SENSOR_TYPE 0
-#define ECG_SAMPLE_ALL_SENSOR_TYPE 3
 #define IMU_SAMPLE_ECG_SENSOR_TYPE 0
 #define IMU_SAMPLE_IMU_SENSOR_TYPE 4
-#define IMU_SAMPLE_ALL_SENSOR_TYPE 2
+
+#define BLE_PACKET_HEADER_SIZE 11      // sizeof(timestamp) + sizeof(sensor_type) + sizeof(data_size) + sizeof(count_packet)
+
+/*
+ * Channel mask (ECG_SENSOR_TYPE, IMU_SENSOR_TYPE): bit 0..3 = ecg_channel1..4, bit 4..6 = imu_channel1..3.
+ * Mask du channel: packet giu nguyen dinh dang cu. Thieu channel: byte sensor_type bat SENSOR_TYPE_MASKED,
+ * data[0] = channel_mask (tinh trong data_size), moi sample chi chua cac channel bat theo thu tu channel.
+ * So sample / packet tinh lai tu dung luong data cua packet du channel: ECG 1 channel 75 sample thay vi 19.
+ */
+#define ECG_CHANNEL_MASK_ALL    0x0F
+#define IMU_CHANNEL_MASK_SHIFT  4
+#define IMU_CHANNEL_MASK_ALL    (((1 << IMU_CHANNEL) - 1) << IMU_CHANNEL_MASK_SHIFT)
+#define CHANNEL_MASK_ALL        (ECG_CHANNEL_MASK_ALL | IMU_CHANNEL_MASK_ALL)
+#define SENSOR_TYPE_MASKED      0x80
+
+#define ECG_DATA_CAPACITY   (ECG_SAMPLE_ECG_SENSOR_TYPE * ECG_DATA_LENGTH * ECG_CHANNEL)
+#define IMU_DATA_CAPACITY   (IMU_SAMPLE_IMU_SENSOR_TYPE * IMU_DATA_LENGTH * IMU_CHANNEL)
+#define ECG_SAMPLE_MAX      ((ECG_DATA_CAPACITY - 1) / ECG_DATA_LENGTH)   // mang ecg_data du cho moi mask
+#define IMU_SAMPLE_MAX      ((IMU_DATA_CAPACITY - 1) / IMU_DATA_LENGTH)
 
 typedef struct
 {   
@@ -30,7 +53,10 @@ typedef enum
 {   
     ECG_SENSOR_TYPE = 2,
     IMU_SENSOR_TYPE,
-    ALL_SENSOR_TYPE
+    ALL_SENSOR_TYPE,                // ECG + IMU, moi stream rate rieng, payload theo hust_sched.h
+    EEG_SENSOR_TYPE,                // nhieu channel (daisy chain ADS1299), payload theo hust_mc.h
+    EMG_SENSOR_TYPE,                // EMG SAADC 12 bit (toi da 8 input, 1..4 kHz), payload theo hust_mc.h
+    CMD_SENSOR_TYPE                 // tra loi lenh dieu khien, khong phai sample, payload theo hust_cmd.h
 } sensor_type_t;
 
 typedef struct
@@ -60,15 +86,53 @@ typedef struct
     sensor_type_t sensor_type;
     uint8_t data_size;
     uint8_t count_packet;
+    uint8_t channel_mask;           // CHANNEL_MASK_ALL neu khong bo channel nao
     ecg_data_t *ecg_data;
     imu_data_t *imu_data;
 } ble_packet_t;
 
-// ham update so sample can truyen theo sensor_type
+// ham update so sample can truyen theo sensor_type va channel_mask
 sample_transfer_t set_sample_transfer(ble_packet_t ble_packet_m);
 
+// so channel bat cua sensor_type trong channel_mask
+int ecg_channel_count(uint8_t channel_mask);
+int imu_channel_count(uint8_t channel_mask);
+
+// true neu packet ECG/IMU phai mang byte channel_mask (thieu channel)
+int ble_packet_masked(ble_packet_t ble_packet_m);
+
+// data_size cua packet ECG/IMU theo so sample va channel_mask
+int ble_packet_data_size(ble_packet_t ble_packet_m);
+
 void convert_data_to_ble_packet(ble_packet_t ble_packet_m, uint8_t ** ble_packet);
 
+// ham giai ma ble packet (phia host), ecg_data/imu_data do nguoi goi cap phat du so sample
+// packet nhieu channel (EEG_SENSOR_TYPE, EMG_SENSOR_TYPE): chi doc header, data giai ma bang hust_mc_unpack
+// packet nhieu stream (ALL_SENSOR_TYPE): chi doc header, data giai ma bang hust_sched_seg_read
+// tra loi lenh (CMD_SENSOR_TYPE): chi doc header, data theo hust_cmd.h
+// packet thieu channel: sensor_type khong con bit SENSOR_TYPE_MASKED, channel tat = 0
+// tra ve 0 neu thanh cong, -1 neu packet sai dinh dang
+int convert_ble_packet_to_data(const uint8_t * ble_packet, int ble_packet_size, ble_packet_t * ble_packet_m);
+
+// chuyen 1 sample ecg 24 bit (big-endian, bu 2) sang int32 va nguoc lai
+int32_t ecg_sample_to_int32(ecg_sample_data_t sample);
+ecg_sample_data_t int32_to_ecg_sample(int32_t value);
+
+// chuyen 1 truc imu 16 bit (big-endian, bu 2) sang int16 va nguoc lai
+int16_t imu_sample_to_int16(imu_sample_data_t sample);
+imu_sample_data_t int16_to_imu_sample(int16_t value);
+
+// con tro toi channel thu ch (0..ECG_CHANNEL-1) cua 1 sample ecg
+ecg_sample_data_t * ecg_channel_get(ecg_data_t * ecg_data, int ch);
+
+// con tro toi truc thu a (0..IMU_CHANNEL-1) cua 1 sample imu
+imu_sample_data_t * imu_channel_get(imu_data_t * imu_data, int a);
+
+// timestamp = chi so sample dau tien cua packet theo dong ho lay mau (uint64 big-endian)
+// thoi gian thuc cua sample n = n / sample rate (xem hust_sample_clock.h)
+void timestamp_set(timestamp_t * timestamp, uint64_t sample_index);
+uint64_t timestamp_get(const timestamp_t * timestamp);
+
 // ham in ra tung byte cua ble packet
 void print_ble_packet_data(uint8_t **ble_packet, int ble_packet_size);
 
@@ -0,0 +1,198 @@
+#include <string.h>
+
+#include "hust_cmd.h"
+#include "hust_ble.h"
+#include "hust_codec.h"
+
+static uint32_t get_be(const uint8_t * p, int n)
+{
+    uint32_t v = 0;
+    for(int i = 0; i < n; i++)
+    {
+        v = (v << 8) | p[i];
+    }
+    return v;
+}
+
+static void put_be(uint8_t * p, uint32_t v, int n)
+{
+    for(int i = n - 1; i >= 0; i--)
+    {
+        p[i] = (uint8_t)v;
+        v >>= 8;
+    }
+}
+
+int hust_cmd_parse(const uint8_t * in, int length, hust_cmd_t * cmd)
+{
+    if(length < HUST_CMD_HEADER_SIZE || length < HUST_CMD_HEADER_SIZE + in[1])
+    {
+        return -1;
+    }
+    cmd->opcode = in[0];
+    cmd->length = in[1];
+    memcpy(cmd->payload, in + HUST_CMD_HEADER_SIZE, cmd->length < HUST_CMD_MAX_PAYLOAD ? cmd->length : HUST_CMD_MAX_PAYLOAD);
+    return HUST_CMD_HEADER_SIZE + in[1];
+}
+
+int hust_cmd_encode(uint8_t opcode, const uint8_t * payload, uint8_t length, uint8_t * out)
+{
+    out[0] = opcode;
+    out[1] = length;
+    if(length > 0)
+    {
+        memcpy(out + HUST_CMD_HEADER_SIZE, payload, length);
+    }
+    return HUST_CMD_HEADER_SIZE + length;
+}
+
+// so byte payload cua tung opcode, -1 neu opcode khong biet
+static int payload_length(uint8_t opcode)
+{
+    switch(opcode)
+    {
+        case HUST_CMD_START:
+        case HUST_CMD_STOP:
+        case HUST_CMD_GET_STATS:
+        case HUST_CMD_GET_CONFIG:
+            return 0;
+        case HUST_CMD_SET_SENSOR_TYPE:
+            return 1;
+        case HUST_CMD_SET_RATE:
+        case HUST_CMD_SET_CODEC:
+            return 2;
+        case HUST_CMD_SET_CHANNEL_MASK:
+            return 4;
+        default:
+            return -1;
+    }
+}
+
+int hust_cmd_apply(hust_cmd_config_t * config, const hust_cmd_t * cmd)
+{
+    int length = payload_length(cmd->opcode);
+    if(length < 0)
+    {
+        return HUST_CMD_ERR_OPCODE;
+    }
+    if(cmd->length != length)
+    {
+        return HUST_CMD_ERR_LENGTH;
+    }
+    switch(cmd->opcode)
+    {
+        case HUST_CMD_START:
+            config->streaming = true;
+            break;
+        case HUST_CMD_STOP:
+            config->streaming = false;
+            break;
+        case HUST_CMD_SET_SENSOR_TYPE:
+            if(cmd->payload[0] < ECG_SENSOR_TYPE || cmd->payload[0] > EMG_SENSOR_TYPE)
+            {
+                return HUST_CMD_ERR_PARAM;
+            }
+            config->sensor_type = cmd->payload[0];
+            break;
+        case HUST_CMD_SET_RATE:
+        {
+            uint16_t rate = (uint16_t)get_be(cmd->payload, 2);
+            if(rate == 0)
+            {
+                return HUST_CMD_ERR_PARAM;
+            }
+            config->rate = rate;
+            break;
+        }
+        case HUST_CMD_SET_CODEC:
+            if(cmd->payload[0] >= HUST_CODEC_COUNT)
+            {
+                return HUST_CMD_ERR_PARAM;
+            }
+            config->codec = cmd->payload[0];
+            config->codec_param = cmd->payload[1];
+            break;
+        case HUST_CMD_SET_CHANNEL_MASK:
+        {
+            uint32_t mask = get_be(cmd->payload, 4);
+            if(mask == 0)
+            {
+                return HUST_CMD_ERR_PARAM;
+            }
+            config->channel_mask = mask;
+            break;
+        }
+        default:
+            break;
+    }
+    return HUST_CMD_OK;
+}
+
+void hust_cmd_config_encode(const hust_cmd_config_t * config, uint8_t * out)
+{
+    out[0] = config->streaming ? 1 : 0;
+    out[1] = config->sensor_type;
+    put_be(out + 2, config->rate, 2);
+    out[4] = config->codec;
+    out[5] = config->codec_param;
+    put_be(out + 6, config->channel_mask, 4);
+    out[10] = config->state;
+}
+
+int hust_cmd_config_decode(const uint8_t * in, int length, hust_cmd_config_t * config)
+{
+    if(length < HUST_CMD_CONFIG_SIZE)
+    {
+        return -1;
+    }
+    config->streaming = in[0] != 0;
+    config->sensor_type = in[1];
+    config->rate = (uint16_t)get_be(in + 2, 2);
+    config->codec = in[4];
+    config->codec_param = in[5];
+    config->channel_mask = get_be(in + 6, 4);
+    config->state = in[10];
+    return 0;
+}
+
+void hust_cmd_queue_init(hust_cmd_queue_t * queue)
+{
+    memset(queue, 0, sizeof(hust_cmd_queue_t));
+}
+
+int hust_cmd_queue_push(hust_cmd_queue_t * queue, const hust_cmd_t * cmd)
+{
+    uint32_t head = queue->head;
+    if(head - queue->tail >= HUST_CMD_QUEUE_SIZE)
+    {
+        queue->dropped++;
+        return -1;
+    }
+    queue->cmd[head & (HUST_CMD_QUEUE_SIZE - 1)] = *cmd;
+    __sync_synchronize();           // ghi xong lenh truoc khi cap nhat head
+    queue->head = head + 1;
+    return 0;
+}
+
+const hust_cmd_t * hust_cmd_queue_peek(const hust_cmd_queue_t * queue)
+{
+    uint32_t tail = queue->tail;
+    if(queue->head == tail)
+    {
+        return NULL;
+    }
+    __sync_synchronize();
+    return &queue->cmd[tail & (HUST_CMD_QUEUE_SIZE - 1)];
+}
+
+void hust_cmd_queue_pop(hust_cmd_queue_t * queue)
+{
+    __sync_synchronize();           // doc xong lenh truoc khi tra cho cho ISR
+    queue->tail++;
+}
+
+const char * hust_cmd_status_name(uint8_t status)
+{
+    static const char * name[] = {"ok", "opcode", "length", "param", "unsupported"};
+    return status < sizeof(name) / sizeof(name[0]) ? name[status] : "?";
+}
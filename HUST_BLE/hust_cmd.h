@@ -0,0 +1,112 @@
+#ifndef HUST_CMD_H__
+#define HUST_CMD_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Lenh dieu khien stream qua NUS RX, dung chung cho firmware va host (hust_cmd_cli).
+ * Moi lan ghi NUS RX chua 1 hoac nhieu lenh noi tiep, so nhieu byte la big-endian nhu ble packet:
+ *
+ *   opcode (1) | length (1) | payload (length)
+ *
+ *   START              -                       cho phep stream: lay mau + gui packet khi central bat notify
+ *   STOP               -                       dung nguon lay mau, bo sample dang cho (hust_state.h)
+ *   SET_SENSOR_TYPE    sensor_type (1)         sensor_type_t, chi cac type firmware build ho tro
+ *   SET_RATE           rate (2)                Hz, stream chinh (ECG/EEG/EMG), lay mau lai tu sample 0
+ *   SET_CODEC          codec (1) | param (1)   hust_codec_t cho packet nhieu channel (hust_mc)
+ *   SET_CHANNEL_MASK   mask (4)                EEG/EMG: bit i = channel i cua stream chinh. ECG (+ IMU): bo tri
+ *                                              ble_packet_t.channel_mask, channel tat bi bo khoi packet
+ *   GET_STATS          -                       tra ve hust_telemetry_t (HUST_TELEMETRY_SIZE byte)
+ *   GET_CONFIG         -                       tra ve cau hinh hien tai
+ *
+ * ISR NUS chi xep lenh vao hust_cmd_queue_t, vong lap main ap dung giua 2 packet (khong bao gio
+ * giua luc dang gom sample cho 1 packet) nen khong can ngat ket noi. Moi lenh duoc tra loi bang
+ * 1 ble packet CMD_SENSOR_TYPE tren NUS TX (count_packet = so thu tu tra loi, timestamp = 0):
+ *
+ *   opcode (1) | status (1) | payload
+ *
+ * payload = hust_telemetry_t voi GET_STATS, cau hinh sau khi ap dung lenh (HUST_CMD_CONFIG_SIZE)
+ * voi moi lenh khac, ke ca khi loi. Lenh den khi hang doi day bi bo va khong co tra loi.
+ */
+
+#define HUST_CMD_HEADER_SIZE        2
+#define HUST_CMD_MAX_PAYLOAD        8
+#define HUST_CMD_CONFIG_SIZE        11      // streaming | sensor_type | rate (2) | codec | param | mask (4) | state
+#define HUST_CMD_QUEUE_SIZE         8       // luy thua cua 2
+
+typedef enum
+{
+    HUST_CMD_START = 0x01,
+    HUST_CMD_STOP,
+    HUST_CMD_SET_SENSOR_TYPE,
+    HUST_CMD_SET_RATE,
+    HUST_CMD_SET_CODEC,
+    HUST_CMD_SET_CHANNEL_MASK,
+    HUST_CMD_GET_STATS,
+    HUST_CMD_GET_CONFIG
+} hust_cmd_opcode_t;
+
+typedef enum
+{
+    HUST_CMD_OK = 0,
+    HUST_CMD_ERR_OPCODE,                // opcode khong biet
+    HUST_CMD_ERR_LENGTH,                // length sai voi opcode
+    HUST_CMD_ERR_PARAM,                 // gia tri khong hop le
+    HUST_CMD_ERR_UNSUPPORTED            // hop le nhung firmware build nay khong ho tro
+} hust_cmd_status_t;
+
+typedef struct
+{
+    uint8_t opcode;
+    uint8_t length;
+    uint8_t payload[HUST_CMD_MAX_PAYLOAD];
+    uint16_t source;                    // ket noi gui lenh, hust_cmd_parse khong dat (firmware dat)
+} hust_cmd_t;
+
+typedef struct
+{
+    bool streaming;                     // START / STOP, nguon chi chay khi state lay mau
+    uint8_t sensor_type;                // sensor_type_t
+    uint16_t rate;                      // Hz, stream chinh
+    uint8_t codec;                      // hust_codec_t, chi packet nhieu channel
+    uint8_t codec_param;
+    uint32_t channel_mask;
+    uint8_t state;                      // hust_state_id_t, chi doc
+} hust_cmd_config_t;
+
+// hang doi lenh: ISR NUS ghi, vong lap main doc, 1 ghi 1 doc khong can khoa
+typedef struct
+{
+    hust_cmd_t cmd[HUST_CMD_QUEUE_SIZE];
+    volatile uint32_t head;
+    volatile uint32_t tail;
+    uint32_t dropped;
+} hust_cmd_queue_t;
+
+// tach 1 lenh dau tien cua in, tra ve so byte da doc, -1 neu lenh bi cat cut
+// payload dai hon HUST_CMD_MAX_PAYLOAD chi chep HUST_CMD_MAX_PAYLOAD byte dau (length giu nguyen)
+int hust_cmd_parse(const uint8_t * in, int length, hust_cmd_t * cmd);
+
+// ghi 1 lenh vao out, tra ve so byte
+int hust_cmd_encode(uint8_t opcode, const uint8_t * payload, uint8_t length, uint8_t * out);
+
+// ap dung lenh SET_* / START / STOP len config (chi kiem tra dinh dang va gia tri co ban,
+// firmware kiem tra them theo build), tra ve hust_cmd_status_t. GET_* khong doi config
+int hust_cmd_apply(hust_cmd_config_t * config, const hust_cmd_t * cmd);
+
+void hust_cmd_config_encode(const hust_cmd_config_t * config, uint8_t * out);
+int hust_cmd_config_decode(const uint8_t * in, int length, hust_cmd_config_t * config);
+
+void hust_cmd_queue_init(hust_cmd_queue_t * queue);
+
+// tra ve 0 neu thanh cong, -1 neu hang doi day (lenh bi bo)
+int hust_cmd_queue_push(hust_cmd_queue_t * queue, const hust_cmd_t * cmd);
+
+// lenh cu nhat, NULL neu rong. Lenh van nam trong hang doi den khi hust_cmd_queue_pop
+const hust_cmd_t * hust_cmd_queue_peek(const hust_cmd_queue_t * queue);
+void hust_cmd_queue_pop(hust_cmd_queue_t * queue);
+
+const char * hust_cmd_status_name(uint8_t status);
+
+#endif // HUST_CMD_H__
@@ -0,0 +1,662 @@
+#include <string.h>
+
+#include "hust_codec.h"
+
+typedef struct
+{
+    uint8_t * data;
+    int size;
+    int pos;                // vi tri bit
+} bit_writer_t;
+
+typedef struct
+{
+    const uint8_t * data;
+    int size;
+    int pos;
+} bit_reader_t;
+
+static uint32_t zigzag_encode(int32_t v)
+{
+    return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+static int32_t zigzag_decode(uint32_t u)
+{
+    return (int32_t)(u >> 1) ^ -(int32_t)(u & 1);
+}
+
+static int bits_put(bit_writer_t * bw, uint32_t value, int n_bits)
+{
+    if(bw->pos + n_bits > bw->size * 8)
+    {
+        return -1;
+    }
+    while(n_bits > 0)
+    {
+        int byte = bw->pos >> 3;
+        int free_bits = 8 - (bw->pos & 7);
+        int take = n_bits < free_bits ? n_bits : free_bits;
+        uint32_t chunk = (value >> (n_bits - take)) & ((1u << take) - 1);
+        if(free_bits == 8)
+        {
+            bw->data[byte] = 0;
+        }
+        bw->data[byte] |= (uint8_t)(chunk << (free_bits - take));
+        bw->pos += take;
+        n_bits -= take;
+    }
+    return 0;
+}
+
+static int bits_get(bit_reader_t * br, int n_bits, uint32_t * p_value)
+{
+    uint32_t value = 0;
+    if(br->pos + n_bits > br->size * 8)
+    {
+        return -1;
+    }
+    while(n_bits > 0)
+    {
+        int avail = 8 - (br->pos & 7);
+        int take = n_bits < avail ? n_bits : avail;
+        uint32_t chunk = ((uint32_t)br->data[br->pos >> 3] >> (avail - take)) & ((1u << take) - 1);
+        value = (value << take) | chunk;
+        br->pos += take;
+        n_bits -= take;
+    }
+    *p_value = value;
+    return 0;
+}
+
+static int bits_bytes(int pos)
+{
+    return (pos + 7) >> 3;
+}
+
+// k Rice toi uu xap xi: log2 cua trung binh
+static uint8_t rice_k_get(const uint32_t * u, int n)
+{
+    uint64_t sum = 0;
+    uint8_t k = 0;
+    for(int i = 0; i < n; i++)
+    {
+        sum += u[i];
+    }
+    uint64_t mean = n > 0 ? sum / (uint64_t)n : 0;
+    while(k < 31 && ((uint64_t)1 << (k + 1)) <= mean)
+    {
+        k++;
+    }
+    return k;
+}
+
+static int rice_put(bit_writer_t * bw, uint32_t u, uint8_t k)
+{
+    uint32_t q = u >> k;
+    if(q >= HUST_CODEC_RICE_ESCAPE)
+    {
+        if(bits_put(bw, (1u << HUST_CODEC_RICE_ESCAPE) - 1, HUST_CODEC_RICE_ESCAPE) != 0)
+        {
+            return -1;
+        }
+        return bits_put(bw, u, 32);
+    }
+    // q bit 1 + bit 0 ket thuc
+    if(bits_put(bw, ((1u << q) - 1) << 1, (int)q + 1) != 0)
+    {
+        return -1;
+    }
+    return k > 0 ? bits_put(bw, u & (uint32_t)((1ull << k) - 1), k) : 0;
+}
+
+static int rice_get(bit_reader_t * br, uint8_t k, uint32_t * p_u)
+{
+    uint32_t q = 0;
+    uint32_t bit;
+    while(1)
+    {
+        if(bits_get(br, 1, &bit) != 0)
+        {
+            return -1;
+        }
+        if(bit == 0)
+        {
+            break;
+        }
+        q++;
+        if(q == HUST_CODEC_RICE_ESCAPE)
+        {
+            return bits_get(br, 32, p_u);
+        }
+    }
+    uint32_t r = 0;
+    if(k > 0 && bits_get(br, k, &r) != 0)
+    {
+        return -1;
+    }
+    *p_u = (q << k) | r;
+    return 0;
+}
+
+// ghi 1 byte k roi n gia tri Rice
+static int rice_block_put(bit_writer_t * bw, const uint32_t * u, int n)
+{
+    uint8_t k = rice_k_get(u, n);
+    if(bits_put(bw, k, 8) != 0)
+    {
+        return -1;
+    }
+    for(int i = 0; i < n; i++)
+    {
+        if(rice_put(bw, u[i], k) != 0)
+        {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int rice_block_get(bit_reader_t * br, uint32_t * u, int n)
+{
+    uint32_t k;
+    if(bits_get(br, 8, &k) != 0 || k > 31)
+    {
+        return -1;
+    }
+    for(int i = 0; i < n; i++)
+    {
+        if(rice_get(br, (uint8_t)k, &u[i]) != 0)
+        {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/* ---- RAW ---- */
+
+static int raw_encode(const int32_t * in, int n, uint8_t * out, int out_size)
+{
+    if(out_size < 3 * n)
+    {
+        return -1;
+    }
+    for(int i = 0; i < n; i++)
+    {
+        out[3 * i] = (uint8_t)(in[i] >> 16);
+        out[3 * i + 1] = (uint8_t)(in[i] >> 8);
+        out[3 * i + 2] = (uint8_t)in[i];
+    }
+    return 3 * n;
+}
+
+static int raw_decode(const uint8_t * in, int in_size, int32_t * out, int n)
+{
+    if(in_size < 3 * n)
+    {
+        return -1;
+    }
+    for(int i = 0; i < n; i++)
+    {
+        int32_t v = ((int32_t)in[3 * i] << 16) | ((int32_t)in[3 * i + 1] << 8) | in[3 * i + 2];
+        out[i] = (v & 0x800000) ? v - 0x1000000 : v;
+    }
+    return 3 * n;
+}
+
+/* ---- BFP: 1 byte exponent + n mantissa param bit ---- */
+
+static int bfp_encode(uint8_t bits, const int32_t * in, int n, uint8_t * out, int out_size)
+{
+    bit_writer_t bw = { out, out_size, 0 };
+    int32_t max_abs = 0;
+    uint8_t e = 0;
+
+    if(bits < 2 || bits > 24)
+    {
+        return -1;
+    }
+    for(int i = 0; i < n; i++)
+    {
+        int32_t a = in[i] < 0 ? -in[i] : in[i];
+        max_abs = a > max_abs ? a : max_abs;
+    }
+    while((max_abs >> e) >= (1 << (bits - 1)) - 1)
+    {
+        e++;
+    }
+    if(bits_put(&bw, e, 8) != 0)
+    {
+        return -1;
+    }
+    int32_t lo = -(1 << (bits - 1));
+    int32_t hi = (1 << (bits - 1)) - 1;
+    for(int i = 0; i < n; i++)
+    {
+        int32_t m = e > 0 ? (in[i] + (1 << (e - 1))) >> e : in[i];
+        m = m < lo ? lo : (m > hi ? hi : m);
+        if(bits_put(&bw, (uint32_t)m & ((1u << bits) - 1), bits) != 0)
+        {
+            return -1;
+        }
+    }
+    return bits_bytes(bw.pos);
+}
+
+static int bfp_decode(uint8_t bits, const uint8_t * in, int in_size, int32_t * out, int n)
+{
+    bit_reader_t br = { in, in_size, 0 };
+    uint32_t e;
+
+    if(bits < 2 || bits > 24 || bits_get(&br, 8, &e) != 0 || e > 24)
+    {
+        return -1;
+    }
+    for(int i = 0; i < n; i++)
+    {
+        uint32_t m;
+        if(bits_get(&br, bits, &m) != 0)
+        {
+            return -1;
+        }
+        int32_t v = (int32_t)(m << (32 - bits)) >> (32 - bits);     // mo rong dau
+        out[i] = (int32_t)((uint32_t)v << e);
+    }
+    return bits_bytes(br.pos);
+}
+
+/* ---- delta + zigzag + varint ---- */
+
+static int delta_varint_encode(const int32_t * in, int n, uint8_t * out, int out_size)
+{
+    int pos = 0;
+    int32_t prev = 0;
+    for(int i = 0; i < n; i++)
+    {
+        uint32_t u = zigzag_encode(in[i] - prev);
+        prev = in[i];
+        do
+        {
+            if(pos >= out_size)
+            {
+                return -1;
+            }
+            out[pos++] = (uint8_t)((u & 0x7F) | (u > 0x7F ? 0x80 : 0));
+            u >>= 7;
+        } while(u != 0);
+    }
+    return pos;
+}
+
+static int delta_varint_decode(const uint8_t * in, int in_size, int32_t * out, int n)
+{
+    int pos = 0;
+    uint32_t prev = 0;                      // cong khong dau: du lieu hong khong tran so co dau
+    for(int i = 0; i < n; i++)
+    {
+        uint32_t u = 0;
+        int shift = 0;
+        uint8_t b;
+        do
+        {
+            if(pos >= in_size || shift > 28)
+            {
+                return -1;
+            }
+            b = in[pos++];
+            u |= (uint32_t)(b & 0x7F) << shift;
+            shift += 7;
+        } while(b & 0x80);
+        prev += (uint32_t)zigzag_decode(u);
+        out[i] = (int32_t)prev;
+    }
+    return pos;
+}
+
+/* ---- delta + Rice ---- */
+
+static int rice_encode(const int32_t * in, int n, uint8_t * out, int out_size)
+{
+    bit_writer_t bw = { out, out_size, 0 };
+    uint32_t u[HUST_CODEC_MAX_BLOCK];
+    int32_t prev = 0;
+    for(int i = 0; i < n; i++)
+    {
+        u[i] = zigzag_encode(in[i] - prev);
+        prev = in[i];
+    }
+    if(rice_block_put(&bw, u, n) != 0)
+    {
+        return -1;
+    }
+    return bits_bytes(bw.pos);
+}
+
+static int rice_decode(const uint8_t * in, int in_size, int32_t * out, int n)
+{
+    bit_reader_t br = { in, in_size, 0 };
+    uint32_t u[HUST_CODEC_MAX_BLOCK];
+    uint32_t prev = 0;
+    if(rice_block_get(&br, u, n) != 0)
+    {
+        return -1;
+    }
+    for(int i = 0; i < n; i++)
+    {
+        prev += (uint32_t)zigzag_decode(u[i]);
+        out[i] = (int32_t)prev;
+    }
+    return bits_bytes(br.pos);
+}
+
+/* ---- LPC: du doan da thuc bac 1..3 (Shorten/FLAC fixed predictor) + Rice ---- */
+
+// tinh khong dau (modulo 2^32) nhu delta: encoder va decoder ra cung ket qua, du lieu hong khong tran so
+static uint32_t lpc_predict(const int32_t * x, int i, int order)
+{
+    uint32_t x1 = i >= 1 ? (uint32_t)x[i - 1] : 0;
+    uint32_t x2 = i >= 2 ? (uint32_t)x[i - 2] : 0;
+    uint32_t x3 = i >= 3 ? (uint32_t)x[i - 3] : 0;
+    switch(order)
+    {
+        case 1:
+            return x1;
+        case 2:
+            return 2 * x1 - x2;
+        default:
+            return 3 * x1 - 3 * x2 + x3;
+    }
+}
+
+static int lpc_encode(const int32_t * in, int n, uint8_t * out, int out_size)
+{
+    bit_writer_t bw = { out, out_size, 0 };
+    uint32_t u[HUST_CODEC_MAX_BLOCK];
+    uint64_t best_sum = UINT64_MAX;
+    int best_order = 1;
+
+    for(int order = 1; order <= 3; order++)
+    {
+        uint64_t sum = 0;
+        for(int i = 0; i < n; i++)
+        {
+            sum += zigzag_encode((int32_t)((uint32_t)in[i] - lpc_predict(in, i, order)));
+        }
+        if(sum < best_sum)
+        {
+            best_sum = sum;
+            best_order = order;
+        }
+    }
+    for(int i = 0; i < n; i++)
+    {
+        u[i] = zigzag_encode((int32_t)((uint32_t)in[i] - lpc_predict(in, i, best_order)));
+    }
+    if(bits_put(&bw, (uint32_t)best_order, 8) != 0 || rice_block_put(&bw, u, n) != 0)
+    {
+        return -1;
+    }
+    return bits_bytes(bw.pos);
+}
+
+static int lpc_decode(const uint8_t * in, int in_size, int32_t * out, int n)
+{
+    bit_reader_t br = { in, in_size, 0 };
+    uint32_t u[HUST_CODEC_MAX_BLOCK];
+    uint32_t order;
+    if(bits_get(&br, 8, &order) != 0 || order < 1 || order > 3 || rice_block_get(&br, u, n) != 0)
+    {
+        return -1;
+    }
+    for(int i = 0; i < n; i++)
+    {
+        out[i] = (int32_t)(lpc_predict(out, i, (int)order) + (uint32_t)zigzag_decode(u[i]));
+    }
+    return bits_bytes(br.pos);
+}
+
+/* ---- wavelet: lifting 5/3 nguyen (JPEG2000 lossless), bien doi xung ---- */
+
+static int wavelet_levels_get(int n)
+{
+    int levels = 0;
+    while(levels < HUST_CODEC_WAVELET_LEVELS && n >= 8)
+    {
+        n = (n + 1) / 2;
+        levels++;
+    }
+    return levels;
+}
+
+// x[0..n) -> [s | d], s = (n+1)/2 he so xap xi, d = n/2 he so chi tiet
+static void lift53_forward(int32_t * x, int n, int32_t * tmp)
+{
+    int ns = (n + 1) / 2;
+    int nd = n / 2;
+    int32_t * s = tmp;
+    int32_t * d = tmp + ns;
+    for(int i = 0; i < ns; i++)
+    {
+        s[i] = x[2 * i];
+    }
+    for(int i = 0; i < nd; i++)
+    {
+        d[i] = x[2 * i + 1];
+    }
+    for(int i = 0; i < nd; i++)
+    {
+        int32_t right = i + 1 < ns ? s[i + 1] : s[i];
+        d[i] -= (s[i] + right) >> 1;
+    }
+    for(int i = 0; i < ns; i++)
+    {
+        int32_t left = i > 0 ? d[i - 1] : d[0];
+        int32_t right = i < nd ? d[i] : d[nd - 1];
+        s[i] += (left + right + 2) >> 2;
+    }
+    memcpy(x, tmp, (size_t)n * sizeof(int32_t));
+}
+
+static void lift53_inverse(int32_t * x, int n, int32_t * tmp)
+{
+    int ns = (n + 1) / 2;
+    int nd = n / 2;
+    int32_t * s = x;
+    int32_t * d = x + ns;
+    for(int i = 0; i < ns; i++)
+    {
+        int32_t left = i > 0 ? d[i - 1] : d[0];
+        int32_t right = i < nd ? d[i] : d[nd - 1];
+        // he so hong: tong tinh 64 bit, cap nhat modulo 2^32
+        s[i] = (int32_t)((uint32_t)s[i] - (uint32_t)(int32_t)(((int64_t)left + right + 2) >> 2));
+    }
+    for(int i = 0; i < nd; i++)
+    {
+        int32_t right = i + 1 < ns ? s[i + 1] : s[i];
+        d[i] = (int32_t)((uint32_t)d[i] + (uint32_t)(int32_t)(((int64_t)s[i] + right) >> 1));
+    }
+    for(int i = 0; i < ns; i++)
+    {
+        tmp[2 * i] = s[i];
+    }
+    for(int i = 0; i < nd; i++)
+    {
+        tmp[2 * i + 1] = d[i];
+    }
+    memcpy(x, tmp, (size_t)n * sizeof(int32_t));
+}
+
+// moi subband (detail cac level + xap xi cuoi) co k Rice rieng
+static int wavelet_encode(uint8_t shift, const int32_t * in, int n, uint8_t * out, int out_size)
+{
+    bit_writer_t bw = { out, out_size, 0 };
+    int32_t x[HUST_CODEC_MAX_BLOCK];
+    int32_t tmp[HUST_CODEC_MAX_BLOCK];
+    uint32_t u[HUST_CODEC_MAX_BLOCK];
+    int levels = wavelet_levels_get(n);
+    int len = n;
+
+    if(shift > 16)
+    {
+        return -1;
+    }
+    memcpy(x, in, (size_t)n * sizeof(int32_t));
+    for(int l = 0; l < levels; l++)
+    {
+        lift53_forward(x, len, tmp);
+        int ns = (len + 1) / 2;
+        int nd = len / 2;
+        for(int i = 0; i < nd; i++)
+        {
+            int32_t c = x[ns + i];
+            if(shift > 0)
+            {
+                c = (c + (1 << (shift - 1))) >> shift;  // luong tu hoa detail (lossy)
+            }
+            u[i] = zigzag_encode(c);
+        }
+        if(rice_block_put(&bw, u, nd) != 0)
+        {
+            return -1;
+        }
+        len = ns;
+    }
+    // xap xi cuoi: delta giua cac he so
+    int32_t prev = 0;
+    for(int i = 0; i < len; i++)
+    {
+        u[i] = zigzag_encode(x[i] - prev);
+        prev = x[i];
+    }
+    if(rice_block_put(&bw, u, len) != 0)
+    {
+        return -1;
+    }
+    return bits_bytes(bw.pos);
+}
+
+static int wavelet_decode(uint8_t shift, const uint8_t * in, int in_size, int32_t * out, int n)
+{
+    bit_reader_t br = { in, in_size, 0 };
+    int32_t tmp[HUST_CODEC_MAX_BLOCK];
+    uint32_t u[HUST_CODEC_MAX_BLOCK];
+    int length[HUST_CODEC_WAVELET_LEVELS + 1];
+    int levels = wavelet_levels_get(n);
+    int len = n;
+
+    if(shift > 16)
+    {
+        return -1;
+    }
+    for(int l = 0; l < levels; l++)
+    {
+        int ns = (len + 1) / 2;
+        int nd = len / 2;
+        length[l] = len;
+        if(rice_block_get(&br, u, nd) != 0)
+        {
+            return -1;
+        }
+        for(int i = 0; i < nd; i++)
+        {
+            out[ns + i] = (int32_t)((uint32_t)zigzag_decode(u[i]) << shift);
+        }
+        len = ns;
+    }
+    if(rice_block_get(&br, u, len) != 0)
+    {
+        return -1;
+    }
+    uint32_t prev = 0;
+    for(int i = 0; i < len; i++)
+    {
+        prev += (uint32_t)zigzag_decode(u[i]);
+        out[i] = (int32_t)prev;
+    }
+    for(int l = levels - 1; l >= 0; l--)
+    {
+        lift53_inverse(out, length[l], tmp);
+    }
+    return bits_bytes(br.pos);
+}
+
+int hust_codec_encode(hust_codec_t codec, uint8_t param, const int32_t * in, int n, uint8_t * out, int out_size)
+{
+    if(n < 0 || n > HUST_CODEC_MAX_BLOCK)
+    {
+        return -1;
+    }
+    switch(codec)
+    {
+        case HUST_CODEC_RAW:
+            return raw_encode(in, n, out, out_size);
+        case HUST_CODEC_BFP:
+            return bfp_encode(param, in, n, out, out_size);
+        case HUST_CODEC_DELTA_VARINT:
+            return delta_varint_encode(in, n, out, out_size);
+        case HUST_CODEC_RICE:
+            return rice_encode(in, n, out, out_size);
+        case HUST_CODEC_LPC:
+            return lpc_encode(in, n, out, out_size);
+        case HUST_CODEC_WAVELET:
+            return wavelet_encode(param, in, n, out, out_size);
+        default:
+            return -1;
+    }
+}
+
+int hust_codec_decode(hust_codec_t codec, uint8_t param, const uint8_t * in, int in_size, int32_t * out, int n)
+{
+    if(n < 0 || n > HUST_CODEC_MAX_BLOCK)
+    {
+        return -1;
+    }
+    switch(codec)
+    {
+        case HUST_CODEC_RAW:
+            return raw_decode(in, in_size, out, n);
+        case HUST_CODEC_BFP:
+            return bfp_decode(param, in, in_size, out, n);
+        case HUST_CODEC_DELTA_VARINT:
+            return delta_varint_decode(in, in_size, out, n);
+        case HUST_CODEC_RICE:
+            return rice_decode(in, in_size, out, n);
+        case HUST_CODEC_LPC:
+            return lpc_decode(in, in_size, out, n);
+        case HUST_CODEC_WAVELET:
+            return wavelet_decode(param, in, in_size, out, n);
+        default:
+            return -1;
+    }
+}
+
+int hust_codec_max_size(hust_codec_t codec, int n)
+{
+    switch(codec)
+    {
+        case HUST_CODEC_RAW:
+            return 3 * n;
+        case HUST_CODEC_BFP:
+            return 1 + 3 * n;
+        case HUST_CODEC_DELTA_VARINT:
+            return 5 * n;
+        default:
+            // header + moi gia tri toi da escape + 32 bit
+            return 2 + HUST_CODEC_WAVELET_LEVELS + (n * (HUST_CODEC_RICE_ESCAPE + 32) + 7) / 8;
+    }
+}
+
+bool hust_codec_is_lossy(hust_codec_t codec, uint8_t param)
+{
+    return (codec == HUST_CODEC_BFP && param < 24) || (codec == HUST_CODEC_WAVELET && param > 0);
+}
+
+const char * hust_codec_name(hust_codec_t codec)
+{
+    static const char * const names[HUST_CODEC_COUNT] =
+    {
+        "raw", "bfp", "delta_varint", "rice", "lpc", "wavelet"
+    };
+    return codec < HUST_CODEC_COUNT ? names[codec] : "?";
+}
@@ -0,0 +1,38 @@
+#ifndef HUST_CODEC_H__
+#define HUST_CODEC_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// cac kieu ma hoa payload cho 1 block sample cua 1 channel (sample 24 bit trong int32)
+// dung chung cho firmware va host (benchmark)
+
+#define HUST_CODEC_MAX_BLOCK        256     // so sample toi da / block
+#define HUST_CODEC_RICE_ESCAPE      24      // q >= escape: ghi gia tri tho 32 bit
+#define HUST_CODEC_WAVELET_LEVELS   4
+
+typedef enum
+{
+    HUST_CODEC_RAW = 0,             // 3 byte / sample, nhu ble packet hien tai
+    HUST_CODEC_BFP,                 // block floating point, param = so bit mantissa (lossy)
+    HUST_CODEC_DELTA_VARINT,        // delta + zigzag + LEB128
+    HUST_CODEC_RICE,                // delta + Rice, k thich nghi theo block
+    HUST_CODEC_LPC,                 // du doan da thuc bac 1..3 (chon theo block) + Rice
+    HUST_CODEC_WAVELET,             // lifting 5/3, param = so bit luong tu hoa detail (0 = lossless)
+    HUST_CODEC_COUNT
+} hust_codec_t;
+
+// ma hoa n sample, tra ve so byte da ghi, -1 neu out_size khong du hoac tham so sai
+int hust_codec_encode(hust_codec_t codec, uint8_t param, const int32_t * in, int n, uint8_t * out, int out_size);
+
+// giai ma n sample tu in_size byte, tra ve so byte da doc, -1 neu du lieu loi
+int hust_codec_decode(hust_codec_t codec, uint8_t param, const uint8_t * in, int in_size, int32_t * out, int n);
+
+// kich thuoc toi da sau ma hoa cua n sample (de cap phat buffer)
+int hust_codec_max_size(hust_codec_t codec, int n);
+
+bool hust_codec_is_lossy(hust_codec_t codec, uint8_t param);
+
+const char * hust_codec_name(hust_codec_t codec);
+
+#endif // HUST_CODEC_H__
@@ -0,0 +1,160 @@
+#include <string.h>
+
+#include "hust_fanout.h"
+
+#define SLOT_MASK   (HUST_FANOUT_SLOTS - 1)
+
+void hust_fanout_init(hust_fanout_t * fanout)
+{
+    fanout->head = 0;
+    fanout->rejected = 0;
+    memset(fanout->length, 0, sizeof(fanout->length));
+    for(int i = 0; i < HUST_FANOUT_LINKS_MAX; i++)
+    {
+        fanout->link[i].conn_handle = HUST_FANOUT_HANDLE_INVALID;
+        fanout->link[i].ready = false;
+    }
+}
+
+hust_fanout_link_t * hust_fanout_link_add(hust_fanout_t * fanout, uint16_t conn_handle)
+{
+    hust_fanout_link_t * link = hust_fanout_link_find(fanout, HUST_FANOUT_HANDLE_INVALID);
+    if(link != NULL)
+    {
+        link->conn_handle = conn_handle;
+        link->ready = false;
+        link->cursor = fanout->head;
+        link->sent = 0;
+        link->dropped = 0;
+        link->hvn_inflight = 0;
+    }
+    return link;
+}
+
+void hust_fanout_link_remove(hust_fanout_t * fanout, uint16_t conn_handle)
+{
+    hust_fanout_link_t * link = hust_fanout_link_find(fanout, conn_handle);
+    if(link != NULL && conn_handle != HUST_FANOUT_HANDLE_INVALID)
+    {
+        link->conn_handle = HUST_FANOUT_HANDLE_INVALID;
+        link->ready = false;
+    }
+}
+
+hust_fanout_link_t * hust_fanout_link_find(hust_fanout_t * fanout, uint16_t conn_handle)
+{
+    for(int i = 0; i < HUST_FANOUT_LINKS_MAX; i++)
+    {
+        if(fanout->link[i].conn_handle == conn_handle)
+        {
+            return &fanout->link[i];
+        }
+    }
+    return NULL;
+}
+
+void hust_fanout_link_ready(hust_fanout_t * fanout, hust_fanout_link_t * link, bool ready)
+{
+    if(ready && !link->ready)
+    {
+        link->cursor = fanout->head;    // khong gui packet cu tu truoc khi central dang ky
+    }
+    link->ready = ready;
+}
+
+uint8_t hust_fanout_count(const hust_fanout_t * fanout)
+{
+    uint8_t count = 0;
+    for(int i = 0; i < HUST_FANOUT_LINKS_MAX; i++)
+    {
+        count += fanout->link[i].conn_handle != HUST_FANOUT_HANDLE_INVALID;
+    }
+    return count;
+}
+
+uint8_t hust_fanout_ready_count(const hust_fanout_t * fanout)
+{
+    uint8_t count = 0;
+    for(int i = 0; i < HUST_FANOUT_LINKS_MAX; i++)
+    {
+        count += fanout->link[i].conn_handle != HUST_FANOUT_HANDLE_INVALID && fanout->link[i].ready;
+    }
+    return count;
+}
+
+int hust_fanout_push(hust_fanout_t * fanout, const uint8_t * packet, uint16_t length)
+{
+    if(length > HUST_FANOUT_SLOT_SIZE)
+    {
+        return -2;
+    }
+    // con ket noi dang nhan co cho trong thi ghi (co the de len packet ket noi cham chua gui)
+    bool busy = false;
+    for(int i = 0; i < HUST_FANOUT_LINKS_MAX; i++)
+    {
+        const hust_fanout_link_t * link = &fanout->link[i];
+        if(link->conn_handle == HUST_FANOUT_HANDLE_INVALID || !link->ready)
+        {
+            continue;
+        }
+        if(fanout->head - link->cursor < HUST_FANOUT_SLOTS)
+        {
+            busy = false;
+            break;
+        }
+        busy = true;
+    }
+    if(busy)
+    {
+        fanout->rejected++;
+        return -1;
+    }
+    uint32_t slot = fanout->head & SLOT_MASK;
+    memcpy(fanout->slot[slot], packet, length);
+    fanout->length[slot] = length;
+    fanout->head++;
+    return 0;
+}
+
+const uint8_t * hust_fanout_peek(hust_fanout_t * fanout, hust_fanout_link_t * link, uint16_t * p_length)
+{
+    if(fanout->head - link->cursor > HUST_FANOUT_SLOTS)
+    {
+        uint32_t oldest = fanout->head - HUST_FANOUT_SLOTS;
+        link->dropped += oldest - link->cursor;
+        link->cursor = oldest;
+    }
+    if(link->cursor == fanout->head)
+    {
+        return NULL;
+    }
+    uint32_t slot = link->cursor & SLOT_MASK;
+    *p_length = fanout->length[slot];
+    return fanout->slot[slot];
+}
+
+void hust_fanout_advance(hust_fanout_link_t * link, bool sent)
+{
+    link->cursor++;
+    if(sent)
+    {
+        link->sent++;
+    }
+    else
+    {
+        link->dropped++;
+    }
+}
+
+void hust_fanout_hvn_queued(hust_fanout_link_t * link)
+{
+    if(link->hvn_inflight < UINT8_MAX)
+    {
+        link->hvn_inflight++;
+    }
+}
+
+void hust_fanout_hvn_complete(hust_fanout_link_t * link, uint8_t count)
+{
+    link->hvn_inflight = count < link->hvn_inflight ? link->hvn_inflight - count : 0;
+}
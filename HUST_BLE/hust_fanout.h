@@ -0,0 +1,75 @@
+#ifndef HUST_FANOUT_H__
+#define HUST_FANOUT_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * 1 stream cho nhieu central (gateway canh giuong + may cam tay cua dieu duong): ble packet dong goi 1
+ * lan, chep 1 lan vao ring chung, moi ket noi doc ring bang con tro rieng. SoftDevice chep packet vao
+ * bo nho cua no luc notify / giao SDU, nen ring khong chep them lan nao cho tung ket noi.
+ *
+ * Moi packet co seq = head luc ghi, ring giu HUST_FANOUT_SLOTS packet moi nhat [head - SLOTS, head).
+ * Ket noi cham bi ghi de packet chua gui thi nhay toi packet cu nhat con trong ring, so packet bi
+ * nhay cong vao dropped cua rieng ket noi do: ket noi cham khong lam cham ket noi nhanh.
+ *
+ * Ring chi tu choi packet moi khi moi ket noi dang nhan deu con HUST_FANOUT_SLOTS packet chua gui (ca
+ * ket noi nhanh nhat cung ban): nguon giu sample nhu khi chi co 1 ket noi.
+ */
+
+#define HUST_FANOUT_LINKS_MAX       4
+#define HUST_FANOUT_SLOTS           16      // luy thua cua 2
+#define HUST_FANOUT_SLOT_SIZE       244     // ble packet dai nhat (MTU 247 - 3)
+#define HUST_FANOUT_HANDLE_INVALID  0xFFFF  // = BLE_CONN_HANDLE_INVALID
+
+typedef struct
+{
+    uint16_t conn_handle;               // HUST_FANOUT_HANDLE_INVALID neu trong
+    bool ready;                         // central dang nhan stream (da bat notify / mo kenh)
+    uint32_t cursor;                    // seq packet tiep theo gui cho ket noi nay
+    uint32_t sent;
+    uint32_t dropped;                   // packet bi ghi de truoc khi gui hoac gui loi
+    uint8_t hvn_inflight;               // notification (moi service) dang nam trong hang doi HVN cua ket noi
+} hust_fanout_link_t;
+
+// vong lap main ghi va doc
+typedef struct
+{
+    uint8_t slot[HUST_FANOUT_SLOTS][HUST_FANOUT_SLOT_SIZE];
+    uint16_t length[HUST_FANOUT_SLOTS];
+    uint32_t head;                      // seq packet tiep theo duoc ghi
+    uint32_t rejected;                  // lan ghi bi tu choi vi moi ket noi deu ban (nguon thu lai)
+    hust_fanout_link_t link[HUST_FANOUT_LINKS_MAX];
+} hust_fanout_t;
+
+void hust_fanout_init(hust_fanout_t * fanout);
+
+// them ket noi (chua nhan stream). Tra ve link, NULL neu het cho
+hust_fanout_link_t * hust_fanout_link_add(hust_fanout_t * fanout, uint16_t conn_handle);
+void hust_fanout_link_remove(hust_fanout_t * fanout, uint16_t conn_handle);
+
+// NULL neu khong co
+hust_fanout_link_t * hust_fanout_link_find(hust_fanout_t * fanout, uint16_t conn_handle);
+
+// ket noi bat dau nhan stream tu packet ghi tiep theo, dung nhan thi khong con giu ring
+void hust_fanout_link_ready(hust_fanout_t * fanout, hust_fanout_link_t * link, bool ready);
+
+// so ket noi / so ket noi dang nhan stream
+uint8_t hust_fanout_count(const hust_fanout_t * fanout);
+uint8_t hust_fanout_ready_count(const hust_fanout_t * fanout);
+
+// ghi 1 packet. Tra ve 0, -1 neu moi ket noi dang nhan deu ban (packet bi tu choi), -2 neu packet qua lon
+int hust_fanout_push(hust_fanout_t * fanout, const uint8_t * packet, uint16_t length);
+
+// packet tiep theo cho link (cung con tro cho moi ket noi), NULL neu da gui het. Packet link chua gui
+// ma da bi ghi de thi bo qua va cong dropped
+const uint8_t * hust_fanout_peek(hust_fanout_t * fanout, hust_fanout_link_t * link, uint16_t * p_length);
+
+// packet tu hust_fanout_peek da gui (sent = true) hoac gui loi
+void hust_fanout_advance(hust_fanout_link_t * link, bool sent);
+
+// 1 notification vao hang doi HVN cua ket noi / count notification da phat (BLE_GATTS_EVT_HVN_TX_COMPLETE)
+void hust_fanout_hvn_queued(hust_fanout_link_t * link);
+void hust_fanout_hvn_complete(hust_fanout_link_t * link, uint8_t count);
+
+#endif // HUST_FANOUT_H__
@@ -0,0 +1,300 @@
+#include <string.h>
+
+#include "hust_flog.h"
+
+#define ROUND4(n)   (((n) + 3u) & ~3u)
+
+static uint32_t batch_addr(const hust_flog_t * log, uint32_t batch)
+{
+    return log->base + (batch % log->n_batches) * HUST_FLOG_BATCH_SIZE;
+}
+
+// batch da ghi xong va chua doc
+static bool batch_readable(const hust_flog_t * log)
+{
+    return (int32_t)(log->wr - log->rd) > 0;
+}
+
+static void read_next_batch(hust_flog_t * log)
+{
+    log->rd++;
+    log->rd_used = 0;
+    log->rd_offset = 0;
+}
+
+// dong batch dang gom: header + dem 0xFF den boi so 4, chuyen sang buffer kia
+static void batch_seal(hust_flog_t * log)
+{
+    uint8_t * batch = log->batch[log->active];
+    batch[0] = (uint8_t)HUST_FLOG_BATCH_MAGIC;
+    batch[1] = (uint8_t)(HUST_FLOG_BATCH_MAGIC >> 8);
+    batch[2] = (uint8_t)log->fill;
+    batch[3] = (uint8_t)(log->fill >> 8);
+    memset(batch + log->fill, 0xFF, ROUND4(log->fill) - log->fill);
+    log->ready = true;
+    log->active ^= 1;
+    log->fill = HUST_FLOG_BATCH_HEADER;
+}
+
+int hust_flog_init(hust_flog_t * log, const hust_flog_io_t * io, uint32_t base, uint32_t page_size, uint16_t n_pages, uint8_t share)
+{
+    if(page_size == 0 || page_size % HUST_FLOG_BATCH_SIZE != 0 || base % page_size != 0 || n_pages < 2
+       || share == 0 || share > 100)
+    {
+        return -1;
+    }
+    memset(log, 0, sizeof(hust_flog_t));
+    log->io = *io;
+    log->base = base;
+    log->page_size = page_size;
+    log->n_pages = n_pages;
+    log->batches_per_page = (uint16_t)(page_size / HUST_FLOG_BATCH_SIZE);
+    log->n_batches = (uint32_t)n_pages * log->batches_per_page;
+    log->fill = HUST_FLOG_BATCH_HEADER;
+    log->share = share;
+    return 0;
+}
+
+int hust_flog_append(hust_flog_t * log, const uint8_t * data, uint16_t length)
+{
+    if(length == 0 || length > HUST_FLOG_RECORD_MAX)
+    {
+        log->records_dropped++;
+        return -1;
+    }
+    if(log->fill + 1 + length > HUST_FLOG_BATCH_SIZE)
+    {
+        if(log->ready)
+        {
+            // batch truoc chua ghi xong (flash cham hon luong packet)
+            log->records_dropped++;
+            return -1;
+        }
+        batch_seal(log);
+    }
+    uint8_t * p = log->batch[log->active] + log->fill;
+    p[0] = (uint8_t)length;
+    memcpy(p + 1, data, length);
+    log->fill += 1 + length;
+    log->records_written++;
+    return 0;
+}
+
+void hust_flog_flush(hust_flog_t * log)
+{
+    if(!log->ready && log->fill > HUST_FLOG_BATCH_HEADER)
+    {
+        batch_seal(log);
+    }
+}
+
+void hust_flog_clear(hust_flog_t * log)
+{
+    // batch dang cho ghi van ghi len slot wr nhung khong duoc doc
+    log->fill = HUST_FLOG_BATCH_HEADER;
+    log->rd = log->wr + (log->ready ? 1 : 0);
+    log->rd_used = 0;
+    log->rd_offset = 0;
+}
+
+// xoa page logic page (vong truoc cua slot do mat): doi rd qua cac batch cu nhat bi mat
+static int page_erase(hust_flog_t * log, uint32_t page)
+{
+    uint32_t keep_from = (page + 1) * log->batches_per_page - log->n_batches;
+    if((page + 1) * log->batches_per_page > log->n_batches && (int32_t)(keep_from - log->rd) > 0)
+    {
+        log->batches_lost += keep_from - log->rd;
+        log->rd = keep_from;
+        log->rd_used = 0;
+        log->rd_offset = 0;
+    }
+    return log->io.erase(log->io.p_context, log->base + (page % log->n_pages) * log->page_size);
+}
+
+// lenh flash tiep theo: xoa page truoc khi ghi batch dau tien cua no, ghi than batch, ghi header
+// sau cung de batch chi hop le khi ghi xong. Ranh sau khi ghi batch dau cua page thi xoa truoc page
+// ke tiep, de luong packet khong phai cho lenh xoa (lau hon thoi gian gom 1 batch)
+static void op_issue(hust_flog_t * log)
+{
+    const uint8_t * batch = log->batch[log->active ^ 1];
+    uint32_t page = log->wr / log->batches_per_page;       // page logic, tang mai
+
+    if(log->erased_to <= page
+       || (!log->ready && log->erased_to == page + 1 && log->wr % log->batches_per_page != 0))
+    {
+        if(page_erase(log, log->erased_to) != 0)
+        {
+            log->errors++;
+            return;
+        }
+        log->op = HUST_FLOG_OP_ERASE;
+        return;
+    }
+    if(!log->ready)
+    {
+        return;
+    }
+    uint16_t used = (uint16_t)(batch[2] | (batch[3] << 8));
+    if(log->io.write(log->io.p_context, batch_addr(log, log->wr) + HUST_FLOG_BATCH_HEADER, batch + HUST_FLOG_BATCH_HEADER,
+                     ROUND4(used) - HUST_FLOG_BATCH_HEADER) != 0)
+    {
+        log->errors++;
+        return;
+    }
+    log->op = HUST_FLOG_OP_WRITE;
+}
+
+void hust_flog_poll(hust_flog_t * log)
+{
+    if(log->op != HUST_FLOG_OP_NONE)
+    {
+        if(!log->op_done)
+        {
+            return;
+        }
+        hust_flog_op_t op = log->op;
+        log->op = HUST_FLOG_OP_NONE;
+        log->op_done = false;
+
+        if(log->op_result != 0)
+        {
+            log->errors++;
+            if(op != HUST_FLOG_OP_ERASE)
+            {
+                // slot co the da ghi 1 phan: bo batch, header khong hop le nen khi doc se bo qua
+                log->batches_lost++;
+                log->ready = false;
+                log->wr++;
+            }
+        }
+        else if(op == HUST_FLOG_OP_ERASE)
+        {
+            log->erased_to++;
+            log->erases++;
+        }
+        else if(op == HUST_FLOG_OP_WRITE)
+        {
+            if(log->io.write(log->io.p_context, batch_addr(log, log->wr), log->batch[log->active ^ 1],
+                             HUST_FLOG_BATCH_HEADER) != 0)
+            {
+                log->errors++;
+                log->batches_lost++;
+                log->ready = false;
+                log->wr++;
+            }
+            else
+            {
+                log->op = HUST_FLOG_OP_HEADER;
+            }
+            return;
+        }
+        else
+        {
+            log->ready = false;
+            log->wr++;
+        }
+    }
+    op_issue(log);
+}
+
+void hust_flog_done(hust_flog_t * log, int result)
+{
+    log->op_result = result;
+    log->op_done = true;
+}
+
+int hust_flog_peek(hust_flog_t * log, uint8_t * data, uint16_t max_length)
+{
+    while(batch_readable(log))
+    {
+        uint32_t addr = batch_addr(log, log->rd);
+        if(log->rd_used == 0)
+        {
+            uint8_t header[HUST_FLOG_BATCH_HEADER];
+            uint16_t used;
+            if(log->io.read(log->io.p_context, addr, header, HUST_FLOG_BATCH_HEADER) != 0
+               || (header[0] | (header[1] << 8)) != HUST_FLOG_BATCH_MAGIC
+               || (used = (uint16_t)(header[2] | (header[3] << 8))) < HUST_FLOG_BATCH_HEADER
+               || used > HUST_FLOG_BATCH_SIZE)
+            {
+                log->batches_lost++;
+                read_next_batch(log);
+                continue;
+            }
+            log->rd_used = used;
+            log->rd_offset = HUST_FLOG_BATCH_HEADER;
+        }
+        if(log->rd_offset < log->rd_used)
+        {
+            uint8_t length;
+            if(log->io.read(log->io.p_context, addr + log->rd_offset, &length, 1) != 0
+               || length == 0 || log->rd_offset + 1 + length > log->rd_used)
+            {
+                log->batches_lost++;
+                read_next_batch(log);
+                continue;
+            }
+            if(length > max_length)
+            {
+                log->records_dropped++;
+                log->rd_offset += 1 + length;
+                continue;
+            }
+            if(log->io.read(log->io.p_context, addr + log->rd_offset + 1, data, length) != 0)
+            {
+                return 0;
+            }
+            return length;
+        }
+        read_next_batch(log);
+    }
+    return 0;
+}
+
+void hust_flog_consume(hust_flog_t * log, uint16_t length)
+{
+    log->rd_offset += 1 + length;
+    log->records_read++;
+    log->backfill_bytes += length;
+    if(log->rd_offset >= log->rd_used)
+    {
+        read_next_batch(log);
+    }
+}
+
+bool hust_flog_empty(const hust_flog_t * log)
+{
+    return !batch_readable(log) && !log->ready && log->fill == HUST_FLOG_BATCH_HEADER;
+}
+
+uint32_t hust_flog_stored(const hust_flog_t * log)
+{
+    return batch_readable(log) ? (log->wr - log->rd) * (HUST_FLOG_BATCH_SIZE - HUST_FLOG_BATCH_HEADER) : 0;
+}
+
+uint32_t hust_flog_capacity(const hust_flog_t * log)
+{
+    // page dang ghi va page da xoa truoc khong giu du lieu cu
+    return (log->n_batches - 2u * log->batches_per_page) * (HUST_FLOG_BATCH_SIZE - HUST_FLOG_BATCH_HEADER);
+}
+
+void hust_flog_share_reset(hust_flog_t * log)
+{
+    log->sent_bytes = 0;
+    log->backfill_bytes = 0;
+}
+
+void hust_flog_sent(hust_flog_t * log, uint16_t length)
+{
+    log->sent_bytes += length;
+}
+
+void hust_flog_backfill_add(hust_flog_t * log, uint16_t length)
+{
+    log->backfill_bytes += length;
+}
+
+bool hust_flog_backfill_turn(const hust_flog_t * log)
+{
+    return (uint64_t)log->backfill_bytes * 100 <= (uint64_t)log->share * log->sent_bytes;
+}
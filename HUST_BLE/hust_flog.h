@@ -0,0 +1,135 @@
+#ifndef HUST_FLOG_H__
+#define HUST_FLOG_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Log packet tren flash cho store-and-forward (state BUFFERING, hust_state.h), dung chung cho
+ * firmware (nrf_fstorage, hust_flog_nrf.c) va host (flash gia lap, hust_flog_bench.c).
+ *
+ * Vung log gom n_pages page lien tiep, ghi vong tron. Page duoc xoa truoc 1 page so voi page dang
+ * ghi, moi page bi xoa dung 1 lan / 1 vong nen mon deu. Packet gom trong RAM thanh
+ * batch HUST_FLOG_BATCH_SIZE byte, moi batch ghi 1 lan va nam tron trong 1 page:
+ *
+ *   batch:  magic (2) | used (2, ca header) | record | record | ... | 0xFF ...
+ *   record: do dai packet (1) | packet
+ *
+ * 2 buffer batch: 1 dang gom, 1 cho/dang ghi (ghi flash bat dong bo qua SoftDevice). Header ghi
+ * sau cung: batch ghi do thi khong co magic va bi bo qua khi doc. Log day thi bo page cu nhat,
+ * giu du lieu moi nhat. Doc lai (backfill) theo thu tu ghi, record chi roi log khi
+ * hust_flog_consume, gui loi thi doc lai dung record do.
+ *
+ * Log bat dau rong sau reset: chi so doc/ghi chi nam trong RAM.
+ */
+
+#define HUST_FLOG_BATCH_SIZE        1024        // uoc cua page, boi so cua 4
+#define HUST_FLOG_BATCH_HEADER      4
+#define HUST_FLOG_BATCH_MAGIC       0x4C48      // "HL"
+#define HUST_FLOG_RECORD_MAX        255
+
+typedef struct
+{
+    // xoa 1 page / ghi len (boi so 4) byte, bat dong bo: tra ve 0 neu da nhan lenh, ket qua bao
+    // qua hust_flog_done. data phai giu nguyen den luc do
+    int (*erase)(void * p_context, uint32_t addr);
+    int (*write)(void * p_context, uint32_t addr, const void * data, uint32_t len);
+    // doc dong bo
+    int (*read)(void * p_context, uint32_t addr, void * data, uint32_t len);
+    void * p_context;
+} hust_flog_io_t;
+
+typedef enum
+{
+    HUST_FLOG_OP_NONE = 0,
+    HUST_FLOG_OP_ERASE,
+    HUST_FLOG_OP_WRITE,                 // than batch
+    HUST_FLOG_OP_HEADER                 // header, ghi sau cung
+} hust_flog_op_t;
+
+typedef struct
+{
+    hust_flog_io_t io;
+    uint32_t base;                      // dia chi page dau tien
+    uint32_t page_size;
+    uint16_t n_pages;
+    uint16_t batches_per_page;
+    uint32_t n_batches;
+
+    // chi so batch logic, tang mai: slot tren flash = chi so % n_batches
+    uint32_t wr;                        // batch ke tiep ghi len flash
+    uint32_t rd;                        // batch dang doc (rd < wr: da ghi xong)
+    uint32_t erased_to;                 // page logic [0, erased_to) da xoa (toi da 1 page truoc wr)
+    uint16_t rd_used;                   // byte cua batch rd, 0 = chua doc header
+    uint16_t rd_offset;                 // record ke tiep trong batch rd
+
+    uint8_t batch[2][HUST_FLOG_BATCH_SIZE];
+    uint16_t fill;                      // byte trong batch[active]
+    uint8_t active;
+    bool ready;                         // batch[active ^ 1] cho ghi len batch wr
+
+    hust_flog_op_t op;                  // lenh flash dang chay
+    volatile bool op_done;
+    volatile int op_result;
+
+    // chia bang thong backfill / live (hust_flog_backfill_turn)
+    uint8_t share;                      // % byte gui danh cho backfill
+    uint32_t sent_bytes;                // tong byte gui tu lan ket noi lai
+    uint32_t backfill_bytes;            // trong do byte backfill
+
+    uint32_t records_written;
+    uint32_t records_read;
+    uint32_t records_dropped;           // ca 2 buffer batch deu day / packet qua dai
+    uint32_t batches_lost;              // bi ghi de khi log day, hoac header hong
+    uint32_t erases;
+    uint32_t errors;                    // lenh flash loi
+} hust_flog_t;
+
+// base va page_size: page flash, page_size boi so cua HUST_FLOG_BATCH_SIZE, n_pages >= 2
+// share: % bang thong cho backfill (1..100). Tra ve -1 neu tham so sai
+int hust_flog_init(hust_flog_t * log, const hust_flog_io_t * io, uint32_t base, uint32_t page_size, uint16_t n_pages, uint8_t share);
+
+// them 1 packet vao batch dang gom, tra ve -1 neu packet bi bo
+int hust_flog_append(hust_flog_t * log, const uint8_t * data, uint16_t length);
+
+// day batch dang gom (chua day) len flash, vd. khi ket noi lai de backfill duoc ca phan cuoi
+void hust_flog_flush(hust_flog_t * log);
+
+// bo moi packet da luu (nguon lay mau chay lai tu sample 0)
+void hust_flog_clear(hust_flog_t * log);
+
+// xu ly lenh flash vua xong va ra lenh tiep theo, goi trong vong lap main (su kien flash cua
+// SoftDevice danh thuc CPU)
+void hust_flog_poll(hust_flog_t * log);
+
+// ket qua lenh flash (0 = thanh cong), goi duoc tu ngat / su kien SoftDevice
+void hust_flog_done(hust_flog_t * log, int result);
+
+// doc record cu nhat da ghi len flash vao data, tra ve do dai, 0 neu khong con
+int hust_flog_peek(hust_flog_t * log, uint8_t * data, uint16_t max_length);
+
+// bo record vua peek (da gui xong), tinh vao byte backfill
+void hust_flog_consume(hust_flog_t * log, uint16_t length);
+
+// khong con packet nao cho doc: ca tren flash lan trong batch RAM
+bool hust_flog_empty(const hust_flog_t * log);
+
+// so byte da ghi len flash ma chua doc (uoc luong theo batch)
+uint32_t hust_flog_stored(const hust_flog_t * log);
+
+// so byte log chac chan giu duoc
+uint32_t hust_flog_capacity(const hust_flog_t * log);
+
+// bat dau dem lai bang thong (ket noi lai)
+void hust_flog_share_reset(hust_flog_t * log);
+
+// moi packet gui di (live hoac backfill)
+void hust_flog_sent(hust_flog_t * log, uint16_t length);
+
+// packet backfill lay tu nguon khac (vd. lich su RAM hust_hist), tinh chung share voi log
+void hust_flog_backfill_add(hust_flog_t * log, uint16_t length);
+
+// backfill chua vuot share % tong byte gui
+bool hust_flog_backfill_turn(const hust_flog_t * log);
+
+#endif // HUST_FLOG_H__
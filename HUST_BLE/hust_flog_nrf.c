@@ -0,0 +1,59 @@
+#include "hust_flog_nrf.h"
+#include "nrf_fstorage.h"
+#include "nrf_fstorage_sd.h"
+
+static hust_flog_t * flog_dev;
+
+static void flog_fstorage_handler(nrf_fstorage_evt_t * p_evt)
+{
+    hust_flog_done(flog_dev, p_evt->result == NRF_SUCCESS ? 0 : -1);
+}
+
+NRF_FSTORAGE_DEF(nrf_fstorage_t flog_fstorage) =
+{
+    .evt_handler = flog_fstorage_handler,
+    .start_addr = HUST_FLOG_NRF_START,
+    .end_addr = HUST_FLOG_NRF_END - 1,
+};
+
+static int flog_erase(void * p_context, uint32_t addr)
+{
+    (void)p_context;
+    return nrf_fstorage_erase(&flog_fstorage, addr, 1, NULL) == NRF_SUCCESS ? 0 : -1;
+}
+
+static int flog_write(void * p_context, uint32_t addr, const void * data, uint32_t len)
+{
+    (void)p_context;
+    return nrf_fstorage_write(&flog_fstorage, addr, data, len, NULL) == NRF_SUCCESS ? 0 : -1;
+}
+
+static int flog_read(void * p_context, uint32_t addr, void * data, uint32_t len)
+{
+    (void)p_context;
+    return nrf_fstorage_read(&flog_fstorage, addr, data, len) == NRF_SUCCESS ? 0 : -1;
+}
+
+ret_code_t hust_flog_nrf_init(hust_flog_t * log, uint8_t share)
+{
+    // goi sau khi bat SoftDevice
+    ret_code_t err_code = nrf_fstorage_init(&flog_fstorage, &nrf_fstorage_sd, NULL);
+    if(err_code != NRF_SUCCESS)
+    {
+        return err_code;
+    }
+    uint32_t page_size = flog_fstorage.p_flash_info->erase_unit;
+    hust_flog_io_t io = {
+        .erase = flog_erase,
+        .write = flog_write,
+        .read = flog_read,
+        .p_context = NULL
+    };
+    flog_dev = log;
+    if(hust_flog_init(log, &io, HUST_FLOG_NRF_START, page_size,
+                      (uint16_t)((HUST_FLOG_NRF_END - HUST_FLOG_NRF_START) / page_size), share) != 0)
+    {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+    return NRF_SUCCESS;
+}
@@ -0,0 +1,23 @@
+#ifndef HUST_FLOG_NRF_H__
+#define HUST_FLOG_NRF_H__
+
+#include <stdint.h>
+
+#include "sdk_errors.h"
+#include "hust_flog.h"
+
+// log packet (hust_flog) tren flash nRF52 qua nrf_fstorage_sd: SoftDevice chen lenh xoa/ghi vao
+// giua cac connection event, ket qua bao qua su kien SoC. Vung log nam cuoi flash, ngoai vung
+// code cua app (FLASH_START + FLASH_SIZE trong project SES phai <= HUST_FLOG_NRF_START)
+
+#ifndef HUST_FLOG_NRF_START
+#define HUST_FLOG_NRF_START         0x50000
+#endif
+#ifndef HUST_FLOG_NRF_END
+#define HUST_FLOG_NRF_END           0x80000     // het flash nRF52832, khong co bootloader
+#endif
+
+// share: % bang thong danh cho backfill khi ket noi lai
+ret_code_t hust_flog_nrf_init(hust_flog_t * log, uint8_t share);
+
+#endif // HUST_FLOG_NRF_H__
@@ -0,0 +1,314 @@
+#include <string.h>
+
+#include "hust_hist.h"
+#include "hust_codec.h"
+#include "hust_ble.h"
+
+#define HIST_CODEC              HUST_CODEC_RICE
+#define HIST_RECORD_MAX         (HUST_HIST_RECORD_HEADER + HUST_HIST_PACKET_MAX)
+
+// bo cuc packet ECG_SENSOR_TYPE: do dai header (+ mask), so channel, so sample. 0 neu khong nen duoc
+static int ecg_layout(const uint8_t * packet, uint16_t length, int * p_head, int * p_channels)
+{
+    if(length < BLE_PACKET_HEADER_SIZE || (packet[8] & ~SENSOR_TYPE_MASKED) != ECG_SENSOR_TYPE)
+    {
+        return 0;
+    }
+    int masked = (packet[8] & SENSOR_TYPE_MASKED) ? 1 : 0;
+    int data_size = packet[9];
+    if(data_size < masked || BLE_PACKET_HEADER_SIZE + data_size > length)
+    {
+        return 0;
+    }
+    int channels = ecg_channel_count(masked ? packet[BLE_PACKET_HEADER_SIZE] : ECG_CHANNEL_MASK_ALL);
+    if(channels == 0)
+    {
+        return 0;
+    }
+    int n = (data_size - masked) / (channels * ECG_DATA_LENGTH);
+    if(n > ECG_SAMPLE_MAX)
+    {
+        return 0;
+    }
+    *p_head = BLE_PACKET_HEADER_SIZE + masked;
+    *p_channels = channels;
+    return n;
+}
+
+// body HUST_HIST_ECG, tra ve so byte, -1 neu khong gon hon packet goc
+static int ecg_encode(const uint8_t * packet, uint16_t length, uint8_t * out)
+{
+    int head, channels;
+    int n = ecg_layout(packet, length, &head, &channels);
+    if(n == 0)
+    {
+        return -1;
+    }
+    int32_t block[ECG_SAMPLE_MAX];
+    int pos = head;
+    memcpy(out, packet, head);
+    for(int ch = 0; ch < channels; ch++)
+    {
+        for(int i = 0; i < n; i++)
+        {
+            block[i] = ecg_sample_to_int32(*(const ecg_sample_data_t *)(packet + head + (i * channels + ch) * ECG_DATA_LENGTH));
+        }
+        int size = hust_codec_encode(HIST_CODEC, 0, block, n, out + pos, length - pos);
+        if(size < 0)
+        {
+            return -1;
+        }
+        pos += size;
+    }
+    int tail = length - (head + n * channels * ECG_DATA_LENGTH);
+    if(pos + tail >= length)
+    {
+        return -1;
+    }
+    memcpy(out + pos, packet + length - tail, tail);
+    return pos + tail;
+}
+
+// dung lai packet tu body HUST_HIST_ECG, tra ve do dai, -1 neu body hong
+static int ecg_decode(const uint8_t * body, int body_size, uint8_t * data, uint16_t max_length)
+{
+    int head, channels;
+    // header packet goc: data_size va mask nam trong phan dau body
+    int n = ecg_layout(body, 0xFFFF, &head, &channels);
+    if(n == 0 || head > body_size)
+    {
+        return -1;
+    }
+    int length = head + n * channels * ECG_DATA_LENGTH;
+    if(length > max_length)
+    {
+        return -1;
+    }
+    int32_t block[ECG_SAMPLE_MAX];
+    int pos = head;
+    memcpy(data, body, head);
+    for(int ch = 0; ch < channels; ch++)
+    {
+        int size = hust_codec_decode(HIST_CODEC, 0, body + pos, body_size - pos, block, n);
+        if(size < 0)
+        {
+            return -1;
+        }
+        pos += size;
+        for(int i = 0; i < n; i++)
+        {
+            *(ecg_sample_data_t *)(data + head + (i * channels + ch) * ECG_DATA_LENGTH) = int32_to_ecg_sample(block[i]);
+        }
+    }
+    int tail = body_size - pos;
+    if(tail < 0 || length + tail > max_length)
+    {
+        return -1;
+    }
+    memcpy(data + length, body + pos, tail);
+    return length + tail;
+}
+
+static uint32_t record_tick(const hust_hist_t * hist, uint32_t offset)
+{
+    const uint8_t * p = hist->buf + offset;
+    return p[2] | ((uint32_t)p[3] << 8) | ((uint32_t)p[4] << 16);
+}
+
+// bo qua phan trong cuoi ring truoc record cu nhat
+static void tail_align(hust_hist_t * hist)
+{
+    if(hist->used == 0)
+    {
+        return;
+    }
+    uint32_t end = hist->size - hist->tail;
+    if(end < 2 || (hist->buf[hist->tail] | (hist->buf[hist->tail + 1] << 8)) == 0)
+    {
+        hist->used -= end;
+        hist->tail = 0;
+    }
+}
+
+// bo record cu nhat (count > 0)
+static void record_drop(hust_hist_t * hist)
+{
+    tail_align(hist);
+    uint32_t size = hist->buf[hist->tail] | (hist->buf[hist->tail + 1] << 8);
+    hist->tail += size;
+    if(hist->tail == hist->size)
+    {
+        hist->tail = 0;
+    }
+    hist->used -= size;
+    hist->count--;
+    if(hist->count > 0)
+    {
+        tail_align(hist);
+        hist->tick_first = record_tick(hist, hist->tail);
+    }
+}
+
+int hust_hist_init(hust_hist_t * hist, uint8_t * buf, uint32_t size, uint32_t tick_mask)
+{
+    memset(hist, 0, sizeof(hust_hist_t));
+    if(size < HIST_RECORD_MAX)
+    {
+        return -1;
+    }
+    hist->buf = buf;
+    hist->size = size;
+    hist->tick_mask = tick_mask;
+    return 0;
+}
+
+void hust_hist_clear(hust_hist_t * hist)
+{
+    hist->head = 0;
+    hist->tail = 0;
+    hist->used = 0;
+    hist->count = 0;
+}
+
+int hust_hist_push(hust_hist_t * hist, const uint8_t * packet, uint16_t length, uint32_t tick)
+{
+    uint8_t record[HIST_RECORD_MAX];
+
+    if(length == 0 || length > HUST_HIST_PACKET_MAX)
+    {
+        return -1;
+    }
+    int body = ecg_encode(packet, length, record + HUST_HIST_RECORD_HEADER);
+    record[5] = HUST_HIST_ECG;
+    if(body < 0)
+    {
+        memcpy(record + HUST_HIST_RECORD_HEADER, packet, length);
+        body = length;
+        record[5] = HUST_HIST_RAW;
+    }
+    uint32_t size = HUST_HIST_RECORD_HEADER + (uint32_t)body;
+
+    // cho lien tuc: sau head (den cuoi ring hoac den tail), hoac dau ring neu cuoi ring khong du
+    if(hist->used == 0)
+    {
+        hist->head = 0;
+        hist->tail = 0;
+    }
+    uint32_t pad = 0;
+    if(hist->used != 0 && hist->head == hist->tail)
+    {
+        return -1;
+    }
+    if(hist->used == 0 || hist->head > hist->tail)
+    {
+        if(hist->size - hist->head < size)
+        {
+            if(hist->used == 0 || hist->tail < size)
+            {
+                return -1;
+            }
+            pad = hist->size - hist->head;
+        }
+    }
+    else if(hist->tail - hist->head < size)
+    {
+        return -1;
+    }
+    if(pad != 0)
+    {
+        if(pad >= 2)
+        {
+            hist->buf[hist->head] = 0;
+            hist->buf[hist->head + 1] = 0;
+        }
+        hist->used += pad;
+        hist->head = 0;
+    }
+
+    tick &= hist->tick_mask;
+    record[0] = (uint8_t)size;
+    record[1] = (uint8_t)(size >> 8);
+    record[2] = (uint8_t)tick;
+    record[3] = (uint8_t)(tick >> 8);
+    record[4] = (uint8_t)(tick >> 16);
+    memcpy(hist->buf + hist->head, record, size);
+    hist->head += size;
+    if(hist->head == hist->size)
+    {
+        hist->head = 0;
+    }
+    if(hist->count == 0)
+    {
+        hist->tick_first = tick;
+    }
+    hist->tick_last = tick;
+    hist->used += size;
+    hist->count++;
+    hist->packets_in++;
+    hist->packet_bytes += length;
+    hist->record_bytes += size;
+    return 0;
+}
+
+int hust_hist_peek(hust_hist_t * hist, uint8_t * data, uint16_t max_length)
+{
+    while(hist->count > 0)
+    {
+        tail_align(hist);
+        const uint8_t * p = hist->buf + hist->tail;
+        int size = p[0] | (p[1] << 8);
+        const uint8_t * body = p + HUST_HIST_RECORD_HEADER;
+        int body_size = size - HUST_HIST_RECORD_HEADER;
+        int length = -1;
+        if(p[5] == HUST_HIST_ECG)
+        {
+            length = ecg_decode(body, body_size, data, max_length);
+        }
+        else if(body_size <= max_length)
+        {
+            memcpy(data, body, body_size);
+            length = body_size;
+        }
+        if(length > 0)
+        {
+            return length;
+        }
+        hist->errors++;
+        record_drop(hist);
+    }
+    return 0;
+}
+
+void hust_hist_consume(hust_hist_t * hist)
+{
+    if(hist->count > 0)
+    {
+        record_drop(hist);
+        hist->packets_out++;
+    }
+}
+
+int hust_hist_pop(hust_hist_t * hist, uint8_t * data, uint16_t max_length)
+{
+    int length = hust_hist_peek(hist, data, max_length);
+    if(length > 0)
+    {
+        hust_hist_consume(hist);
+    }
+    return length;
+}
+
+uint32_t hust_hist_span(const hust_hist_t * hist)
+{
+    return hist->count > 0 ? (hist->tick_last - hist->tick_first) & hist->tick_mask : 0;
+}
+
+uint32_t hust_hist_capacity(const hust_hist_t * hist)
+{
+    // span phu count - 1 khoang giua cac record
+    if(hist->count < 2 || hist->used == 0)
+    {
+        return 0;
+    }
+    return (uint32_t)((uint64_t)hust_hist_span(hist) * hist->size * hist->count / ((uint64_t)hist->used * (hist->count - 1)));
+}
@@ -0,0 +1,78 @@
+#ifndef HUST_HIST_H__
+#define HUST_HIST_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Lich su N giay gan nhat trong RAM, nen gon, cho cac lan mat ket noi ngan (state BUFFERING,
+ * hust_state.h): khong ghi flash, ket noi lai la gui lai ngay. Dung chung cho firmware va host
+ * (hust_hist_bench.c).
+ *
+ * Ring byte gom cac record lien tuc (record khong vat qua cuoi ring, phan du cuoi ring bo trong):
+ *
+ *   record: do dai record (2, ca header) | tick (3, RTC luc luu) | kind (1) | body
+ *
+ *   HUST_HIST_RAW:  body = packet nguyen ven (ALL / IMU / EEG / EMG, payload hust_mc da nen san)
+ *   HUST_HIST_ECG:  body = header packet (+ byte channel_mask) | moi channel 1 block hust_codec RICE
+ *                   (lossless) n sample | phan con lai cua packet (vd. trailer latency)
+ *
+ * Doc ra (hust_hist_peek) dung lai dung packet da luu, host khong can biet. Ring day thi
+ * hust_hist_push tra ve -1: nguoi goi lay record cu nhat ra (hust_hist_pop) - bo di hoac chuyen
+ * xuong flash (hust_flog) - roi push lai.
+ */
+
+#define HUST_HIST_RECORD_HEADER     6
+#define HUST_HIST_PACKET_MAX        255     // packet dai nhat luu duoc (= HUST_FLOG_RECORD_MAX)
+
+typedef enum
+{
+    HUST_HIST_RAW = 0,
+    HUST_HIST_ECG
+} hust_hist_kind_t;
+
+typedef struct
+{
+    uint8_t * buf;
+    uint32_t size;
+    uint32_t tick_mask;                 // RTC 24 bit: 0xFFFFFF
+
+    uint32_t head;                      // offset record ke tiep ghi
+    uint32_t tail;                      // offset record cu nhat
+    uint32_t used;                      // byte tu tail den head, ca phan bo trong cuoi ring
+    uint32_t count;                     // so record dang giu
+    uint32_t tick_first;                // tick record cu nhat / moi nhat
+    uint32_t tick_last;
+
+    uint32_t packets_in;
+    uint32_t packets_out;               // doc ra qua hust_hist_consume / hust_hist_pop
+    uint32_t packet_bytes;              // tong byte packet da luu
+    uint32_t record_bytes;              // va byte record tuong ung (ty le nen)
+    uint32_t errors;                    // record hong khi giai ma, bi bo
+} hust_hist_t;
+
+// buf: vung RAM cua ring, tick_mask: mat na cua bo dem tick. Tra ve -1 neu vung qua nho
+int hust_hist_init(hust_hist_t * hist, uint8_t * buf, uint32_t size, uint32_t tick_mask);
+
+// bo het record (nguon lay mau chay lai tu sample 0)
+void hust_hist_clear(hust_hist_t * hist);
+
+// luu 1 packet luc tick, tra ve -1 neu ring khong con cho (hoac packet qua dai / rong)
+int hust_hist_push(hust_hist_t * hist, const uint8_t * packet, uint16_t length, uint32_t tick);
+
+// dung lai packet cu nhat vao data, tra ve do dai, 0 neu ring rong
+int hust_hist_peek(hust_hist_t * hist, uint8_t * data, uint16_t max_length);
+
+// bo record cu nhat (vua peek va gui xong)
+void hust_hist_consume(hust_hist_t * hist);
+
+// peek + consume
+int hust_hist_pop(hust_hist_t * hist, uint8_t * data, uint16_t max_length);
+
+// so tick tu record cu nhat den moi nhat dang giu
+uint32_t hust_hist_span(const hust_hist_t * hist);
+
+// so tick ring giu duoc khi day, uoc luong theo ty le nen hien tai (0 neu chua du du lieu)
+uint32_t hust_hist_capacity(const hust_hist_t * hist);
+
+#endif // HUST_HIST_H__
@@ -0,0 +1,228 @@
+#include "hust_imu.h"
+
+typedef struct
+{
+    uint16_t rate;
+    uint8_t odr;
+} lsm6_odr_t;
+
+// CTRL1_XL.ODR_XL / FIFO_CTRL5.ODR_FIFO (cung ma)
+static const lsm6_odr_t lsm6_odr[] =
+{
+    {26, 0x2}, {52, 0x3}, {104, 0x4}, {208, 0x5}, {416, 0x6}, {833, 0x7}
+};
+
+int hust_imu_reg_read(hust_imu_t * imu, uint8_t reg, uint8_t * data, uint8_t n)
+{
+    return imu->io.xfer(imu->io.p_context, imu->addr, &reg, 1, data, n);
+}
+
+int hust_imu_reg_write(hust_imu_t * imu, uint8_t reg, uint8_t value)
+{
+    uint8_t tx[2] = {reg, value};
+    return imu->io.xfer(imu->io.p_context, imu->addr, tx, 2, NULL, 0);
+}
+
+// doc WHO_AM_I tai 1 dia chi, tra ve ho chip nhan ra
+static hust_imu_family_t imu_probe(hust_imu_t * imu, uint8_t addr)
+{
+    uint8_t id;
+
+    imu->addr = addr;
+    if(addr == HUST_LSM6_ADDR || addr == HUST_LSM6_ADDR + 1)
+    {
+        if(hust_imu_reg_read(imu, HUST_LSM6_WHO_AM_I, &id, 1) == 0 && (id == 0x69 || id == 0x6A))
+        {
+            imu->who_am_i = id;
+            return HUST_IMU_LSM6;
+        }
+    }
+    else if(hust_imu_reg_read(imu, HUST_MPU_WHO_AM_I, &id, 1) == 0 && (id == 0x70 || id == 0x71 || id == 0x12))
+    {
+        imu->who_am_i = id;
+        return HUST_IMU_MPU;
+    }
+    return HUST_IMU_UNKNOWN;
+}
+
+static int lsm6_odr_code(uint16_t rate)
+{
+    for(unsigned i = 0; i < sizeof(lsm6_odr) / sizeof(lsm6_odr[0]); i++)
+    {
+        if(lsm6_odr[i].rate == rate)
+        {
+            return lsm6_odr[i].odr;
+        }
+    }
+    return -1;
+}
+
+static int lsm6_init(hust_imu_t * imu)
+{
+    int odr = lsm6_odr_code(imu->rate);
+    if(odr < 0)
+    {
+        return -1;
+    }
+    // threshold FIFO tinh theo word 16 bit
+    uint16_t threshold = (uint16_t)imu->watermark * 3;
+
+    imu->fifo_reg = HUST_LSM6_FIFO_DATA_OUT_L;
+    if(hust_imu_reg_write(imu, HUST_LSM6_CTRL3_C, 0x01) != 0)      // SW_RESET
+    {
+        return -1;
+    }
+    imu->io.delay_us(imu->io.p_context, 100);
+    if(hust_imu_reg_write(imu, HUST_LSM6_CTRL3_C, 0x44) != 0                            // BDU, IF_INC
+       || hust_imu_reg_write(imu, HUST_LSM6_FIFO_CTRL1, (uint8_t)threshold) != 0
+       || hust_imu_reg_write(imu, HUST_LSM6_FIFO_CTRL1 + 1, (uint8_t)(threshold >> 8)) != 0
+       || hust_imu_reg_write(imu, HUST_LSM6_FIFO_CTRL3, 0x01) != 0                      // accel vao FIFO, khong gyro
+       || hust_imu_reg_write(imu, HUST_LSM6_INT1_CTRL, 0x08) != 0                       // INT1_FTH
+       || hust_imu_reg_write(imu, HUST_LSM6_CTRL1_XL, (uint8_t)((odr << 4) | 0x08)) != 0) // +-4 g
+    {
+        return -1;
+    }
+    return hust_imu_fifo_reset(imu);
+}
+
+static int mpu_init(hust_imu_t * imu)
+{
+    // sample 1 kHz / (1 + SMPLRT_DIV): lam tron rate ve uoc nguyen gan nhat cua 1000 (104 -> 100 Hz)
+    uint16_t div = imu->rate == 0 || imu->rate > 1000 ? 0 : (uint16_t)((1000 + imu->rate / 2) / imu->rate);
+    if(div == 0 || div > 256)
+    {
+        return -1;
+    }
+    imu->rate = (uint16_t)(1000 / div);
+    imu->fifo_reg = HUST_MPU_FIFO_R_W;
+    if(hust_imu_reg_write(imu, HUST_MPU_PWR_MGMT_1, 0x80) != 0)    // H_RESET
+    {
+        return -1;
+    }
+    imu->io.delay_us(imu->io.p_context, 100000);
+    if(hust_imu_reg_write(imu, HUST_MPU_PWR_MGMT_1, 0x01) != 0                          // clock PLL
+       || hust_imu_reg_write(imu, HUST_MPU_CONFIG, 0x01) != 0                           // DLPF -> sample 1 kHz
+       || hust_imu_reg_write(imu, HUST_MPU_SMPLRT_DIV, (uint8_t)(div - 1)) != 0
+       || hust_imu_reg_write(imu, HUST_MPU_ACCEL_CONFIG, 0x08) != 0                     // +-4 g
+       || hust_imu_reg_write(imu, HUST_MPU_FIFO_EN, 0x08) != 0                          // ACCEL vao FIFO
+       || hust_imu_reg_write(imu, HUST_MPU_INT_PIN_CFG, 0x00) != 0                      // xung 50 us, active high
+       || hust_imu_reg_write(imu, HUST_MPU_INT_ENABLE, 0x01) != 0)                      // RAW_RDY
+    {
+        return -1;
+    }
+    return hust_imu_fifo_reset(imu);
+}
+
+int hust_imu_init(hust_imu_t * imu, const hust_imu_io_t * io, uint16_t rate, uint8_t watermark)
+{
+    static const uint8_t probe_addr[] = {HUST_LSM6_ADDR, HUST_LSM6_ADDR + 1, HUST_MPU_ADDR, HUST_MPU_ADDR + 1};
+
+    if(watermark == 0 || watermark > HUST_IMU_MAX_WATERMARK)
+    {
+        return -1;
+    }
+    imu->io = *io;
+    imu->rate = rate;
+    imu->watermark = watermark;
+    imu->family = HUST_IMU_UNKNOWN;
+    for(unsigned i = 0; i < sizeof(probe_addr) && imu->family == HUST_IMU_UNKNOWN; i++)
+    {
+        imu->family = imu_probe(imu, probe_addr[i]);
+    }
+    switch(imu->family)
+    {
+        case HUST_IMU_LSM6: return lsm6_init(imu);
+        case HUST_IMU_MPU:  return mpu_init(imu);
+        default:            return -1;
+    }
+}
+
+int hust_imu_fifo_count(hust_imu_t * imu)
+{
+    uint8_t status[2];
+    if(imu->family == HUST_IMU_LSM6)
+    {
+        // FIFO_STATUS1/2: DIFF_FIFO (word 16 bit chua doc), bit 14 = tran
+        if(hust_imu_reg_read(imu, HUST_LSM6_FIFO_STATUS1, status, 2) != 0)
+        {
+            return -1;
+        }
+        return (((status[1] & 0x07) << 8) | status[0]) / 3;
+    }
+    // MPU: FIFO_COUNT (byte), big-endian
+    if(hust_imu_reg_read(imu, HUST_MPU_FIFO_COUNTH, status, 2) != 0)
+    {
+        return -1;
+    }
+    return (((status[0] & 0x1F) << 8) | status[1]) / HUST_IMU_SAMPLE_SIZE;
+}
+
+int hust_imu_fifo_read(hust_imu_t * imu, uint8_t * buffer, uint8_t n)
+{
+    // LSM6: dia chi quay ve FIFO_DATA_OUT_L sau moi word; MPU: FIFO_R_W khong tang dia chi
+    return hust_imu_reg_read(imu, imu->fifo_reg, buffer, (uint8_t)(n * HUST_IMU_SAMPLE_SIZE));
+}
+
+int hust_imu_fifo_reset(hust_imu_t * imu)
+{
+    uint8_t odr_mode = 0;
+    if(imu->family == HUST_IMU_LSM6)
+    {
+        // bypass (xoa FIFO) roi continuous, ODR_FIFO = ODR accel
+        for(unsigned i = 0; i < sizeof(lsm6_odr) / sizeof(lsm6_odr[0]); i++)
+        {
+            if(lsm6_odr[i].rate == imu->rate)
+            {
+                odr_mode = (uint8_t)(lsm6_odr[i].odr << 3);
+            }
+        }
+        if(hust_imu_reg_write(imu, HUST_LSM6_FIFO_CTRL5, 0x00) != 0)
+        {
+            return -1;
+        }
+        return hust_imu_reg_write(imu, HUST_LSM6_FIFO_CTRL5, (uint8_t)(odr_mode | 0x06));
+    }
+    if(hust_imu_reg_write(imu, HUST_MPU_USER_CTRL, 0x04) != 0)     // FIFO_RST
+    {
+        return -1;
+    }
+    return hust_imu_reg_write(imu, HUST_MPU_USER_CTRL, 0x40);      // FIFO_EN
+}
+
+void hust_imu_parse(const hust_imu_t * imu, const uint8_t * buffer, int n, int16_t * axis)
+{
+    // LSM6 little-endian, MPU big-endian
+    int hi = imu->family == HUST_IMU_LSM6 ? 1 : 0;
+    for(int i = 0; i < n * IMU_CHANNEL; i++)
+    {
+        axis[i] = (int16_t)((buffer[2 * i + hi] << 8) | buffer[2 * i + 1 - hi]);
+    }
+}
+
+int hust_imu_power(hust_imu_t * imu, bool on)
+{
+    if(imu->family == HUST_IMU_LSM6)
+    {
+        // ODR_XL = 0: power-down, giu full scale
+        int odr = on ? lsm6_odr_code(imu->rate) : 0;
+        if(odr < 0)
+        {
+            return -1;
+        }
+        return hust_imu_reg_write(imu, HUST_LSM6_CTRL1_XL, (uint8_t)((odr << 4) | 0x08));
+    }
+    if(imu->family == HUST_IMU_MPU)
+    {
+        // SLEEP, giu clock PLL; accel can ~30 ms sau khi thuc day
+        if(hust_imu_reg_write(imu, HUST_MPU_PWR_MGMT_1, on ? 0x01 : 0x41) != 0)
+        {
+            return -1;
+        }
+        if(on)
+        {
+            imu->io.delay_us(imu->io.p_context, 30000);
+        }
+        return 0;
+    }
+    return -1;
+}
@@ -0,0 +1,97 @@
+#ifndef HUST_IMU_H__
+#define HUST_IMU_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "hust_ble.h"
+
+/*
+ * Driver IMU dung FIFO noi cua cam bien (accel 3 truc, 16 bit), phan doc lap phan cung.
+ * Ho LSM6 (LSM6DS3/LSM6DSL, WHO_AM_I 0x69/0x6A): ngat FIFO threshold tren INT1.
+ * Ho MPU (MPU-6500/MPU-9250/ICM-20602, WHO_AM_I 0x70/0x71/0x12): khong co ngat watermark,
+ * INT bao moi sample, hust_imu_nrf dem xung INT bang PPI + TIMER de tao watermark.
+ *
+ * Moi lan doc: 1 giao dich I2C (ghi dia chi thanh ghi FIFO + doc watermark * 6 byte), thay cho
+ * watermark giao dich doc tung sample.
+ */
+
+#define HUST_IMU_SAMPLE_SIZE        6           // 3 truc x 16 bit
+#define HUST_IMU_MAX_WATERMARK      42          // RXD.MAXCNT 8 bit cua TWIM nRF52832: 42 * 6 = 252 byte
+
+// LSM6DS3 / LSM6DSL
+#define HUST_LSM6_ADDR              0x6A        // SDO/SA0 = 0, 0x6B neu = 1
+#define HUST_LSM6_FIFO_CTRL1        0x06
+#define HUST_LSM6_FIFO_CTRL3        0x08
+#define HUST_LSM6_FIFO_CTRL5        0x0A
+#define HUST_LSM6_INT1_CTRL         0x0D
+#define HUST_LSM6_WHO_AM_I          0x0F
+#define HUST_LSM6_CTRL1_XL          0x10
+#define HUST_LSM6_CTRL3_C           0x12
+#define HUST_LSM6_FIFO_STATUS1      0x3A
+#define HUST_LSM6_FIFO_DATA_OUT_L   0x3E
+
+// MPU-6500 / MPU-9250 / ICM-20602
+#define HUST_MPU_ADDR               0x68        // AD0 = 0, 0x69 neu = 1
+#define HUST_MPU_SMPLRT_DIV         0x19
+#define HUST_MPU_CONFIG             0x1A
+#define HUST_MPU_ACCEL_CONFIG       0x1C
+#define HUST_MPU_FIFO_EN            0x23
+#define HUST_MPU_INT_PIN_CFG        0x37
+#define HUST_MPU_INT_ENABLE         0x38
+#define HUST_MPU_USER_CTRL          0x6A
+#define HUST_MPU_PWR_MGMT_1         0x6B
+#define HUST_MPU_FIFO_COUNTH        0x72
+#define HUST_MPU_FIFO_R_W           0x74
+#define HUST_MPU_WHO_AM_I           0x75
+
+typedef enum
+{
+    HUST_IMU_UNKNOWN = 0,
+    HUST_IMU_LSM6,
+    HUST_IMU_MPU
+} hust_imu_family_t;
+
+typedef struct
+{
+    // 1 giao dich I2C: ghi tx_len byte roi (neu rx_len > 0) repeated start va doc rx_len byte
+    int (*xfer)(void * p_context, uint8_t addr, const uint8_t * tx, uint16_t tx_len, uint8_t * rx, uint16_t rx_len);
+    void (*delay_us)(void * p_context, uint32_t us);
+    void * p_context;
+} hust_imu_io_t;
+
+typedef struct
+{
+    hust_imu_io_t io;
+    hust_imu_family_t family;
+    uint8_t addr;                               // dia chi I2C 7 bit tim thay
+    uint8_t who_am_i;
+    uint8_t watermark;                          // so sample / lan doc FIFO
+    uint8_t fifo_reg;                           // thanh ghi doc FIFO (burst)
+    uint16_t rate;                              // Hz, rate thuc cua chip (MPU: 1000 / so nguyen)
+} hust_imu_t;
+
+// do tim chip tren 4 dia chi (LSM6 0x6A/0x6B, MPU 0x68/0x69), reset, cau hinh accel +-4 g o rate Hz
+// (LSM6: 26, 52, 104, 208, 416, 833; MPU: lam tron ve 1000 / n, rate thuc luu trong imu->rate), FIFO chi chua accel, ngat watermark
+// tra ve 0 neu thanh cong, -1 neu khong tim thay chip hoac tham so khong hop le
+int hust_imu_init(hust_imu_t * imu, const hust_imu_io_t * io, uint16_t rate, uint8_t watermark);
+
+int hust_imu_reg_read(hust_imu_t * imu, uint8_t reg, uint8_t * data, uint8_t n);
+int hust_imu_reg_write(hust_imu_t * imu, uint8_t reg, uint8_t value);
+
+// so sample dang nam trong FIFO (1 giao dich doc trang thai), -1 neu loi
+int hust_imu_fifo_count(hust_imu_t * imu);
+
+// doc n sample (n * HUST_IMU_SAMPLE_SIZE byte) trong 1 giao dich burst
+int hust_imu_fifo_read(hust_imu_t * imu, uint8_t * buffer, uint8_t n);
+
+// xoa FIFO (sau khi tran / khi start)
+int hust_imu_fifo_reset(hust_imu_t * imu);
+
+// tat (LSM6 power-down, MPU sleep) / bat lai accel, cau hinh giu nguyen. Bat lai roi xoa FIFO truoc khi doc
+int hust_imu_power(hust_imu_t * imu, bool on);
+
+// chuyen n sample tho tu FIFO (thu tu byte cua chip) sang int16 [n][IMU_CHANNEL] (x, y, z)
+void hust_imu_parse(const hust_imu_t * imu, const uint8_t * buffer, int n, int16_t * axis);
+
+#endif // HUST_IMU_H__
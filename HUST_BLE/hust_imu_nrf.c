@@ -0,0 +1,255 @@
+#include "hust_imu_nrf.h"
+#include "nrfx_twim.h"
+#include "nrfx_gpiote.h"
+#include "nrfx_timer.h"
+#include "nrfx_ppi.h"
+#include "nrf_gpio.h"
+#include "nrf_delay.h"
+#include "app_timer.h"
+#include "app_error.h"
+
+static const nrfx_twim_t imu_twim = NRFX_TWIM_INSTANCE(1);
+static const nrfx_timer_t imu_timer = NRFX_TIMER_INSTANCE(3);
+static nrf_ppi_channel_t imu_ppi_int;           // MPU INT -> TIMER3 COUNT
+static uint8_t imu_fifo_reg;
+static uint8_t imu_raw[HUST_IMU_MAX_WATERMARK * HUST_IMU_SAMPLE_SIZE];
+static int16_t imu_axis[HUST_IMU_MAX_WATERMARK * IMU_CHANNEL];
+static hust_imu_t * imu_dev;
+static hust_imu_nrf_handler_t imu_handler;
+static uint64_t imu_next_index;
+static uint32_t imu_overruns;
+static volatile bool imu_streaming;
+static volatile bool imu_xfer_done;
+static volatile bool imu_xfer_ok;
+static bool imu_busy;                           // dang co burst
+static uint8_t imu_pending;                     // ngat watermark cho burst
+static uint32_t imu_t_last[2];                  // tick cua burst dang doc / dang cho
+
+static void imu_burst_start(void)
+{
+    nrfx_twim_xfer_desc_t desc = NRFX_TWIM_XFER_DESC_TXRX(imu_dev->addr, &imu_fifo_reg, 1, imu_raw,
+                                                          imu_dev->watermark * HUST_IMU_SAMPLE_SIZE);
+    imu_busy = true;
+    if(nrfx_twim_xfer(&imu_twim, &desc, 0) != NRFX_SUCCESS)
+    {
+        imu_busy = false;
+    }
+}
+
+// 1 lan FIFO dat watermark (goi trong ngat GPIOTE / TIMER3, cung muc uu tien voi TWIM)
+static void imu_watermark(void)
+{
+    uint32_t now = app_timer_cnt_get();
+    if(!imu_streaming)
+    {
+        return;
+    }
+    if(imu_busy)
+    {
+        imu_overruns++;
+        imu_pending++;
+        imu_t_last[1] = now;
+        return;
+    }
+    imu_t_last[0] = now;
+    imu_burst_start();
+}
+
+static void imu_twim_handler(nrfx_twim_evt_t const * p_event, void * p_context)
+{
+    (void)p_context;
+    if(!imu_streaming)
+    {
+        imu_xfer_ok = p_event->type == NRFX_TWIM_EVT_DONE;
+        imu_xfer_done = true;
+        return;
+    }
+    imu_busy = false;
+    if(p_event->type == NRFX_TWIM_EVT_DONE)
+    {
+        uint64_t first_index = imu_next_index;
+        imu_next_index += imu_dev->watermark;
+        hust_imu_parse(imu_dev, imu_raw, imu_dev->watermark, imu_axis);
+        imu_handler(imu_axis, imu_dev->watermark, first_index, imu_t_last[0]);
+    }
+    if(imu_pending > 0)
+    {
+        imu_pending--;
+        imu_t_last[0] = imu_t_last[1];
+        imu_burst_start();
+    }
+    else if(imu_dev->family == HUST_IMU_LSM6 && nrf_gpio_pin_read(HUST_IMU_PIN_INT))
+    {
+        // INT1 van cao: FIFO con >= watermark (canh len bi bo qua trong luc burst)
+        imu_t_last[0] = app_timer_cnt_get();
+        imu_burst_start();
+    }
+}
+
+// doc/ghi thanh ghi, chi dung khi chua stream
+static int imu_xfer(void * p_context, uint8_t addr, const uint8_t * tx, uint16_t tx_len, uint8_t * rx, uint16_t rx_len)
+{
+    nrfx_twim_xfer_desc_t desc = NRFX_TWIM_XFER_DESC_TXRX(addr, (uint8_t *)tx, tx_len, rx, rx_len);
+    (void)p_context;
+
+    if(rx_len == 0)
+    {
+        desc.type = NRFX_TWIM_XFER_TX;
+    }
+    imu_xfer_done = false;
+    if(nrfx_twim_xfer(&imu_twim, &desc, 0) != NRFX_SUCCESS)
+    {
+        return -1;
+    }
+    while(!imu_xfer_done)
+    {
+    }
+    return imu_xfer_ok ? 0 : -1;
+}
+
+static void imu_delay_us(void * p_context, uint32_t us)
+{
+    (void)p_context;
+    nrf_delay_us(us);
+}
+
+static void imu_int_handler(nrfx_gpiote_pin_t pin, nrf_gpiote_polarity_t action)
+{
+    (void)pin;
+    (void)action;
+    imu_watermark();
+}
+
+// TIMER3 COMPARE0: da dem du watermark xung data ready cua MPU (bo dem tu xoa ve 0)
+static void imu_timer_handler(nrf_timer_event_t event_type, void * p_context)
+{
+    (void)p_context;
+    if(event_type == NRF_TIMER_EVENT_COMPARE0)
+    {
+        imu_watermark();
+    }
+}
+
+ret_code_t hust_imu_nrf_init(hust_imu_t * imu, uint16_t rate, hust_imu_nrf_handler_t handler)
+{
+    ret_code_t err_code;
+
+    imu_dev = imu;
+    imu_handler = handler;
+    imu_streaming = false;
+
+    nrfx_twim_config_t twim_config = NRFX_TWIM_DEFAULT_CONFIG;
+    twim_config.scl = HUST_IMU_PIN_SCL;
+    twim_config.sda = HUST_IMU_PIN_SDA;
+    twim_config.frequency = NRF_TWIM_FREQ_400K;
+    err_code = nrfx_twim_init(&imu_twim, &twim_config, imu_twim_handler, NULL);
+    if(err_code != NRFX_SUCCESS)
+    {
+        return err_code;
+    }
+    nrfx_twim_enable(&imu_twim);
+
+    hust_imu_io_t io = {
+        .xfer = imu_xfer,
+        .delay_us = imu_delay_us,
+        .p_context = NULL
+    };
+    if(hust_imu_init(imu, &io, rate, HUST_IMU_WATERMARK) != 0
+       || hust_imu_power(imu, false) != 0)                     // accel tat den hust_imu_nrf_start
+    {
+        return NRF_ERROR_NOT_FOUND;
+    }
+    imu_fifo_reg = imu->fifo_reg;
+
+    if(!nrfx_gpiote_is_init())
+    {
+        err_code = nrfx_gpiote_init();
+        if(err_code != NRFX_SUCCESS)
+        {
+            return err_code;
+        }
+    }
+    nrfx_gpiote_in_config_t int_config = NRFX_GPIOTE_CONFIG_IN_SENSE_LOTOHI(true);
+    if(imu->family == HUST_IMU_LSM6)
+    {
+        // INT1 la muc (FIFO >= threshold): ngat o canh len
+        return nrfx_gpiote_in_init(HUST_IMU_PIN_INT, &int_config, imu_int_handler);
+    }
+
+    // MPU: xung data ready chi dem bang PPI, khong ngat
+    err_code = nrfx_gpiote_in_init(HUST_IMU_PIN_INT, &int_config, NULL);
+    if(err_code != NRFX_SUCCESS)
+    {
+        return err_code;
+    }
+    nrfx_timer_config_t timer_config = NRFX_TIMER_DEFAULT_CONFIG;
+    timer_config.mode = NRF_TIMER_MODE_COUNTER;
+    timer_config.bit_width = NRF_TIMER_BIT_WIDTH_16;
+    err_code = nrfx_timer_init(&imu_timer, &timer_config, imu_timer_handler);
+    if(err_code != NRFX_SUCCESS)
+    {
+        return err_code;
+    }
+    nrfx_timer_extended_compare(&imu_timer, NRF_TIMER_CC_CHANNEL0, imu->watermark,
+                                NRF_TIMER_SHORT_COMPARE0_CLEAR_MASK, true);
+    err_code = nrfx_ppi_channel_alloc(&imu_ppi_int);
+    if(err_code != NRFX_SUCCESS)
+    {
+        return err_code;
+    }
+    return nrfx_ppi_channel_assign(imu_ppi_int,
+                                   nrfx_gpiote_in_event_addr_get(HUST_IMU_PIN_INT),
+                                   nrfx_timer_task_address_get(&imu_timer, NRF_TIMER_TASK_COUNT));
+}
+
+ret_code_t hust_imu_nrf_start(void)
+{
+    ret_code_t err_code;
+
+    imu_next_index = 0;
+    imu_overruns = 0;
+    imu_pending = 0;
+    imu_busy = false;
+    if(hust_imu_power(imu_dev, true) != 0 || hust_imu_fifo_reset(imu_dev) != 0)
+    {
+        return NRF_ERROR_INTERNAL;
+    }
+    imu_streaming = true;
+    if(imu_dev->family == HUST_IMU_MPU)
+    {
+        nrfx_timer_clear(&imu_timer);
+        nrfx_timer_enable(&imu_timer);
+        err_code = nrfx_ppi_channel_enable(imu_ppi_int);
+        if(err_code != NRFX_SUCCESS)
+        {
+            return err_code;
+        }
+        nrfx_gpiote_in_event_enable(HUST_IMU_PIN_INT, false);
+    }
+    else
+    {
+        nrfx_gpiote_in_event_enable(HUST_IMU_PIN_INT, true);
+    }
+    return NRF_SUCCESS;
+}
+
+void hust_imu_nrf_stop(void)
+{
+    nrfx_gpiote_in_event_disable(HUST_IMU_PIN_INT);
+    if(imu_dev->family == HUST_IMU_MPU)
+    {
+        (void)nrfx_ppi_channel_disable(imu_ppi_int);
+        nrfx_timer_disable(&imu_timer);
+    }
+    // cho burst dang chay xong truoc khi dung lai TWIM cho giao dich cau hinh
+    while(imu_busy)
+    {
+    }
+    imu_streaming = false;
+    (void)hust_imu_power(imu_dev, false);
+}
+
+uint32_t hust_imu_nrf_overruns(void)
+{
+    return imu_overruns;
+}
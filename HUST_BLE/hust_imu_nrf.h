@@ -0,0 +1,42 @@
+#ifndef HUST_IMU_NRF_H__
+#define HUST_IMU_NRF_H__
+
+#include <stdint.h>
+
+#include "sdk_errors.h"
+#include "hust_imu.h"
+
+// IMU tren nRF52: TWIM1 400 kHz, doc FIFO bang 1 giao dich EasyDMA (watermark * 6 byte) moi lan
+// FIFO dat watermark. CPU chi bi ngat 1 lan / watermark sample + 1 lan khi DMA xong.
+//   LSM6: INT1 (FIFO threshold) --GPIOTE ngat--> burst
+//   MPU : INT (data ready, 1 xung / sample) --GPIOTE/PPI--> TIMER3 COUNT, COMPARE0 = watermark --> burst
+
+#define HUST_IMU_WATERMARK          16          // sample / lan doc FIFO (<= HUST_IMU_MAX_WATERMARK)
+
+#ifndef HUST_IMU_PIN_SCL
+#define HUST_IMU_PIN_SCL            11
+#endif
+#ifndef HUST_IMU_PIN_SDA
+#define HUST_IMU_PIN_SDA            12
+#endif
+#ifndef HUST_IMU_PIN_INT
+#define HUST_IMU_PIN_INT            16
+#endif
+
+// goi trong ngat TWIM khi doc xong 1 burst: n sample [n][IMU_CHANNEL] (x, y, z),
+// first_index = chi so sample cua sample dau tien, t_last = tick RTC (app_timer) luc ngat watermark,
+// tuc luc lay mau sample cuoi cung (sample i lay mau truoc do (n - 1 - i) / rate giay)
+typedef void (*hust_imu_nrf_handler_t)(const int16_t * axis, uint8_t n, uint64_t first_index, uint32_t t_last);
+
+// cau hinh TWIM1/GPIOTE (va PPI/TIMER3 voi MPU) va chip (hust_imu_init), ket qua luu vao imu
+ret_code_t hust_imu_nrf_init(hust_imu_t * imu, uint16_t rate, hust_imu_nrf_handler_t handler);
+
+// accel tat khi khong stream: start bat lai va xoa FIFO, stop tat
+ret_code_t hust_imu_nrf_start(void);
+void hust_imu_nrf_stop(void);
+
+// so lan ngat watermark den khi burst truoc chua xong (burst duoc noi tiep, khong mat sample
+// tru khi FIFO cua chip tran)
+uint32_t hust_imu_nrf_overruns(void);
+
+#endif // HUST_IMU_NRF_H__
@@ -0,0 +1,298 @@
+#include <string.h>
+
+#include "hust_l2cap.h"
+
+#define L2CAP_SDU_HEADER    2       // do dai SDU trong K-frame dau
+
+void hust_l2cap_tx_init(hust_l2cap_tx_t * tx, uint16_t sdu_max)
+{
+    tx->sdu_max = sdu_max < HUST_L2CAP_SDU_MAX ? sdu_max : HUST_L2CAP_SDU_MAX;
+    tx->closed = 0;
+    tx->submitted = 0;
+    tx->completed = 0;
+    tx->packets = 0;
+    memset(tx->length, 0, sizeof(tx->length));
+}
+
+int hust_l2cap_tx_append(hust_l2cap_tx_t * tx, const uint8_t * packet, uint16_t length)
+{
+    if(length + HUST_L2CAP_LENGTH_SIZE > tx->sdu_max)
+    {
+        return -2;
+    }
+    uint32_t fill = tx->closed % HUST_L2CAP_SDU_QUEUE;
+    if(tx->length[fill] + HUST_L2CAP_LENGTH_SIZE + length > tx->sdu_max)
+    {
+        // SDU dang gom day: dong lai neu con buffer trong de gom tiep
+        if(tx->closed + 1 - tx->completed >= HUST_L2CAP_SDU_QUEUE)
+        {
+            return -1;
+        }
+        tx->closed++;
+        fill = tx->closed % HUST_L2CAP_SDU_QUEUE;
+        tx->length[fill] = 0;
+    }
+    uint8_t * p = tx->sdu[fill] + tx->length[fill];
+    p[0] = (uint8_t)length;
+    p[1] = (uint8_t)(length >> 8);
+    memcpy(p + HUST_L2CAP_LENGTH_SIZE, packet, length);
+    tx->length[fill] += HUST_L2CAP_LENGTH_SIZE + length;
+    tx->packets++;
+    return 0;
+}
+
+const uint8_t * hust_l2cap_tx_next(hust_l2cap_tx_t * tx, uint16_t * p_length)
+{
+    if(tx->closed == tx->submitted)
+    {
+        uint32_t fill = tx->closed % HUST_L2CAP_SDU_QUEUE;
+        if(tx->length[fill] == 0 || tx->submitted != tx->completed)
+        {
+            return NULL;                // chua co gi, hoac link dang ban: gom tiep
+        }
+        tx->closed++;
+        tx->length[tx->closed % HUST_L2CAP_SDU_QUEUE] = 0;
+    }
+    uint32_t next = tx->submitted % HUST_L2CAP_SDU_QUEUE;
+    *p_length = tx->length[next];
+    return tx->sdu[next];
+}
+
+void hust_l2cap_tx_submitted(hust_l2cap_tx_t * tx)
+{
+    if(tx->submitted != tx->closed)
+    {
+        tx->submitted++;
+    }
+}
+
+void hust_l2cap_tx_completed(hust_l2cap_tx_t * tx)
+{
+    if(tx->completed != tx->submitted)
+    {
+        tx->completed++;
+    }
+}
+
+uint32_t hust_l2cap_tx_inflight(const hust_l2cap_tx_t * tx)
+{
+    return tx->submitted - tx->completed;
+}
+
+uint16_t hust_l2cap_kframes(uint16_t length, uint16_t mps)
+{
+    return (uint16_t)((length + L2CAP_SDU_HEADER + mps - 1) / mps);
+}
+
+int hust_l2cap_sdu_next(const uint8_t * sdu, uint16_t length, uint16_t * p_offset, const uint8_t ** p_packet)
+{
+    uint16_t offset = *p_offset;
+    if(offset >= length)
+    {
+        return 0;
+    }
+    if(offset + HUST_L2CAP_LENGTH_SIZE > length)
+    {
+        return -1;
+    }
+    uint16_t packet_length = (uint16_t)(sdu[offset] | (sdu[offset + 1] << 8));
+    if(packet_length == 0 || offset + HUST_L2CAP_LENGTH_SIZE + packet_length > length)
+    {
+        return -1;
+    }
+    *p_packet = sdu + offset + HUST_L2CAP_LENGTH_SIZE;
+    *p_offset = (uint16_t)(offset + HUST_L2CAP_LENGTH_SIZE + packet_length);
+    return packet_length;
+}
+
+#ifndef HUST_HOST_BUILD
+static void channel_reset(hust_l2cap_t * l2cap)
+{
+    l2cap->local_cid = BLE_L2CAP_CID_INVALID;
+    l2cap->tx_mps = BLE_L2CAP_MPS_MIN;
+    l2cap->credits = 0;
+    hust_l2cap_tx_init(&l2cap->tx, HUST_L2CAP_SDU_MAX);
+}
+
+void hust_l2cap_init(hust_l2cap_t * l2cap)
+{
+    l2cap->conn_handle = BLE_CONN_HANDLE_INVALID;
+    l2cap->credits_received = 0;
+    l2cap->credit_stalls = 0;
+    channel_reset(l2cap);
+}
+
+uint32_t hust_l2cap_conn_cfg_set(uint8_t conn_cfg_tag, uint32_t ram_start)
+{
+    ble_cfg_t ble_cfg;
+
+    memset(&ble_cfg, 0, sizeof(ble_cfg));
+    ble_cfg.conn_cfg.conn_cfg_tag                        = conn_cfg_tag;
+    ble_cfg.conn_cfg.params.l2cap_conn_cfg.rx_mps        = BLE_L2CAP_MPS_MIN;
+    ble_cfg.conn_cfg.params.l2cap_conn_cfg.tx_mps        = HUST_L2CAP_MPS;
+    ble_cfg.conn_cfg.params.l2cap_conn_cfg.rx_queue_size = 1;
+    ble_cfg.conn_cfg.params.l2cap_conn_cfg.tx_queue_size = HUST_L2CAP_SDU_QUEUE - 1;
+    ble_cfg.conn_cfg.params.l2cap_conn_cfg.ch_count      = 1;
+    return sd_ble_cfg_set(BLE_CONN_CFG_L2CAP, &ble_cfg, ram_start);
+}
+
+// tham so phat cua central (MTU, MPS, credit ban dau)
+static void tx_params_set(hust_l2cap_t * l2cap, ble_l2cap_ch_tx_params_t const * p_params)
+{
+    hust_l2cap_tx_init(&l2cap->tx, p_params->tx_mtu);
+    l2cap->tx_mps = p_params->tx_mps;
+    l2cap->credits = p_params->credits;
+}
+
+static void on_ch_setup_request(hust_l2cap_t * l2cap, ble_l2cap_evt_t const * p_evt)
+{
+    ble_l2cap_ch_setup_params_t params;
+    uint16_t local_cid = p_evt->local_cid;
+
+    memset(&params, 0, sizeof(params));
+    if(p_evt->params.ch_setup_request.le_psm != HUST_L2CAP_PSM)
+    {
+        params.status = BLE_L2CAP_CH_STATUS_CODE_LE_PSM_NOT_SUPPORTED;
+    }
+    else if(l2cap->local_cid != BLE_L2CAP_CID_INVALID)
+    {
+        params.status = BLE_L2CAP_CH_STATUS_CODE_NO_RESOURCES;      // 1 kenh / ket noi
+    }
+    else
+    {
+        params.status = BLE_L2CAP_CH_STATUS_CODE_SUCCESS;
+        params.rx_params.rx_mtu = HUST_L2CAP_RX_MTU;
+        params.rx_params.rx_mps = BLE_L2CAP_MPS_MIN;
+        params.rx_params.sdu_buf.p_data = l2cap->rx_buf;
+        params.rx_params.sdu_buf.len = sizeof(l2cap->rx_buf);
+    }
+    if(sd_ble_l2cap_ch_setup(p_evt->conn_handle, &local_cid, &params) == NRF_SUCCESS
+       && params.status == BLE_L2CAP_CH_STATUS_CODE_SUCCESS)
+    {
+        tx_params_set(l2cap, &p_evt->params.ch_setup_request.tx_params);
+        l2cap->conn_handle = p_evt->conn_handle;
+        l2cap->local_cid = local_cid;   // vong lap main bat dau gom packet
+    }
+}
+
+// event cua kenh dang mo (local_cid chi duy nhat trong 1 ket noi)
+static bool channel_evt(const hust_l2cap_t * l2cap, ble_l2cap_evt_t const * p_evt)
+{
+    return p_evt->conn_handle == l2cap->conn_handle && p_evt->local_cid == l2cap->local_cid;
+}
+
+void hust_l2cap_on_ble_evt(ble_evt_t const * p_ble_evt, void * p_context)
+{
+    hust_l2cap_t * l2cap = (hust_l2cap_t *)p_context;
+    ble_l2cap_evt_t const * p_evt = &p_ble_evt->evt.l2cap_evt;
+
+    switch(p_ble_evt->header.evt_id)
+    {
+        case BLE_GAP_EVT_DISCONNECTED:
+            if(p_ble_evt->evt.gap_evt.conn_handle == l2cap->conn_handle)
+            {
+                l2cap->conn_handle = BLE_CONN_HANDLE_INVALID;
+                channel_reset(l2cap);
+            }
+            break;
+
+        case BLE_L2CAP_EVT_CH_SETUP_REQUEST:
+            on_ch_setup_request(l2cap, p_evt);
+            break;
+
+        case BLE_L2CAP_EVT_CH_SETUP:
+            if(channel_evt(l2cap, p_evt))
+            {
+                tx_params_set(l2cap, &p_evt->params.ch_setup.tx_params);
+            }
+            break;
+
+        case BLE_L2CAP_EVT_CH_RELEASED:
+            if(channel_evt(l2cap, p_evt))
+            {
+                l2cap->conn_handle = BLE_CONN_HANDLE_INVALID;
+                channel_reset(l2cap);   // packet dang gom bi bo, stream quay ve notification
+            }
+            break;
+
+        case BLE_L2CAP_EVT_CH_TX:
+            if(channel_evt(l2cap, p_evt))
+            {
+                hust_l2cap_tx_completed(&l2cap->tx);
+            }
+            break;
+
+        case BLE_L2CAP_EVT_CH_CREDIT:
+            if(channel_evt(l2cap, p_evt))
+            {
+                l2cap->credits += p_evt->params.credit.credits;
+                l2cap->credits_received += p_evt->params.credit.credits;
+            }
+            break;
+
+        case BLE_L2CAP_EVT_CH_RX:
+            if(channel_evt(l2cap, p_evt))
+            {
+                // khong dung du lieu central gui, tra buffer cho SoftDevice nhan tiep
+                ble_data_t sdu_buf = {.p_data = l2cap->rx_buf, .len = sizeof(l2cap->rx_buf)};
+                (void)sd_ble_l2cap_ch_rx(p_evt->conn_handle, p_evt->local_cid, &sdu_buf);
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+bool hust_l2cap_open(const hust_l2cap_t * l2cap)
+{
+    return l2cap->local_cid != BLE_L2CAP_CID_INVALID;
+}
+
+uint32_t hust_l2cap_poll(hust_l2cap_t * l2cap)
+{
+    const uint8_t * sdu;
+    uint16_t length;
+
+    if(l2cap->local_cid == BLE_L2CAP_CID_INVALID)
+    {
+        return NRF_ERROR_INVALID_STATE;
+    }
+    while((sdu = hust_l2cap_tx_next(&l2cap->tx, &length)) != NULL)
+    {
+        ble_data_t sdu_buf = {.p_data = (uint8_t *)sdu, .len = length};
+        uint32_t err_code = sd_ble_l2cap_ch_tx(l2cap->conn_handle, l2cap->local_cid, &sdu_buf);
+        if(err_code != NRF_SUCCESS)
+        {
+            return err_code == NRF_ERROR_RESOURCES ? NRF_SUCCESS : err_code;
+        }
+        hust_l2cap_tx_submitted(&l2cap->tx);
+        uint16_t kframes = hust_l2cap_kframes(length, l2cap->tx_mps);
+        if(l2cap->credits < kframes)
+        {
+            l2cap->credit_stalls++;     // SoftDevice giu SDU toi khi central cap them credit
+        }
+        l2cap->credits -= kframes;
+    }
+    return NRF_SUCCESS;
+}
+
+uint32_t hust_l2cap_send(hust_l2cap_t * l2cap, const uint8_t * packet, uint16_t length)
+{
+    if(l2cap->local_cid == BLE_L2CAP_CID_INVALID)
+    {
+        return NRF_ERROR_INVALID_STATE;
+    }
+    switch(hust_l2cap_tx_append(&l2cap->tx, packet, length))
+    {
+        case -1:
+            return NRF_ERROR_RESOURCES;
+        case -2:
+            return NRF_ERROR_DATA_SIZE;
+        default:
+            break;
+    }
+    (void)hust_l2cap_poll(l2cap);       // packet da nam trong SDU, loi giao SDU de vong lap main thu lai
+    return NRF_SUCCESS;
+}
+#endif
@@ -0,0 +1,114 @@
+#ifndef HUST_L2CAP_H__
+#define HUST_L2CAP_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Stream qua kenh L2CAP CoC (LE credit based) thay notification. Central mo kenh toi PSM
+ * HUST_L2CAP_PSM sau khi ket noi; central khong mo kenh (khong ho tro CoC) thi stream van di
+ * service bio / NUS nhu cu.
+ *
+ * SDU (toi da HUST_L2CAP_SDU_MAX byte, khong qua MTU kenh cua central) gom nhieu ble packet nguyen
+ * ven (convert_data_to_ble_packet, ca trailer latency), moi packet co do dai dung truoc:
+ *
+ *   length (2, little-endian) | ble packet (length) | length | ble packet | ...
+ *
+ * SoftDevice chia SDU thanh K-frame toi da MPS byte, moi K-frame ton 1 credit central cap; het credit
+ * thi SDU nam trong hang doi TX cua SoftDevice cho BLE_L2CAP_EVT_CH_CREDIT. Buffer SDU thuoc app
+ * den BLE_L2CAP_EVT_CH_TX.
+ *
+ * Gom packet: SDU dang gom duoc giao SoftDevice ngay khi khong con SDU nao dang phat (link ranh: do
+ * tre nhu notification), nguoc lai gom tiep den khi day (link ban: SDU lon, it header va it lan goi
+ * SoftDevice hon 1 notification / packet).
+ *
+ * Chi 1 kenh cho ca thiet bi: central dau tien mo kenh giu no den khi dong kenh / ngat, central khac
+ * mo kenh thi bi tu choi (BLE_L2CAP_CH_STATUS_CODE_NO_RESOURCES) va stream qua notification.
+ */
+
+#define HUST_L2CAP_PSM              0x0080  // LE PSM dong dau tien
+#define HUST_L2CAP_SDU_MAX          2048
+#define HUST_L2CAP_SDU_QUEUE        3       // buffer SDU: toi da (QUEUE - 1) dang phat, 1 dang gom
+#define HUST_L2CAP_LENGTH_SIZE      2       // do dai truoc moi packet
+#define HUST_L2CAP_MPS              247     // K-frame + header L2CAP (4) = 1 PDU data length 251
+
+// SDU dang gom / dang phat, vong lap main ghi, completed do ngat BLE tang
+typedef struct
+{
+    uint8_t sdu[HUST_L2CAP_SDU_QUEUE][HUST_L2CAP_SDU_MAX];
+    uint16_t length[HUST_L2CAP_SDU_QUEUE];
+    uint16_t sdu_max;                   // min(HUST_L2CAP_SDU_MAX, MTU kenh cua central)
+    uint32_t closed;                    // so SDU da gom xong, buffer [closed % QUEUE] dang gom
+    uint32_t submitted;                 // so SDU da giao SoftDevice
+    volatile uint32_t completed;        // so SDU SoftDevice da phat xong
+    uint32_t packets;                   // so ble packet da gom
+} hust_l2cap_tx_t;
+
+void hust_l2cap_tx_init(hust_l2cap_tx_t * tx, uint16_t sdu_max);
+
+// them 1 ble packet vao SDU dang gom. Tra ve 0, -1 neu het buffer (cho SDU phat xong), -2 neu packet
+// khong vua 1 SDU
+int hust_l2cap_tx_append(hust_l2cap_tx_t * tx, const uint8_t * packet, uint16_t length);
+
+// SDU tiep theo can giao SoftDevice, NULL neu khong co. SDU dang gom chi dong khi khong con SDU nao
+// dang phat. Goi hust_l2cap_tx_submitted khi SoftDevice nhan
+const uint8_t * hust_l2cap_tx_next(hust_l2cap_tx_t * tx, uint16_t * p_length);
+void hust_l2cap_tx_submitted(hust_l2cap_tx_t * tx);
+
+// SDU cu nhat da phat xong (BLE_L2CAP_EVT_CH_TX)
+void hust_l2cap_tx_completed(hust_l2cap_tx_t * tx);
+
+// SDU da giao SoftDevice chua phat xong
+uint32_t hust_l2cap_tx_inflight(const hust_l2cap_tx_t * tx);
+
+// so K-frame (credit) cua 1 SDU length byte voi MPS mps
+uint16_t hust_l2cap_kframes(uint16_t length, uint16_t mps);
+
+// tach packet tu SDU nhan duoc, bat dau voi *p_offset = 0. Tra ve do dai packet, 0 khi het SDU,
+// -1 neu SDU sai
+int hust_l2cap_sdu_next(const uint8_t * sdu, uint16_t length, uint16_t * p_offset, const uint8_t ** p_packet);
+
+#ifndef HUST_HOST_BUILD
+#include "ble.h"
+#include "nrf_sdh_ble.h"
+
+#define HUST_L2CAP_BLE_OBSERVER_PRIO    2
+#define HUST_L2CAP_RX_MTU               BLE_L2CAP_MTU_MIN   // central khong gui gi qua kenh
+
+#define HUST_L2CAP_DEF(_name)                                                   \
+static hust_l2cap_t _name;                                                      \
+NRF_SDH_BLE_OBSERVER(_name ## _obs,                                             \
+                     HUST_L2CAP_BLE_OBSERVER_PRIO,                              \
+                     hust_l2cap_on_ble_evt, &_name)
+
+typedef struct
+{
+    hust_l2cap_tx_t tx;
+    uint16_t conn_handle;               // central dang giu kenh
+    uint16_t local_cid;                 // BLE_L2CAP_CID_INVALID khi chua co kenh
+    uint16_t tx_mps;                    // K-frame toi da ve phia central
+    int32_t credits;                    // credit con lai (uoc luong, tru khi giao SDU)
+    uint32_t credits_received;
+    uint32_t credit_stalls;             // SDU giao SoftDevice khi credit khong du
+    uint8_t rx_buf[HUST_L2CAP_RX_MTU];
+} hust_l2cap_t;
+
+void hust_l2cap_init(hust_l2cap_t * l2cap);
+
+void hust_l2cap_on_ble_evt(ble_evt_t const * p_ble_evt, void * p_context);
+
+// dat cau hinh L2CAP cua SoftDevice (1 kenh, hang doi TX = SDU co the dang phat), truoc sd_ble_enable
+uint32_t hust_l2cap_conn_cfg_set(uint8_t conn_cfg_tag, uint32_t ram_start);
+
+// kenh da mo: stream di L2CAP
+bool hust_l2cap_open(const hust_l2cap_t * l2cap);
+
+// gom 1 ble packet, giao SDU neu link ranh. NRF_ERROR_INVALID_STATE neu chua co kenh,
+// NRF_ERROR_RESOURCES neu het buffer SDU, NRF_ERROR_DATA_SIZE neu packet khong vua SDU
+uint32_t hust_l2cap_send(hust_l2cap_t * l2cap, const uint8_t * packet, uint16_t length);
+
+// giao SDU da gom cho SoftDevice, goi moi vong lap main
+uint32_t hust_l2cap_poll(hust_l2cap_t * l2cap);
+#endif
+
+#endif // HUST_L2CAP_H__
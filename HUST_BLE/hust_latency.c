@@ -0,0 +1,121 @@
+#include <string.h>
+
+#include "hust_latency.h"
+
+static uint16_t tick_delta(uint32_t from, uint32_t to)
+{
+    uint32_t d = (to - from) & HUST_LATENCY_TICK_MASK;
+    return d < HUST_LATENCY_INVALID ? (uint16_t)d : HUST_LATENCY_INVALID - 1;
+}
+
+static void put_u16(uint8_t * p, uint16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static uint16_t get_u16(const uint8_t * p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+void hust_latency_trailer_encode(const hust_latency_trailer_t * trailer, uint8_t * out)
+{
+    out[0] = HUST_LATENCY_TRAILER_MAGIC;
+    out[1] = (uint8_t)trailer->t_first;
+    out[2] = (uint8_t)(trailer->t_first >> 8);
+    out[3] = (uint8_t)(trailer->t_first >> 16);
+    out[4] = (uint8_t)(trailer->t_first >> 24);
+    put_u16(out + 5, trailer->d_last);
+    put_u16(out + 7, trailer->d_packed);
+    put_u16(out + 9, trailer->d_send);
+    out[11] = trailer->prev_count;
+    put_u16(out + 12, trailer->prev_d_radio);
+    put_u16(out + 14, trailer->prev_d_txc);
+}
+
+int hust_latency_trailer_decode(const uint8_t * in, int length, hust_latency_trailer_t * trailer)
+{
+    if(length < HUST_LATENCY_TRAILER_SIZE || in[0] != HUST_LATENCY_TRAILER_MAGIC)
+    {
+        return -1;
+    }
+    trailer->t_first = (uint32_t)in[1] | ((uint32_t)in[2] << 8) | ((uint32_t)in[3] << 16) | ((uint32_t)in[4] << 24);
+    trailer->d_last = get_u16(in + 5);
+    trailer->d_packed = get_u16(in + 7);
+    trailer->d_send = get_u16(in + 9);
+    trailer->prev_count = in[11];
+    trailer->prev_d_radio = get_u16(in + 12);
+    trailer->prev_d_txc = get_u16(in + 14);
+    return 0;
+}
+
+void hust_latency_reset(hust_latency_t * latency)
+{
+    latency->inflight_head = 0;
+    latency->inflight_count = 0;
+    latency->prev_valid = false;
+}
+
+void hust_latency_first_sample(hust_latency_t * latency, uint32_t now)
+{
+    latency->t_first = now;
+}
+
+void hust_latency_last_sample(hust_latency_t * latency, uint32_t now)
+{
+    latency->t_last = now;
+}
+
+void hust_latency_packed(hust_latency_t * latency, uint32_t now)
+{
+    latency->t_packed = now;
+}
+
+void hust_latency_radio_active(hust_latency_t * latency, uint32_t now)
+{
+    latency->t_radio = now;
+}
+
+void hust_latency_sent(hust_latency_t * latency, uint8_t count, uint32_t t_send)
+{
+    if(latency->inflight_count == HUST_LATENCY_INFLIGHT)
+    {
+        // hang doi day hon du kien: bo packet cu nhat
+        latency->inflight_head = (latency->inflight_head + 1) % HUST_LATENCY_INFLIGHT;
+        latency->inflight_count--;
+    }
+    uint8_t tail = (latency->inflight_head + latency->inflight_count) % HUST_LATENCY_INFLIGHT;
+    latency->inflight[tail].count = count;
+    latency->inflight[tail].t_send = t_send;
+    latency->inflight_count++;
+}
+
+void hust_latency_tx_complete(hust_latency_t * latency, uint8_t n_complete, uint32_t now)
+{
+    // HVN TX complete theo thu tu gui; chi giu lai packet cuoi cung de gui trong trailer tiep theo
+    while(n_complete > 0 && latency->inflight_count > 0)
+    {
+        hust_latency_inflight_t * p = &latency->inflight[latency->inflight_head];
+        uint32_t t_radio = ((latency->t_radio - p->t_send) & HUST_LATENCY_TICK_MASK) < ((now - p->t_send) & HUST_LATENCY_TICK_MASK) ?
+                           latency->t_radio : p->t_send;    // radio active truoc khi gui: coi nhu khong cho
+        latency->prev_valid = true;
+        latency->prev_count = p->count;
+        latency->prev_d_radio = tick_delta(p->t_send, t_radio);
+        latency->prev_d_txc = tick_delta(p->t_send, now);
+        latency->inflight_head = (latency->inflight_head + 1) % HUST_LATENCY_INFLIGHT;
+        latency->inflight_count--;
+        n_complete--;
+    }
+}
+
+void hust_latency_trailer_get(const hust_latency_t * latency, uint32_t t_send, hust_latency_trailer_t * trailer)
+{
+    trailer->t_first = latency->t_first & HUST_LATENCY_TICK_MASK;
+    trailer->d_last = tick_delta(latency->t_first, latency->t_last);
+    trailer->d_packed = tick_delta(latency->t_first, latency->t_packed);
+    trailer->d_send = tick_delta(latency->t_first, t_send);
+    trailer->prev_count = latency->prev_count;
+    trailer->prev_d_radio = latency->prev_valid ? latency->prev_d_radio : HUST_LATENCY_INVALID;
+    trailer->prev_d_txc = latency->prev_valid ? latency->prev_d_txc : HUST_LATENCY_INVALID;
+}
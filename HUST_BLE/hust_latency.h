@@ -0,0 +1,79 @@
+#ifndef HUST_LATENCY_H__
+#define HUST_LATENCY_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// do latency tung giai doan cua 1 ble packet: ring -> dong goi -> hang doi HVN -> OTA -> host
+// thoi gian tren thiet bi tinh bang tick RTC cua app_timer (24 bit)
+
+#ifndef HUST_LATENCY_TRAILER_ENABLED
+#define HUST_LATENCY_TRAILER_ENABLED 0      // 1: gan trailer thoi gian vao cuoi moi ble packet
+#endif
+
+#define HUST_LATENCY_TICK_HZ        16384   // APP_TIMER_CONFIG_RTC_FREQUENCY = 1
+#define HUST_LATENCY_TICK_MASK      0xFFFFFF
+#define HUST_LATENCY_TRAILER_MAGIC  0xA7
+#define HUST_LATENCY_TRAILER_SIZE   16
+#define HUST_LATENCY_INFLIGHT       16      // so packet toi da dang nam trong hang doi HVN
+#define HUST_LATENCY_INVALID        0xFFFF
+
+/*
+ * trailer (little-endian, nam sau data, khong tinh vao data_size):
+ *   magic(1) t_first(4) d_last(2) d_packed(2) d_send(2) prev_count(1) prev_d_radio(2) prev_d_txc(2)
+ * d_*      : so tick tinh tu t_first (sample dau tien vao ring)
+ * prev_*   : packet prev_count da gui xong truoc do, tinh tu t_send cua packet do:
+ *            d_radio = bat dau connection event mang packet (radio notification), d_txc = BLE_GATTS_EVT_HVN_TX_COMPLETE
+ */
+typedef struct
+{
+    uint32_t t_first;
+    uint16_t d_last;
+    uint16_t d_packed;
+    uint16_t d_send;
+    uint8_t prev_count;
+    uint16_t prev_d_radio;
+    uint16_t prev_d_txc;
+} hust_latency_trailer_t;
+
+typedef struct
+{
+    uint8_t count;
+    uint32_t t_send;
+} hust_latency_inflight_t;
+
+typedef struct
+{
+    uint32_t t_first;
+    uint32_t t_last;
+    uint32_t t_packed;
+    uint32_t t_radio;                               // lan radio active gan nhat
+    hust_latency_inflight_t inflight[HUST_LATENCY_INFLIGHT];
+    uint8_t inflight_head;
+    uint8_t inflight_count;
+    bool prev_valid;
+    uint8_t prev_count;
+    uint16_t prev_d_radio;
+    uint16_t prev_d_txc;
+} hust_latency_t;
+
+void hust_latency_trailer_encode(const hust_latency_trailer_t * trailer, uint8_t * out);
+
+// tra ve 0 neu in la trailer hop le
+int hust_latency_trailer_decode(const uint8_t * in, int length, hust_latency_trailer_t * trailer);
+
+// xoa hang doi inflight (khi mat ket noi, cac packet dang cho se khong bao gio tx complete)
+void hust_latency_reset(hust_latency_t * latency);
+
+// cac moc thoi gian phia thiet bi, now = app_timer_cnt_get()
+void hust_latency_first_sample(hust_latency_t * latency, uint32_t now);
+void hust_latency_last_sample(hust_latency_t * latency, uint32_t now);
+void hust_latency_packed(hust_latency_t * latency, uint32_t now);
+void hust_latency_radio_active(hust_latency_t * latency, uint32_t now);
+void hust_latency_sent(hust_latency_t * latency, uint8_t count, uint32_t t_send);
+void hust_latency_tx_complete(hust_latency_t * latency, uint8_t n_complete, uint32_t now);
+
+// tao trailer cho packet sap gui luc t_send
+void hust_latency_trailer_get(const hust_latency_t * latency, uint32_t t_send, hust_latency_trailer_t * trailer);
+
+#endif // HUST_LATENCY_H__
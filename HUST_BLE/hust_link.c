@@ -0,0 +1,345 @@
+#include <string.h>
+
+#include "hust_link.h"
+
+#define LINK_IFS_US             150
+#define LINK_EVENT_MARGIN_US    600     // SoftDevice dung connection event truoc anchor ke tiep
+#define LINK_ATT_OVERHEAD       7       // header notification (3) + L2CAP (4)
+
+uint32_t hust_link_pdu_us(uint8_t phy, uint32_t ll)
+{
+    switch(phy)
+    {
+        case HUST_LINK_PHY_2M:
+            // preamble 2 + access address 4 + header 2 + payload + CRC 3, 4 us / byte
+            return (2 + 4 + 2 + ll + 3) * 4 + (2 + 4 + 2 + 3) * 4 + 2 * LINK_IFS_US;
+        case HUST_LINK_PHY_CODED:
+            // S=8: preamble + access address + CI + TERM1 = 376 us, header + payload + CRC 64 us / byte, TERM2 24 us
+            return 400 + (2 + ll + 3) * 64 + 400 + (2 + 3) * 64 + 2 * LINK_IFS_US;
+        default:
+            return (1 + 4 + 2 + ll + 3) * 8 + (1 + 4 + 2 + 3) * 8 + 2 * LINK_IFS_US;
+    }
+}
+
+// thoi gian phat 1 notification payload byte, chia thanh PDU data_length byte
+static uint32_t notification_us(uint8_t phy, uint16_t payload, uint16_t data_length)
+{
+    uint32_t att = payload + LINK_ATT_OVERHEAD;
+    uint32_t full = att / data_length;
+    uint32_t rest = att % data_length;
+    return full * hust_link_pdu_us(phy, data_length) + (rest != 0 ? hust_link_pdu_us(phy, rest) : 0);
+}
+
+uint32_t hust_link_capacity(const hust_link_t * link, hust_link_config_t config)
+{
+    uint32_t interval_us = config.interval * 1250u;
+    if(interval_us <= LINK_EVENT_MARGIN_US)
+    {
+        return 0;
+    }
+    uint32_t packets = (interval_us - LINK_EVENT_MARGIN_US) / notification_us(config.phy, link->payload, link->data_length);
+    if(packets > link->queue)
+    {
+        packets = link->queue;
+    }
+    return (uint32_t)((uint64_t)packets * link->payload * 8 * 1000000u / interval_us);
+}
+
+// event length (1.25 ms) du cho queue notification
+static uint16_t conn_cfg_event_length(const hust_link_conn_cfg_t * cfg)
+{
+    uint32_t length = (cfg->hvn_tx_queue * cfg->notification_us + LINK_EVENT_MARGIN_US + 1249) / 1250;
+    return (uint16_t)(length < cfg->event_length_min ? cfg->event_length_min : length);
+}
+
+int hust_link_conn_cfg(hust_link_conn_cfg_t * cfg, uint32_t target_bps, uint16_t interval, uint8_t phy,
+                       uint16_t payload, uint16_t data_length, uint16_t event_length_min)
+{
+    uint32_t interval_us = interval * 1250u;
+    cfg->event_length_min = event_length_min < HUST_LINK_EVENT_LENGTH_MIN ? HUST_LINK_EVENT_LENGTH_MIN : event_length_min;
+    cfg->notification_us = notification_us(phy, payload, data_length < 27 ? 27 : data_length);
+    // notification / interval de dat target_bps, gioi han boi thoi gian phat trong 1 interval
+    uint64_t bits = (uint64_t)target_bps * interval_us;
+    uint64_t per_packet = (uint64_t)payload * 8 * 1000000u;
+    uint32_t packets = (uint32_t)((bits + per_packet - 1) / per_packet);
+    uint32_t fit = interval_us > LINK_EVENT_MARGIN_US ? (interval_us - LINK_EVENT_MARGIN_US) / cfg->notification_us : 0;
+    int result = packets <= fit ? 0 : -1;
+    if(packets > fit)
+    {
+        packets = fit;
+    }
+    packets = packets < 1 ? 1 : packets > HUST_LINK_QUEUE_MAX ? HUST_LINK_QUEUE_MAX : packets;
+    cfg->hvn_tx_queue = (uint8_t)packets;
+    cfg->event_length = conn_cfg_event_length(cfg);
+    return result;
+}
+
+bool hust_link_conn_cfg_shrink(hust_link_conn_cfg_t * cfg)
+{
+    if(cfg->hvn_tx_queue <= 1)
+    {
+        return false;
+    }
+    cfg->hvn_tx_queue--;
+    cfg->event_length = conn_cfg_event_length(cfg);
+    return true;
+}
+
+uint32_t hust_link_stat_bps(const hust_link_stat_t * stat)
+{
+    return stat->ms > 0 ? (uint32_t)((uint64_t)stat->bytes * 8000 / stat->ms) : 0;
+}
+
+const char * hust_link_phy_name(uint8_t phy)
+{
+    switch(phy)
+    {
+        case HUST_LINK_PHY_1M:      return "1M";
+        case HUST_LINK_PHY_2M:      return "2M";
+        case HUST_LINK_PHY_CODED:   return "coded";
+        default:                    return "?";
+    }
+}
+
+// thu tu PHY tu nhanh den cham
+static int phy_rank(uint8_t phy)
+{
+    return phy == HUST_LINK_PHY_2M ? 0 : phy == HUST_LINK_PHY_1M ? 1 : 2;
+}
+
+static const uint8_t phy_by_rank[] = {HUST_LINK_PHY_2M, HUST_LINK_PHY_1M, HUST_LINK_PHY_CODED};
+
+// RSSI toi thieu de giu PHY
+static int16_t phy_floor(const hust_link_t * link, uint8_t phy)
+{
+    if(phy == HUST_LINK_PHY_2M)
+    {
+        return HUST_LINK_RSSI_FLOOR_2M;
+    }
+    return phy == HUST_LINK_PHY_1M && link->coded ? HUST_LINK_RSSI_FLOOR_1M : INT16_MIN;
+}
+
+// chon muc stats cho cau hinh dang chay, tra ve muc vua roi (NULL neu cau hinh khong doi)
+static const hust_link_stat_t * stat_select(hust_link_t * link)
+{
+    hust_link_stat_t * stat = &link->stats[link->stat];
+    if(stat->config.phy == link->current.phy && stat->config.interval == link->current.interval)
+    {
+        return NULL;
+    }
+    int pick = -1;
+    for(int i = 0; i < HUST_LINK_STATS; i++)
+    {
+        hust_link_stat_t * s = &link->stats[i];
+        if(s->config.phy == link->current.phy && s->config.interval == link->current.interval)
+        {
+            pick = i;
+            break;
+        }
+        // muc trong (ms = 0) hoac it du lieu nhat thi bi thay
+        if(i != link->stat && (pick < 0 || s->ms < link->stats[pick].ms))
+        {
+            pick = i;
+        }
+    }
+    hust_link_stat_t * next = &link->stats[pick];
+    if(next->config.phy != link->current.phy || next->config.interval != link->current.interval)
+    {
+        memset(next, 0, sizeof(hust_link_stat_t));
+        next->config = link->current;
+    }
+    link->stat = (uint8_t)pick;
+    return stat;
+}
+
+// interval dai nhat co dung luong (tru ty le loi) >= need, interval_min neu khong co
+static uint16_t interval_choose(const hust_link_t * link, uint8_t phy, uint64_t need)
+{
+    hust_link_config_t config = {phy, link->interval_max};
+    for(; config.interval > link->interval_min; config.interval--)
+    {
+        if((uint64_t)hust_link_capacity(link, config) * (100 - link->per) / 100 >= need)
+        {
+            break;
+        }
+    }
+    return config.interval;
+}
+
+void hust_link_init(hust_link_t * link, uint16_t interval_min, uint16_t interval_max, uint8_t queue, bool coded)
+{
+    memset(link, 0, sizeof(hust_link_t));
+    link->interval_min = interval_min;
+    link->interval_max = interval_max < interval_min ? interval_min : interval_max;
+    link->queue = queue == 0 ? 1 : queue;
+    link->coded = coded;
+    link->payload = 20;                 // ATT MTU mac dinh 23
+    link->data_length = 27;
+    link->current.phy = HUST_LINK_PHY_1M;
+    link->current.interval = interval_min;
+    link->target = link->current;
+    link->stats[0].config = link->current;
+}
+
+uint8_t hust_link_connected(hust_link_t * link, uint16_t interval)
+{
+    link->current.phy = HUST_LINK_PHY_1M;
+    link->current.interval = interval;
+    link->target.phy = HUST_LINK_PHY_2M;
+    link->target.interval = interval;
+    link->payload = 20;
+    link->data_length = 27;
+    link->required_bps = 0;
+    link->achieved_bps = 0;
+    link->rssi_valid = false;
+    link->per = 0;
+    link->per_bad_count = 0;
+    link->phy_ms = 0;
+    link->interval_ms = 0;
+    link->retry_ms = HUST_LINK_PHY_RETRY_MS;
+    link->have_last = false;
+    (void)stat_select(link);
+    return HUST_LINK_CHANGE_PHY;
+}
+
+const hust_link_stat_t * hust_link_phy_updated(hust_link_t * link, uint8_t phy)
+{
+    if(phy != link->current.phy)
+    {
+        link->per = 0;
+        link->per_bad_count = 0;
+    }
+    link->current.phy = phy;
+    link->target.phy = phy;             // ca khi central chon PHY khac / tu choi
+    link->phy_ms = 0;
+    return stat_select(link);
+}
+
+const hust_link_stat_t * hust_link_interval_updated(hust_link_t * link, uint16_t interval)
+{
+    link->current.interval = interval;
+    link->target.interval = interval;
+    link->interval_ms = 0;
+    return stat_select(link);
+}
+
+void hust_link_payload_set(hust_link_t * link, uint16_t payload, uint16_t data_length)
+{
+    if(payload > 0)
+    {
+        link->payload = payload;
+    }
+    if(data_length >= 27)
+    {
+        link->data_length = data_length;
+    }
+}
+
+void hust_link_rssi(hust_link_t * link, int8_t rssi)
+{
+    link->rssi = link->rssi_valid ? (int16_t)((link->rssi * 3 + rssi) / 4) : rssi;
+    link->rssi_valid = true;
+}
+
+uint8_t hust_link_tick(hust_link_t * link, uint32_t elapsed_ms, const hust_link_sample_t * sample)
+{
+    uint8_t change = 0;
+
+    if(!link->have_last || elapsed_ms == 0)
+    {
+        link->last = *sample;
+        link->have_last = true;
+        return 0;
+    }
+    uint32_t built = sample->packets_built - link->last.packets_built;
+    uint32_t sent = sample->packets_sent - link->last.packets_sent;
+    uint32_t bytes = sample->bytes_sent - link->last.bytes_sent;
+    bool dropped = sample->samples_dropped != link->last.samples_dropped;
+    bool backlogged = sample->nus_resources != link->last.nus_resources;
+    link->last = *sample;
+    link->phy_ms += elapsed_ms;
+    link->interval_ms += elapsed_ms;
+
+    // bitrate can: packet dong goi x do dai trung binh packet da gui
+    uint32_t average = sent > 0 ? bytes / sent : link->payload;
+    uint32_t need = (uint32_t)((uint64_t)built * average * 8000 / elapsed_ms);
+    link->required_bps = need > link->required_bps ? need : (link->required_bps * 3 + need) / 4;
+    link->achieved_bps = (uint32_t)((uint64_t)bytes * 8000 / elapsed_ms);
+
+    hust_link_stat_t * stat = &link->stats[link->stat];
+    stat->ms += elapsed_ms;
+    stat->bytes += bytes;
+    if(backlogged && link->achieved_bps > stat->peak_bps)
+    {
+        stat->peak_bps = link->achieved_bps;
+    }
+    // loi uoc luong: chi do duoc khi khong gui kip (hang doi HVN day, throughput < bitrate can),
+    // bang do hut so voi dung luong tinh theo thoi gian phat
+    uint32_t capacity = hust_link_capacity(link, link->current);
+    if(backlogged && (uint64_t)link->achieved_bps * 10 < (uint64_t)link->required_bps * 9 && capacity > 0)
+    {
+        uint32_t per = link->achieved_bps < capacity ? 100 - (uint32_t)((uint64_t)link->achieved_bps * 100 / capacity) : 0;
+        link->per_bad_count = per >= HUST_LINK_PER_BAD ? link->per_bad_count + 1 : 0;
+        link->per = (uint8_t)((link->per + per) / 2);
+    }
+    else
+    {
+        link->per_bad_count = 0;
+        link->per -= (uint8_t)((link->per + 7) / 8);
+    }
+
+    // yeu cau cu khong duoc central chap nhan
+    if(link->target.phy != link->current.phy && link->phy_ms >= HUST_LINK_HOLD_MS)
+    {
+        link->target.phy = link->current.phy;
+        link->phy_ms = 0;
+    }
+    if(link->target.interval != link->current.interval && link->interval_ms >= HUST_LINK_HOLD_MS)
+    {
+        link->target.interval = link->current.interval;
+        link->interval_ms = 0;
+    }
+
+    // PHY: ha khi RSSI duoi nguong / loi cao, thu lai PHY nhanh hon khi on dinh du lau
+    int rank = phy_rank(link->current.phy);
+    int max_rank = link->coded ? 2 : 1;
+    if(link->target.phy == link->current.phy)
+    {
+        bool weak = link->rssi_valid && link->rssi < phy_floor(link, link->current.phy);
+        if((weak || link->per_bad_count >= 2) && rank < max_rank)
+        {
+            // vua len PHY nhanh hon da phai ha: lan sau cho lau gap doi
+            link->retry_ms = link->phy_ms < link->retry_ms && link->retry_ms < HUST_LINK_PHY_RETRY_MS * 8
+                             ? link->retry_ms * 2 : link->retry_ms;
+            link->target.phy = phy_by_rank[rank + 1];
+            link->phy_ms = 0;
+            link->per_bad_count = 0;
+            change |= HUST_LINK_CHANGE_PHY;
+        }
+        else if(rank > 0 && link->phy_ms >= link->retry_ms && link->per < HUST_LINK_PER_BAD / 2
+                && (!link->rssi_valid
+                    || link->rssi >= phy_floor(link, phy_by_rank[rank - 1]) + HUST_LINK_RSSI_HYSTERESIS))
+        {
+            link->target.phy = phy_by_rank[rank - 1];
+            link->phy_ms = 0;
+            change |= HUST_LINK_CHANGE_PHY;
+        }
+    }
+
+    // interval theo bitrate can tren PHY se dung; mat sample / con backfill thi lay dung luong toi da
+    uint64_t target_bps = (uint64_t)link->required_bps * (100 + HUST_LINK_HEADROOM) / 100;
+    uint16_t interval = dropped || sample->backfill ? link->interval_min
+                        : interval_choose(link, link->target.phy, target_bps);
+    if(interval != link->current.interval && link->target.interval == link->current.interval)
+    {
+        bool short_of = hust_link_capacity(link, link->current) < target_bps || dropped || sample->backfill;
+        if((short_of && interval < link->current.interval)
+           || (link->interval_ms >= HUST_LINK_HOLD_MS && interval > link->current.interval + link->current.interval / 4))
+        {
+            link->target.interval = interval;
+            link->interval_ms = 0;
+            change |= HUST_LINK_CHANGE_INTERVAL;
+        }
+    }
+    return change;
+}
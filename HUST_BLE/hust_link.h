@@ -0,0 +1,149 @@
+#ifndef HUST_LINK_H__
+#define HUST_LINK_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Quan ly ket noi: chon PHY va connection interval theo bitrate can gui, dung chung cho firmware
+ * (main.c goi SoftDevice) va host (hust_link_bench.c).
+ *
+ * - PHY uu tien 2M, RSSI thap hoac ty le loi cao thi ha xuong 1M (roi coded neu SoftDevice ho tro),
+ *   on dinh du lau thi thu lai PHY nhanh hon.
+ * - Interval: dai nhat (it connection event nhat, radio bat it nhat) ma dung luong uoc tinh van
+ *   >= bitrate can * (100 + HUST_LINK_HEADROOM) %. Dung luong tinh theo thoi gian phat tren khong
+ *   cua 1 notification + ACK, connection event keo dai den het interval (event length extension),
+ *   toi da hang doi HVN TX notification / event.
+ * - Bitrate can do tu so packet dong goi / s x do dai trung binh. Nguon bi mat sample (link khong
+ *   kip) hoac con du lieu backfill thi can toi da dung luong.
+ * - Ty le loi: SoftDevice khong dem loi CRC, uoc luong bang do hut throughput so voi dung luong
+ *   tinh toan khi hang doi HVN day ma khong gui kip. Dung luong dung de chon interval da tru loi.
+ *
+ * Throughput dat duoc duoc cong don theo tung cau hinh (PHY, interval) de chon cau hinh radio it
+ * ton nang luong nhat ma van du cho stream.
+ *
+ * Cau hinh connection cua SoftDevice (hang doi HVN TX, GAP event length) tinh tu throughput muc tieu
+ * bang cung mo hinh thoi gian phat, dat 1 lan truoc sd_ble_enable.
+ */
+
+#define HUST_LINK_PHY_1M            1       // = BLE_GAP_PHY_1MBPS / 2MBPS / CODED
+#define HUST_LINK_PHY_2M            2
+#define HUST_LINK_PHY_CODED         4
+
+#define HUST_LINK_HEADROOM          50      // % du tru dung luong so voi bitrate can
+#define HUST_LINK_RSSI_FLOOR_2M     (-80)   // dBm, duoi nguong thi bo 2M
+#define HUST_LINK_RSSI_FLOOR_1M     (-88)   // dBm, duoi nguong thi bo 1M (neu co coded)
+#define HUST_LINK_RSSI_HYSTERESIS   6       // dB phai vuot nguong de thu lai PHY nhanh hon
+#define HUST_LINK_PER_BAD           30      // % loi uoc luong de ha PHY (2 chu ky lien tiep)
+#define HUST_LINK_PHY_RETRY_MS      30000   // thoi gian on dinh truoc khi thu lai PHY nhanh hon (x2 moi lan that bai, toi da x8)
+#define HUST_LINK_HOLD_MS           10000   // khoang cach toi thieu giua 2 lan doi interval
+#define HUST_LINK_STATS             8       // so cau hinh luu throughput
+#define HUST_LINK_QUEUE_MAX         20      // hang doi HVN TX toi da khi tinh tu throughput muc tieu
+#define HUST_LINK_EVENT_LENGTH_MIN  2       // = BLE_GAP_EVENT_LENGTH_MIN (2.5 ms)
+
+#define HUST_LINK_CHANGE_PHY        0x01
+#define HUST_LINK_CHANGE_INTERVAL   0x02
+
+typedef struct
+{
+    uint8_t phy;                        // HUST_LINK_PHY_*
+    uint16_t interval;                  // don vi 1.25 ms
+} hust_link_config_t;
+
+typedef struct
+{
+    hust_link_config_t config;
+    uint32_t ms;                        // thoi gian chay o cau hinh nay
+    uint32_t bytes;                     // byte gui duoc
+    uint32_t peak_bps;                  // throughput cao nhat 1 chu ky luc hang doi HVN day
+} hust_link_stat_t;
+
+// bo dem cong don cua pipeline (hust_telemetry_t), moi chu ky hust_link_tick
+typedef struct
+{
+    uint32_t packets_built;
+    uint32_t packets_sent;
+    uint32_t bytes_sent;
+    uint32_t samples_dropped;
+    uint32_t nus_resources;             // hang doi HVN day
+    bool backfill;                      // con packet luu luc mat ket noi chua gui
+} hust_link_sample_t;
+
+// cau hinh connection cua SoftDevice (BLE_CONN_CFG_GATTS, BLE_CONN_CFG_GAP)
+typedef struct
+{
+    uint8_t hvn_tx_queue;               // notification SoftDevice nhan truoc cho moi ket noi
+    uint16_t event_length;              // thoi gian danh cho 1 connection event, don vi 1.25 ms
+    uint32_t notification_us;           // noi bo: thoi gian phat 1 notification
+    uint16_t event_length_min;          // noi bo: event length khong giam duoi gia tri nay
+} hust_link_conn_cfg_t;
+
+typedef struct
+{
+    // tham so
+    uint16_t interval_min;
+    uint16_t interval_max;
+    uint8_t queue;                      // notification toi da / connection event (hang doi HVN TX)
+    bool coded;                         // SoftDevice ho tro coded PHY (S140)
+    uint16_t payload;                   // byte / notification (MTU - 3)
+    uint16_t data_length;               // byte payload LL toi da (27..251)
+
+    hust_link_config_t current;         // cau hinh dang chay
+    hust_link_config_t target;          // cau hinh muon dung (da yeu cau)
+    uint32_t required_bps;              // bitrate can, tang ngay / giam cham
+    uint32_t achieved_bps;              // throughput chu ky gan nhat
+    int16_t rssi;                       // dBm, trung binh truot
+    bool rssi_valid;
+    uint8_t per;                        // % loi uoc luong, trung binh truot
+    uint8_t per_bad_count;              // so chu ky lien tiep loi >= HUST_LINK_PER_BAD
+    uint32_t phy_ms;                    // thoi gian tu lan doi PHY gan nhat
+    uint32_t retry_ms;                  // cho truoc khi thu lai PHY nhanh hon, gap doi moi lan that bai
+    uint32_t interval_ms;               // thoi gian tu lan doi interval gan nhat
+
+    hust_link_sample_t last;
+    bool have_last;
+    hust_link_stat_t stats[HUST_LINK_STATS];
+    uint8_t stat;                       // stats[] cua cau hinh dang chay
+} hust_link_t;
+
+// interval don vi 1.25 ms, queue >= 1. coded: cho phep ha xuong coded PHY
+void hust_link_init(hust_link_t * link, uint16_t interval_min, uint16_t interval_max, uint8_t queue, bool coded);
+
+// ket noi moi o 1M voi interval central chon, tra ve HUST_LINK_CHANGE_* can yeu cau (2M, interval)
+uint8_t hust_link_connected(hust_link_t * link, uint16_t interval);
+
+// ket qua doi PHY / interval (BLE_GAP_EVT_PHY_UPDATE / CONN_PARAM_UPDATE), ca khi central tu doi.
+// Tra ve stats cua cau hinh vua roi (de log throughput), NULL neu cau hinh khong doi
+const hust_link_stat_t * hust_link_phy_updated(hust_link_t * link, uint8_t phy);
+const hust_link_stat_t * hust_link_interval_updated(hust_link_t * link, uint16_t interval);
+
+// MTU / data length moi
+void hust_link_payload_set(hust_link_t * link, uint16_t payload, uint16_t data_length);
+
+// RSSI moi (BLE_GAP_EVT_RSSI_CHANGED)
+void hust_link_rssi(hust_link_t * link, int8_t rssi);
+
+// goi moi chu ky elapsed_ms, tra ve HUST_LINK_CHANGE_* can yeu cau (cau hinh moi trong link->target)
+uint8_t hust_link_tick(hust_link_t * link, uint32_t elapsed_ms, const hust_link_sample_t * sample);
+
+// hang doi HVN va event length de dat target_bps o interval (1.25 ms) tren phy, notification payload
+// byte chia thanh PDU data_length byte, event length >= event_length_min (vd. mac dinh cua sdk_config).
+// Tra ve 0, -1 neu interval khong du thoi gian phat (cfg = toi da)
+int hust_link_conn_cfg(hust_link_conn_cfg_t * cfg, uint32_t target_bps, uint16_t interval, uint8_t phy,
+                       uint16_t payload, uint16_t data_length, uint16_t event_length_min);
+
+// bot 1 notification khoi hang doi (va event length theo) khi SoftDevice thieu RAM, false neu da toi thieu
+bool hust_link_conn_cfg_shrink(hust_link_conn_cfg_t * cfg);
+
+// thoi gian phat 1 PDU du lieu ll byte + ACK rong (us)
+uint32_t hust_link_pdu_us(uint8_t phy, uint32_t ll);
+
+// dung luong uoc tinh (bit/s) cua 1 cau hinh
+uint32_t hust_link_capacity(const hust_link_t * link, hust_link_config_t config);
+
+// throughput trung binh cua 1 muc stats
+uint32_t hust_link_stat_bps(const hust_link_stat_t * stat);
+
+const char * hust_link_phy_name(uint8_t phy);
+
+#endif // HUST_LINK_H__
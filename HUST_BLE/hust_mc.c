@@ -0,0 +1,171 @@
+#include "hust_mc.h"
+
+int hust_mc_raw_frames(int n_channels, int data_size)
+{
+    int n = (data_size - HUST_MC_HEADER_SIZE) / (3 * n_channels);
+    if(n < 0)
+    {
+        return 0;
+    }
+    return n > HUST_MC_MAX_FRAMES ? HUST_MC_MAX_FRAMES : n;
+}
+
+// ma hoa dung n frame, tra ve so byte hoac -1 neu khong vua
+static int mc_encode(const int32_t * frames, int n_channels, int n, hust_codec_t codec, uint8_t param,
+                     uint8_t * data, int data_size)
+{
+    int pos = HUST_MC_HEADER_SIZE;
+
+    data[0] = (uint8_t)n_channels;
+    data[1] = (uint8_t)n;
+    data[2] = (uint8_t)codec;
+    data[3] = param;
+    if(codec == HUST_CODEC_RAW)
+    {
+        if(pos + 3 * n * n_channels > data_size)
+        {
+            return -1;
+        }
+        for(int i = 0; i < n * n_channels; i++)
+        {
+            int32_t v = frames[i];
+            data[pos++] = (uint8_t)(v >> 16);
+            data[pos++] = (uint8_t)(v >> 8);
+            data[pos++] = (uint8_t)v;
+        }
+        return pos;
+    }
+    for(int ch = 0; ch < n_channels; ch++)
+    {
+        int32_t block[HUST_MC_MAX_FRAMES];
+        for(int i = 0; i < n; i++)
+        {
+            block[i] = frames[i * n_channels + ch];
+        }
+        int room = data_size - pos - 1;
+        if(room <= 0)
+        {
+            return -1;
+        }
+        int len = hust_codec_encode(codec, param, block, n, data + pos + 1, room > 255 ? 255 : room);
+        if(len < 0)
+        {
+            return -1;
+        }
+        data[pos] = (uint8_t)len;
+        pos += 1 + len;
+    }
+    return pos;
+}
+
+int hust_mc_pack(const int32_t * frames, int n_channels, int n_frames, hust_codec_t codec, uint8_t param,
+                 uint8_t * data, int data_size, int * length)
+{
+    if(n_channels <= 0 || n_channels > HUST_MC_MAX_CHANNELS || n_frames <= 0 || codec >= HUST_CODEC_COUNT)
+    {
+        return -1;
+    }
+    if(data_size > HUST_MC_MAX_DATA_SIZE)
+    {
+        data_size = HUST_MC_MAX_DATA_SIZE;
+    }
+    if(n_frames > HUST_MC_MAX_FRAMES)
+    {
+        n_frames = HUST_MC_MAX_FRAMES;
+    }
+    if(codec == HUST_CODEC_RAW)
+    {
+        int n = hust_mc_raw_frames(n_channels, data_size);
+        n = n < n_frames ? n : n_frames;
+        *length = n > 0 ? mc_encode(frames, n_channels, n, codec, param, data, data_size) : -1;
+        return *length < 0 ? -1 : n;
+    }
+
+    // thu ca block truoc (truong hop thuong), neu khong vua thi tim nhi phan so frame lon nhat
+    *length = mc_encode(frames, n_channels, n_frames, codec, param, data, data_size);
+    if(*length >= 0)
+    {
+        return n_frames;
+    }
+    int lo = 0;
+    int hi = n_frames;
+    int last = n_frames;            // so frame cua lan ma hoa gan nhat dang nam trong data
+    while(hi - lo > 1)
+    {
+        int mid = (lo + hi) / 2;
+        int len = mc_encode(frames, n_channels, mid, codec, param, data, data_size);
+        last = mid;
+        if(len >= 0)
+        {
+            lo = mid;
+            *length = len;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    if(lo == 0)
+    {
+        return -1;
+    }
+    if(last != lo)
+    {
+        *length = mc_encode(frames, n_channels, lo, codec, param, data, data_size);
+    }
+    return lo;
+}
+
+int hust_mc_unpack(const uint8_t * data, int length, int32_t * frames, int max_frames, hust_mc_info_t * info)
+{
+    if(length < HUST_MC_HEADER_SIZE)
+    {
+        return -1;
+    }
+    info->n_channels = data[0];
+    info->n_frames = data[1];
+    info->codec = (hust_codec_t)data[2];
+    info->param = data[3];
+
+    int n_channels = info->n_channels;
+    int n = info->n_frames;
+    int pos = HUST_MC_HEADER_SIZE;
+    if(n_channels == 0 || n_channels > HUST_MC_MAX_CHANNELS || n > max_frames || n > HUST_MC_MAX_FRAMES
+       || info->codec >= HUST_CODEC_COUNT)
+    {
+        return -1;
+    }
+    if(info->codec == HUST_CODEC_RAW)
+    {
+        if(pos + 3 * n * n_channels > length)
+        {
+            return -1;
+        }
+        for(int i = 0; i < n * n_channels; i++)
+        {
+            int32_t v = ((int32_t)data[pos] << 16) | ((int32_t)data[pos + 1] << 8) | data[pos + 2];
+            frames[i] = (v ^ 0x800000) - 0x800000;
+            pos += 3;
+        }
+        return 0;
+    }
+    for(int ch = 0; ch < n_channels; ch++)
+    {
+        int32_t block[HUST_MC_MAX_FRAMES];
+        if(pos >= length)
+        {
+            return -1;
+        }
+        int len = data[pos++];
+        if(pos + len > length || hust_codec_decode(info->codec, info->param, data + pos, len, block, n) != len)
+        {
+            return -1;
+        }
+        for(int i = 0; i < n; i++)
+        {
+            frames[i * n_channels + ch] = block[i];
+        }
+        pos += len;
+    }
+    return 0;
+}
@@ -0,0 +1,49 @@
+#ifndef HUST_MC_H__
+#define HUST_MC_H__
+
+#include <stdint.h>
+
+#include "hust_codec.h"
+
+/*
+ * Payload ble packet nhieu channel (EEG_SENSOR_TYPE, EMG_SENSOR_TYPE), so channel chon luc chay.
+ * Header ble packet 11 byte giu nguyen (timestamp = chi so sample cua frame dau tien), data:
+ *
+ *   n_channels (1) | n_frames (1) | codec (1) | param (1) | du lieu
+ *
+ *   HUST_CODEC_RAW: n_frames x n_channels sample 24 bit big-endian, frame truoc channel sau
+ *   codec khac:     moi channel 1 block n_frames sample: len (1) + len byte hust_codec
+ *
+ * data_size cua ble packet la uint8 va MTU 247 -> toi da 233 byte data. 32 channel RAW = 2 frame / packet
+ * (196 byte), 500 SPS -> 250 packet/s, ~414 kbit/s, vua 2M PHY. Codec khong mat du lieu dua duoc nhieu
+ * frame hon vao 1 packet (32 channel EEG: DELTA_VARINT ~5 frame, ~176 kbit/s, xem hust_ads_bench),
+ * hust_mc_pack tu chon so frame lon nhat con vua.
+ */
+
+#define HUST_MC_HEADER_SIZE     4
+#define HUST_MC_MAX_CHANNELS    32
+#define HUST_MC_MAX_FRAMES      64
+#define HUST_MC_MAX_DATA_SIZE   255         // data_size cua ble packet la uint8
+
+typedef struct
+{
+    uint8_t n_channels;
+    uint8_t n_frames;
+    hust_codec_t codec;
+    uint8_t param;
+} hust_mc_info_t;
+
+// so frame RAW toi da trong data_size byte
+int hust_mc_raw_frames(int n_channels, int data_size);
+
+// dong goi toi da n_frames frame (frames[frame][channel]) vao data (toi da data_size byte)
+// tra ve so frame da dong goi (giu thu tu, phan con lai dong goi o packet sau), *length = so byte,
+// -1 neu tham so sai hoac 1 frame cung khong vua
+int hust_mc_pack(const int32_t * frames, int n_channels, int n_frames, hust_codec_t codec, uint8_t param,
+                 uint8_t * data, int data_size, int * length);
+
+// giai ma data cua ble packet, frames can du max_frames * n_channels int32
+// tra ve 0 neu thanh cong, -1 neu du lieu loi
+int hust_mc_unpack(const uint8_t * data, int length, int32_t * frames, int max_frames, hust_mc_info_t * info);
+
+#endif // HUST_MC_H__
@@ -0,0 +1,138 @@
+#include <string.h>
+
+#include "hust_prof.h"
+#ifdef HUST_HOST_BUILD
+#include <stdio.h>
+#else
+#include "nrf_log.h"
+#endif
+
+static hust_prof_stat_t prof_stat[HUST_PROF_REGION_COUNT];
+
+static const char * prof_name[HUST_PROF_REGION_COUNT] =
+{
+    "ecg_timer", "pack", "nus_send", "emg_buffer"
+};
+
+void hust_prof_reset(void)
+{
+    for(int i = 0; i < HUST_PROF_REGION_COUNT; i++)
+    {
+        uint32_t budget = prof_stat[i].budget;
+        memset(&prof_stat[i], 0, sizeof(hust_prof_stat_t));
+        prof_stat[i].min = UINT32_MAX;
+        prof_stat[i].budget = budget;
+    }
+}
+
+void hust_prof_init(void)
+{
+#ifndef HUST_HOST_BUILD
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+    hust_prof_reset();
+}
+
+void hust_prof_record(hust_prof_region_t region, uint32_t cycles)
+{
+    hust_prof_stat_t * stat = &prof_stat[region];
+    int bin = cycles == 0 ? 0 : 31 - __builtin_clz(cycles);     // CLZ 1 lenh tren M4
+
+    stat->count++;
+    stat->sum += cycles;
+    if(cycles < stat->min)
+    {
+        stat->min = cycles;
+    }
+    if(cycles > stat->max)
+    {
+        stat->max = cycles;
+    }
+    if(stat->budget != 0 && cycles > stat->budget)
+    {
+        stat->over_budget++;
+    }
+    stat->hist[bin < HUST_PROF_HIST_BINS ? bin : HUST_PROF_HIST_BINS - 1]++;
+}
+
+void hust_prof_budget_set(hust_prof_region_t region, uint32_t cycles)
+{
+    prof_stat[region].budget = cycles;
+}
+
+const hust_prof_stat_t * hust_prof_get(hust_prof_region_t region)
+{
+    return &prof_stat[region];
+}
+
+const char * hust_prof_name(hust_prof_region_t region)
+{
+    return region < HUST_PROF_REGION_COUNT ? prof_name[region] : "?";
+}
+
+void hust_prof_dump(void)
+{
+    for(int i = 0; i < HUST_PROF_REGION_COUNT; i++)
+    {
+        const hust_prof_stat_t * stat = &prof_stat[i];
+        uint32_t avg = stat->count > 0 ? (uint32_t)(stat->sum / stat->count) : 0;
+        uint32_t min = stat->count > 0 ? stat->min : 0;
+#ifdef HUST_HOST_BUILD
+        printf("prof %-10s n=%u min=%u avg=%u max=%u", prof_name[i], stat->count, min, avg, stat->max);
+        if(stat->budget != 0)
+        {
+            printf(" budget=%u over=%u", stat->budget, stat->over_budget);
+        }
+        printf(" hist");
+        for(int b = 0; b < HUST_PROF_HIST_BINS; b++)
+        {
+            if(stat->hist[b] > 0)
+            {
+                printf(" 2^%d:%u", b, stat->hist[b]);
+            }
+        }
+        printf("\n");
+#else
+        NRF_LOG_INFO("prof %s n=%u min=%u avg=%u max=%u", prof_name[i], stat->count, min, avg, stat->max);
+        if(stat->budget != 0)
+        {
+            NRF_LOG_INFO("  budget %u, over %u", stat->budget, stat->over_budget);
+        }
+        for(int b = 0; b < HUST_PROF_HIST_BINS; b++)
+        {
+            if(stat->hist[b] > 0)
+            {
+                NRF_LOG_INFO("  2^%d: %u", b, stat->hist[b]);
+            }
+        }
+#endif
+    }
+}
+
+static void put_u32(uint8_t * p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+int hust_prof_serialize(uint8_t * out, int out_size)
+{
+    if(out_size < HUST_PROF_REGION_COUNT * HUST_PROF_STAT_SIZE)
+    {
+        return -1;
+    }
+    for(int i = 0; i < HUST_PROF_REGION_COUNT; i++)
+    {
+        const hust_prof_stat_t * stat = &prof_stat[i];
+        uint8_t * p = out + i * HUST_PROF_STAT_SIZE;
+        put_u32(p, stat->count);
+        put_u32(p + 4, stat->count > 0 ? stat->min : 0);
+        put_u32(p + 8, stat->count > 0 ? (uint32_t)(stat->sum / stat->count) : 0);
+        put_u32(p + 12, stat->max);
+    }
+    return HUST_PROF_REGION_COUNT * HUST_PROF_STAT_SIZE;
+}
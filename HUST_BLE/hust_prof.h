@@ -0,0 +1,84 @@
+#ifndef HUST_PROF_H__
+#define HUST_PROF_H__
+
+#include <stdint.h>
+
+// do so chu ky CPU cua cac doan code nong (DWT CYCCNT tren Cortex-M4, clock_gettime (ns) tren host)
+// HUST_PROF_ENABLED = 0: cac macro HUST_PROF_* bi bo hoan toan khi bien dich
+
+#ifndef HUST_PROF_ENABLED
+#define HUST_PROF_ENABLED 0
+#endif
+
+#define HUST_PROF_HIST_BINS     24          // bin i: [2^i, 2^(i+1)) chu ky, bin cuoi gom tat ca gia tri lon hon
+#define HUST_PROF_STAT_SIZE     16          // so byte 1 region trong hust_prof_serialize (khong gom histogram)
+
+typedef enum
+{
+    HUST_PROF_ECG_TIMER = 0,                // ecg_timer_timeout_handler
+    HUST_PROF_PACK,                         // convert_data_to_ble_packet
+    HUST_PROF_NUS_SEND,                     // ble_nus_data_send trong main
+    HUST_PROF_EMG_BUFFER,                   // emg_buffer_handler (ngat SAADC, co ngan sach chu ky)
+    HUST_PROF_REGION_COUNT
+} hust_prof_region_t;
+
+typedef struct
+{
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t sum;
+    uint32_t budget;                        // ngan sach chu ky / lan, 0 = khong gioi han
+    uint32_t over_budget;                   // so lan vuot ngan sach
+    uint32_t hist[HUST_PROF_HIST_BINS];
+} hust_prof_stat_t;
+
+#ifdef HUST_HOST_BUILD
+#include <time.h>
+
+static inline uint32_t hust_prof_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec);
+}
+#else
+#include "nrf.h"
+
+static inline uint32_t hust_prof_now(void)
+{
+    return DWT->CYCCNT;
+}
+#endif
+
+// bat DWT cycle counter (host: khong can) va xoa thong ke
+void hust_prof_init(void);
+void hust_prof_reset(void);
+
+void hust_prof_record(hust_prof_region_t region, uint32_t cycles);
+
+// dat ngan sach chu ky cho region (giu qua hust_prof_reset), so lan vuot in trong hust_prof_dump
+void hust_prof_budget_set(hust_prof_region_t region, uint32_t cycles);
+
+const hust_prof_stat_t * hust_prof_get(hust_prof_region_t region);
+const char * hust_prof_name(hust_prof_region_t region);
+
+// in thong ke ra NRF_LOG (RTT) / stdout tren host
+void hust_prof_dump(void);
+
+// ghi count/min/avg/max (uint32 little-endian) cua tung region, tra ve so byte, -1 neu out_size khong du
+int hust_prof_serialize(uint8_t * out, int out_size);
+
+#if HUST_PROF_ENABLED
+#define HUST_PROF_INIT()            hust_prof_init()
+#define HUST_PROF_START(name)       uint32_t hust_prof_t0_##name = hust_prof_now()
+#define HUST_PROF_STOP(name, region) hust_prof_record((region), hust_prof_now() - hust_prof_t0_##name)
+#define HUST_PROF_BUDGET(region, cycles) hust_prof_budget_set((region), (cycles))
+#else
+#define HUST_PROF_INIT()
+#define HUST_PROF_START(name)
+#define HUST_PROF_STOP(name, region)
+#define HUST_PROF_BUDGET(region, cycles)
+#endif
+
+#endif // HUST_PROF_H__
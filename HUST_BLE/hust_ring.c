@@ -0,0 +1,105 @@
+#include <string.h>
+
+#include "hust_ring.h"
+
+void hust_ring_init(hust_ring_t * ring)
+{
+    memset(ring, 0, sizeof(hust_ring_t));
+}
+
+int hust_ring_push(hust_ring_t * ring, const hust_frame_t * frame)
+{
+    uint32_t head = ring->head;
+    uint32_t count = head - ring->tail;
+    if(count >= HUST_RING_FRAMES)
+    {
+        ring->dropped++;
+        return -1;
+    }
+    ring->frame[head & (HUST_RING_FRAMES - 1)] = *frame;
+    __sync_synchronize();           // ghi xong frame truoc khi cap nhat head
+    ring->head = head + 1;
+    if(count + 1 > ring->high_water)
+    {
+        ring->high_water = count + 1;
+    }
+    return 0;
+}
+
+int hust_ring_pop(hust_ring_t * ring, hust_frame_t * frame)
+{
+    uint32_t tail = ring->tail;
+    if(ring->head == tail)
+    {
+        return -1;
+    }
+    __sync_synchronize();
+    *frame = ring->frame[tail & (HUST_RING_FRAMES - 1)];
+    __sync_synchronize();           // doc xong frame truoc khi tra cho cho ISR
+    ring->tail = tail + 1;
+    return 0;
+}
+
+uint32_t hust_ring_count(const hust_ring_t * ring)
+{
+    return ring->head - ring->tail;
+}
+
+int hust_mc_ring_init(hust_mc_ring_t * ring, uint8_t n_channels)
+{
+    if(n_channels == 0 || n_channels > ring->max_channels)
+    {
+        return -1;
+    }
+    ring->n_channels = n_channels;
+    ring->head = 0;
+    ring->tail = 0;
+    ring->high_water = 0;
+    ring->dropped = 0;
+    return 0;
+}
+
+int32_t * hust_mc_ring_claim(hust_mc_ring_t * ring)
+{
+    uint32_t head = ring->head;
+    if(head - ring->tail >= ring->capacity)
+    {
+        ring->dropped++;
+        return NULL;
+    }
+    return ring->sample + (head & (ring->capacity - 1)) * ring->max_channels;
+}
+
+void hust_mc_ring_commit(hust_mc_ring_t * ring, uint64_t sample_index)
+{
+    uint32_t head = ring->head;
+    uint32_t count = head - ring->tail + 1;
+    ring->index[head & (ring->capacity - 1)] = sample_index;
+    __sync_synchronize();           // ghi xong frame truoc khi cap nhat head
+    ring->head = head + 1;
+    if(count > ring->high_water)
+    {
+        ring->high_water = count;
+    }
+}
+
+int hust_mc_ring_pop(hust_mc_ring_t * ring, int32_t * frame, uint64_t * sample_index)
+{
+    uint32_t tail = ring->tail;
+    if(ring->head == tail)
+    {
+        return -1;
+    }
+    __sync_synchronize();
+    uint32_t slot = tail & (ring->capacity - 1);
+    memcpy(frame, ring->sample + slot * ring->max_channels, ring->n_channels * sizeof(int32_t));
+    *sample_index = ring->index[slot];
+    __sync_synchronize();           // doc xong frame truoc khi tra cho cho ISR
+    ring->tail = tail + 1;
+    return 0;
+}
+
+uint32_t hust_mc_ring_count(const hust_mc_ring_t * ring)
+{
+    return ring->head - ring->tail;
+}
@@ -0,0 +1,75 @@
+#ifndef HUST_RING_H__
+#define HUST_RING_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "hust_ble.h"
+
+// ring sample giua nguon lay mau (ISR, ghi) va vong lap dong goi ble packet (main, doc)
+// 1 ghi 1 doc, khong can khoa
+
+#define HUST_RING_FRAMES    128     // luy thua cua 2
+
+typedef struct
+{
+    uint64_t sample_index;          // chi so sample theo dong ho lay mau
+    uint32_t t_acq;                 // tick RTC luc lay mau (uoc luong voi buffer DMA)
+    ecg_data_t ecg;
+} hust_frame_t;
+
+typedef struct
+{
+    hust_frame_t frame[HUST_RING_FRAMES];
+    volatile uint32_t head;         // so frame da ghi
+    volatile uint32_t tail;         // so frame da doc
+    uint32_t high_water;
+    uint32_t dropped;               // frame bi bo vi ring day
+} hust_ring_t;
+
+void hust_ring_init(hust_ring_t * ring);
+
+// ghi 1 frame, tra ve 0 neu thanh cong, -1 neu ring day (frame bi bo)
+int hust_ring_push(hust_ring_t * ring, const hust_frame_t * frame);
+
+// doc 1 frame, tra ve 0 neu thanh cong, -1 neu ring rong
+int hust_ring_pop(hust_ring_t * ring, hust_frame_t * frame);
+
+uint32_t hust_ring_count(const hust_ring_t * ring);
+
+// ring frame nhieu channel (EEG/EMG, so channel chon luc chay): frame = n_channels int32,
+// bo nho cap tinh boi HUST_MC_RING_DEF. Ghi tai cho (claim/commit) de ISR tach frame thang vao ring
+typedef struct
+{
+    int32_t * sample;               // [capacity][max_channels]
+    uint64_t * index;               // chi so sample cua tung frame
+    uint32_t capacity;              // luy thua cua 2
+    uint8_t max_channels;
+    uint8_t n_channels;
+    volatile uint32_t head;
+    volatile uint32_t tail;
+    uint32_t high_water;
+    uint32_t dropped;
+} hust_mc_ring_t;
+
+#define HUST_MC_RING_DEF(_name, _capacity, _max_channels)                       \
+    static int32_t _name##_sample[(_capacity) * (_max_channels)];               \
+    static uint64_t _name##_index[(_capacity)];                                 \
+    static hust_mc_ring_t _name = {                                             \
+        .sample = _name##_sample, .index = _name##_index,                       \
+        .capacity = (_capacity), .max_channels = (_max_channels),               \
+        .n_channels = (_max_channels) }
+
+// dat lai ring va so channel / frame (<= max_channels)
+int hust_mc_ring_init(hust_mc_ring_t * ring, uint8_t n_channels);
+
+// o ghi frame tiep theo, NULL neu ring day (frame bi bo)
+int32_t * hust_mc_ring_claim(hust_mc_ring_t * ring);
+void hust_mc_ring_commit(hust_mc_ring_t * ring, uint64_t sample_index);
+
+// doc 1 frame (n_channels int32), tra ve 0 neu thanh cong, -1 neu ring rong
+int hust_mc_ring_pop(hust_mc_ring_t * ring, int32_t * frame, uint64_t * sample_index);
+
+uint32_t hust_mc_ring_count(const hust_mc_ring_t * ring);
+
+#endif // HUST_RING_H__
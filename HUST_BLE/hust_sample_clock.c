@@ -0,0 +1,56 @@
+#include "hust_sample_clock.h"
+
+int hust_sample_clock_init(hust_sample_clock_t * clock, uint32_t tick_hz, uint32_t rate, uint32_t now)
+{
+    if(rate == 0 || tick_hz / rate < HUST_SAMPLE_CLOCK_MIN_TICKS)
+    {
+        return -1;
+    }
+    clock->tick_hz = tick_hz;
+    clock->rate = rate;
+    clock->tick_int = tick_hz / rate;
+    clock->tick_rem = tick_hz % rate;
+    clock->acc = clock->tick_rem;                          // phan du cua sample 0
+    clock->deadline = (uint64_t)now + clock->tick_int;     // sample 0 sau 1 chu ky
+    clock->sample_index = 0;
+    clock->late = 0;
+    return 0;
+}
+
+uint32_t hust_sample_clock_wait(const hust_sample_clock_t * clock, uint32_t now, uint32_t mask)
+{
+    uint32_t diff = ((uint32_t)clock->deadline - now) & mask;
+    // diff > nua vong dem: moc da qua (den muon)
+    if(diff > (mask >> 1) || diff < HUST_SAMPLE_CLOCK_MIN_TICKS)
+    {
+        return HUST_SAMPLE_CLOCK_MIN_TICKS;
+    }
+    return diff;
+}
+
+uint64_t hust_sample_clock_advance(hust_sample_clock_t * clock, uint32_t now, uint32_t mask)
+{
+    uint64_t index = clock->sample_index++;
+
+    clock->deadline += clock->tick_int;
+    clock->acc += clock->tick_rem;
+    if(clock->acc >= clock->rate)
+    {
+        clock->acc -= clock->rate;
+        clock->deadline++;
+    }
+    // moc moi van nam truoc now: timeout bi tre hon 1 chu ky (SoftDevice chiem CPU)
+    uint32_t diff = ((uint32_t)clock->deadline - now) & mask;
+    if(diff > (mask >> 1))
+    {
+        clock->late++;
+    }
+    return index;
+}
+
+uint64_t hust_sample_clock_tick_of(uint32_t tick_hz, uint32_t rate, uint64_t n)
+{
+    // (n + 1) vi sample 0 nam sau anchor 1 chu ky, tach phan nguyen de tranh tran 64 bit
+    uint64_t k = n + 1;
+    return (k / rate) * tick_hz + ((k % rate) * tick_hz) / rate;
+}
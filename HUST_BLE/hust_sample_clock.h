@@ -0,0 +1,40 @@
+#ifndef HUST_SAMPLE_CLOCK_H__
+#define HUST_SAMPLE_CLOCK_H__
+
+#include <stdint.h>
+
+// dong ho lay mau chinh xac: moc thoi gian cua sample n = anchor + floor(n * tick_hz / rate)
+// phan du cua tick_hz / rate duoc cong don (fractional accumulation) nen khong troi theo thoi gian
+// vd. RTC 16384 Hz, 1000 Hz: 16.384 tick / sample -> 16, 16, 17, ... thay vi luon 16 (1024 Hz)
+
+#define HUST_SAMPLE_CLOCK_RTC_HZ        16384       // APP_TIMER_CONFIG_RTC_FREQUENCY = 1
+#define HUST_SAMPLE_CLOCK_RTC_MASK      0xFFFFFF    // RTC 24 bit
+#define HUST_SAMPLE_CLOCK_MIN_TICKS     5           // APP_TIMER_MIN_TIMEOUT_TICKS
+
+typedef struct
+{
+    uint32_t tick_hz;
+    uint32_t rate;
+    uint32_t tick_int;              // phan nguyen tick_hz / rate
+    uint32_t tick_rem;              // phan du tick_hz % rate
+    uint32_t acc;                   // phan du cong don, < rate
+    uint64_t deadline;              // tick (tuyet doi, da mo rong 64 bit) cua sample ke tiep
+    uint64_t sample_index;          // chi so sample ke tiep
+    uint32_t late;                  // so lan timeout den muon hon 1 chu ky
+} hust_sample_clock_t;
+
+// khoi tao voi tan so tick tick_hz va tan so lay mau rate, now = bo dem tick hien tai
+// tra ve 0 neu thanh cong, -1 neu rate khong hop le (0 hoac qua nhanh so voi tick_hz)
+int hust_sample_clock_init(hust_sample_clock_t * clock, uint32_t tick_hz, uint32_t rate, uint32_t now);
+
+// so tick tu now den moc cua sample ke tiep (toi thieu HUST_SAMPLE_CLOCK_MIN_TICKS)
+// mask = HUST_SAMPLE_CLOCK_RTC_MASK voi RTC, 0xFFFFFFFF voi TIMER 32 bit
+uint32_t hust_sample_clock_wait(const hust_sample_clock_t * clock, uint32_t now, uint32_t mask);
+
+// sample hien tai da lay xong: tra ve chi so cua no va chuyen moc sang sample ke tiep
+uint64_t hust_sample_clock_advance(hust_sample_clock_t * clock, uint32_t now, uint32_t mask);
+
+// tick cua sample n tinh tu anchor (sample 0), dung chung cho host de dung lai thoi gian
+uint64_t hust_sample_clock_tick_of(uint32_t tick_hz, uint32_t rate, uint64_t n);
+
+#endif // HUST_SAMPLE_CLOCK_H__
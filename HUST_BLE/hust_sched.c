@@ -0,0 +1,227 @@
+#include "hust_sched.h"
+#include "hust_sample_clock.h"
+
+// channel mask (bo tri ble_packet_t) cua byte stream, 0 neu khong hop le
+static uint8_t stream_channel_mask(uint8_t stream)
+{
+    uint8_t off = stream >> 4;
+    switch(stream & 0x0F)
+    {
+        case HUST_STREAM_ECG:
+            return (uint8_t)(~off & ECG_CHANNEL_MASK_ALL);
+        case HUST_STREAM_IMU:
+            if(off & ~(IMU_CHANNEL_MASK_ALL >> IMU_CHANNEL_MASK_SHIFT))
+            {
+                return 0;
+            }
+            return (uint8_t)(~(off << IMU_CHANNEL_MASK_SHIFT) & IMU_CHANNEL_MASK_ALL);
+        default:
+            return 0;
+    }
+}
+
+uint8_t hust_sched_stream_byte(uint8_t stream, uint8_t channel_mask)
+{
+    uint8_t off = stream == HUST_STREAM_ECG ? (uint8_t)(~channel_mask & ECG_CHANNEL_MASK_ALL)
+                : (uint8_t)((~channel_mask & IMU_CHANNEL_MASK_ALL) >> IMU_CHANNEL_MASK_SHIFT);
+    return (uint8_t)(stream | (off << 4));
+}
+
+int hust_sched_sample_size(uint8_t stream)
+{
+    uint8_t mask = stream_channel_mask(stream);
+    switch(stream & 0x0F)
+    {
+        case HUST_STREAM_ECG: return ECG_DATA_LENGTH * ecg_channel_count(mask);
+        case HUST_STREAM_IMU: return IMU_DATA_LENGTH * imu_channel_count(mask);
+        default:              return 0;
+    }
+}
+
+int hust_sched_plan(const hust_sched_stream_t * streams, int n_streams, int data_size, uint8_t * take, bool * full)
+{
+    int used = 0;
+    bool done[HUST_STREAM_COUNT] = {false};
+
+    *full = false;
+    if(data_size > HUST_SCHED_MAX_DATA_SIZE)
+    {
+        data_size = HUST_SCHED_MAX_DATA_SIZE;
+    }
+    for(int i = 0; i < n_streams; i++)
+    {
+        take[i] = 0;
+    }
+    // stream rate thap truoc: phan dang cho nho, lay het de khong bi tre qua 1 packet
+    for(int k = 0; k < n_streams && k < HUST_STREAM_COUNT; k++)
+    {
+        int s = -1;
+        for(int i = 0; i < n_streams && i < HUST_STREAM_COUNT; i++)
+        {
+            if(!done[i] && (s < 0 || streams[i].rate < streams[s].rate))
+            {
+                s = i;
+            }
+        }
+        done[s] = true;
+        if(streams[s].pending == 0)
+        {
+            continue;
+        }
+        int size = hust_sched_sample_size(streams[s].stream);
+        if(size == 0)
+        {
+            continue;
+        }
+        int room = (data_size - used - HUST_SCHED_SEG_HEADER) / size;
+        int n = streams[s].pending;
+        if(n > 255)
+        {
+            n = 255;
+        }
+        if(room < n)
+        {
+            *full = true;
+            n = room > 0 ? room : 0;
+        }
+        if(n > 0)
+        {
+            take[s] = (uint8_t)n;
+            used += HUST_SCHED_SEG_HEADER + n * size;
+        }
+    }
+    return used;
+}
+
+void hust_sched_seg_header(uint8_t * out, uint8_t stream, uint8_t n, uint64_t first_index, uint16_t rate,
+                           uint64_t anchor_index, uint32_t t_anchor)
+{
+    if(anchor_index < first_index || anchor_index - first_index > 255)
+    {
+        t_anchor -= (uint32_t)((int64_t)(anchor_index - first_index) * HUST_SAMPLE_CLOCK_RTC_HZ / rate);
+        anchor_index = first_index;
+    }
+    t_anchor &= HUST_SAMPLE_CLOCK_RTC_MASK;
+    out[0] = stream;
+    out[1] = n;
+    out[2] = (uint8_t)(first_index >> 24);
+    out[3] = (uint8_t)(first_index >> 16);
+    out[4] = (uint8_t)(first_index >> 8);
+    out[5] = (uint8_t)first_index;
+    out[6] = (uint8_t)(anchor_index - first_index);
+    out[7] = (uint8_t)(t_anchor >> 16);
+    out[8] = (uint8_t)(t_anchor >> 8);
+    out[9] = (uint8_t)t_anchor;
+}
+
+int hust_sched_seg_read(const uint8_t * data, int length, hust_sched_seg_t * seg)
+{
+    if(length < HUST_SCHED_SEG_HEADER)
+    {
+        return -1;
+    }
+    int size = hust_sched_sample_size(data[0]);
+    int seg_size = HUST_SCHED_SEG_HEADER + data[1] * size;
+    if(size == 0 || seg_size > length)
+    {
+        return -1;
+    }
+    seg->stream = data[0] & 0x0F;
+    seg->channel_mask = stream_channel_mask(data[0]);
+    seg->sample_size = (uint8_t)size;
+    seg->n = data[1];
+    seg->first_index = ((uint32_t)data[2] << 24) | ((uint32_t)data[3] << 16) | ((uint32_t)data[4] << 8) | data[5];
+    seg->anchor = data[6];
+    seg->t_anchor = ((uint32_t)data[7] << 16) | ((uint32_t)data[8] << 8) | data[9];
+    seg->data = data + HUST_SCHED_SEG_HEADER;
+    return seg_size;
+}
+
+void hust_sched_ecg_get(const hust_sched_seg_t * seg, int i, ecg_data_t * ecg)
+{
+    const uint8_t * p = seg->data + i * seg->sample_size;
+    for(int ch = 0; ch < ECG_CHANNEL; ch++)
+    {
+        if(seg->channel_mask & (1 << ch))
+        {
+            memcpy(ecg_channel_get(ecg, ch)->byte, p, ECG_DATA_LENGTH);
+            p += ECG_DATA_LENGTH;
+        }
+        else
+        {
+            memset(ecg_channel_get(ecg, ch)->byte, 0, ECG_DATA_LENGTH);
+        }
+    }
+}
+
+void hust_sched_imu_get(const hust_sched_seg_t * seg, int i, imu_data_t * imu)
+{
+    const uint8_t * p = seg->data + i * seg->sample_size;
+    for(int a = 0; a < IMU_CHANNEL; a++)
+    {
+        if(seg->channel_mask & (1 << (IMU_CHANNEL_MASK_SHIFT + a)))
+        {
+            memcpy(imu_channel_get(imu, a)->byte, p, IMU_DATA_LENGTH);
+            p += IMU_DATA_LENGTH;
+        }
+        else
+        {
+            memset(imu_channel_get(imu, a)->byte, 0, IMU_DATA_LENGTH);
+        }
+    }
+}
+
+void hust_sched_timeline_init(hust_sched_timeline_t * tl, double nominal_rate)
+{
+    memset(tl, 0, sizeof(*tl));
+    tl->rate = nominal_rate;
+    tl->period = 1.0 / nominal_rate;
+}
+
+uint64_t hust_sched_timeline_anchor(hust_sched_timeline_t * tl, const hust_sched_seg_t * seg)
+{
+    if(!tl->have_anchor)
+    {
+        tl->have_anchor = true;
+        tl->tick = seg->t_anchor;
+        tl->index = seg->first_index;
+        tl->index0 = tl->index + seg->anchor;
+        tl->anchor_last = tl->index0;
+        tl->t0 = (double)tl->tick / HUST_SAMPLE_CLOCK_RTC_HZ;
+        tl->n = 1;
+        return tl->index;
+    }
+    // unwrap: hieu > nua vong la so am (moc lui nhe do tre ngat)
+    int32_t d_tick = (int32_t)((seg->t_anchor - (uint32_t)tl->tick) << 8) >> 8;
+    int32_t d_index = (int32_t)(seg->first_index - (uint32_t)tl->index);
+    tl->tick += (int64_t)d_tick;
+    tl->index += (int64_t)d_index;
+
+    uint64_t anchor = tl->index + seg->anchor;
+    if(anchor != tl->anchor_last)
+    {
+        // moc IMU lap lai qua nhieu segment cung 1 burst: chi tinh 1 lan
+        double x = (double)anchor - (double)tl->index0;
+        double y = (double)tl->tick / HUST_SAMPLE_CLOCK_RTC_HZ - tl->t0;
+        tl->anchor_last = anchor;
+        tl->n += 1;
+        tl->sx += x;
+        tl->sy += y;
+        tl->sxx += x * x;
+        tl->sxy += x * y;
+        double det = tl->n * tl->sxx - tl->sx * tl->sx;
+        if(x * tl->period >= 1.0 && det > 0)
+        {
+            tl->period = (tl->n * tl->sxy - tl->sx * tl->sy) / det;
+            tl->rate = 1.0 / tl->period;
+        }
+    }
+    return tl->index;
+}
+
+double hust_sched_timeline_time(const hust_sched_timeline_t * tl, uint64_t index)
+{
+    // duong hoi quy di qua diem trung binh cua cac moc
+    double x = (double)index - (double)tl->index0;
+    return tl->t0 + tl->sy / tl->n + tl->period * (x - tl->sx / tl->n);
+}
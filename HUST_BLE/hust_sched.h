@@ -0,0 +1,106 @@
+#ifndef HUST_SCHED_H__
+#define HUST_SCHED_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "hust_ble.h"
+
+/*
+ * Payload ALL_SENSOR_TYPE: nhieu stream (ECG, IMU), moi stream rate rieng. Header ble packet 11 byte
+ * giu nguyen (timestamp = chi so sample dau tien cua segment dau tien), data = cac segment noi tiep:
+ *
+ *   stream (1) | n (1) | first_index (4, BE) | anchor (1) | t_anchor (3, BE) | n sample
+ *
+ *   stream     : bit 0..3 = hust_stream_t, bit 4..7 = channel TAT cua stream (bit 4 + i = channel i),
+ *                0 = du channel (dinh dang truoc khi co channel mask)
+ *   first_index: 32 bit thap chi so sample dau tien theo dong ho lay mau cua stream do
+ *   anchor     : moc thoi gian cua stream la sample first_index + anchor (co the nam sau segment)
+ *   t_anchor   : tick RTC 24 bit (HUST_SAMPLE_CLOCK_RTC_HZ) luc lay mau sample moc. Thiet bi chon sample
+ *                co tick do truc tiep (ngat watermark IMU, ngat DMA ECG), khong ngoai suy theo rate danh
+ *                nghia. Host hoi quy cac moc (hust_sched_timeline_t) ra rate thuc cua tung stream (thach
+ *                anh IMU lech vai %) va thoi gian tung sample tren cung truc RTC
+ *   sample     : ECG 4 channel x 3 byte, IMU 3 truc x 2 byte, big-endian nhu ECG_SENSOR_TYPE, chi cac
+ *                channel bat theo thu tu channel
+ *
+ * hust_sched_plan chia packet theo so sample dang cho cua tung stream: stream cham (IMU 104 Hz) lay het
+ * phan dang cho truoc, stream nhanh (ECG 1000 Hz) lap day phan con lai. ECG 1000 Hz + IMU 104 Hz,
+ * MTU 247: ~17 ECG + ~1.8 IMU / packet, 59 packet/s, thay vi 3 + 2 co dinh (333 packet/s, xem hust_sched_bench).
+ */
+
+#define HUST_SCHED_SEG_HEADER       10
+#define HUST_SCHED_MAX_DATA_SIZE    255     // data_size cua ble packet la uint8
+
+typedef enum
+{
+    HUST_STREAM_ECG = 0,
+    HUST_STREAM_IMU,
+    HUST_STREAM_COUNT
+} hust_stream_t;
+
+typedef struct
+{
+    uint8_t stream;                 // byte stream cua segment (hust_sched_stream_byte)
+    uint16_t rate;                  // Hz, danh nghia
+    uint16_t pending;               // sample dang cho dong goi
+} hust_sched_stream_t;
+
+typedef struct
+{
+    uint8_t stream;                 // hust_stream_t
+    uint8_t channel_mask;           // channel bat, bo tri bit nhu ble_packet_t.channel_mask
+    uint8_t sample_size;
+    uint8_t n;
+    uint32_t first_index;
+    uint8_t anchor;
+    uint32_t t_anchor;
+    const uint8_t * data;           // n * sample_size byte
+} hust_sched_seg_t;
+
+// byte stream cua segment tu hust_stream_t va channel mask (bo tri bit nhu ble_packet_t.channel_mask)
+uint8_t hust_sched_stream_byte(uint8_t stream, uint8_t channel_mask);
+
+// so byte / sample theo byte stream, 0 neu stream khong hop le hoac khong con channel nao
+int hust_sched_sample_size(uint8_t stream);
+
+// chon so sample take[i] cua tung stream cho 1 packet data_size byte, tra ve so byte payload
+// *full = true neu con sample dang cho khong vua packet (packet day, nen gui ngay)
+int hust_sched_plan(const hust_sched_stream_t * streams, int n_streams, int data_size, uint8_t * take, bool * full);
+
+// ghi header segment (HUST_SCHED_SEG_HEADER byte), sample ghi tiep theo sau
+// moc: sample anchor_index (first_index <= anchor_index <= first_index + 255) lay mau luc t_anchor
+// anchor_index ngoai khoang: ngoai suy ve sample dau tien theo rate danh nghia
+void hust_sched_seg_header(uint8_t * out, uint8_t stream, uint8_t n, uint64_t first_index, uint16_t rate,
+                           uint64_t anchor_index, uint32_t t_anchor);
+
+// doc segment tai data[0], tra ve so byte cua segment, -1 neu du lieu loi
+int hust_sched_seg_read(const uint8_t * data, int length, hust_sched_seg_t * seg);
+
+// doc sample thu i cua segment, channel tat = 0
+void hust_sched_ecg_get(const hust_sched_seg_t * seg, int i, ecg_data_t * ecg);
+void hust_sched_imu_get(const hust_sched_seg_t * seg, int i, imu_data_t * imu);
+
+// thoi gian tung sample cua 1 stream phia host: hoi quy tuyen tinh t = t0 + period * (index - index0)
+// tren cac moc cua segment (sai so luong tu tick va tre ngat trung binh di)
+typedef struct
+{
+    double rate;                    // Hz: danh nghia, sau >= 1 s moc la rate hoi quy
+    bool have_anchor;
+    uint64_t index0;                // moc dau tien
+    double t0;                      // s
+    double period;                  // s / sample
+    uint64_t tick;                  // tick RTC cua moc moi nhat, da unwrap
+    uint64_t index;                 // first_index cua segment moi nhat, da unwrap
+    uint64_t anchor_last;           // chi so sample cua moc moi nhat
+    double n, sx, sy, sxx, sxy;     // tong hoi quy, x = index - index0, y = t - t(index0)
+} hust_sched_timeline_t;
+
+void hust_sched_timeline_init(hust_sched_timeline_t * tl, double nominal_rate);
+
+// them moc cua 1 segment, tra ve chi so sample 64 bit cua sample dau tien segment
+uint64_t hust_sched_timeline_anchor(hust_sched_timeline_t * tl, const hust_sched_seg_t * seg);
+
+// thoi gian (s, truc RTC thiet bi) cua sample index
+double hust_sched_timeline_time(const hust_sched_timeline_t * tl, uint64_t index);
+
+#endif // HUST_SCHED_H__
@@ -0,0 +1,183 @@
+#include "hust_siggen.h"
+
+// 1 nhip PQRST (tong cac ham Gauss P, Q, R, S, T), Q15
+static const int16_t ecg_template[SIGGEN_TABLE_SIZE] =
+{
+         0,      0,      0,      0,      0,      0,      0,      0,      0,      0,      0,      0,
+         0,      0,      0,      0,      0,      0,      0,      0,      0,      0,      0,      0,
+         0,      1,      2,      3,      6,     10,     16,     27,     44,     69,    106,    160,
+       234,    335,    469,    639,    850,   1104,   1399,   1730,   2088,   2459,   2827,   3170,
+      3470,   3706,   3864,   3930,   3901,   3780,   3573,   3297,   2968,   2608,   2236,   1871,
+      1528,   1217,    947,    719,    532,    385,    271,    187,    125,     82,     53,     33,
+        20,     12,      7,      4,      2,      1,      1,      0,      0,      0,      0,      0,
+        -1,     -4,    -15,    -52,   -156,   -403,   -889,  -1677,  -2689,  -3618,  -3945,  -3085,
+      -597,   3684,   9585,  16544,  23560,  29277,  32348,  31943,  28116,  21758,  14190,   6707,
+       332,  -4235,  -6652,  -7028,  -5935,  -4189,  -2510,  -1285,   -563,   -212,    -68,    -19,
+        -4,     -1,      0,      1,      1,      1,      2,      2,      3,      4,      6,      8,
+        11,     15,     19,     25,     33,     43,     55,     71,     90,    114,    144,    180,
+       224,    277,    340,    415,    504,    608,    729,    868,   1028,   1210,   1415,   1646,
+      1902,   2185,   2494,   2830,   3191,   3577,   3985,   4413,   4857,   5313,   5776,   6242,
+      6704,   7156,   7592,   8006,   8392,   8742,   9051,   9315,   9528,   9686,   9787,   9829,
+      9811,   9733,   9598,   9406,   9163,   8871,   8536,   8164,   7761,   7333,   6886,   6427,
+      5962,   5497,   5038,   4589,   4154,   3738,   3343,   2971,   2625,   2305,   2012,   1745,
+      1505,   1289,   1098,    930,    782,    654,    544,    449,    369,    301,    244,    197,
+       158,    126,     99,     78,     61,     48,     37,     28,     22,     16,     12,      9,
+         7,      5,      4,      3,      2,      1,      1,      1,      1,      0,      0,      0,
+         0,      0,      0,      0,      0,      0,      0,      0,      0,      0,      0,      0,
+         0,      0,      0,      0,
+};
+
+// sin 1 chu ky, Q15
+static const int16_t sine_table[SIGGEN_TABLE_SIZE] =
+{
+         0,    804,   1608,   2410,   3212,   4011,   4808,   5602,   6393,   7179,   7962,   8739,
+      9512,  10278,  11039,  11793,  12539,  13279,  14010,  14732,  15446,  16151,  16846,  17530,
+     18204,  18868,  19519,  20159,  20787,  21403,  22005,  22594,  23170,  23731,  24279,  24811,
+     25329,  25832,  26319,  26790,  27245,  27683,  28105,  28510,  28898,  29268,  29621,  29956,
+     30273,  30571,  30852,  31113,  31356,  31580,  31785,  31971,  32137,  32285,  32412,  32521,
+     32609,  32678,  32728,  32757,  32767,  32757,  32728,  32678,  32609,  32521,  32412,  32285,
+     32137,  31971,  31785,  31580,  31356,  31113,  30852,  30571,  30273,  29956,  29621,  29268,
+     28898,  28510,  28105,  27683,  27245,  26790,  26319,  25832,  25329,  24811,  24279,  23731,
+     23170,  22594,  22005,  21403,  20787,  20159,  19519,  18868,  18204,  17530,  16846,  16151,
+     15446,  14732,  14010,  13279,  12539,  11793,  11039,  10278,   9512,   8739,   7962,   7179,
+      6393,   5602,   4808,   4011,   3212,   2410,   1608,    804,      0,   -804,  -1608,  -2410,
+     -3212,  -4011,  -4808,  -5602,  -6393,  -7179,  -7962,  -8739,  -9512, -10278, -11039, -11793,
+    -12539, -13279, -14010, -14732, -15446, -16151, -16846, -17530, -18204, -18868, -19519, -20159,
+    -20787, -21403, -22005, -22594, -23170, -23731, -24279, -24811, -25329, -25832, -26319, -26790,
+    -27245, -27683, -28105, -28510, -28898, -29268, -29621, -29956, -30273, -30571, -30852, -31113,
+    -31356, -31580, -31785, -31971, -32137, -32285, -32412, -32521, -32609, -32678, -32728, -32757,
+    -32767, -32757, -32728, -32678, -32609, -32521, -32412, -32285, -32137, -31971, -31785, -31580,
+    -31356, -31113, -30852, -30571, -30273, -29956, -29621, -29268, -28898, -28510, -28105, -27683,
+    -27245, -26790, -26319, -25832, -25329, -24811, -24279, -23731, -23170, -22594, -22005, -21403,
+    -20787, -20159, -19519, -18868, -18204, -17530, -16846, -16151, -15446, -14732, -14010, -13279,
+    -12539, -11793, -11039, -10278,  -9512,  -8739,  -7962,  -7179,  -6393,  -5602,  -4808,  -4011,
+     -3212,  -2410,  -1608,   -804,
+};
+
+#define SIGGEN_ECG_WANDER_MHZ   300     // troi baseline 0.3 Hz
+#define SIGGEN_EEG_WAX_MHZ      200     // alpha manh/yeu theo chu ky 5 s
+#define SIGGEN_EMG_DUTY         90      // phan cua chu ky burst co hoat dong co (/256)
+
+static uint32_t phase_inc_get(uint32_t freq_mhz, uint32_t sample_rate)
+{
+    return (uint32_t)((((uint64_t)freq_mhz) << 32) / ((uint64_t)sample_rate * 1000));
+}
+
+static uint32_t rng_next(siggen_t * siggen)
+{
+    uint32_t x = siggen->rng;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    siggen->rng = x;
+    return x;
+}
+
+// so ngau nhien Q15 trong [-32768, 32767]
+static int32_t rng_q15(siggen_t * siggen)
+{
+    return (int32_t)(rng_next(siggen) >> 16) - 32768;
+}
+
+// tra bang voi noi suy tuyen tinh theo pha Q32, ket qua Q15
+static int32_t table_lookup(const int16_t * table, uint32_t phase)
+{
+    uint32_t index = phase >> 24;
+    int32_t frac = (int32_t)((phase >> 8) & 0xFFFF);
+    int32_t a = table[index];
+    int32_t b = table[(index + 1) & (SIGGEN_TABLE_SIZE - 1)];
+    return a + (((b - a) * frac) >> 16);
+}
+
+void siggen_init(siggen_t * siggen, siggen_type_t type, uint32_t sample_rate, uint32_t seed)
+{
+    siggen->type = type;
+    siggen->sample_rate = sample_rate;
+    siggen->rng = seed ? seed : 1;
+    siggen->phase = 0;
+    siggen->slow_phase = 0;
+    siggen->lp_fast = 0;
+    siggen->lp_slow = 0;
+    siggen->pink_sum = 0;
+    siggen->pink_count = 0;
+    for(int i = 0; i < SIGGEN_PINK_ROWS; i++)
+    {
+        siggen->pink_row[i] = 0;
+    }
+    switch(type)
+    {
+        case SIGGEN_ECG:
+            siggen->amplitude = 4000;       // ~1.1 mV voi ADS1298 gain 6
+            siggen->noise = 40;
+            siggen->slow_phase_inc = phase_inc_get(SIGGEN_ECG_WANDER_MHZ, sample_rate);
+            siggen_set_heart_rate(siggen, SIGGEN_ECG_HEART_RATE);
+            break;
+        case SIGGEN_EMG:
+            siggen->amplitude = 3000;
+            siggen->noise = 20;
+            siggen->phase_inc = phase_inc_get(SIGGEN_EMG_BURST_MHZ, sample_rate);
+            siggen->slow_phase_inc = 0;
+            break;
+        case SIGGEN_EEG:
+            siggen->amplitude = 200;        // ~50 uV
+            siggen->noise = 10;
+            siggen->phase_inc = phase_inc_get(SIGGEN_EEG_ALPHA_MHZ, sample_rate);
+            siggen->slow_phase_inc = phase_inc_get(SIGGEN_EEG_WAX_MHZ, sample_rate);
+            break;
+    }
+}
+
+void siggen_set_heart_rate(siggen_t * siggen, uint32_t bpm)
+{
+    siggen->phase_inc = phase_inc_get(bpm * 1000 / 60, siggen->sample_rate);
+}
+
+int32_t siggen_next(siggen_t * siggen)
+{
+    int32_t value = 0;
+    int32_t white = (rng_q15(siggen) * siggen->noise) >> 15;
+
+    switch(siggen->type)
+    {
+        case SIGGEN_ECG:
+            value = (table_lookup(ecg_template, siggen->phase) * siggen->amplitude) >> 15;
+            value += (table_lookup(sine_table, siggen->slow_phase) * (siggen->amplitude >> 3)) >> 15;
+            break;
+
+        case SIGGEN_EMG:
+        {
+            // nhieu trang qua loc thong dai (2 loc thong thap 1 cuc), dieu bien bang cua so burst
+            int32_t x = rng_q15(siggen);
+            siggen->lp_fast += (x - siggen->lp_fast) >> 1;
+            siggen->lp_slow += (siggen->lp_fast - siggen->lp_slow) >> 4;
+            uint32_t index = siggen->phase >> 24;
+            int32_t envelope = 1024;        // hoat dong co nen
+            if(index < SIGGEN_EMG_DUTY)
+            {
+                envelope += sine_table[index * (SIGGEN_TABLE_SIZE / 2) / SIGGEN_EMG_DUTY];
+            }
+            value = (((siggen->lp_fast - siggen->lp_slow) * envelope) >> 15) * siggen->amplitude >> 15;
+        } break;
+
+        case SIGGEN_EEG:
+        {
+            // 1/f (Voss-McCartney): moi sample chi thay 1 hang
+            uint32_t row = 0;
+            siggen->pink_count++;
+            while(row < SIGGEN_PINK_ROWS - 1 && ((siggen->pink_count >> row) & 1) == 0)
+            {
+                row++;
+            }
+            int32_t x = rng_q15(siggen);
+            siggen->pink_sum += x - siggen->pink_row[row];
+            siggen->pink_row[row] = x;
+            int32_t wax = (table_lookup(sine_table, siggen->slow_phase) + 32768) >> 1;     // 0..1 Q15
+            int32_t alpha = (table_lookup(sine_table, siggen->phase) * wax) >> 15;
+            value = (((siggen->pink_sum >> 3) + alpha) * siggen->amplitude) >> 15;
+        } break;
+    }
+
+    siggen->phase += siggen->phase_inc;
+    siggen->slow_phase += siggen->slow_phase_inc;
+    return value + white;
+}
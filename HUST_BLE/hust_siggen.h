@@ -0,0 +1,50 @@
+#ifndef HUST_SIGGEN_H__
+#define HUST_SIGGEN_H__
+
+#include <stdint.h>
+
+// nguon tin hieu gia lap ECG/EMG/EEG: dung bang + so nguyen (fixed-point), tat dinh theo seed
+// dung chung cho firmware va host (benchmark codec, filter, throughput)
+
+#define SIGGEN_TABLE_SIZE       256
+#define SIGGEN_PINK_ROWS        8       // so hang Voss-McCartney cho nhieu 1/f
+
+#define SIGGEN_ECG_HEART_RATE   72      // bpm mac dinh
+#define SIGGEN_EMG_BURST_MHZ    500     // chu ky burst EMG mac dinh (0.5 Hz)
+#define SIGGEN_EEG_ALPHA_MHZ    10000   // nhip alpha 10 Hz
+
+typedef enum
+{
+    SIGGEN_ECG = 0,
+    SIGGEN_EMG,
+    SIGGEN_EEG
+} siggen_type_t;
+
+typedef struct
+{
+    siggen_type_t type;
+    uint32_t sample_rate;
+    uint32_t rng;                       // xorshift32
+    int32_t amplitude;                  // bien do dinh (LSB cua ADC 24 bit)
+    int32_t noise;                      // bien do nhieu trang (LSB)
+    uint32_t phase;                     // ECG: pha nhip tim, EMG: pha burst, EEG: pha alpha (Q32)
+    uint32_t phase_inc;
+    uint32_t slow_phase;                // ECG: troi baseline, EEG: dieu bien alpha (Q32)
+    uint32_t slow_phase_inc;
+    int32_t lp_fast;                    // EMG: loc thong dai = lp_fast - lp_slow
+    int32_t lp_slow;
+    int32_t pink_row[SIGGEN_PINK_ROWS]; // EEG: nhieu 1/f
+    int32_t pink_sum;
+    uint32_t pink_count;
+} siggen_t;
+
+// khoi tao nguon tin hieu voi tham so mac dinh theo type, seed khac 0
+void siggen_init(siggen_t * siggen, siggen_type_t type, uint32_t sample_rate, uint32_t seed);
+
+// doi nhip tim (chi dung cho SIGGEN_ECG)
+void siggen_set_heart_rate(siggen_t * siggen, uint32_t bpm);
+
+// lay sample tiep theo
+int32_t siggen_next(siggen_t * siggen);
+
+#endif // HUST_SIGGEN_H__
@@ -0,0 +1,67 @@
+#include <string.h>
+
+#include "hust_state.h"
+
+void hust_state_init(hust_state_t * sm, uint32_t buffer_timeout, uint32_t tick_mask)
+{
+    memset(sm, 0, sizeof(hust_state_t));
+    sm->state = HUST_STATE_IDLE;
+    sm->buffer_timeout = buffer_timeout;
+    sm->tick_mask = tick_mask;
+    sm->entered[HUST_STATE_IDLE] = 1;
+}
+
+static hust_state_id_t next_state(const hust_state_t * sm, const hust_state_input_t * input, uint32_t now)
+{
+    if(!input->enabled)
+    {
+        return HUST_STATE_IDLE;
+    }
+    if(input->connected && input->notifying)
+    {
+        return HUST_STATE_STREAMING;
+    }
+    switch(sm->state)
+    {
+        case HUST_STATE_STREAMING:
+            // mat ket noi: giu sample; con ket noi ma tat notify: central khong muon nhan
+            return input->connected ? HUST_STATE_ARMED : HUST_STATE_BUFFERING;
+        case HUST_STATE_BUFFERING:
+            // ket noi lai nhung chua bat notify van giu sample
+            if(sm->buffer_timeout != 0 && ((now - sm->t_enter) & sm->tick_mask) >= sm->buffer_timeout)
+            {
+                return HUST_STATE_ARMED;
+            }
+            return HUST_STATE_BUFFERING;
+        default:
+            return HUST_STATE_ARMED;
+    }
+}
+
+hust_state_id_t hust_state_update(hust_state_t * sm, const hust_state_input_t * input, uint32_t now)
+{
+    hust_state_id_t state = next_state(sm, input, now);
+    if(state != sm->state)
+    {
+        sm->state = state;
+        sm->t_enter = now;
+        sm->entered[state]++;
+    }
+    return state;
+}
+
+bool hust_state_sampling(hust_state_id_t state)
+{
+    return state == HUST_STATE_STREAMING || state == HUST_STATE_BUFFERING;
+}
+
+bool hust_state_sending(hust_state_id_t state)
+{
+    return state == HUST_STATE_STREAMING;
+}
+
+const char * hust_state_name(hust_state_id_t state)
+{
+    static const char * name[HUST_STATE_COUNT] = {"idle", "armed", "streaming", "buffering"};
+    return state < HUST_STATE_COUNT ? name[state] : "?";
+}
@@ -0,0 +1,66 @@
+#ifndef HUST_STATE_H__
+#define HUST_STATE_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * May trang thai lay mau, dung chung cho firmware va host. Nguon lay mau (timer, SAADC, ADS, IMU)
+ * va nguon cap cam bien chi bat khi can:
+ *
+ *   IDLE       STOP (lenh NUS)                                 tat nguon, khong gui
+ *   ARMED      START nhung chua co central bat notify NUS TX   tat nguon, cho CCCD
+ *   STREAMING  da ket noi + notify NUS TX bat                  lay mau, gui packet
+ *   BUFFERING  dang STREAMING thi mat ket noi                  lay mau, giu sample trong buffer
+ *
+ *   IDLE      --START-->                 ARMED / STREAMING
+ *   ARMED     --COMM_STARTED-->          STREAMING
+ *   STREAMING --DISCONNECTED-->          BUFFERING
+ *   STREAMING --COMM_STOPPED-->          ARMED     (central tu tat notify, khong can giu sample)
+ *   BUFFERING --COMM_STARTED-->          STREAMING (gui lai phan da giu truoc)
+ *   BUFFERING --het buffer_timeout-->    ARMED     (bo sample da giu)
+ *   bat ky    --STOP-->                  IDLE
+ *
+ * Trang thai chi tinh lai tu dau vao (enabled / connected / notifying) trong vong lap main, cac
+ * handler su kien BLE chi cap nhat dau vao.
+ */
+
+typedef enum
+{
+    HUST_STATE_IDLE = 0,
+    HUST_STATE_ARMED,
+    HUST_STATE_STREAMING,
+    HUST_STATE_BUFFERING,
+    HUST_STATE_COUNT
+} hust_state_id_t;
+
+typedef struct
+{
+    bool enabled;                       // START / STOP (hust_cmd_config_t.streaming)
+    bool connected;                     // BLE_GAP_EVT_CONNECTED / DISCONNECTED
+    bool notifying;                     // BLE_NUS_EVT_COMM_STARTED / COMM_STOPPED
+} hust_state_input_t;
+
+typedef struct
+{
+    hust_state_id_t state;
+    uint32_t buffer_timeout;            // tick, 0 = giu sample den khi ket noi lai
+    uint32_t tick_mask;                 // tick RTC 24 bit: HUST_SAMPLE_CLOCK_RTC_MASK
+    uint32_t t_enter;                   // tick luc vao state hien tai
+    uint32_t entered[HUST_STATE_COUNT]; // so lan vao tung state
+} hust_state_t;
+
+void hust_state_init(hust_state_t * sm, uint32_t buffer_timeout, uint32_t tick_mask);
+
+// tinh lai trang thai tu dau vao tai tick now, tra ve trang thai moi
+hust_state_id_t hust_state_update(hust_state_t * sm, const hust_state_input_t * input, uint32_t now);
+
+// nguon lay mau phai chay (STREAMING, BUFFERING)
+bool hust_state_sampling(hust_state_id_t state);
+
+// packet duoc gui (STREAMING)
+bool hust_state_sending(hust_state_id_t state);
+
+const char * hust_state_name(hust_state_id_t state);
+
+#endif // HUST_STATE_H__
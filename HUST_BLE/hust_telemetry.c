@@ -0,0 +1,208 @@
+#include <string.h>
+
+#include "hust_telemetry.h"
+
+static uint8_t * put_u16(uint8_t * p, uint16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    return p + 2;
+}
+
+static uint8_t * put_u32(uint8_t * p, uint32_t v)
+{
+    p = put_u16(p, (uint16_t)v);
+    return put_u16(p, (uint16_t)(v >> 16));
+}
+
+static const uint8_t * get_u16(const uint8_t * p, uint16_t * v)
+{
+    *v = (uint16_t)(p[0] | (p[1] << 8));
+    return p + 2;
+}
+
+static const uint8_t * get_u32(const uint8_t * p, uint32_t * v)
+{
+    uint16_t lo, hi;
+    p = get_u16(p, &lo);
+    p = get_u16(p, &hi);
+    *v = lo | ((uint32_t)hi << 16);
+    return p;
+}
+
+void hust_telemetry_encode(const hust_telemetry_t * telemetry, uint8_t * out)
+{
+    uint8_t * p = out;
+    *p++ = HUST_TELEMETRY_VERSION;
+    p = put_u32(p, telemetry->samples_acquired);
+    p = put_u32(p, telemetry->samples_dropped);
+    p = put_u32(p, telemetry->packets_built);
+    p = put_u32(p, telemetry->packets_sent);
+    p = put_u32(p, telemetry->nus_resources);
+    p = put_u32(p, telemetry->nus_errors);
+    p = put_u32(p, telemetry->bytes_sent);
+    p = put_u32(p, telemetry->throughput_bps);
+    p = put_u16(p, telemetry->mtu);
+    *p++ = telemetry->tx_phy;
+    *p++ = telemetry->rx_phy;
+    *p++ = telemetry->hvn_inflight;
+    *p++ = telemetry->hvn_high_water;
+    p = put_u16(p, telemetry->ring_high_water);
+    p = put_u32(p, telemetry->history_ms);
+    p = put_u32(p, telemetry->history_capacity_ms);
+    *p++ = telemetry->hvn_tx_queue;
+    p = put_u16(p, telemetry->event_length);
+    put_u16(p, telemetry->conn_interval);
+}
+
+int hust_telemetry_decode(const uint8_t * in, int length, hust_telemetry_t * telemetry)
+{
+    const uint8_t * p = in;
+    if(length < HUST_TELEMETRY_SIZE || *p++ != HUST_TELEMETRY_VERSION)
+    {
+        return -1;
+    }
+    p = get_u32(p, &telemetry->samples_acquired);
+    p = get_u32(p, &telemetry->samples_dropped);
+    p = get_u32(p, &telemetry->packets_built);
+    p = get_u32(p, &telemetry->packets_sent);
+    p = get_u32(p, &telemetry->nus_resources);
+    p = get_u32(p, &telemetry->nus_errors);
+    p = get_u32(p, &telemetry->bytes_sent);
+    p = get_u32(p, &telemetry->throughput_bps);
+    p = get_u16(p, &telemetry->mtu);
+    telemetry->tx_phy = *p++;
+    telemetry->rx_phy = *p++;
+    telemetry->hvn_inflight = *p++;
+    telemetry->hvn_high_water = *p++;
+    p = get_u16(p, &telemetry->ring_high_water);
+    p = get_u32(p, &telemetry->history_ms);
+    p = get_u32(p, &telemetry->history_capacity_ms);
+    telemetry->hvn_tx_queue = *p++;
+    p = get_u16(p, &telemetry->event_length);
+    get_u16(p, &telemetry->conn_interval);
+    return 0;
+}
+
+void hust_telemetry_hvn_queued(hust_telemetry_t * telemetry)
+{
+    telemetry->hvn_inflight++;
+    if(telemetry->hvn_inflight > telemetry->hvn_high_water)
+    {
+        telemetry->hvn_high_water = telemetry->hvn_inflight;
+    }
+}
+
+void hust_telemetry_hvn_complete(hust_telemetry_t * telemetry, uint8_t count)
+{
+    telemetry->hvn_inflight = count < telemetry->hvn_inflight ? telemetry->hvn_inflight - count : 0;
+}
+
+void hust_telemetry_ring_level(hust_telemetry_t * telemetry, uint16_t level)
+{
+    if(level > telemetry->ring_high_water)
+    {
+        telemetry->ring_high_water = level;
+    }
+}
+
+void hust_telemetry_tick(hust_telemetry_t * telemetry, uint32_t elapsed_ms)
+{
+    if(elapsed_ms > 0)
+    {
+        telemetry->throughput_bps = (uint32_t)((uint64_t)(telemetry->bytes_sent - telemetry->bytes_sent_last_tick) * 8000u / elapsed_ms);
+    }
+    telemetry->bytes_sent_last_tick = telemetry->bytes_sent;
+}
+
+#ifndef HUST_HOST_BUILD
+uint32_t hust_telemetry_service_init(hust_telemetry_service_t * service, uint8_t uuid_type)
+{
+    uint32_t err_code;
+    ble_uuid_t ble_uuid;
+    ble_add_char_params_t add_char_params;
+    uint8_t init_value[HUST_TELEMETRY_SIZE] = {HUST_TELEMETRY_VERSION};
+
+    service->conn_handle = BLE_CONN_HANDLE_INVALID;
+    service->notify_enabled = false;
+
+    ble_uuid.type = uuid_type;
+    ble_uuid.uuid = HUST_TELEMETRY_UUID_SERVICE;
+    err_code = sd_ble_gatts_service_add(BLE_GATTS_SRVC_TYPE_PRIMARY, &ble_uuid, &service->service_handle);
+    if(err_code != NRF_SUCCESS)
+    {
+        return err_code;
+    }
+
+    memset(&add_char_params, 0, sizeof(add_char_params));
+    add_char_params.uuid = HUST_TELEMETRY_UUID_CHAR;
+    add_char_params.uuid_type = uuid_type;
+    add_char_params.max_len = HUST_TELEMETRY_SIZE;
+    add_char_params.init_len = HUST_TELEMETRY_SIZE;
+    add_char_params.p_init_value = init_value;
+    add_char_params.char_props.read = 1;
+    add_char_params.char_props.notify = 1;
+    add_char_params.read_access = SEC_OPEN;
+    add_char_params.cccd_write_access = SEC_OPEN;
+
+    return characteristic_add(service->service_handle, &add_char_params, &service->telemetry_handles);
+}
+
+void hust_telemetry_service_on_ble_evt(ble_evt_t const * p_ble_evt, void * p_context)
+{
+    hust_telemetry_service_t * service = (hust_telemetry_service_t *)p_context;
+
+    switch(p_ble_evt->header.evt_id)
+    {
+        case BLE_GAP_EVT_DISCONNECTED:
+            if(p_ble_evt->evt.gap_evt.conn_handle == service->conn_handle)
+            {
+                service->conn_handle = BLE_CONN_HANDLE_INVALID;
+                service->notify_enabled = false;
+            }
+            break;
+
+        case BLE_GATTS_EVT_WRITE:
+        {
+            ble_gatts_evt_write_t const * p_write = &p_ble_evt->evt.gatts_evt.params.write;
+            uint16_t conn_handle = p_ble_evt->evt.gatts_evt.conn_handle;
+            if(p_write->handle == service->telemetry_handles.cccd_handle && p_write->len == 2
+               && (service->conn_handle == BLE_CONN_HANDLE_INVALID || service->conn_handle == conn_handle))
+            {
+                // notify cho central dang ky dau tien, den khi no ngat
+                service->conn_handle = conn_handle;
+                service->notify_enabled = ble_srv_is_notification_enabled(p_write->data);
+            }
+        } break;
+
+        default:
+            break;
+    }
+}
+
+uint32_t hust_telemetry_service_update(hust_telemetry_service_t * service, const hust_telemetry_t * telemetry)
+{
+    uint8_t value[HUST_TELEMETRY_SIZE];
+    ble_gatts_value_t gatts_value;
+
+    hust_telemetry_encode(telemetry, value);
+
+    memset(&gatts_value, 0, sizeof(gatts_value));
+    gatts_value.len = HUST_TELEMETRY_SIZE;
+    gatts_value.p_value = value;
+    uint32_t err_code = sd_ble_gatts_value_set(BLE_CONN_HANDLE_INVALID, service->telemetry_handles.value_handle, &gatts_value);
+    if(err_code != NRF_SUCCESS || service->conn_handle == BLE_CONN_HANDLE_INVALID || !service->notify_enabled)
+    {
+        return err_code;
+    }
+
+    ble_gatts_hvx_params_t hvx_params;
+    uint16_t length = HUST_TELEMETRY_SIZE;
+    memset(&hvx_params, 0, sizeof(hvx_params));
+    hvx_params.handle = service->telemetry_handles.value_handle;
+    hvx_params.type = BLE_GATT_HVX_NOTIFICATION;
+    hvx_params.p_len = &length;
+    hvx_params.p_data = value;
+    return sd_ble_gatts_hvx(service->conn_handle, &hvx_params);
+}
+#endif
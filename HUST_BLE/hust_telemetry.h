@@ -0,0 +1,85 @@
+#ifndef HUST_TELEMETRY_H__
+#define HUST_TELEMETRY_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// bo dem hieu nang cua pipeline lay mau -> dong goi -> NUS, doc/notify qua characteristic telemetry
+// phan ma hoa/giai ma dung chung cho firmware va host
+
+#define HUST_TELEMETRY_VERSION          3
+#define HUST_TELEMETRY_SIZE             54      // so byte sau ma hoa (little-endian)
+#define HUST_TELEMETRY_INTERVAL_MS      1000    // chu ky cap nhat throughput + notify
+
+#define HUST_TELEMETRY_UUID_SERVICE     0x0010  // dung chung base UUID voi NUS
+#define HUST_TELEMETRY_UUID_CHAR        0x0011
+
+typedef struct
+{
+    uint32_t samples_acquired;          // sample da dua vao buffer
+    uint32_t samples_dropped;           // sample bi bo o ISR (buffer chua san sang / da day)
+    uint32_t packets_built;
+    uint32_t packets_sent;              // ble_nus_data_send tra ve NRF_SUCCESS
+    uint32_t nus_resources;             // ble_nus_data_send tra ve NRF_ERROR_RESOURCES (hang doi HVN day)
+    uint32_t nus_errors;                // loi khac (chua ket noi, chua bat notify, ...)
+    uint32_t bytes_sent;
+    uint32_t throughput_bps;            // bit/s trong chu ky HUST_TELEMETRY_INTERVAL_MS gan nhat
+    uint16_t mtu;
+    uint8_t tx_phy;                     // BLE_GAP_PHY_1MBPS / 2MBPS / CODED
+    uint8_t rx_phy;
+    uint8_t hvn_inflight;               // so notification dang nam trong hang doi HVN
+    uint8_t hvn_high_water;
+    uint16_t ring_high_water;           // so sample cho dong goi lon nhat
+    uint32_t history_ms;                // du lieu dang giu trong lich su RAM (hust_hist) cho ket noi lai
+    uint32_t history_capacity_ms;       // lich su RAM giu duoc khi day, theo ty le nen hien tai
+    uint8_t hvn_tx_queue;               // hang doi HVN TX da cau hinh cho SoftDevice (BLE_CONN_CFG_GATTS)
+    uint16_t event_length;              // GAP event length da cau hinh, don vi 1.25 ms
+    uint16_t conn_interval;             // connection interval hien tai, don vi 1.25 ms
+
+    uint32_t bytes_sent_last_tick;      // noi bo, khong ma hoa
+} hust_telemetry_t;
+
+void hust_telemetry_encode(const hust_telemetry_t * telemetry, uint8_t * out);
+
+// tra ve 0 neu thanh cong, -1 neu sai kich thuoc/version
+int hust_telemetry_decode(const uint8_t * in, int length, hust_telemetry_t * telemetry);
+
+// cap nhat cac gia tri high-water
+void hust_telemetry_hvn_queued(hust_telemetry_t * telemetry);
+void hust_telemetry_hvn_complete(hust_telemetry_t * telemetry, uint8_t count);
+void hust_telemetry_ring_level(hust_telemetry_t * telemetry, uint16_t level);
+
+// goi moi HUST_TELEMETRY_INTERVAL_MS, tinh throughput tu bytes_sent
+void hust_telemetry_tick(hust_telemetry_t * telemetry, uint32_t elapsed_ms);
+
+#ifndef HUST_HOST_BUILD
+#include "ble.h"
+#include "ble_srv_common.h"
+#include "nrf_sdh_ble.h"
+
+#define HUST_TELEMETRY_BLE_OBSERVER_PRIO 2
+
+#define HUST_TELEMETRY_SERVICE_DEF(_name)                                       \
+static hust_telemetry_service_t _name;                                          \
+NRF_SDH_BLE_OBSERVER(_name ## _obs,                                             \
+                     HUST_TELEMETRY_BLE_OBSERVER_PRIO,                          \
+                     hust_telemetry_service_on_ble_evt, &_name)
+
+typedef struct
+{
+    uint16_t service_handle;
+    ble_gatts_char_handles_t telemetry_handles;
+    uint16_t conn_handle;               // central dau tien bat notify
+    bool notify_enabled;
+} hust_telemetry_service_t;
+
+// them service telemetry, uuid_type = base UUID da dang ky (m_nus.uuid_type)
+uint32_t hust_telemetry_service_init(hust_telemetry_service_t * service, uint8_t uuid_type);
+
+void hust_telemetry_service_on_ble_evt(ble_evt_t const * p_ble_evt, void * p_context);
+
+// cap nhat gia tri characteristic va notify neu central da bat CCCD
+uint32_t hust_telemetry_service_update(hust_telemetry_service_t * service, const hust_telemetry_t * telemetry);
+#endif
+
+#endif // HUST_TELEMETRY_H__
@@ -0,0 +1,297 @@
+/*
+ * Kiem tra driver hust_ads voi ADS129x gia lap (hust_ads_mock) va do toc do tach frame.
+ *
+ *   hust_ads_bench [-i id_hex] [-d devices] [-r rate] [-g gain] [-n frames]
+ *
+ * Mac dinh: 1 ADS1299 (id 3E), 1000 SPS, gain 6, 1000000 frame. -d 2..4: daisy chain 16..32 channel.
+ * Kiem tra: chuoi khoi tao (thanh ghi CONFIG1/CONFIG3/CHnSET), tu choi rate/gain khong hop le,
+ * phat hien header status sai (ca chip cuoi chuoi), gia tri tung channel sau hust_ads_frame_to_ecg /
+ * hust_ads_channel / hust_ads_demux trung voi gia tri mock da tao, va packet nhieu channel
+ * (hust_mc) giai ma lai dung voi tung codec. Tra ve 1 neu co loi.
+ *
+ * Toc do: so frame / s tach duoc tren host (ca block HUST_ADS_BUFFER_FRAMES frame nhu trong ngat),
+ * so voi rate can thiet, thoi gian bus SPI / frame o 4 MHz, 8 MHz, va voi moi codec: so frame /
+ * packet (MTU 247), packet/s va kbit/s o rate da chon.
+ *
+ * Build: cc -O2 -DHUST_HOST_BUILD -I../HUST_BLE -I. hust_ads_bench.c hust_ads_mock.c ../HUST_BLE/hust_ads.c ../HUST_BLE/hust_ble.c ../HUST_BLE/hust_siggen.c ../HUST_BLE/hust_mc.c ../HUST_BLE/hust_codec.c
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "hust_ads.h"
+#include "hust_ads_mock.h"
+#include "hust_mc.h"
+
+#define BENCH_BLOCK     32              // = HUST_ADS_BUFFER_FRAMES cua firmware
+#define BENCH_MC_FRAMES 16              // = EEG_PACK_FRAMES cua firmware
+#define BENCH_DATA_SIZE (247 - 3 - BLE_PACKET_HEADER_SIZE)
+
+static int failures = 0;
+
+#define CHECK(cond, ...) do { if(!(cond)) { failures++; fprintf(stderr, "FAIL: " __VA_ARGS__); fprintf(stderr, "\n"); } } while(0)
+
+static void usage(void)
+{
+    fprintf(stderr, "usage: hust_ads_bench [-i id_hex] [-d devices] [-r rate] [-g gain] [-n frames]\n");
+}
+
+static double time_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static void check_init(uint8_t id, uint8_t n_devices, uint32_t rate, uint8_t gain)
+{
+    hust_ads_mock_t mock;
+    hust_ads_io_t io;
+    hust_ads_t ads;
+
+    hust_ads_mock_init(&mock, id, n_devices, 1);
+    hust_ads_mock_io(&mock, &io);
+    CHECK(hust_ads_init(&ads, &io, n_devices, rate, gain) == 0, "init id %02x rate %u gain %u", id, rate, gain);
+    CHECK(ads.device == mock.device && ads.n_channels == mock.n_channels, "id decode %02x", id);
+    CHECK(ads.frame_size == n_devices * HUST_ADS_FRAME_SIZE(mock.chip_channels), "frame size");
+    CHECK(mock.rdatac, "init must leave the device in RDATAC");
+    CHECK(!mock.started, "init must not start conversions");
+    CHECK((mock.reg[HUST_ADS_REG_CONFIG1] & 0x07) == hust_ads_rate_code(mock.device, rate), "CONFIG1.DR");
+    CHECK((mock.reg[HUST_ADS_REG_CONFIG3] & 0x80) != 0, "CONFIG3.PD_REFBUF");
+    for(int ch = 0; ch < mock.chip_channels; ch++)
+    {
+        CHECK(mock.reg[HUST_ADS_REG_CH1SET + ch] == (hust_ads_gain_code(mock.device, gain) << 4), "CH%dSET", ch + 1);
+    }
+    CHECK(mock.delay_us >= 150000, "reference settle delay");
+    CHECK(mock.errors == 0, "mock reported %u protocol errors", mock.errors);
+
+    // doi rate luc chay (lenh SET_RATE): chi doi CONFIG1.DR, quay lai RDATAC
+    uint8_t config1 = mock.reg[HUST_ADS_REG_CONFIG1];
+    CHECK(hust_ads_set_rate(&ads, 2000) == 0 && ads.rate == 2000, "set rate 2000");
+    CHECK((mock.reg[HUST_ADS_REG_CONFIG1] & 0x07) == hust_ads_rate_code(mock.device, 2000)
+          && (mock.reg[HUST_ADS_REG_CONFIG1] & ~0x07) == (config1 & ~0x07), "CONFIG1 after set rate");
+    CHECK(mock.rdatac, "set rate must leave the device in RDATAC");
+    CHECK(hust_ads_set_rate(&ads, 3000) != 0 && ads.rate == 2000, "set rate 3000 accepted");
+    CHECK(mock.errors == 0, "mock reported %u protocol errors after set rate", mock.errors);
+}
+
+int main(int argc, char ** argv)
+{
+    uint8_t id = 0x3E;
+    uint8_t n_devices = 1;
+    uint32_t rate = 1000;
+    uint8_t gain = 6;
+    long n_frames = 1000000;
+
+    for(int i = 1; i < argc; i++)
+    {
+        if(strcmp(argv[i], "-i") == 0 && i + 1 < argc)
+        {
+            id = (uint8_t)strtoul(argv[++i], NULL, 16);
+        }
+        else if(strcmp(argv[i], "-d") == 0 && i + 1 < argc)
+        {
+            n_devices = (uint8_t)atoi(argv[++i]);
+        }
+        else if(strcmp(argv[i], "-r") == 0 && i + 1 < argc)
+        {
+            rate = (uint32_t)atol(argv[++i]);
+        }
+        else if(strcmp(argv[i], "-g") == 0 && i + 1 < argc)
+        {
+            gain = (uint8_t)atoi(argv[++i]);
+        }
+        else if(strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+        {
+            n_frames = atol(argv[++i]);
+        }
+        else
+        {
+            usage();
+            return 1;
+        }
+    }
+
+    // khoi tao: cac bien the ADS1298/ADS1299 va tham so sai
+    static const uint8_t ids[] = {0x3C, 0x3D, 0x3E, 0x90, 0x91, 0x92, 0xD2};
+    for(unsigned i = 0; i < sizeof(ids); i++)
+    {
+        check_init(ids[i], 1, 1000, 6);
+    }
+    check_init(0x3E, 1, 250, 24);
+    check_init(0x92, 1, 500, 12);
+    check_init(0x3E, 2, 500, 24);
+    check_init(0x3E, 4, 250, 24);
+    CHECK(hust_ads_rate_code(HUST_ADS1298, 250) < 0, "ADS1298 has no 250 SPS");
+    CHECK(hust_ads_gain_code(HUST_ADS1299, 3) < 0, "ADS1299 has no gain 3");
+
+    hust_ads_mock_t mock;
+    hust_ads_io_t io;
+    hust_ads_t ads;
+    hust_ads_device_t unknown_device;
+    uint8_t unknown_channels;
+    CHECK(hust_ads_decode_id(0x00, &unknown_device, &unknown_channels) != 0, "id 00 accepted");
+    hust_ads_mock_init(&mock, 0x92, 1, 1);
+    hust_ads_mock_io(&mock, &io);
+    CHECK(hust_ads_init(&ads, &io, 1, 250, 6) != 0, "ADS1298 accepted 250 SPS");
+    CHECK(hust_ads_init(&ads, &io, HUST_ADS_MAX_DEVICES + 1, 500, 6) != 0, "chain longer than HUST_ADS_MAX_DEVICES accepted");
+
+    if(hust_ads_mock_init(&mock, id, n_devices, 1) != 0)
+    {
+        fprintf(stderr, "unknown id %02x or device count %u\n", id, n_devices);
+        return 1;
+    }
+    hust_ads_mock_io(&mock, &io);
+    if(hust_ads_init(&ads, &io, n_devices, rate, gain) != 0)
+    {
+        fprintf(stderr, "init failed (rate %u, gain %u)\n", rate, gain);
+        return 1;
+    }
+    hust_ads_start(&ads);
+
+    // stream: doc tung block qua SPI gia lap, roi tach nhu ngat TIMER2 cua firmware
+    uint8_t * frames = malloc(BENCH_BLOCK * ads.frame_size);
+    int32_t * expected = malloc(BENCH_BLOCK * ads.n_channels * sizeof(int32_t));
+    int32_t * demux = malloc(BENCH_BLOCK * ads.n_channels * sizeof(int32_t));
+    int32_t * history = malloc((n_frames + BENCH_BLOCK) * (size_t)ads.n_channels * sizeof(int32_t));
+    double parse_ns = 0;
+    double demux_ns = 0;
+    long mismatches = 0;
+    long bad_status = 0;
+    uint64_t checksum = 0;
+
+    for(long done = 0; done < n_frames; done += BENCH_BLOCK)
+    {
+        mock.trace = expected;
+        for(int i = 0; i < BENCH_BLOCK; i++)
+        {
+            io.xfer(io.p_context, NULL, 0, frames + i * ads.frame_size, ads.frame_size);
+        }
+
+        ecg_data_t ecg[BENCH_BLOCK];
+        uint32_t status;
+        int bad = 0;
+        double t0 = time_ns();
+        for(int i = 0; i < BENCH_BLOCK; i++)
+        {
+            bad |= hust_ads_frame_to_ecg(frames + i * ads.frame_size, &ecg[i], &status);
+        }
+        double t1 = time_ns();
+        bad_status += hust_ads_demux(&ads, frames, BENCH_BLOCK, demux);
+        demux_ns += time_ns() - t1;
+        parse_ns += t1 - t0;
+
+        CHECK(bad == 0, "status header at frame %ld", done);
+        for(int i = 0; i < BENCH_BLOCK; i++)
+        {
+            for(int ch = 0; ch < ads.n_channels; ch++)
+            {
+                int32_t want = expected[i * ads.n_channels + ch];
+                int32_t got = hust_ads_channel(&ads, frames + i * ads.frame_size, ch);
+                if(ch < ECG_CHANNEL)
+                {
+                    int32_t packed = ecg_sample_to_int32(*ecg_channel_get(&ecg[i], ch));
+                    mismatches += packed != want;
+                    checksum += (uint32_t)packed;
+                }
+                mismatches += got != want;
+                mismatches += demux[i * ads.n_channels + ch] != want;
+            }
+        }
+        if(history != NULL)
+        {
+            memcpy(history + done * ads.n_channels, demux, BENCH_BLOCK * ads.n_channels * sizeof(int32_t));
+        }
+    }
+    CHECK(mismatches == 0, "%ld channel values differ from the mock", mismatches);
+    CHECK(bad_status == 0, "%ld frames with a bad status header", bad_status);
+    CHECK(mock.errors == 0, "mock reported %u protocol errors while streaming", mock.errors);
+
+    // chip cuoi chuoi mat dong bo: hust_ads_demux phai phat hien
+    uint8_t saved = frames[(ads.n_devices - 1) * ads.chip_frame_size];
+    frames[(ads.n_devices - 1) * ads.chip_frame_size] = 0x00;
+    CHECK(hust_ads_demux(&ads, frames, 1, demux) == 1, "bad status of the last device not detected");
+    frames[(ads.n_devices - 1) * ads.chip_frame_size] = saved;
+
+    // header status sai phai bi loai
+    ecg_data_t ecg_bad;
+    uint32_t status_bad;
+    frames[0] = 0x00;
+    CHECK(hust_ads_frame_to_ecg(frames, &ecg_bad, &status_bad) != 0, "corrupt status accepted");
+
+    double fps = (double)mock.frames / (parse_ns / 1e9);
+    double demux_fps = (double)mock.frames / (demux_ns / 1e9);
+    double frame_bits = ads.frame_size * 8.0;
+    printf("device        %u x %s id %02x, %u channels, frame %u bytes\n", ads.n_devices,
+           ads.device == HUST_ADS1299 ? "ADS1299" : "ADS1298", ads.id, ads.n_channels, ads.frame_size);
+    printf("frames        %llu (checksum %llx)\n", (unsigned long long)mock.frames, (unsigned long long)checksum);
+    printf("parse         %.1f Mframe/s, %.1f MB/s, %.1f ns/frame (first %d channels -> ecg_data_t)\n",
+           fps / 1e6, fps * ads.frame_size / 1e6, parse_ns / (double)mock.frames, ECG_CHANNEL);
+    printf("demux         %.1f Mframe/s, %.1f MB/s, %.1f ns/frame (%u channels -> int32)\n",
+           demux_fps / 1e6, demux_fps * ads.frame_size / 1e6, demux_ns / (double)mock.frames, ads.n_channels);
+    printf("headroom      %.0fx real time at %u SPS\n", demux_fps / rate, rate);
+    printf("spi           %.2f us/frame at 4 MHz (%.1f%% of period), %.2f us at 8 MHz\n",
+           frame_bits / 4.0, frame_bits / 4.0 * rate / 1e4, frame_bits / 8.0);
+
+    // packet nhieu channel: dong goi lai toan bo lich su voi tung codec khong mat du lieu
+    printf("%-14s %8s %8s %8s %9s %10s\n", "codec", "frm/pkt", "pkt/s", "kbit/s", "pack_us", "unpack_us");
+    for(int c = 0; c < HUST_CODEC_COUNT && history != NULL; c++)
+    {
+        if(hust_codec_is_lossy((hust_codec_t)c, 0))
+        {
+            continue;
+        }
+        uint8_t data[HUST_MC_MAX_DATA_SIZE];
+        int32_t unpacked[BENCH_MC_FRAMES * HUST_MC_MAX_CHANNELS];
+        long packets = 0;
+        long packed_frames = 0;
+        long bytes = 0;
+        long errors = 0;
+        double pack_ns = 0;
+        double unpack_ns = 0;
+        for(long f = 0; f + BENCH_MC_FRAMES <= n_frames; )
+        {
+            int length;
+            const int32_t * block = history + f * ads.n_channels;
+            double t0 = time_ns();
+            int n = hust_mc_pack(block, ads.n_channels, BENCH_MC_FRAMES, (hust_codec_t)c, 0, data, BENCH_DATA_SIZE, &length);
+            double t1 = time_ns();
+            if(n <= 0)
+            {
+                errors++;
+                break;
+            }
+            hust_mc_info_t info;
+            int err = hust_mc_unpack(data, length, unpacked, BENCH_MC_FRAMES, &info);
+            unpack_ns += time_ns() - t1;
+            pack_ns += t1 - t0;
+            if(err != 0 || info.n_frames != n || info.n_channels != ads.n_channels
+               || memcmp(unpacked, block, n * ads.n_channels * sizeof(int32_t)) != 0)
+            {
+                errors++;
+            }
+            packets++;
+            packed_frames += n;
+            bytes += BLE_PACKET_HEADER_SIZE + length;
+            f += n;
+        }
+        CHECK(errors == 0, "%s: %ld multichannel packets failed to round-trip", hust_codec_name((hust_codec_t)c), errors);
+        if(packets == 0)
+        {
+            continue;
+        }
+        double per_packet = (double)packed_frames / packets;
+        printf("%-14s %8.2f %8.1f %8.1f %9.2f %10.2f\n", hust_codec_name((hust_codec_t)c), per_packet,
+               rate / per_packet, rate / per_packet * ((double)bytes / packets) * 8 / 1000,
+               pack_ns / packets / 1e3, unpack_ns / packets / 1e3);
+    }
+    printf("result        %s\n", failures == 0 ? "PASS" : "FAIL");
+
+    free(frames);
+    free(expected);
+    free(demux);
+    free(history);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,179 @@
+#include <string.h>
+
+#include "hust_ads_mock.h"
+
+static void mock_reset(hust_ads_mock_t * mock)
+{
+    uint8_t id = mock->reg[HUST_ADS_REG_ID];
+
+    // gia tri thanh ghi mac dinh sau reset theo datasheet
+    memset(mock->reg, 0, sizeof(mock->reg));
+    mock->reg[HUST_ADS_REG_ID] = id;
+    if(mock->device == HUST_ADS1299)
+    {
+        mock->reg[HUST_ADS_REG_CONFIG1] = 0x96;
+        mock->reg[HUST_ADS_REG_CONFIG2] = 0xC0;
+        mock->reg[HUST_ADS_REG_CONFIG3] = 0x60;
+        memset(&mock->reg[HUST_ADS_REG_CH1SET], 0x61, HUST_ADS_MAX_CHANNELS);
+    }
+    else
+    {
+        mock->reg[HUST_ADS_REG_CONFIG1] = 0x06;
+        mock->reg[HUST_ADS_REG_CONFIG2] = 0x40;
+        mock->reg[HUST_ADS_REG_CONFIG3] = 0x40;
+    }
+    mock->rdatac = true;
+    mock->started = mock->start_pin;
+}
+
+static void mock_frame(hust_ads_mock_t * mock, uint8_t * rx)
+{
+    // chip 1 ra truoc, sau do la du lieu dich qua DAISY_IN cua cac chip sau
+    for(int chip = 0; chip < mock->n_devices; chip++)
+    {
+        // status: 1100 + LOFF_STATP + LOFF_STATN + GPIO (khong co dien cuc hong)
+        rx[0] = HUST_ADS_STATUS_HEADER;
+        rx[1] = 0;
+        rx[2] = 0;
+        rx += HUST_ADS_STATUS_SIZE;
+        for(int chip_ch = 0; chip_ch < mock->chip_channels; chip_ch++)
+        {
+            int ch = chip * mock->chip_channels + chip_ch;
+            int32_t value = 0;
+            if((mock->reg[HUST_ADS_REG_CH1SET + chip_ch] & HUST_ADS_CHSET_PD) == 0)
+            {
+                value = siggen_next(&mock->gen[ch]);
+                value = value > 0x7FFFFF ? 0x7FFFFF : value < -0x800000 ? -0x800000 : value;
+            }
+            rx[0] = (uint8_t)(value >> 16);
+            rx[1] = (uint8_t)(value >> 8);
+            rx[2] = (uint8_t)value;
+            rx += HUST_ADS_SAMPLE_SIZE;
+            if(mock->trace != NULL)
+            {
+                *mock->trace++ = value;
+            }
+        }
+    }
+    mock->frames++;
+}
+
+static int mock_xfer(void * p_context, const uint8_t * tx, uint16_t tx_len, uint8_t * rx, uint16_t rx_len)
+{
+    hust_ads_mock_t * mock = p_context;
+
+    if(rx != NULL)
+    {
+        memset(rx, 0, rx_len);
+    }
+    if(tx_len == 0)
+    {
+        // doc frame (MOSI = 0x00)
+        if(!mock->rdatac || !mock->started || rx_len != mock->n_devices * HUST_ADS_FRAME_SIZE(mock->chip_channels))
+        {
+            mock->errors++;
+            return 0;
+        }
+        mock_frame(mock, rx);
+        return 0;
+    }
+
+    uint8_t opcode = tx[0];
+    mock->commands++;
+    if((opcode & 0xE0) == HUST_ADS_CMD_RREG || (opcode & 0xE0) == HUST_ADS_CMD_WREG)
+    {
+        uint8_t addr = opcode & 0x1F;
+        uint8_t n = tx_len > 1 ? tx[1] + 1 : 0;
+        if(mock->rdatac || tx_len < 2 || addr + n > HUST_ADS_REG_COUNT)
+        {
+            mock->errors++;             // chip bo qua RREG/WREG khi dang RDATAC
+            return 0;
+        }
+        if((opcode & 0xE0) == HUST_ADS_CMD_RREG)
+        {
+            if(rx == NULL || rx_len < 2 + n)
+            {
+                mock->errors++;
+                return 0;
+            }
+            memcpy(rx + 2, &mock->reg[addr], n);
+        }
+        else
+        {
+            if(tx_len < 2 + n)
+            {
+                mock->errors++;
+                return 0;
+            }
+            for(uint8_t i = 0; i < n; i++)
+            {
+                if(addr + i != HUST_ADS_REG_ID)
+                {
+                    mock->reg[addr + i] = tx[2 + i];
+                }
+            }
+        }
+        return 0;
+    }
+    switch(opcode)
+    {
+        case HUST_ADS_CMD_RESET:  mock_reset(mock); break;
+        case HUST_ADS_CMD_START:  mock->started = true; break;
+        case HUST_ADS_CMD_STOP:   mock->started = mock->start_pin; break;
+        case HUST_ADS_CMD_RDATAC: mock->rdatac = true; break;
+        case HUST_ADS_CMD_SDATAC: mock->rdatac = false; break;
+        case HUST_ADS_CMD_WAKEUP:
+        case HUST_ADS_CMD_STANDBY:
+        case HUST_ADS_CMD_RDATA:  break;
+        default:                  mock->errors++; break;
+    }
+    return 0;
+}
+
+static void mock_set_pin(void * p_context, hust_ads_pin_t pin, bool level)
+{
+    hust_ads_mock_t * mock = p_context;
+
+    if(pin == HUST_ADS_PIN_START)
+    {
+        mock->start_pin = level;
+        mock->started = level;
+    }
+    else if(pin == HUST_ADS_PIN_RESET && level)
+    {
+        mock_reset(mock);
+    }
+}
+
+static void mock_delay_us(void * p_context, uint32_t us)
+{
+    hust_ads_mock_t * mock = p_context;
+    mock->delay_us += us;
+}
+
+int hust_ads_mock_init(hust_ads_mock_t * mock, uint8_t id, uint8_t n_devices, uint32_t seed)
+{
+    memset(mock, 0, sizeof(*mock));
+    if(n_devices == 0 || n_devices > HUST_ADS_MAX_DEVICES
+       || hust_ads_decode_id(id, &mock->device, &mock->chip_channels) != 0)
+    {
+        return -1;
+    }
+    mock->n_devices = n_devices;
+    mock->n_channels = n_devices * mock->chip_channels;
+    mock->reg[HUST_ADS_REG_ID] = id;
+    mock_reset(mock);
+    for(int ch = 0; ch < mock->n_channels; ch++)
+    {
+        siggen_init(&mock->gen[ch], mock->device == HUST_ADS1299 ? SIGGEN_EEG : SIGGEN_ECG, 1000, seed + ch);
+    }
+    return 0;
+}
+
+void hust_ads_mock_io(hust_ads_mock_t * mock, hust_ads_io_t * io)
+{
+    io->xfer = mock_xfer;
+    io->set_pin = mock_set_pin;
+    io->delay_us = mock_delay_us;
+    io->p_context = mock;
+}
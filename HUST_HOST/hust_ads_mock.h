@@ -0,0 +1,37 @@
+#ifndef HUST_ADS_MOCK_H__
+#define HUST_ADS_MOCK_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "hust_ads.h"
+#include "hust_siggen.h"
+
+// ADS1298/ADS1299 gia lap sau hust_ads_io_t: file thanh ghi, lenh SPI, chan START/RESET
+// va frame RDATAC tao tu hust_siggen, de chay driver hust_ads tren host
+
+typedef struct
+{
+    uint8_t reg[HUST_ADS_REG_COUNT];
+    hust_ads_device_t device;
+    uint8_t n_devices;                  // so chip trong daisy chain, cung file thanh ghi (WREG broadcast)
+    uint8_t chip_channels;
+    uint8_t n_channels;                 // tong so channel ca chuoi
+    bool rdatac;                        // che do doc lien tuc (mac dinh sau reset)
+    bool start_pin;
+    bool started;                       // START pin hoac lenh START
+    siggen_t gen[HUST_ADS_MAX_TOTAL_CHANNELS];
+    uint64_t frames;                    // so frame da doc
+    int32_t * trace;                    // != NULL: ghi gia tri tung channel cua frame vua doc, tang dan
+    uint64_t delay_us;                  // tong thoi gian delay driver yeu cau
+    uint32_t commands;
+    uint32_t errors;                    // truy cap sai (doc thanh ghi khi dang RDATAC, frame khi chua START...)
+} hust_ads_mock_t;
+
+// id: gia tri thanh ghi ID (vd 0x3E = ADS1299, 0x92 = ADS1298), n_devices: so chip daisy chain
+// tra ve -1 neu id / n_devices khong hop le
+int hust_ads_mock_init(hust_ads_mock_t * mock, uint8_t id, uint8_t n_devices, uint32_t seed);
+
+void hust_ads_mock_io(hust_ads_mock_t * mock, hust_ads_io_t * io);
+
+#endif // HUST_ADS_MOCK_H__
@@ -0,0 +1,270 @@
+/*
+ * Gia lap stream broadcast hust_bcast: nguon dua ble packet (co count_packet) vao PDU, PDU len
+ * advertising moi publish_ms, advertising phat moi interval + advDelay 0..10 ms, nhieu may thu nghe
+ * voi ti le bat report khac nhau, xen report cua thiet bi khac va report hong.
+ *
+ *   hust_bcast_bench [-d decimation] [-i interval_ms] [-r packet_rate] [-v]
+ *
+ * Kiem tra: may thu bat moi report nhan du moi PDU (publish cham hon advertising); moi may thu nhan
+ * packet tang dan, dung noi dung, chi so chia het cho decimation; PDU nhan + bo lo = PDU phat tu PDU
+ * dau tien nhan duoc; report lap lai PDU cu khong ra packet 2 lan; report thiet bi khac bo qua, report
+ * hong tinh vao errors; nguon phat nhanh hon PDU chua duoc thi bi tu choi (khong mat packet trong PDU).
+ * Tra ve 1 neu co loi.
+ *
+ * In ra: packet nguon / dua vao / bi tu choi, PDU phat, PDU nhan / lap lai / bo lo / sai cua tung may thu.
+ *
+ * Build: cc -O2 -DHUST_HOST_BUILD -I../HUST_BLE hust_bcast_bench.c ../HUST_BLE/hust_bcast.c
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hust_bcast.h"
+
+#define PACKET_SIZE         120         // BCAST_PACKET_SIZE
+#define SOURCE_PACKETS      32          // packet cho dua vao PDU trong app, day thi mat packet
+#define RUN_MS              60000
+#define RECEIVERS           3
+
+static int failures = 0;
+static int verbose = 0;
+static int decimation = 4;
+static int interval_ms = 50;
+static int packet_rate = 100;           // packet / s
+
+#define CHECK(cond, ...) do { if(!(cond)) { failures++; fprintf(stderr, "FAIL: " __VA_ARGS__); fprintf(stderr, "\n"); } } while(0)
+
+typedef struct
+{
+    const char * name;
+    int catch_percent;                  // report bat duoc / advertising event (scan window, nhieu, khoang cach)
+    hust_bcast_rx_t rx;
+    int32_t first_seq;                  // seq PDU dau tien nhan, -1 neu chua
+    uint16_t last_seq;
+    uint32_t pdu_packets;               // tong count cua PDU nhan
+    uint32_t received;
+    uint32_t next_index;
+    uint32_t errors;
+    uint32_t corrupted;                 // report hong da dua vao
+} receiver_t;
+
+static void packet_fill(uint8_t * packet, uint32_t index)
+{
+    packet[0] = (uint8_t)index;
+    packet[1] = (uint8_t)(index >> 8);
+    packet[2] = (uint8_t)(index >> 16);
+    packet[3] = (uint8_t)(index >> 24);
+    for(int i = 4; i < PACKET_SIZE; i++)
+    {
+        packet[i] = (uint8_t)(index * 13 + i);
+    }
+}
+
+static void packet_check(receiver_t * receiver, const uint8_t * packet, int length)
+{
+    uint32_t index = packet[0] | (packet[1] << 8) | (packet[2] << 16) | ((uint32_t)packet[3] << 24);
+    int ok = length == PACKET_SIZE && index >= receiver->next_index && index % decimation == 0;
+    for(int i = 4; ok && i < PACKET_SIZE; i++)
+    {
+        ok = packet[i] == (uint8_t)(index * 13 + i);
+    }
+    if(!ok)
+    {
+        receiver->errors++;
+        return;
+    }
+    receiver->next_index = index + 1;
+    receiver->received++;
+}
+
+static void report(receiver_t * receiver, const uint8_t * adv, uint16_t length)
+{
+    const uint8_t * region;
+    uint16_t region_length;
+    uint32_t pdus = receiver->rx.pdus;
+    int count = hust_bcast_rx_report(&receiver->rx, adv, length, &region, &region_length);
+    if(receiver->rx.pdus != pdus)
+    {
+        if(receiver->first_seq < 0)
+        {
+            receiver->first_seq = receiver->rx.seq;
+        }
+        receiver->last_seq = receiver->rx.seq;
+    }
+    if(count <= 0)
+    {
+        return;
+    }
+    receiver->pdu_packets += count;
+    uint16_t offset = 0;
+    const uint8_t * packet;
+    int packet_length;
+    while((packet_length = hust_bcast_packet_next(region, region_length, &offset, &packet)) > 0)
+    {
+        packet_check(receiver, packet, packet_length);
+    }
+    if(packet_length < 0)
+    {
+        receiver->errors++;
+    }
+}
+
+int main(int argc, char ** argv)
+{
+    for(int i = 1; i < argc; i++)
+    {
+        if(strcmp(argv[i], "-d") == 0 && i + 1 < argc)
+        {
+            decimation = atoi(argv[++i]);
+        }
+        else if(strcmp(argv[i], "-i") == 0 && i + 1 < argc)
+        {
+            interval_ms = atoi(argv[++i]);
+        }
+        else if(strcmp(argv[i], "-r") == 0 && i + 1 < argc)
+        {
+            packet_rate = atoi(argv[++i]);
+        }
+        else if(strcmp(argv[i], "-v") == 0)
+        {
+            verbose = 1;
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [-d decimation] [-i interval_ms] [-r packet_rate] [-v]\n", argv[0]);
+            return 2;
+        }
+    }
+    if(decimation < 1 || decimation > 255 || interval_ms < 20 || packet_rate < 1 || packet_rate > 1000)
+    {
+        fprintf(stderr, "decimation 1..255, interval_ms >= 20, packet_rate 1..1000\n");
+        return 2;
+    }
+
+    const int publish_ms = interval_ms + 10;   // BCAST_PUBLISH_INTERVAL
+    const int per_pdu = (HUST_BCAST_ADV_MAX - HUST_BCAST_HEADER) / (PACKET_SIZE + 1);
+    receiver_t receivers[RECEIVERS] =
+    {
+        {.name = "bedside", .catch_percent = 100},
+        {.name = "ward", .catch_percent = 70},
+        {.name = "corridor", .catch_percent = 25},
+    };
+    hust_bcast_tx_t tx;
+    uint8_t adv[HUST_BCAST_ADV_MAX];
+    uint16_t adv_length = 0;
+    uint8_t source[SOURCE_PACKETS][PACKET_SIZE];
+    uint32_t source_head = 0;
+    uint32_t source_tail = 0;
+    uint32_t source_dropped = 0;
+    uint32_t produced = 0;
+    uint32_t accepted = 0;
+    uint64_t t_packet = 0;
+    int t_adv = 0;
+    // report cua thiet bi khac: flags + ten + manufacturer cua hang khac
+    static const uint8_t other[] = {0x02, 0x01, 0x06, 0x05, 0x09, 'E', 'C', 'G', '2',
+                                    0x0A, 0xFF, 0x59, 0x00, 0x48, 0x01, 0x00, 0x01, 0x00, 0xAA, 0xBB};
+
+    srand(1);
+    hust_bcast_tx_init(&tx, (uint8_t)decimation);
+    for(int r = 0; r < RECEIVERS; r++)
+    {
+        hust_bcast_rx_init(&receivers[r].rx);
+        receivers[r].first_seq = -1;
+    }
+
+    for(int t = 0; t < RUN_MS; t++)
+    {
+        // nguon: packet_rate packet / s, hang doi app day thi mat packet
+        while((uint64_t)t * 1000 >= t_packet)
+        {
+            t_packet += 1000000 / packet_rate;
+            if(source_head - source_tail >= SOURCE_PACKETS)
+            {
+                source_dropped++;           // sample mat truoc khi dong goi: count_packet khong tang
+                continue;
+            }
+            packet_fill(source[source_head % SOURCE_PACKETS], produced++);
+            source_head++;
+        }
+        while(source_tail != source_head
+              && hust_bcast_tx_offer(&tx, source[source_tail % SOURCE_PACKETS], PACKET_SIZE) == 0)
+        {
+            source_tail++;
+            accepted++;
+        }
+
+        if(t % publish_ms == 0)
+        {
+            adv_length = hust_bcast_tx_publish(&tx, adv);
+        }
+
+        // advertising event: moi may thu bat report voi ti le rieng, report lap lai PDU hien tai
+        if(t == t_adv)
+        {
+            t_adv += interval_ms + rand() % 11;
+            for(int r = 0; r < RECEIVERS; r++)
+            {
+                receiver_t * receiver = &receivers[r];
+                if(rand() % 100 >= receiver->catch_percent)
+                {
+                    continue;
+                }
+                if(rand() % 50 == 0)
+                {
+                    report(receiver, other, sizeof(other));
+                }
+                if(rand() % 200 == 0 && adv_length > HUST_BCAST_HEADER + 1)
+                {
+                    uint8_t broken[HUST_BCAST_ADV_MAX];
+                    memcpy(broken, adv, adv_length);
+                    broken[HUST_BCAST_HEADER] = 0xFF;   // do dai packet vuot PDU
+                    report(receiver, broken, adv_length);
+                    receiver->corrupted++;
+                }
+                report(receiver, adv, adv_length);
+            }
+        }
+    }
+
+    printf("decimation %d  interval %d ms  publish %d ms  %d packet / s  %d packet / PDU\n",
+           decimation, interval_ms, publish_ms, packet_rate, per_pdu);
+    printf("source %u  offered %u  rejected %u  source dropped %u  published %u\n",
+           produced, tx.offered, tx.rejected, source_dropped, tx.published);
+    for(int r = 0; r < RECEIVERS; r++)
+    {
+        receiver_t * receiver = &receivers[r];
+        hust_bcast_rx_t * rx = &receiver->rx;
+        uint32_t span = receiver->first_seq < 0 ? 0 : (uint16_t)(receiver->last_seq - receiver->first_seq) + 1u;
+        printf("  %-9s %3d%%  pdus %5u  duplicates %5u  lost %5u  errors %3u  packets %5u  bad %u\n",
+               receiver->name, receiver->catch_percent, rx->pdus, rx->duplicates, rx->lost, rx->errors,
+               receiver->received, receiver->errors);
+        CHECK(receiver->errors == 0, "%s: %u packet sai thu tu / noi dung / decimation", receiver->name, receiver->errors);
+        CHECK(rx->pdus + rx->lost == span, "%s: pdus %u + lost %u != %u PDU phat tu PDU dau tien",
+              receiver->name, rx->pdus, rx->lost, span);
+        CHECK(receiver->received == receiver->pdu_packets, "%s: packet %u != count cua PDU nhan %u",
+              receiver->name, receiver->received, receiver->pdu_packets);
+        CHECK(rx->errors == receiver->corrupted, "%s: errors %u != %u report hong", receiver->name,
+              rx->errors, receiver->corrupted);
+        CHECK(rx->decimation == decimation, "%s: decimation %u != %d", receiver->name, rx->decimation, decimation);
+    }
+    // may thu bat moi report: moi PDU it nhat 1 advertising event
+    CHECK(receivers[0].rx.lost == 0, "%s: bo lo %u PDU", receivers[0].name, receivers[0].rx.lost);
+    CHECK(receivers[0].rx.duplicates > 0, "%s: khong report lap lai (kich ban sai?)", receivers[0].name);
+    // packet gom du: offered = packet lay + packet bo theo decimation
+    CHECK(tx.offered == accepted, "offered %u != accepted %u", tx.offered, accepted);
+    double capacity = 1000.0 * per_pdu * decimation / publish_ms;
+    if(packet_rate < capacity * 0.9)
+    {
+        CHECK(source_dropped == 0, "nguon bo %u packet khi PDU con du cho (%.0f packet / s)", source_dropped, capacity);
+    }
+    else if(packet_rate > capacity * 1.1)
+    {
+        CHECK(tx.rejected > 0, "PDU khong tu choi packet khi nguon nhanh hon %.0f packet / s", capacity);
+    }
+    if(verbose)
+    {
+        printf("capacity %.0f packet / s, header %d, packet max %d\n", capacity, HUST_BCAST_HEADER, HUST_BCAST_PACKET_MAX);
+    }
+    printf("%s\n", failures == 0 ? "PASS" : "FAIL");
+    return failures != 0;
+}
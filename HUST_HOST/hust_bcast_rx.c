@@ -0,0 +1,84 @@
+/*
+ * Ghep lai stream broadcast (hust_bcast) tu cac advertising report may thu bat duoc.
+ *
+ *   hust_replay capture <reports.hcap>          moi dong 1 report: du lieu advertising (AD structure), hex
+ *   hust_bcast_rx <reports.hcap> <stream.hcap>
+ *
+ * Report lap lai cung PDU (advertising phat lai du lieu cu den lan cap nhat sau) chi lay 1 lan, report
+ * khong phai PDU broadcast (thiet bi khac) bo qua. ble packet trong PDU ghi ra stream.hcap nguyen ven,
+ * moc thoi gian = report dau tien cua PDU, de hust_replay replay / info giai ma nhu log NUS. Packet bo
+ * theo decimation hust_replay tinh la packet mat (count_packet nhay theo decimation).
+ *
+ * In ra: report, PDU nhan / lap lai / bo lo / sai, packet ghi ra, decimation.
+ *
+ * Build: cc -DHUST_HOST_BUILD -I../HUST_BLE hust_bcast_rx.c hust_capture.c ../HUST_BLE/hust_bcast.c
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hust_bcast.h"
+#include "hust_capture.h"
+
+int main(int argc, char ** argv)
+{
+    hust_capture_t in;
+    hust_capture_t out;
+    hust_capture_rec_t rec;
+    hust_bcast_rx_t rx;
+    uint64_t reports = 0;
+    uint64_t packets = 0;
+    int status = 0;
+
+    if(argc != 3)
+    {
+        fprintf(stderr, "usage: %s <reports.hcap> <stream.hcap>\n", argv[0]);
+        return 2;
+    }
+    if(hust_capture_open(&in, argv[1]) != 0)
+    {
+        perror(argv[1]);
+        return 1;
+    }
+    if(hust_capture_create(&out, argv[2]) != 0)
+    {
+        perror(argv[2]);
+        hust_capture_close(&in);
+        return 1;
+    }
+    hust_bcast_rx_init(&rx);
+
+    while(status == 0 && hust_capture_read(&in, &rec) == 0)
+    {
+        const uint8_t * region;
+        uint16_t region_length;
+        reports++;
+        if(hust_bcast_rx_report(&rx, rec.data, rec.length, &region, &region_length) <= 0)
+        {
+            continue;
+        }
+        uint16_t offset = 0;
+        const uint8_t * packet;
+        int length;
+        while((length = hust_bcast_packet_next(region, region_length, &offset, &packet)) > 0)
+        {
+            if(hust_capture_write(&out, rec.t_us, packet, (uint16_t)length) != 0)
+            {
+                perror(argv[2]);
+                status = 1;
+                break;
+            }
+            packets++;
+        }
+    }
+
+    printf("reports %llu  pdus %u  duplicates %u  lost %u  errors %u\n", (unsigned long long)reports,
+           rx.pdus, rx.duplicates, rx.lost, rx.errors);
+    printf("packets %llu  decimation %u\n", (unsigned long long)packets, rx.decimation);
+    hust_capture_close(&in);
+    if(hust_capture_close(&out) != 0)
+    {
+        status = 1;
+    }
+    return status;
+}
@@ -0,0 +1,164 @@
+#define _POSIX_C_SOURCE 200809L
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+
+#include "hust_capture.h"
+
+#define HCAP_VERSION    1
+
+typedef struct
+{
+    char magic[4];
+    uint32_t version;
+} hcap_header_t;
+
+uint64_t hust_time_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+}
+
+static void sleep_until_us(uint64_t t_us)
+{
+    struct timespec ts;
+    ts.tv_sec = (time_t)(t_us / 1000000u);
+    ts.tv_nsec = (long)(t_us % 1000000u) * 1000;
+    while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR)
+    {
+    }
+}
+
+int hust_capture_create(hust_capture_t * cap, const char * path)
+{
+    hcap_header_t header;
+
+    memset(cap, 0, sizeof(*cap));
+    cap->file = fopen(path, "wb");
+    if(cap->file == NULL)
+    {
+        return -1;
+    }
+    memcpy(header.magic, "HCAP", 4);
+    header.version = HCAP_VERSION;
+    if(fwrite(&header, sizeof(header), 1, cap->file) != 1)
+    {
+        fclose(cap->file);
+        cap->file = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+int hust_capture_write(hust_capture_t * cap, uint64_t t_us, const uint8_t * data, uint16_t length)
+{
+    if(length > HUST_CAPTURE_MAX_DATA_LEN ||
+       fwrite(&t_us, sizeof(t_us), 1, cap->file) != 1 ||
+       fwrite(&length, sizeof(length), 1, cap->file) != 1 ||
+       fwrite(data, 1, length, cap->file) != length)
+    {
+        return -1;
+    }
+    if(cap->count == 0)
+    {
+        cap->t_first_us = t_us;
+    }
+    cap->t_last_us = t_us;
+    cap->count++;
+    return 0;
+}
+
+int hust_capture_rewind(hust_capture_t * cap)
+{
+    return fseek(cap->file, (long)sizeof(hcap_header_t), SEEK_SET) == 0 ? 0 : -1;
+}
+
+int hust_capture_read(hust_capture_t * cap, hust_capture_rec_t * rec)
+{
+    if(fread(&rec->t_us, sizeof(rec->t_us), 1, cap->file) != 1)
+    {
+        return feof(cap->file) ? 1 : -1;
+    }
+    if(fread(&rec->length, sizeof(rec->length), 1, cap->file) != 1 ||
+       rec->length > HUST_CAPTURE_MAX_DATA_LEN ||
+       fread(rec->data, 1, rec->length, cap->file) != rec->length)
+    {
+        return -1;
+    }
+    return 0;
+}
+
+int hust_capture_open(hust_capture_t * cap, const char * path)
+{
+    hcap_header_t header;
+    hust_capture_rec_t rec;
+    int err;
+
+    memset(cap, 0, sizeof(*cap));
+    cap->file = fopen(path, "rb");
+    if(cap->file == NULL)
+    {
+        return -1;
+    }
+    if(fread(&header, sizeof(header), 1, cap->file) != 1 || memcmp(header.magic, "HCAP", 4) != 0)
+    {
+        hust_capture_close(cap);
+        return -1;
+    }
+    while((err = hust_capture_read(cap, &rec)) == 0)
+    {
+        if(cap->count == 0)
+        {
+            cap->t_first_us = rec.t_us;
+        }
+        cap->t_last_us = rec.t_us;
+        cap->count++;
+    }
+    if(err < 0 || hust_capture_rewind(cap) != 0)
+    {
+        hust_capture_close(cap);
+        return -1;
+    }
+    return 0;
+}
+
+int hust_capture_close(hust_capture_t * cap)
+{
+    int err = 0;
+    if(cap->file != NULL)
+    {
+        err = fclose(cap->file) != 0 ? -1 : 0;
+        cap->file = NULL;
+    }
+    return err;
+}
+
+int hust_capture_replay(hust_capture_t * cap, const hust_replay_cfg_t * cfg, hust_replay_handler_t handler, void * p_context)
+{
+    hust_capture_rec_t rec;
+    uint64_t index = 0;
+    uint64_t t_start = hust_time_us();
+    double mean_interval = cap->count > 1 ? (double)(cap->t_last_us - cap->t_first_us) / (double)(cap->count - 1) : 0;
+    int err;
+
+    if(hust_capture_rewind(cap) != 0)
+    {
+        return -1;
+    }
+    while((err = hust_capture_read(cap, &rec)) == 0)
+    {
+        if(cfg->speed > 0)
+        {
+            // lich tuyet doi tinh tu dau log de khong bi troi khi sleep tre
+            double offset = cfg->preserve_jitter ? (double)(rec.t_us - cap->t_first_us) : mean_interval * (double)index;
+            sleep_until_us(t_start + (uint64_t)(offset / cfg->speed));
+        }
+        if(handler(&rec, p_context) != 0)
+        {
+            return -1;
+        }
+        index++;
+    }
+    return err < 0 ? -1 : 0;
+}
@@ -0,0 +1,56 @@
+#ifndef HUST_CAPTURE_H__
+#define HUST_CAPTURE_H__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Log nhi phan cac notification NUS nhan duoc o host (.hcap):
+ * [header][record][record]...  record = uint64 t_us (thoi diem nhan) + uint16 length + data
+ */
+
+#define HUST_CAPTURE_MAX_DATA_LEN   512
+
+typedef struct
+{
+    uint64_t t_us;
+    uint16_t length;
+    uint8_t data[HUST_CAPTURE_MAX_DATA_LEN];
+} hust_capture_rec_t;
+
+typedef struct
+{
+    FILE * file;
+    uint64_t count;                 // so record (khi doc)
+    uint64_t t_first_us;
+    uint64_t t_last_us;
+} hust_capture_t;
+
+// che do phat lai
+typedef struct
+{
+    double speed;                   // 1.0 = thoi gian thuc, <= 0: nhanh nhat co the
+    bool preserve_jitter;           // giu nguyen khoang cach giua cac packet, neu khong thi chia deu
+} hust_replay_cfg_t;
+
+typedef int (*hust_replay_handler_t)(const hust_capture_rec_t * rec, void * p_context);
+
+int hust_capture_create(hust_capture_t * cap, const char * path);
+int hust_capture_write(hust_capture_t * cap, uint64_t t_us, const uint8_t * data, uint16_t length);
+
+// mo log de doc, quet 1 lan de biet so record va khoang thoi gian
+int hust_capture_open(hust_capture_t * cap, const char * path);
+// doc record tiep theo, tra ve 1 neu het file, -1 neu loi
+int hust_capture_read(hust_capture_t * cap, hust_capture_rec_t * rec);
+int hust_capture_rewind(hust_capture_t * cap);
+
+int hust_capture_close(hust_capture_t * cap);
+
+// phat lai toan bo log vao handler theo cfg, dung lai neu handler tra ve khac 0
+int hust_capture_replay(hust_capture_t * cap, const hust_replay_cfg_t * cfg, hust_replay_handler_t handler, void * p_context);
+
+// thoi gian monotonic (us)
+uint64_t hust_time_us(void);
+
+#endif // HUST_CAPTURE_H__
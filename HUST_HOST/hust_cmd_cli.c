@@ -0,0 +1,338 @@
+/*
+ * Tao lenh dieu khien stream (hust_cmd.h) de ghi vao NUS RX, va giai ma tra loi cua thiet bi.
+ *
+ *   hust_cmd_cli <lenh> [<lenh> ...]        in ra hex cua cac lenh, ghi 1 lan vao NUS RX
+ *                                           (vd. gatttool --char-write-req -a <rx handle> -n $(hust_cmd_cli ...))
+ *   hust_cmd_cli -d                         doc notification NUS tu stdin (moi dong 1 packet, hex),
+ *                                           in cac tra loi CMD_SENSOR_TYPE, bo qua packet du lieu
+ *   hust_cmd_cli -c                         doc notification characteristic control cua service bio
+ *                                           (hust_bio.h, ghi lenh vao control thay NUS RX), in tra loi
+ *   hust_cmd_cli -e                         doc notification characteristic event, in event
+ *   hust_cmd_cli -s                         doc gia tri characteristic schema, in bo cuc packet data
+ *
+ * Lenh:
+ *   start | stop | stats | config
+ *   type <ecg|imu|all|eeg|emg|so>
+ *   rate <Hz>
+ *   codec <raw|bfp|delta_varint|rice|lpc|wavelet|so> [param]
+ *   mask <hex>
+ *
+ * Build: cc -DHUST_HOST_BUILD -I../HUST_BLE hust_cmd_cli.c ../HUST_BLE/hust_cmd.c ../HUST_BLE/hust_ble.c ../HUST_BLE/hust_codec.c ../HUST_BLE/hust_telemetry.c ../HUST_BLE/hust_state.c ../HUST_BLE/hust_bio.c
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "hust_ble.h"
+#include "hust_cmd.h"
+#include "hust_codec.h"
+#include "hust_telemetry.h"
+#include "hust_state.h"
+#include "hust_bio.h"
+
+static const char * sensor_type_name[] = {"", "", "ecg", "imu", "all", "eeg", "emg", "cmd"};
+
+static const char * opcode_name[] =
+{
+    "", "start", "stop", "type", "rate", "codec", "mask", "stats", "config"
+};
+
+static void usage(void)
+{
+    fprintf(stderr,
+            "usage: hust_cmd_cli <cmd> [<cmd> ...]\n"
+            "       hust_cmd_cli -d | -c | -e | -s\n"
+            "cmd:   start | stop | stats | config | type <name|n> | rate <Hz> | codec <name|n> [param] | mask <hex>\n");
+}
+
+static int parse_hex_line(const char * line, uint8_t * data, int max_len)
+{
+    int length = 0;
+    int nibble = -1;
+    for(const char * p = line; *p != '\0'; p++)
+    {
+        if(!isxdigit((unsigned char)*p))
+        {
+            continue;
+        }
+        int v = isdigit((unsigned char)*p) ? *p - '0' : tolower((unsigned char)*p) - 'a' + 10;
+        if(nibble < 0)
+        {
+            nibble = v;
+        }
+        else
+        {
+            if(length >= max_len)
+            {
+                return -1;
+            }
+            data[length++] = (uint8_t)((nibble << 4) | v);
+            nibble = -1;
+        }
+    }
+    return nibble < 0 ? length : -1;
+}
+
+static int lookup(const char * name, const char * const * table, int n)
+{
+    for(int i = 0; i < n; i++)
+    {
+        if(table[i][0] != '\0' && strcmp(name, table[i]) == 0)
+        {
+            return i;
+        }
+    }
+    return isdigit((unsigned char)name[0]) ? atoi(name) : -1;
+}
+
+static int codec_lookup(const char * name)
+{
+    for(int c = 0; c < HUST_CODEC_COUNT; c++)
+    {
+        if(strcmp(name, hust_codec_name((hust_codec_t)c)) == 0)
+        {
+            return c;
+        }
+    }
+    return isdigit((unsigned char)name[0]) ? atoi(name) : -1;
+}
+
+// dich lenh argv[*i] (va tham so) ra out, tra ve so byte, -1 neu sai cu phap
+static int encode_arg(int argc, char ** argv, int * i, uint8_t * out)
+{
+    const char * name = argv[*i];
+    const char * arg = *i + 1 < argc ? argv[*i + 1] : NULL;
+    uint8_t payload[HUST_CMD_MAX_PAYLOAD];
+    int opcode = lookup(name, opcode_name, sizeof(opcode_name) / sizeof(opcode_name[0]));
+
+    switch(opcode)
+    {
+        case HUST_CMD_START:
+        case HUST_CMD_STOP:
+        case HUST_CMD_GET_STATS:
+        case HUST_CMD_GET_CONFIG:
+            return hust_cmd_encode((uint8_t)opcode, NULL, 0, out);
+        case HUST_CMD_SET_SENSOR_TYPE:
+        {
+            int type = arg != NULL ? lookup(arg, sensor_type_name, sizeof(sensor_type_name) / sizeof(sensor_type_name[0])) : -1;
+            if(type < 0)
+            {
+                return -1;
+            }
+            (*i)++;
+            payload[0] = (uint8_t)type;
+            return hust_cmd_encode(HUST_CMD_SET_SENSOR_TYPE, payload, 1, out);
+        }
+        case HUST_CMD_SET_RATE:
+        {
+            long rate = arg != NULL ? strtol(arg, NULL, 0) : 0;
+            if(rate <= 0 || rate > 0xFFFF)
+            {
+                return -1;
+            }
+            (*i)++;
+            payload[0] = (uint8_t)(rate >> 8);
+            payload[1] = (uint8_t)rate;
+            return hust_cmd_encode(HUST_CMD_SET_RATE, payload, 2, out);
+        }
+        case HUST_CMD_SET_CODEC:
+        {
+            int codec = arg != NULL ? codec_lookup(arg) : -1;
+            if(codec < 0)
+            {
+                return -1;
+            }
+            (*i)++;
+            payload[0] = (uint8_t)codec;
+            payload[1] = 0;
+            if(*i + 1 < argc && isdigit((unsigned char)argv[*i + 1][0]))
+            {
+                payload[1] = (uint8_t)atoi(argv[++(*i)]);
+            }
+            return hust_cmd_encode(HUST_CMD_SET_CODEC, payload, 2, out);
+        }
+        case HUST_CMD_SET_CHANNEL_MASK:
+        {
+            if(arg == NULL)
+            {
+                return -1;
+            }
+            uint32_t mask = (uint32_t)strtoul(arg, NULL, 16);
+            (*i)++;
+            for(int b = 0; b < 4; b++)
+            {
+                payload[b] = (uint8_t)(mask >> (24 - 8 * b));
+            }
+            return hust_cmd_encode(HUST_CMD_SET_CHANNEL_MASK, payload, 4, out);
+        }
+        default:
+            return -1;
+    }
+}
+
+static void print_response(const uint8_t * data, int data_size, uint8_t count)
+{
+    uint8_t opcode = data[0];
+    uint8_t status = data[1];
+    hust_cmd_config_t config;
+    hust_telemetry_t telemetry;
+
+    printf("#%-3u %-7s %-12s", count,
+           opcode < sizeof(opcode_name) / sizeof(opcode_name[0]) ? opcode_name[opcode] : "?",
+           hust_cmd_status_name(status));
+    if(opcode == HUST_CMD_GET_STATS && status == HUST_CMD_OK
+       && hust_telemetry_decode(data + 2, data_size - 2, &telemetry) == 0)
+    {
+        printf(" acquired %u dropped %u sent %u resources %u errors %u %u bps mtu %u history %.1f/%.1f s"
+               " interval %.2f ms hvn queue %u event %.2f ms",
+               telemetry.samples_acquired, telemetry.samples_dropped, telemetry.packets_sent,
+               telemetry.nus_resources, telemetry.nus_errors, telemetry.throughput_bps, telemetry.mtu,
+               telemetry.history_ms / 1000.0, telemetry.history_capacity_ms / 1000.0,
+               telemetry.conn_interval * 1.25, telemetry.hvn_tx_queue, telemetry.event_length * 1.25);
+    }
+    else if(hust_cmd_config_decode(data + 2, data_size - 2, &config) == 0)
+    {
+        printf(" %s (%s) %s %u Hz codec %s/%u mask %08x",
+               config.streaming ? "started" : "stopped", hust_state_name((hust_state_id_t)config.state),
+               config.sensor_type < sizeof(sensor_type_name) / sizeof(sensor_type_name[0]) ? sensor_type_name[config.sensor_type] : "?",
+               config.rate, config.codec < HUST_CODEC_COUNT ? hust_codec_name((hust_codec_t)config.codec) : "?",
+               config.codec_param, config.channel_mask);
+    }
+    printf("\n");
+}
+
+static int decode(void)
+{
+    char line[1024];
+    uint8_t data[512];
+    unsigned long packets = 0;
+
+    while(fgets(line, sizeof(line), stdin) != NULL)
+    {
+        ecg_data_t ecg_data[ECG_SAMPLE_MAX];
+        imu_data_t imu_data[IMU_SAMPLE_MAX];
+        ble_packet_t ble_packet_m;
+
+        ble_packet_m.ecg_data = ecg_data;
+        ble_packet_m.imu_data = imu_data;
+
+        int length = parse_hex_line(line, data, sizeof(data));
+        if(length <= 0 || convert_ble_packet_to_data(data, length, &ble_packet_m) != 0)
+        {
+            continue;
+        }
+        if(ble_packet_m.sensor_type != CMD_SENSOR_TYPE)
+        {
+            packets++;
+            continue;
+        }
+        if(ble_packet_m.data_size >= 2)
+        {
+            print_response(data + BLE_PACKET_HEADER_SIZE, ble_packet_m.data_size, ble_packet_m.count_packet);
+        }
+    }
+    fprintf(stderr, "%lu data packets skipped\n", packets);
+    return 0;
+}
+
+static void print_event(const hust_bio_event_t * event)
+{
+    const uint8_t * p = event->payload;
+
+    printf("#%-3u %06x %-7s", event->seq, event->tick, hust_bio_event_name(event->type));
+    if(event->type == HUST_BIO_EVENT_STATE && event->length >= 2)
+    {
+        printf(" %s -> %s", hust_state_name((hust_state_id_t)p[1]), hust_state_name((hust_state_id_t)p[0]));
+    }
+    else if(event->type == HUST_BIO_EVENT_DROP && event->length >= 4)
+    {
+        printf(" %u samples", p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24));
+    }
+    else if(event->type == HUST_BIO_EVENT_LINK && event->length >= 3)
+    {
+        printf(" phy %u interval %.2f ms", p[0], (p[1] | (p[2] << 8)) * 1.25);
+    }
+    printf("\n");
+}
+
+static void print_schema(const hust_bio_schema_t * schema)
+{
+    printf("header %u %s %u Hz mask %08x codec %s/%u samples/packet %u max packet %u imu %u Hz\n",
+           schema->header_size,
+           schema->sensor_type < sizeof(sensor_type_name) / sizeof(sensor_type_name[0]) ? sensor_type_name[schema->sensor_type] : "?",
+           schema->rate, schema->channel_mask,
+           schema->codec < HUST_CODEC_COUNT ? hust_codec_name((hust_codec_t)schema->codec) : "?",
+           schema->codec_param, schema->samples_per_packet, schema->max_packet, schema->imu_rate);
+}
+
+// notification / gia tri characteristic cua service bio, moi dong 1 gia tri (hex)
+static int decode_bio(char mode)
+{
+    char line[1024];
+    uint8_t data[512];
+    uint8_t count = 0;
+
+    while(fgets(line, sizeof(line), stdin) != NULL)
+    {
+        hust_bio_event_t event;
+        hust_bio_schema_t schema;
+        int length = parse_hex_line(line, data, sizeof(data));
+
+        if(mode == 'c' && length >= 2)
+        {
+            print_response(data, length, count++);
+        }
+        else if(mode == 'e' && hust_bio_event_decode(data, length, &event) == 0)
+        {
+            print_event(&event);
+        }
+        else if(mode == 's' && hust_bio_schema_decode(data, length, &schema) == 0)
+        {
+            print_schema(&schema);
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char ** argv)
+{
+    uint8_t out[256];
+    int length = 0;
+
+    if(argc < 2)
+    {
+        usage();
+        return 1;
+    }
+    if(strcmp(argv[1], "-d") == 0)
+    {
+        return decode();
+    }
+    if(strcmp(argv[1], "-c") == 0 || strcmp(argv[1], "-e") == 0 || strcmp(argv[1], "-s") == 0)
+    {
+        return decode_bio(argv[1][1]);
+    }
+    for(int i = 1; i < argc; i++)
+    {
+        if(length + HUST_CMD_HEADER_SIZE + HUST_CMD_MAX_PAYLOAD > (int)sizeof(out))
+        {
+            fprintf(stderr, "too many commands\n");
+            return 1;
+        }
+        int n = encode_arg(argc, argv, &i, out + length);
+        if(n < 0)
+        {
+            fprintf(stderr, "bad command: %s\n", argv[i]);
+            usage();
+            return 1;
+        }
+        length += n;
+    }
+    for(int i = 0; i < length; i++)
+    {
+        printf("%02x", out[i]);
+    }
+    printf("\n");
+    return 0;
+}
@@ -0,0 +1,547 @@
+/*
+ * Benchmark cac codec payload (hust_codec) tren corpus ECG/EMG/EEG.
+ *
+ *   hust_codec_bench [-b block] [-r repeat] [-t seconds] [-k m4_cycles_per_ns] [file.hea | file.edf ...]
+ *
+ * Corpus = tin hieu gia lap (hust_siggen) + cac file WFDB (format 16/212) va EDF (16 bit) them vao.
+ * Ket qua in ra stdout dang TSV, 1 dong / (signal type, codec):
+ *   ratio             = kich thuoc raw 24 bit / kich thuoc sau ma hoa
+ *   enc_m4_cyc        = so cycle ma hoa / sample uoc tinh tren Cortex-M4
+ *   dec_msps          = toc do giai ma tren host (trieu sample / s)
+ *   prd_pct           = percentage root-mean-square difference (codec lossy)
+ *
+ * Uoc tinh cycle M4: do thoi gian tren host roi nhan voi ti le cycle M4 / ns host, ti le nay
+ * duoc hieu chinh bang 1 vong lap tham chieu co so cycle M4 da biet (co the ghi de bang -k).
+ *
+ * Build: cc -O2 -I../HUST_BLE hust_codec_bench.c ../HUST_BLE/hust_codec.c ../HUST_BLE/hust_siggen.c -lm
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+#include <time.h>
+
+#include "hust_codec.h"
+#include "hust_siggen.h"
+
+#define BENCH_MAX_ENTRY         256
+#define BENCH_SYNTH_CHANNEL     4
+#define M4_REF_CYCLES_PER_ITER  6       // MUL + ADD + EOR(LSR) + SUBS + BNE(2) tren Cortex-M4
+
+typedef struct
+{
+    char name[96];
+    siggen_type_t type;
+    int32_t * x;
+    long n;
+} bench_entry_t;
+
+typedef struct
+{
+    hust_codec_t codec;
+    uint8_t param;
+} bench_codec_t;
+
+typedef struct
+{
+    long samples;
+    long bytes;
+    double enc_ns;
+    double dec_ns;
+    double err2;
+    double sig2;
+} bench_result_t;
+
+static const bench_codec_t bench_codecs[] =
+{
+    { HUST_CODEC_RAW, 0 },
+    { HUST_CODEC_BFP, 12 },
+    { HUST_CODEC_BFP, 8 },
+    { HUST_CODEC_DELTA_VARINT, 0 },
+    { HUST_CODEC_RICE, 0 },
+    { HUST_CODEC_LPC, 0 },
+    { HUST_CODEC_WAVELET, 0 },
+    { HUST_CODEC_WAVELET, 4 },
+};
+#define BENCH_CODEC_COUNT   (sizeof(bench_codecs) / sizeof(bench_codecs[0]))
+
+static const char * const type_names[] = { "ecg", "emg", "eeg" };
+static const uint32_t synth_rate[] = { 1000, 2000, 250 };
+
+static bench_entry_t entries[BENCH_MAX_ENTRY];
+static int n_entries;
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static bench_entry_t * entry_add(const char * name, siggen_type_t type, long n)
+{
+    if(n_entries >= BENCH_MAX_ENTRY)
+    {
+        return NULL;
+    }
+    bench_entry_t * e = &entries[n_entries];
+    e->x = malloc((size_t)n * sizeof(int32_t));
+    if(e->x == NULL)
+    {
+        return NULL;
+    }
+    snprintf(e->name, sizeof(e->name), "%s", name);
+    e->type = type;
+    e->n = n;
+    n_entries++;
+    return e;
+}
+
+static siggen_type_t type_from_label(const char * label)
+{
+    char upper[96];
+    int i;
+    for(i = 0; label[i] != '\0' && i < (int)sizeof(upper) - 1; i++)
+    {
+        upper[i] = (char)toupper((unsigned char)label[i]);
+    }
+    upper[i] = '\0';
+    if(strstr(upper, "EEG") != NULL)
+    {
+        return SIGGEN_EEG;
+    }
+    if(strstr(upper, "EMG") != NULL)
+    {
+        return SIGGEN_EMG;
+    }
+    return SIGGEN_ECG;
+}
+
+static void synth_load(double seconds)
+{
+    for(int t = SIGGEN_ECG; t <= SIGGEN_EEG; t++)
+    {
+        for(int ch = 0; ch < BENCH_SYNTH_CHANNEL; ch++)
+        {
+            char name[64];
+            siggen_t siggen;
+            long n = (long)(seconds * synth_rate[t]);
+            snprintf(name, sizeof(name), "synth_%s_%d", type_names[t], ch);
+            bench_entry_t * e = entry_add(name, (siggen_type_t)t, n);
+            if(e == NULL)
+            {
+                return;
+            }
+            siggen_init(&siggen, (siggen_type_t)t, synth_rate[t], 0x1000u * (uint32_t)(t + 1) + (uint32_t)ch + 1);
+            for(long i = 0; i < n; i++)
+            {
+                e->x[i] = siggen_next(&siggen);
+            }
+        }
+    }
+}
+
+// WFDB: <rec>.hea + file .dat, chi ho tro format 16 va 212
+static int wfdb_load(const char * hea_path)
+{
+    FILE * f = fopen(hea_path, "r");
+    char line[512];
+    char rec_name[64];
+    int n_sig = 0;
+    long n_samp = 0;
+    double fs;
+
+    if(f == NULL)
+    {
+        return -1;
+    }
+    do
+    {
+        if(fgets(line, sizeof(line), f) == NULL)
+        {
+            fclose(f);
+            return -1;
+        }
+    } while(line[0] == '#');
+    if(sscanf(line, "%63s %d %lf %ld", rec_name, &n_sig, &fs, &n_samp) < 4 || n_sig <= 0 || n_samp <= 0)
+    {
+        fclose(f);
+        return -1;
+    }
+
+    char dat_name[128] = "";
+    int fmt = 0;
+    siggen_type_t type[64];
+    char label[64][96];
+    for(int s = 0; s < n_sig && s < 64; s++)
+    {
+        char file_name[128];
+        int sig_fmt;
+        if(fgets(line, sizeof(line), f) == NULL || sscanf(line, "%127s %d", file_name, &sig_fmt) != 2)
+        {
+            fclose(f);
+            return -1;
+        }
+        if(s > 0 && (strcmp(file_name, dat_name) != 0 || sig_fmt != fmt))
+        {
+            fclose(f);
+            return -1;          // chi ho tro tat ca signal trong 1 file .dat cung format
+        }
+        strcpy(dat_name, file_name);
+        fmt = sig_fmt;
+        // mo ta la cot cuoi cung (sau 8 cot so)
+        const char * p = line;
+        for(int col = 0; col < 8 && *p != '\0'; col++)
+        {
+            while(*p != '\0' && !isspace((unsigned char)*p))
+            {
+                p++;
+            }
+            while(*p != '\0' && isspace((unsigned char)*p))
+            {
+                p++;
+            }
+        }
+        snprintf(label[s], sizeof(label[s]), "%.95s", p);
+        label[s][strcspn(label[s], "\r\n")] = '\0';
+        type[s] = type_from_label(label[s]);
+    }
+    fclose(f);
+    if(n_sig > 64 || (fmt != 16 && fmt != 212))
+    {
+        return -1;
+    }
+
+    char dat_path[512];
+    const char * slash = strrchr(hea_path, '/');
+    int dir_len = slash ? (int)(slash - hea_path + 1) : 0;
+    snprintf(dat_path, sizeof(dat_path), "%.*s%s", dir_len, hea_path, dat_name);
+    f = fopen(dat_path, "rb");
+    if(f == NULL)
+    {
+        return -1;
+    }
+    bench_entry_t * e[64];
+    for(int s = 0; s < n_sig; s++)
+    {
+        char name[96];
+        snprintf(name, sizeof(name), "%.31s:%.63s", rec_name, label[s]);
+        e[s] = entry_add(name, type[s], n_samp);
+        if(e[s] == NULL)
+        {
+            fclose(f);
+            return -1;
+        }
+    }
+    long k = 0;         // chi so sample tong (xen ke theo signal)
+    long total = n_samp * n_sig;
+    while(k < total)
+    {
+        uint8_t b[3];
+        if(fmt == 16)
+        {
+            if(fread(b, 1, 2, f) != 2)
+            {
+                break;
+            }
+            e[k % n_sig]->x[k / n_sig] = (int16_t)(b[0] | (b[1] << 8));
+            k++;
+        }
+        else
+        {
+            // 212: 2 sample 12 bit trong 3 byte
+            if(fread(b, 1, 3, f) != 3)
+            {
+                break;
+            }
+            int32_t v0 = b[0] | ((b[1] & 0x0F) << 8);
+            int32_t v1 = b[2] | ((b[1] & 0xF0) << 4);
+            e[k % n_sig]->x[k / n_sig] = v0 & 0x800 ? v0 - 0x1000 : v0;
+            k++;
+            if(k < total)
+            {
+                e[k % n_sig]->x[k / n_sig] = v1 & 0x800 ? v1 - 0x1000 : v1;
+                k++;
+            }
+        }
+    }
+    fclose(f);
+    for(int s = 0; s < n_sig; s++)
+    {
+        e[s]->n = k / n_sig;
+    }
+    return 0;
+}
+
+static long edf_field(const char * header, int offset, int length)
+{
+    char buf[32];
+    memcpy(buf, header + offset, (size_t)length);
+    buf[length] = '\0';
+    return atol(buf);
+}
+
+// EDF/EDF+ 16 bit
+static int edf_load(const char * path)
+{
+    FILE * f = fopen(path, "rb");
+    char header[256];
+    if(f == NULL || fread(header, 1, 256, f) != 256)
+    {
+        if(f != NULL)
+        {
+            fclose(f);
+        }
+        return -1;
+    }
+    long n_records = edf_field(header, 236, 8);
+    int n_sig = (int)edf_field(header, 252, 4);
+    if(n_records <= 0 || n_sig <= 0 || n_sig > 64)
+    {
+        fclose(f);
+        return -1;
+    }
+    char * sig_header = malloc((size_t)n_sig * 256);
+    if(sig_header == NULL || fread(sig_header, 256, (size_t)n_sig, f) != (size_t)n_sig)
+    {
+        free(sig_header);
+        fclose(f);
+        return -1;
+    }
+    long spr[64];
+    bench_entry_t * e[64];
+    for(int s = 0; s < n_sig; s++)
+    {
+        char label[17];
+        char name[96];
+        memcpy(label, sig_header + s * 16, 16);
+        label[16] = '\0';
+        for(int i = 15; i >= 0 && label[i] == ' '; i--)
+        {
+            label[i] = '\0';
+        }
+        spr[s] = edf_field(sig_header, n_sig * 216 + s * 8, 8);
+        snprintf(name, sizeof(name), "%.78s:%.16s", path, label);
+        e[s] = spr[s] > 0 ? entry_add(name, type_from_label(label), spr[s] * n_records) : NULL;
+        if(e[s] == NULL)
+        {
+            free(sig_header);
+            fclose(f);
+            return -1;
+        }
+    }
+    free(sig_header);
+    long r;
+    for(r = 0; r < n_records; r++)
+    {
+        int ok = 1;
+        for(int s = 0; s < n_sig && ok; s++)
+        {
+            for(long i = 0; i < spr[s]; i++)
+            {
+                uint8_t b[2];
+                if(fread(b, 1, 2, f) != 2)
+                {
+                    ok = 0;
+                    break;
+                }
+                e[s]->x[r * spr[s] + i] = (int16_t)(b[0] | (b[1] << 8));
+            }
+        }
+        if(!ok)
+        {
+            break;
+        }
+    }
+    fclose(f);
+    for(int s = 0; s < n_sig; s++)
+    {
+        e[s]->n = r * spr[s];
+    }
+    return 0;
+}
+
+// ti le cycle M4 / ns host tu vong lap tham chieu
+static double m4_calibrate(void)
+{
+    const long iterations = 20000000;
+    volatile uint32_t sink;
+    double best = 1e30;
+    for(int rep = 0; rep < 3; rep++)
+    {
+        uint32_t x = 1;
+        uint32_t acc = 0;
+        double t0 = now_ns();
+        for(long i = 0; i < iterations; i++)
+        {
+            x = x * 1103515245u + 12345u;
+            acc ^= x >> 7;
+        }
+        double t = now_ns() - t0;
+        sink = acc;
+        best = t < best ? t : best;
+    }
+    (void)sink;
+    return (double)M4_REF_CYCLES_PER_ITER * (double)iterations / best;
+}
+
+static void bench_entry(const bench_entry_t * e, const bench_codec_t * c, int block, int repeat, bench_result_t * res)
+{
+    long n_blocks = (e->n + block - 1) / block;
+    int max_size = hust_codec_max_size(c->codec, block);
+    uint8_t * enc = malloc((size_t)n_blocks * (size_t)max_size);
+    int * enc_len = malloc((size_t)n_blocks * sizeof(int));
+    int32_t * dec = malloc((size_t)e->n * sizeof(int32_t));
+    double best_enc = 1e30;
+    double best_dec = 1e30;
+    long bytes = 0;
+
+    if(enc == NULL || enc_len == NULL || dec == NULL)
+    {
+        fprintf(stderr, "out of memory\n");
+        exit(1);
+    }
+    for(int rep = 0; rep < repeat; rep++)
+    {
+        double t0 = now_ns();
+        bytes = 0;
+        for(long b = 0; b < n_blocks; b++)
+        {
+            long first = b * block;
+            int n = (int)(e->n - first < block ? e->n - first : block);
+            enc_len[b] = hust_codec_encode(c->codec, c->param, e->x + first, n, enc + b * max_size, max_size);
+            bytes += enc_len[b];
+        }
+        double t1 = now_ns();
+        for(long b = 0; b < n_blocks; b++)
+        {
+            long first = b * block;
+            int n = (int)(e->n - first < block ? e->n - first : block);
+            hust_codec_decode(c->codec, c->param, enc + b * max_size, enc_len[b], dec + first, n);
+        }
+        double t2 = now_ns();
+        best_enc = t1 - t0 < best_enc ? t1 - t0 : best_enc;
+        best_dec = t2 - t1 < best_dec ? t2 - t1 : best_dec;
+    }
+
+    res->samples += e->n;
+    res->bytes += bytes;
+    res->enc_ns += best_enc;
+    res->dec_ns += best_dec;
+    for(long i = 0; i < e->n; i++)
+    {
+        double d = (double)e->x[i] - (double)dec[i];
+        res->err2 += d * d;
+        res->sig2 += (double)e->x[i] * (double)e->x[i];
+    }
+    free(enc);
+    free(enc_len);
+    free(dec);
+}
+
+int main(int argc, char ** argv)
+{
+    int block = 128;
+    int repeat = 5;
+    double seconds = 60;
+    double cycles_per_ns = 0;
+
+    int i;
+    for(i = 1; i < argc && argv[i][0] == '-'; i++)
+    {
+        if(i + 1 >= argc)
+        {
+            break;
+        }
+        if(strcmp(argv[i], "-b") == 0)
+        {
+            block = atoi(argv[++i]);
+        }
+        else if(strcmp(argv[i], "-r") == 0)
+        {
+            repeat = atoi(argv[++i]);
+        }
+        else if(strcmp(argv[i], "-t") == 0)
+        {
+            seconds = atof(argv[++i]);
+        }
+        else if(strcmp(argv[i], "-k") == 0)
+        {
+            cycles_per_ns = atof(argv[++i]);
+        }
+        else
+        {
+            break;
+        }
+    }
+    if(block <= 0 || block > HUST_CODEC_MAX_BLOCK || repeat <= 0)
+    {
+        fprintf(stderr, "usage: hust_codec_bench [-b block<=%d] [-r repeat] [-t seconds] [-k m4_cycles_per_ns] [file.hea | file.edf ...]\n",
+                HUST_CODEC_MAX_BLOCK);
+        return 1;
+    }
+
+    synth_load(seconds);
+    for(; i < argc; i++)
+    {
+        const char * ext = strrchr(argv[i], '.');
+        int err = -1;
+        if(ext != NULL && strcmp(ext, ".hea") == 0)
+        {
+            err = wfdb_load(argv[i]);
+        }
+        else if(ext != NULL && (strcmp(ext, ".edf") == 0 || strcmp(ext, ".EDF") == 0))
+        {
+            err = edf_load(argv[i]);
+        }
+        if(err != 0)
+        {
+            fprintf(stderr, "skip %s\n", argv[i]);
+        }
+    }
+    if(cycles_per_ns <= 0)
+    {
+        cycles_per_ns = m4_calibrate();
+    }
+    fprintf(stderr, "%d signals, block %d, m4 model %.3f cycles/host ns\n", n_entries, block, cycles_per_ns);
+
+    printf("type\tcodec\tparam\tsamples\tratio\tbits_per_sample\tenc_m4_cyc\tdec_msps\tprd_pct\n");
+    for(int t = SIGGEN_ECG; t <= SIGGEN_EEG; t++)
+    {
+        for(size_t c = 0; c < BENCH_CODEC_COUNT; c++)
+        {
+            bench_result_t res;
+            memset(&res, 0, sizeof(res));
+            for(int k = 0; k < n_entries; k++)
+            {
+                if(entries[k].type == (siggen_type_t)t)
+                {
+                    bench_entry(&entries[k], &bench_codecs[c], block, repeat, &res);
+                }
+            }
+            if(res.samples == 0)
+            {
+                continue;
+            }
+            double prd = hust_codec_is_lossy(bench_codecs[c].codec, bench_codecs[c].param) && res.sig2 > 0 ?
+                         100.0 * sqrt(res.err2 / res.sig2) : 0.0;
+            printf("%s\t%s\t%u\t%ld\t%.3f\t%.2f\t%.1f\t%.2f\t%.4f\n",
+                   type_names[t],
+                   hust_codec_name(bench_codecs[c].codec),
+                   bench_codecs[c].param,
+                   res.samples,
+                   (double)res.samples * 3.0 / (double)res.bytes,
+                   (double)res.bytes * 8.0 / (double)res.samples,
+                   res.enc_ns * cycles_per_ns / (double)res.samples,
+                   (double)res.samples / res.dec_ns * 1e3,
+                   prd);
+        }
+    }
+    for(int k = 0; k < n_entries; k++)
+    {
+        free(entries[k].x);
+    }
+    return 0;
+}
@@ -0,0 +1,299 @@
+/*
+ * Gia lap 1 stream ECG gui cho nhieu central qua hust_fanout: nguon dong goi packet 1 lan, moi central
+ * doc ring bang con tro rieng voi toc do rieng (so packet / connection event, interval).
+ *
+ *   hust_fanout_bench [-s slow_interval_ms] [-v]
+ *
+ * Kich ban: gateway nhanh + may cam tay cham, 2 central deu nhanh, may cam tay ket noi muon va ngat
+ * giua chung, 2 central deu cham.
+ * Kiem tra: central nhanh nhan du moi packet dung thu tu du central kia cham hay ngat; central cham
+ * nhan + bo dung bang so packet da ghi tu luc no dang ky, packet nhan duoc tang dan va dung noi dung;
+ * central dang ky muon bat dau tu packet ghi tiep theo; ring chi tu choi packet khi moi central deu
+ * cham va khi do khong central nao mat packet; moi central nhan cung 1 con tro cho cung 1 packet
+ * (khong chep packet cho tung ket noi); do sau hang doi HVN dem rieng tung ket noi. Tra ve 1 neu co loi.
+ *
+ * In ra: packet nhan / bo / chua gui cua tung central, lan ring tu choi packet, packet nguon bo, RAM ring so voi
+ * 1 hang doi chep rieng cho tung ket noi.
+ *
+ * Build: cc -O2 -DHUST_HOST_BUILD -I../HUST_BLE hust_fanout_bench.c ../HUST_BLE/hust_fanout.c
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hust_fanout.h"
+
+#define PACKET_SIZE         239         // ECG 4 channel, 19 sample / packet
+#define PACKET_PERIOD_US    9500        // 19 sample o 2000 Hz
+#define SOURCE_PACKETS      64          // packet cho ghi vao ring trong app, day thi mat packet
+#define RUN_MS              20000
+#define LINKS               2
+
+static int failures = 0;
+static int verbose = 0;
+static int slow_interval_ms = 50;
+
+#define CHECK(cond, ...) do { if(!(cond)) { failures++; fprintf(stderr, "FAIL: " __VA_ARGS__); fprintf(stderr, "\n"); } } while(0)
+
+typedef struct
+{
+    const char * name;
+    int interval_ms;
+    int packets_per_event;              // hang doi HVN / thoi gian phat trong 1 connection event
+    int join_ms;                        // ket noi + dang ky
+    int leave_ms;                       // ngat, RUN_MS = khong ngat
+} link_config_t;
+
+typedef struct
+{
+    const char * name;
+    link_config_t link[LINKS];
+    int expect_drops;                   // central 1 phai mat packet
+    int expect_rejected;                // ring phai tu choi packet
+} scenario_t;
+
+typedef struct
+{
+    hust_fanout_link_t * link;
+    uint16_t conn_handle;
+    uint32_t first_index;               // packet dau tien phai nhan (head luc dang ky)
+    uint32_t expected;                  // packet ghi vao ring tu luc dang ky
+    uint32_t received;
+    uint32_t next_index;                // packet nhan sau phai >= next_index
+    uint32_t unsent;                    // packet chua gui luc ngat
+    uint32_t errors;
+} sink_t;
+
+static hust_fanout_t fanout;
+static const uint8_t * slot_of[1 << 16];    // con tro central dau tien nhan cho tung packet
+
+static void packet_fill(uint8_t * packet, uint32_t index)
+{
+    packet[0] = (uint8_t)index;
+    packet[1] = (uint8_t)(index >> 8);
+    packet[2] = (uint8_t)(index >> 16);
+    packet[3] = (uint8_t)(index >> 24);
+    for(int i = 4; i < PACKET_SIZE; i++)
+    {
+        packet[i] = (uint8_t)(index * 7 + i);
+    }
+}
+
+static void packet_check(sink_t * sink, const uint8_t * packet, uint16_t length)
+{
+    uint32_t index = packet[0] | (packet[1] << 8) | (packet[2] << 16) | ((uint32_t)packet[3] << 24);
+    int ok = length == PACKET_SIZE && index >= sink->next_index;
+    for(int i = 4; ok && i < PACKET_SIZE; i++)
+    {
+        ok = packet[i] == (uint8_t)(index * 7 + i);
+    }
+    if(sink->received == 0 && index != sink->first_index)
+    {
+        ok = 0;                         // dang ky muon: bat dau tu packet ghi sau luc dang ky
+    }
+    if(!ok)
+    {
+        sink->errors++;
+        return;
+    }
+    uint16_t key = (uint16_t)index;
+    if(slot_of[key] == NULL)
+    {
+        slot_of[key] = packet;
+    }
+    else if(slot_of[key] != packet)
+    {
+        sink->errors++;                 // ket noi khac nhan ban chep khac cua cung packet
+    }
+    sink->next_index = index + 1;
+    sink->received++;
+}
+
+static void scenario_run(const scenario_t * scenario)
+{
+    uint8_t source[SOURCE_PACKETS][PACKET_SIZE];
+    uint32_t source_head = 0;
+    uint32_t source_tail = 0;
+    uint32_t source_dropped = 0;
+    uint32_t pushed = 0;
+    sink_t sink[LINKS];
+
+    hust_fanout_init(&fanout);
+    memset(sink, 0, sizeof(sink));
+    memset(slot_of, 0, sizeof(slot_of));
+    for(int l = 0; l < LINKS; l++)
+    {
+        sink[l].conn_handle = (uint16_t)l;
+    }
+
+    uint64_t t_next = 0;
+    for(int t = 0; t < RUN_MS; t++)
+    {
+        for(int l = 0; l < LINKS; l++)
+        {
+            const link_config_t * config = &scenario->link[l];
+            if(t == config->join_ms)
+            {
+                sink[l].link = hust_fanout_link_add(&fanout, sink[l].conn_handle);
+                hust_fanout_link_ready(&fanout, sink[l].link, true);
+                sink[l].first_index = pushed;
+                sink[l].next_index = pushed;
+            }
+            if(t == config->leave_ms && sink[l].link != NULL)
+            {
+                // packet con trong ring khong gui duoc nua
+                sink[l].unsent = fanout.head - sink[l].link->cursor;
+                hust_fanout_link_remove(&fanout, sink[l].conn_handle);
+                sink[l].link = NULL;
+            }
+        }
+
+        // nguon: 1 packet / PACKET_PERIOD_US, hang doi app day thi mat packet
+        while((uint64_t)t * 1000 >= t_next)
+        {
+            t_next += PACKET_PERIOD_US;
+            if(source_head - source_tail >= SOURCE_PACKETS)
+            {
+                source_dropped++;
+                continue;
+            }
+            packet_fill(source[source_head % SOURCE_PACKETS], pushed + (source_head - source_tail));
+            source_head++;
+        }
+        while(source_tail != source_head
+              && hust_fanout_push(&fanout, source[source_tail % SOURCE_PACKETS], PACKET_SIZE) == 0)
+        {
+            source_tail++;
+            pushed++;
+            for(int l = 0; l < LINKS; l++)
+            {
+                sink[l].expected += sink[l].link != NULL;
+            }
+        }
+
+        // connection event cua tung central
+        for(int l = 0; l < LINKS; l++)
+        {
+            const link_config_t * config = &scenario->link[l];
+            if(sink[l].link == NULL || t % config->interval_ms != 0)
+            {
+                continue;
+            }
+            for(int n = 0; n < config->packets_per_event; n++)
+            {
+                uint16_t length;
+                const uint8_t * packet = hust_fanout_peek(&fanout, sink[l].link, &length);
+                if(packet == NULL)
+                {
+                    break;
+                }
+                packet_check(&sink[l], packet, length);
+                hust_fanout_advance(sink[l].link, true);
+            }
+        }
+    }
+
+    printf("%-26s pushed %5u  rejected %5u  source dropped %5u\n", scenario->name,
+           pushed, fanout.rejected, source_dropped);
+    uint32_t sent[LINKS];
+    uint32_t dropped[LINKS];
+    for(int l = 0; l < LINKS; l++)
+    {
+        const link_config_t * config = &scenario->link[l];
+        // packet chua gui (cuoi run / luc ngat) gom ca packet da bi ghi de ma peek chua tinh vao dropped
+        const hust_fanout_link_t * link = sink[l].link;
+        uint32_t pending = link != NULL ? fanout.head - link->cursor : sink[l].unsent;
+        sent[l] = link != NULL ? link->sent : sink[l].received;
+        dropped[l] = link != NULL ? link->dropped : sink[l].expected - sink[l].received - sink[l].unsent;
+        printf("  %-12s %2d ms x %d  received %5u  dropped %5u  pending %2u  errors %u\n",
+               config->name, config->interval_ms, config->packets_per_event,
+               sink[l].received, dropped[l], pending, sink[l].errors);
+        CHECK(sink[l].errors == 0, "%s / %s: %u packet sai thu tu / noi dung / con tro", scenario->name, config->name, sink[l].errors);
+        CHECK(sent[l] == sink[l].received, "%s / %s: sent %u != received %u", scenario->name, config->name, sent[l], sink[l].received);
+        CHECK(sink[l].received + dropped[l] + pending == sink[l].expected,
+              "%s / %s: received %u + dropped %u + pending %u != %u packet ghi tu luc dang ky",
+              scenario->name, config->name, sink[l].received, dropped[l], pending, sink[l].expected);
+    }
+    // central 0 (gateway) luon du nhanh: khong mat packet du central 1 the nao
+    CHECK(dropped[0] == 0, "%s: gateway mat %u packet", scenario->name, dropped[0]);
+    if(scenario->expect_drops)
+    {
+        CHECK(dropped[1] > 0, "%s: central cham khong mat packet (kich ban sai?)", scenario->name);
+    }
+    else
+    {
+        CHECK(dropped[1] == 0, "%s: central 1 mat %u packet", scenario->name, dropped[1]);
+    }
+    if(scenario->expect_rejected)
+    {
+        CHECK(fanout.rejected > 0, "%s: ring khong tu choi packet khi moi central cham", scenario->name);
+    }
+    else
+    {
+        CHECK(fanout.rejected == 0 && source_dropped == 0, "%s: ring tu choi %u packet, nguon bo %u khi con central nhanh",
+              scenario->name, fanout.rejected, source_dropped);
+    }
+}
+
+int main(int argc, char ** argv)
+{
+    for(int i = 1; i < argc; i++)
+    {
+        if(strcmp(argv[i], "-s") == 0 && i + 1 < argc)
+        {
+            slow_interval_ms = atoi(argv[++i]);
+        }
+        else if(strcmp(argv[i], "-v") == 0)
+        {
+            verbose = 1;
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [-s slow_interval_ms] [-v]\n", argv[0]);
+            return 2;
+        }
+    }
+    if(slow_interval_ms < 20)
+    {
+        fprintf(stderr, "slow_interval_ms >= 20 (4 packet / event phai cham hon nguon)\n");
+        return 2;
+    }
+
+    // may cam tay: 4 packet / connection event, cham hon nguon (~105 packet / s) khi interval >= 40 ms
+    const scenario_t scenarios[] =
+    {
+        {"gateway + handheld",      {{"gateway", 15, 6, 0, RUN_MS}, {"handheld", slow_interval_ms, 4, 0, RUN_MS}}, slow_interval_ms >= 40, 0},
+        {"gateway + fast handheld", {{"gateway", 15, 6, 0, RUN_MS}, {"handheld", 30, 6, 0, RUN_MS}}, 0, 0},
+        {"handheld joins, leaves",  {{"gateway", 15, 6, 0, RUN_MS}, {"handheld", 30, 6, 5003, 15000}}, 0, 0},
+        {"both slow",               {{"gateway", 50, 4, 0, RUN_MS}, {"handheld", 50, 4, 0, RUN_MS}}, 0, 1},
+    };
+    for(size_t i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++)
+    {
+        scenario_run(&scenarios[i]);
+    }
+    // do sau hang doi HVN rieng tung ket noi: bat dau 0 khi them, khong am khi TX complete dem du
+    hust_fanout_init(&fanout);
+    hust_fanout_link_t * a = hust_fanout_link_add(&fanout, 0);
+    hust_fanout_link_t * b = hust_fanout_link_add(&fanout, 1);
+    for(int n = 0; n < 5; n++)
+    {
+        hust_fanout_hvn_queued(b);
+    }
+    hust_fanout_hvn_complete(b, 2);
+    CHECK(a->hvn_inflight == 0 && b->hvn_inflight == 3, "hvn_inflight %u / %u, phai 0 / 3", a->hvn_inflight, b->hvn_inflight);
+    hust_fanout_hvn_complete(b, 7);
+    CHECK(b->hvn_inflight == 0, "hvn_inflight %u sau TX complete thua, phai 0", b->hvn_inflight);
+    hust_fanout_hvn_queued(b);
+    hust_fanout_link_remove(&fanout, 1);
+    b = hust_fanout_link_add(&fanout, 2);
+    CHECK(b->hvn_inflight == 0, "ket noi moi ke thua hvn_inflight %u", b->hvn_inflight);
+
+    printf("ring %u bytes for %d links, one copy per link would be %u bytes\n",
+           (unsigned)sizeof(fanout.slot), LINKS, (unsigned)sizeof(fanout.slot) * LINKS);
+    if(verbose)
+    {
+        printf("slots %d x %d bytes, links max %d\n", HUST_FANOUT_SLOTS, HUST_FANOUT_SLOT_SIZE, HUST_FANOUT_LINKS_MAX);
+    }
+    printf("%s\n", failures == 0 ? "PASS" : "FAIL");
+    return failures != 0;
+}
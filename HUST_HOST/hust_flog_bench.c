@@ -0,0 +1,433 @@
+/*
+ * Kiem tra log packet tren flash (hust_flog) voi flash NOR gia lap va mo phong 1 lan mat ket noi:
+ * BUFFERING ghi packet vao log, ket noi lai thi backfill xen voi stream live nhu backfill_process
+ * trong main.c.
+ *
+ *   hust_flog_bench [-r packets_per_s] [-p packet_size] [-o outage_s] [-b link_bytes_per_s] [-s share] [-n pages]
+ *
+ * Mac dinh: 50 packet/s x 244 byte (ECG 1000 Hz, 4 channel), mat ket noi 10 s, link 40000 byte/s,
+ * backfill 50 %, 48 page 4 KB (0x50000..0x80000 nhu hust_flog_nrf.h). Flash gia lap nhu nRF52832:
+ * xoa page 85 ms, ghi 41 us / word, lenh ket thuc bat dong bo. Packet nhanh hon 1/2 toc do ghi flash
+ * lien tuc thi khong duoc mat packet nao vi cho flash.
+ * Kiem tra: flash chi ghi len byte da xoa (bit 1 -> 0), moi packet doc lai dung noi dung, dung thu tu,
+ * lien tuc den packet cuoi cung truoc khi ket noi lai (log day thi chi mat packet cu nhat), so lan
+ * xoa cac page lech nhau <= 1 sau nhieu vong, batch ghi loi bi bo qua chu khong doc ra packet hong,
+ * clear bo het packet, backfill khong vuot share % byte gui, stream live khong mat packet khi link
+ * du cho live + share.
+ * Tra ve 1 neu co loi.
+ *
+ * In ra: dung luong log va so giay giu duoc o luong packet nay, packet luu / mat, thoi gian gui het
+ * backfill sau khi ket noi lai.
+ *
+ * Build: cc -O2 -DHUST_HOST_BUILD -I../HUST_BLE hust_flog_bench.c ../HUST_BLE/hust_flog.c
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hust_flog.h"
+
+#define BENCH_PAGE_SIZE     4096
+#define BENCH_MAX_PAGES     128
+#define BENCH_ERASE_US      85000
+#define BENCH_WORD_US       41
+
+static int failures = 0;
+
+#define CHECK(cond, ...) do { if(!(cond)) { failures++; fprintf(stderr, "FAIL: " __VA_ARGS__); fprintf(stderr, "\n"); } } while(0)
+
+typedef struct
+{
+    uint8_t mem[BENCH_MAX_PAGES * BENCH_PAGE_SIZE];
+    uint32_t base;
+    uint32_t n_pages;
+    uint32_t erase_count[BENCH_MAX_PAGES];
+    hust_flog_t * log;
+    // lenh dang chay: ket thuc luc done_us
+    int op;                             // 0 / 1 erase / 2 write
+    uint32_t addr;
+    const uint8_t * src;
+    uint32_t len;
+    uint64_t done_us;
+    uint64_t now_us;
+    int fail_write;                     // lenh ghi thu n (dem tu 1) bi loi giua chung, 0 = khong
+    int writes;
+    uint32_t bad_writes;                // ghi len byte chua xoa
+} flash_sim_t;
+
+static int sim_erase(void * p_context, uint32_t addr)
+{
+    flash_sim_t * f = p_context;
+    if(f->op != 0 || addr < f->base || (addr - f->base) % BENCH_PAGE_SIZE != 0 || addr >= f->base + f->n_pages * BENCH_PAGE_SIZE)
+    {
+        return -1;
+    }
+    f->op = 1;
+    f->addr = addr;
+    f->done_us = f->now_us + BENCH_ERASE_US;
+    return 0;
+}
+
+static int sim_write(void * p_context, uint32_t addr, const void * data, uint32_t len)
+{
+    flash_sim_t * f = p_context;
+    if(f->op != 0 || len % 4 != 0 || addr % 4 != 0 || addr < f->base || addr + len > f->base + f->n_pages * BENCH_PAGE_SIZE)
+    {
+        return -1;
+    }
+    f->op = 2;
+    f->addr = addr;
+    f->src = data;
+    f->len = len;
+    f->done_us = f->now_us + BENCH_WORD_US * (len / 4);
+    return 0;
+}
+
+static int sim_read(void * p_context, uint32_t addr, void * data, uint32_t len)
+{
+    flash_sim_t * f = p_context;
+    if(addr < f->base || addr + len > f->base + f->n_pages * BENCH_PAGE_SIZE)
+    {
+        return -1;
+    }
+    memcpy(data, f->mem + (addr - f->base), len);
+    return 0;
+}
+
+// ket thuc lenh flash da den han (du lieu chep luc ket thuc: buffer phai con nguyen)
+static void sim_run(flash_sim_t * f, uint64_t now_us)
+{
+    f->now_us = now_us;
+    if(f->op == 0 || now_us < f->done_us)
+    {
+        return;
+    }
+    uint8_t * p = f->mem + (f->addr - f->base);
+    int result = 0;
+    if(f->op == 1)
+    {
+        memset(p, 0xFF, BENCH_PAGE_SIZE);
+        f->erase_count[(f->addr - f->base) / BENCH_PAGE_SIZE]++;
+    }
+    else
+    {
+        uint32_t len = f->len;
+        if(++f->writes == f->fail_write)
+        {
+            len /= 2;                   // mat dien / SoftDevice timeout giua lenh
+            result = -1;
+        }
+        for(uint32_t i = 0; i < len; i++)
+        {
+            f->bad_writes += (p[i] & f->src[i]) != f->src[i];
+            p[i] &= f->src[i];
+        }
+    }
+    f->op = 0;
+    hust_flog_done(f->log, result);
+}
+
+static void sim_init(flash_sim_t * f, hust_flog_t * log, uint32_t n_pages, uint8_t share)
+{
+    hust_flog_io_t io = {.erase = sim_erase, .write = sim_write, .read = sim_read, .p_context = f};
+    memset(f, 0, sizeof(flash_sim_t));
+    memset(f->mem, 0x00, sizeof(f->mem));       // flash chua xoa
+    f->base = 0x50000;
+    f->n_pages = n_pages;
+    f->log = log;
+    CHECK(hust_flog_init(log, &io, f->base, BENCH_PAGE_SIZE, (uint16_t)n_pages, share) == 0, "init");
+}
+
+static uint16_t packet_make(uint32_t seq, uint16_t packet_size, uint8_t * data)
+{
+    uint16_t length = (uint16_t)(packet_size - seq % 16);
+    for(uint16_t i = 0; i < length; i++)
+    {
+        data[i] = (uint8_t)(seq * 31 + i);
+    }
+    memcpy(data, &seq, sizeof(seq));
+    return length;
+}
+
+// doc lai 1 packet va kiem tra noi dung, tra ve seq hoac -1
+static int64_t packet_check(const uint8_t * data, int length, uint16_t packet_size)
+{
+    uint8_t expect[HUST_FLOG_RECORD_MAX];
+    uint32_t seq;
+    memcpy(&seq, data, sizeof(seq));
+    if(length != packet_make(seq, packet_size, expect) || memcmp(data, expect, length) != 0)
+    {
+        return -1;
+    }
+    return seq;
+}
+
+// ghi n packet lien tiep, cho flash xong
+static void fill_log(flash_sim_t * f, hust_flog_t * log, uint32_t first, uint32_t n, uint16_t packet_size, uint64_t * now_us)
+{
+    uint8_t data[HUST_FLOG_RECORD_MAX];
+    for(uint32_t seq = first; seq < first + n; seq++)
+    {
+        uint16_t length = packet_make(seq, packet_size, data);
+        while(hust_flog_append(log, data, length) != 0)
+        {
+            log->records_dropped--;     // chi cho flash, khong tinh la mat
+            *now_us += 100;
+            sim_run(f, *now_us);
+            hust_flog_poll(log);
+        }
+        hust_flog_poll(log);
+    }
+    while(log->ready || log->fill > HUST_FLOG_BATCH_HEADER || f->op != 0)
+    {
+        hust_flog_flush(log);
+        *now_us += 100;
+        sim_run(f, *now_us);
+        hust_flog_poll(log);
+    }
+}
+
+// doc het log, tra ve so packet, kiem tra lien tuc tu first den last
+static uint32_t drain_log(hust_flog_t * log, uint16_t packet_size, int64_t first, int64_t last, const char * name)
+{
+    uint8_t data[HUST_FLOG_RECORD_MAX];
+    int64_t expect = first;
+    uint32_t n = 0;
+    int length;
+    while((length = hust_flog_peek(log, data, sizeof(data))) > 0)
+    {
+        int64_t seq = packet_check(data, length, packet_size);
+        CHECK(seq >= 0, "%s: packet hong sau seq %lld", name, (long long)expect - 1);
+        if(expect < 0)
+        {
+            expect = seq;
+        }
+        CHECK(seq == expect, "%s: seq %lld != %lld", name, (long long)seq, (long long)expect);
+        expect = seq + 1;
+        hust_flog_consume(log, (uint16_t)length);
+        n++;
+    }
+    CHECK(last < 0 || expect == last + 1, "%s: packet cuoi %lld != %lld", name, (long long)expect - 1, (long long)last);
+    return n;
+}
+
+static void check_wear(uint16_t packet_size)
+{
+    static flash_sim_t f;
+    hust_flog_t log;
+    uint64_t now_us = 0;
+    uint32_t n_pages = 8;
+
+    sim_init(&f, &log, n_pages, 50);
+    // ~10 vong log, khong doc: chi giu phan moi nhat
+    uint32_t n = 10 * n_pages * BENCH_PAGE_SIZE / packet_size;
+    fill_log(&f, &log, 0, n, packet_size, &now_us);
+    uint32_t lo = UINT32_MAX;
+    uint32_t hi = 0;
+    for(uint32_t p = 0; p < n_pages; p++)
+    {
+        lo = f.erase_count[p] < lo ? f.erase_count[p] : lo;
+        hi = f.erase_count[p] > hi ? f.erase_count[p] : hi;
+    }
+    CHECK(hi - lo <= 1, "wear: erase %u..%u", lo, hi);
+    CHECK(f.bad_writes == 0, "wear: %u byte ghi len vung chua xoa", f.bad_writes);
+    uint32_t kept = drain_log(&log, packet_size, -1, n - 1, "wear");
+    CHECK(kept * packet_size >= hust_flog_capacity(&log) * 9 / 10 && log.batches_lost > 0, "wear: giu %u packet", kept);
+    printf("wear         %u pages x %u cycles, erase/page %u..%u, kept %u of %u packets\n",
+           n_pages, hi, lo, hi, kept, n);
+
+    // lenh ghi loi giua chung: batch do bi bo, cac batch khac doc dung
+    sim_init(&f, &log, n_pages, 50);
+    f.fail_write = 5;
+    fill_log(&f, &log, 0, 40, packet_size, &now_us);
+    uint32_t lost_before = log.batches_lost;
+    uint32_t read = 0;
+    uint8_t data[HUST_FLOG_RECORD_MAX];
+    int length;
+    while((length = hust_flog_peek(&log, data, sizeof(data))) > 0)
+    {
+        CHECK(packet_check(data, length, packet_size) >= 0, "write error: packet hong");
+        hust_flog_consume(&log, (uint16_t)length);
+        read++;
+    }
+    CHECK(log.errors == 1 && log.batches_lost == lost_before + 1 && read > 0 && read < 40,
+          "write error: errors %u lost %u read %u", log.errors, log.batches_lost, read);
+
+    // clear: ca batch dang cho ghi cung khong duoc doc
+    sim_init(&f, &log, n_pages, 50);
+    fill_log(&f, &log, 0, 20, packet_size, &now_us);
+    packet_make(20, packet_size, data);
+    (void)hust_flog_append(&log, data, packet_size);
+    hust_flog_flush(&log);
+    hust_flog_clear(&log);
+    fill_log(&f, &log, 100, 10, packet_size, &now_us);
+    CHECK(drain_log(&log, packet_size, 100, 109, "clear") == 10, "clear");
+}
+
+static void usage(void)
+{
+    fprintf(stderr, "usage: hust_flog_bench [-r packets_per_s] [-p packet_size] [-o outage_s] [-b link_bytes_per_s] [-s share] [-n pages]\n");
+}
+
+int main(int argc, char ** argv)
+{
+    static flash_sim_t f;
+    hust_flog_t log;
+    double rate = 50;
+    int packet_size = 244;
+    double outage_s = 10;
+    double link = 40000;
+    int share = 50;
+    int n_pages = 48;
+
+    for(int i = 1; i < argc; i++)
+    {
+        if(i + 1 >= argc)
+        {
+            usage();
+            return 1;
+        }
+        if(strcmp(argv[i], "-r") == 0)
+        {
+            rate = atof(argv[++i]);
+        }
+        else if(strcmp(argv[i], "-p") == 0)
+        {
+            packet_size = atoi(argv[++i]);
+        }
+        else if(strcmp(argv[i], "-o") == 0)
+        {
+            outage_s = atof(argv[++i]);
+        }
+        else if(strcmp(argv[i], "-b") == 0)
+        {
+            link = atof(argv[++i]);
+        }
+        else if(strcmp(argv[i], "-s") == 0)
+        {
+            share = atoi(argv[++i]);
+        }
+        else if(strcmp(argv[i], "-n") == 0)
+        {
+            n_pages = atoi(argv[++i]);
+        }
+        else
+        {
+            usage();
+            return 1;
+        }
+    }
+    if(rate <= 0 || packet_size < 20 || packet_size > HUST_FLOG_RECORD_MAX || outage_s <= 0
+       || link <= rate * packet_size || share < 1 || share > 100 || n_pages < 2 || n_pages > BENCH_MAX_PAGES)
+    {
+        usage();
+        return 1;
+    }
+
+    check_wear((uint16_t)packet_size);
+
+    // mat ket noi outage_s giay roi ket noi lai, buoc 1 ms
+    sim_init(&f, &log, (uint32_t)n_pages, (uint8_t)share);
+    uint8_t data[HUST_FLOG_RECORD_MAX];
+    double due = 0;
+    uint32_t seq = 0;
+    uint32_t outage_last = 0;
+    int64_t backfill_expect = -1;
+    uint32_t backfilled = 0;
+    uint32_t live_sent = 0;
+    uint32_t live_lost = 0;
+    double budget = 0;
+    double drained_s = -1;
+    double share_max = 0;
+    uint64_t t_ms;
+
+    for(t_ms = 0; t_ms < (uint64_t)((outage_s * 10 + 10) * 1000) && drained_s < 0; t_ms++)
+    {
+        bool connected = t_ms >= (uint64_t)(outage_s * 1000);
+        sim_run(&f, t_ms * 1000);
+        if(connected && t_ms == (uint64_t)(outage_s * 1000))
+        {
+            outage_last = seq - 1;
+            hust_flog_share_reset(&log);
+        }
+        budget = connected ? budget + link / 1000 : 0;
+
+        // packet live: nhu stream_process, luc mat ket noi vao log (ble_packet_send)
+        for(due += rate / 1000; due >= 1; due -= 1, seq++)
+        {
+            uint16_t length = packet_make(seq, (uint16_t)packet_size, data);
+            if(!connected)
+            {
+                (void)hust_flog_append(&log, data, length);
+            }
+            else if(budget >= length)
+            {
+                budget -= length;
+                hust_flog_sent(&log, length);
+                live_sent++;
+            }
+            else
+            {
+                live_lost++;
+            }
+        }
+
+        // backfill: nhu backfill_process
+        while(connected && hust_flog_backfill_turn(&log))
+        {
+            int length = hust_flog_peek(&log, data, sizeof(data));
+            if(length == 0)
+            {
+                hust_flog_flush(&log);
+                if(!log.ready && f.op == 0 && log.fill == HUST_FLOG_BATCH_HEADER && drained_s < 0)
+                {
+                    drained_s = (double)t_ms / 1000 - outage_s;
+                }
+                break;
+            }
+            if(budget < length)
+            {
+                break;
+            }
+            budget -= length;
+            int64_t s = packet_check(data, length, (uint16_t)packet_size);
+            CHECK(s >= 0, "backfill: packet hong");
+            // packet bo vi flash cham chi tao khoang trong, khong dao thu tu
+            CHECK(backfill_expect < 0 || s == backfill_expect || (log.records_dropped > 0 && s > backfill_expect),
+                  "backfill: seq %lld != %lld", (long long)s, (long long)backfill_expect);
+            backfill_expect = s + 1;
+            hust_flog_sent(&log, (uint16_t)length);
+            hust_flog_consume(&log, (uint16_t)length);
+            backfilled++;
+            double r = (double)log.backfill_bytes / log.sent_bytes;
+            share_max = log.sent_bytes > 10000 && r > share_max ? r : share_max;
+        }
+        hust_flog_poll(&log);
+    }
+
+    double per_s = rate * packet_size;
+    uint32_t stored = log.records_written;
+    CHECK(drained_s >= 0, "backfill chua xong sau %.0f s", (double)t_ms / 1000 - outage_s);
+    CHECK(backfill_expect == (int64_t)outage_last + 1, "backfill: packet cuoi %lld != %u", (long long)backfill_expect - 1, outage_last);
+    // toc do ghi flash lien tuc: xoa + ghi 1 page
+    double flash_bps = BENCH_PAGE_SIZE * 1e6 / (BENCH_ERASE_US + BENCH_PAGE_SIZE / 4 * BENCH_WORD_US);
+    CHECK(log.records_dropped == 0 || per_s > flash_bps / 2, "%u packet bo vi flash cham", log.records_dropped);
+    CHECK(stored * (double)packet_size <= hust_flog_capacity(&log) || log.batches_lost > 0, "log day nhung khong bo page nao");
+    CHECK(stored * (double)packet_size > hust_flog_capacity(&log) || backfilled == stored,
+          "log chua day: backfill %u / %u packet", backfilled, stored);
+    // vuot share toi da 1 packet
+    CHECK(share_max <= share / 100.0 + packet_size / 10000.0, "backfill %.1f %% > share %d %%", share_max * 100, share);
+    // link du cho live + share backfill thi live khong mat packet
+    CHECK(live_lost == 0 || link * (100 - share) < per_s * 100, "%u packet live khong gui duoc", live_lost);
+    CHECK(f.bad_writes == 0, "%u byte ghi len vung chua xoa", f.bad_writes);
+
+    printf("log          %d pages, capacity %u bytes = %.1f s at %.0f packets/s x %d bytes\n",
+           n_pages, hust_flog_capacity(&log), hust_flog_capacity(&log) / per_s, rate, packet_size);
+    printf("flash        %.0f bytes/s sustained (erase + write), packets %.0f bytes/s\n", flash_bps, per_s);
+    printf("outage       %.1f s: %u packets stored, %u dropped (RAM), %u batches overwritten, %u erases\n",
+           outage_s, stored, log.records_dropped, log.batches_lost, log.erases);
+    printf("backfill     %u packets in %.1f s after reconnect, share max %.1f %% (limit %d %%), live %u sent %u lost\n",
+           backfilled, drained_s, share_max * 100, share, live_sent, live_lost);
+    printf("%s\n", failures == 0 ? "PASS" : "FAIL");
+    return failures != 0;
+}
@@ -0,0 +1,299 @@
+/*
+ * Kiem tra lich su RAM nen gon (hust_hist) va uoc luong so giay giu duoc khi mat ket noi ngan:
+ * dong goi ECG nhu main.c (siggen, packet ECG_SENSOR_TYPE, co the thieu channel / co trailer), day
+ * vao ring, ring day thi lay record cu nhat ra (nhu ble_packet_send luc BUFFERING: chuyen xuong
+ * flash hoac bo).
+ *
+ *   hust_hist_bench [-m ring_bytes] [-r rate] [-c channel_mask] [-t trailer_bytes]
+ *
+ * Mac dinh: ring 24576 byte (uoc luong RAM trong giua heap va stack ban S132), ECG 500 Hz 4 channel.
+ * Kiem tra: moi packet doc ra (ca record bi day ra khi ring day) giong het packet goc, dung thu tu,
+ * lien tuc den packet cuoi; tron packet RAW / ECG do dai ngau nhien voi push/pop xen ke khop hang
+ * doi mau; ring rong thi khong con byte nao bi giu; uoc luong so giay giu duoc luc ring moi day 1
+ * nua lech <= 10 % so voi luc day; clear bo het record.
+ * Tra ve 1 neu co loi.
+ *
+ * In ra: ty le nen, so giay ring giu duoc so voi luu packet tho.
+ *
+ * Build: cc -O2 -DHUST_HOST_BUILD -I../HUST_BLE hust_hist_bench.c ../HUST_BLE/hust_hist.c ../HUST_BLE/hust_codec.c ../HUST_BLE/hust_ble.c ../HUST_BLE/hust_siggen.c
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hust_hist.h"
+#include "hust_ble.h"
+#include "hust_siggen.h"
+
+#define BENCH_RTC_HZ        16384
+#define BENCH_RTC_MASK      0xFFFFFF
+#define BENCH_MAX_RING      (256 * 1024)
+
+static int failures = 0;
+
+#define CHECK(cond, ...) do { if(!(cond)) { failures++; fprintf(stderr, "FAIL: " __VA_ARGS__); fprintf(stderr, "\n"); } } while(0)
+
+static uint8_t ring_buf[BENCH_MAX_RING];
+
+typedef struct
+{
+    siggen_t lead[ECG_CHANNEL];
+    uint8_t mask;
+    int trailer;
+    int samples;                        // sample / packet
+    uint32_t seq;
+} ecg_source_t;
+
+static const int32_t lead_amplitude[ECG_CHANNEL] = {4000, 2800, -1200, 3300};
+
+static void source_init(ecg_source_t * src, uint32_t rate, uint8_t mask, int trailer)
+{
+    ble_packet_t p;
+    memset(src, 0, sizeof(ecg_source_t));
+    for(int ch = 0; ch < ECG_CHANNEL; ch++)
+    {
+        siggen_init(&src->lead[ch], SIGGEN_ECG, rate, ch + 1);
+        src->lead[ch].amplitude = lead_amplitude[ch];
+    }
+    src->mask = mask;
+    src->trailer = trailer;
+    p.sensor_type = ECG_SENSOR_TYPE;
+    p.channel_mask = mask;
+    src->samples = set_sample_transfer(p).ecg_sample;
+}
+
+// packet ECG_SENSOR_TYPE nhu convert_data_to_ble_packet, trailer = byte ngau nhien sau data_size
+static uint16_t source_packet(ecg_source_t * src, uint8_t * data)
+{
+    int channels = ecg_channel_count(src->mask);
+    int masked = src->mask != ECG_CHANNEL_MASK_ALL;
+    int pos = BLE_PACKET_HEADER_SIZE;
+
+    for(int i = 0; i < 8; i++)
+    {
+        data[i] = (uint8_t)((uint64_t)src->seq * src->samples >> (8 * i));
+    }
+    data[8] = (uint8_t)(ECG_SENSOR_TYPE | (masked ? SENSOR_TYPE_MASKED : 0));
+    data[9] = (uint8_t)(masked + src->samples * channels * ECG_DATA_LENGTH);
+    data[10] = (uint8_t)src->seq;
+    if(masked)
+    {
+        data[pos++] = src->mask;
+    }
+    for(int s = 0; s < src->samples; s++)
+    {
+        for(int ch = 0; ch < ECG_CHANNEL; ch++)
+        {
+            int32_t v = siggen_next(&src->lead[ch]);
+            if(src->mask & (1 << ch))
+            {
+                *(ecg_sample_data_t *)(data + pos) = int32_to_ecg_sample(v);
+                pos += ECG_DATA_LENGTH;
+            }
+        }
+    }
+    for(int i = 0; i < src->trailer; i++)
+    {
+        data[pos++] = (uint8_t)rand();
+    }
+    src->seq++;
+    return (uint16_t)pos;
+}
+
+typedef struct
+{
+    uint8_t data[HUST_HIST_PACKET_MAX];
+    uint16_t length;
+} packet_t;
+
+// doc record cu nhat ra va so voi packet goc thu *p_next
+static void pop_check(hust_hist_t * hist, const packet_t * packets, uint32_t * p_next, const char * name)
+{
+    uint8_t data[HUST_HIST_PACKET_MAX];
+    int length = hust_hist_pop(hist, data, sizeof(data));
+    const packet_t * p = &packets[*p_next];
+    CHECK(length == p->length && memcmp(data, p->data, length) == 0, "%s: packet %u khac goc (%d / %u byte)",
+          name, *p_next, length, p->length);
+    (*p_next)++;
+}
+
+// stream ECG lien tuc vao ring kich thuoc size, tra ve so giay ring giu duoc khi day
+static double check_stream(uint32_t size, uint32_t rate, uint8_t mask, int trailer, double * p_ratio, double * p_raw_s)
+{
+    hust_hist_t hist;
+    ecg_source_t src;
+    source_init(&src, rate, mask, trailer);
+    CHECK(hust_hist_init(&hist, ring_buf, size, BENCH_RTC_MASK) == 0, "init %u byte", size);
+
+    // du cho ring day 3 lan o ty le nen toi da ~4
+    uint32_t n = 0;
+    uint32_t max_packets = 12 * size / (BLE_PACKET_HEADER_SIZE + 1) + 1000;
+    packet_t * packets = malloc(sizeof(packet_t) * max_packets);
+    uint32_t next = 0;                  // packet ke tiep phai doc ra
+    uint32_t estimate = 0;
+    uint32_t full_span = 0;
+    bool full = false;
+
+    while(n < max_packets)
+    {
+        uint32_t tick = (uint32_t)((uint64_t)n * src.samples * BENCH_RTC_HZ / rate);
+        packets[n].length = source_packet(&src, packets[n].data);
+        while(hust_hist_push(&hist, packets[n].data, packets[n].length, tick) != 0)
+        {
+            if(!full)
+            {
+                full_span = hust_hist_span(&hist);
+                full = true;
+            }
+            pop_check(&hist, packets, &next, "stream");
+        }
+        if(!full && hist.used >= size / 2 && estimate == 0)
+        {
+            estimate = hust_hist_capacity(&hist);
+        }
+        n++;
+        if(full && n - next > 0 && next > n / 2)
+        {
+            break;
+        }
+    }
+    CHECK(full, "stream: ring khong day sau %u packet", n);
+    double diff = full_span > estimate ? full_span - estimate : estimate - full_span;
+    CHECK(diff <= full_span / 10.0, "stream: uoc luong %u tick, thuc te %u tick", estimate, full_span);
+    while(hist.count > 0)
+    {
+        pop_check(&hist, packets, &next, "drain");
+    }
+    CHECK(next == n, "stream: doc %u / %u packet", next, n);
+    CHECK(hist.used == 0 && hust_hist_peek(&hist, packets[0].data, HUST_HIST_PACKET_MAX) == 0, "stream: ring rong con %u byte", hist.used);
+    CHECK(hist.errors == 0, "stream: %u record hong", hist.errors);
+
+    *p_ratio = (double)hist.record_bytes / hist.packet_bytes;
+    // packet tho (record RAW) trong cung ring
+    *p_raw_s = (double)size / (packets[0].length + HUST_HIST_RECORD_HEADER) * src.samples / rate;
+    free(packets);
+    return (double)full_span / BENCH_RTC_HZ;
+}
+
+// packet RAW / ECG do dai ngau nhien, push / pop ngau nhien, so voi hang doi mau
+static void check_mixed(void)
+{
+    enum { N = 20000 };
+    hust_hist_t hist;
+    ecg_source_t src;
+    packet_t * packets = malloc(sizeof(packet_t) * N);
+    uint32_t next = 0;
+    uint32_t n = 0;
+
+    srand(7);
+    CHECK(hust_hist_init(&hist, ring_buf, 1500, BENCH_RTC_MASK) == 0, "mixed: init");
+    source_init(&src, 250, 0x0B, 4);
+    while(n < N)
+    {
+        if(rand() % 3 != 0)
+        {
+            packet_t * p = &packets[n];
+            if(rand() % 2)
+            {
+                p->length = source_packet(&src, p->data);
+            }
+            else
+            {
+                p->length = (uint16_t)(1 + rand() % HUST_HIST_PACKET_MAX);
+                for(int i = 0; i < p->length; i++)
+                {
+                    p->data[i] = (uint8_t)rand();
+                }
+            }
+            // tick tang qua moc 24 bit
+            while(hust_hist_push(&hist, p->data, p->length, 0xFFF000u + n * 16) != 0)
+            {
+                CHECK(hist.count > 0, "mixed: ring rong van khong nhan packet %u byte", p->length);
+                if(hist.count == 0)
+                {
+                    break;
+                }
+                pop_check(&hist, packets, &next, "mixed");
+            }
+            n++;
+        }
+        else if(hist.count > 0)
+        {
+            pop_check(&hist, packets, &next, "mixed");
+        }
+        CHECK(hist.used <= hist.size, "mixed: used %u > size", hist.used);
+        CHECK(hist.count == 0 || hust_hist_span(&hist) == (n - 1 - next) * 16u, "mixed: span %u", hust_hist_span(&hist));
+    }
+    while(hist.count > 0)
+    {
+        pop_check(&hist, packets, &next, "mixed");
+    }
+    CHECK(next == N && hist.used == 0, "mixed: doc %u / %u, con %u byte", next, N, hist.used);
+
+    // clear
+    for(int i = 0; i < 5; i++)
+    {
+        CHECK(hust_hist_push(&hist, packets[i].data, packets[i].length, i) == 0, "clear: push");
+    }
+    hust_hist_clear(&hist);
+    CHECK(hist.count == 0 && hust_hist_peek(&hist, packets[0].data, HUST_HIST_PACKET_MAX) == 0 && hust_hist_span(&hist) == 0, "clear");
+    free(packets);
+}
+
+static void usage(void)
+{
+    fprintf(stderr, "usage: hust_hist_bench [-m ring_bytes] [-r rate] [-c channel_mask] [-t trailer_bytes]\n");
+}
+
+int main(int argc, char ** argv)
+{
+    uint32_t size = 24576;
+    uint32_t rate = 500;
+    uint8_t mask = ECG_CHANNEL_MASK_ALL;
+    int trailer = 0;
+
+    for(int i = 1; i < argc; i++)
+    {
+        if(i + 1 >= argc)
+        {
+            usage();
+            return 1;
+        }
+        if(strcmp(argv[i], "-m") == 0)
+        {
+            size = (uint32_t)atoi(argv[++i]);
+        }
+        else if(strcmp(argv[i], "-r") == 0)
+        {
+            rate = (uint32_t)atoi(argv[++i]);
+        }
+        else if(strcmp(argv[i], "-c") == 0)
+        {
+            mask = (uint8_t)strtol(argv[++i], NULL, 0);
+        }
+        else if(strcmp(argv[i], "-t") == 0)
+        {
+            trailer = atoi(argv[++i]);
+        }
+        else
+        {
+            usage();
+            return 1;
+        }
+    }
+    if(size > BENCH_MAX_RING || rate == 0 || ecg_channel_count(mask) == 0 || trailer < 0 || trailer > 16)
+    {
+        usage();
+        return 1;
+    }
+
+    check_mixed();
+
+    double ratio, raw_s;
+    double held_s = check_stream(size, rate, mask, trailer, &ratio, &raw_s);
+    CHECK(ratio < 1.0, "ECG khong gon hon packet tho (%.2f)", ratio);
+    printf("ring %u byte, ECG %u Hz mask 0x%02X: record / packet %.2f, giu %.1f s (packet tho %.1f s)\n",
+           size, rate, mask, ratio, held_s, raw_s);
+    printf("%s\n", failures == 0 ? "PASS" : "FAIL");
+    return failures == 0 ? 0 : 1;
+}
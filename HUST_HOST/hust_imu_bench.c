@@ -0,0 +1,301 @@
+/*
+ * Kiem tra driver hust_imu voi IMU gia lap (hust_imu_mock) va so sanh doc FIFO theo burst voi
+ * doc tung sample.
+ *
+ *   hust_imu_bench [-r rate] [-w watermark] [-n samples]
+ *
+ * Mac dinh: 104 Hz, watermark 16, 100000 sample, chay ca LSM6DSL (0x6A @ 0x6B) va MPU-9250 (0x71 @ 0x68).
+ * Kiem tra: do tim chip, thanh ghi sau khoi tao, tu choi watermark/rate khong hop le va dia chi
+ * khong co chip, gia tri + thu tu tung sample doc qua FIFO (ngat INT1 cua LSM6 / dem xung data ready
+ * cua MPU nhu TIMER3) trung voi gia tri mock da tao, khong tran FIFO. Tra ve 1 neu co loi.
+ *
+ * So sanh: giao dich I2C / sample, thoi gian bus I2C 400 kHz / sample, % bus ban, so ngat CPU /
+ * sample (watermark + DMA xong) giua burst FIFO va doc thanh ghi output moi sample, va thoi gian
+ * hust_imu_parse / sample tren host.
+ *
+ * Build: cc -O2 -DHUST_HOST_BUILD -I../HUST_BLE -I. hust_imu_bench.c hust_imu_mock.c ../HUST_BLE/hust_imu.c ../HUST_BLE/hust_ble.c
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "hust_imu.h"
+#include "hust_imu_mock.h"
+
+#define BENCH_I2C_HZ    400000
+
+static int failures = 0;
+
+#define CHECK(cond, ...) do { if(!(cond)) { failures++; fprintf(stderr, "FAIL: " __VA_ARGS__); fprintf(stderr, "\n"); } } while(0)
+
+typedef struct
+{
+    const char * name;
+    uint8_t who_am_i;
+    uint8_t addr;
+    uint8_t out_reg;                    // thanh ghi output dau tien (doc tung sample)
+} bench_chip_t;
+
+static const bench_chip_t bench_chip[] =
+{
+    {"LSM6DSL",  0x6A, HUST_LSM6_ADDR + 1, 0x28},
+    {"MPU-9250", 0x71, HUST_MPU_ADDR,      0x3B},
+};
+
+static void usage(void)
+{
+    fprintf(stderr, "usage: hust_imu_bench [-r rate] [-w watermark] [-n samples]\n");
+}
+
+static double time_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static void check_init(const bench_chip_t * chip, uint16_t rate, uint8_t watermark)
+{
+    hust_imu_mock_t mock;
+    hust_imu_io_t io;
+    hust_imu_t imu;
+
+    hust_imu_mock_init(&mock, chip->who_am_i, chip->addr);
+    hust_imu_mock_io(&mock, &io);
+    CHECK(hust_imu_init(&imu, &io, rate, watermark) == 0, "%s init rate %u", chip->name, rate);
+    CHECK(imu.family == mock.family && imu.addr == chip->addr && imu.who_am_i == chip->who_am_i,
+          "%s probe (addr 0x%02x)", chip->name, imu.addr);
+    if(mock.family == HUST_IMU_LSM6)
+    {
+        uint16_t threshold = (uint16_t)(mock.reg[HUST_LSM6_FIFO_CTRL1] | (mock.reg[HUST_LSM6_FIFO_CTRL1 + 1] << 8));
+        CHECK(threshold == watermark * 3, "%s FIFO threshold %u", chip->name, threshold);
+        CHECK((mock.reg[HUST_LSM6_CTRL1_XL] & 0x0C) == 0x08, "%s full scale", chip->name);
+        CHECK((mock.reg[HUST_LSM6_CTRL1_XL] >> 4) == (mock.reg[HUST_LSM6_FIFO_CTRL5] >> 3), "%s ODR_FIFO != ODR_XL", chip->name);
+        CHECK(mock.reg[HUST_LSM6_INT1_CTRL] == 0x08, "%s INT1_FTH", chip->name);
+        CHECK((mock.reg[HUST_LSM6_CTRL3_C] & 0x44) == 0x44, "%s BDU/IF_INC", chip->name);
+    }
+    else
+    {
+        CHECK(1000 / (mock.reg[HUST_MPU_SMPLRT_DIV] + 1) == imu.rate, "%s SMPLRT_DIV %u rate %u",
+              chip->name, mock.reg[HUST_MPU_SMPLRT_DIV], imu.rate);
+        CHECK((mock.reg[HUST_MPU_PWR_MGMT_1] & 0x40) == 0, "%s still sleeping", chip->name);
+        CHECK(mock.reg[HUST_MPU_FIFO_EN] == 0x08 && mock.reg[HUST_MPU_USER_CTRL] == 0x40, "%s FIFO config", chip->name);
+        CHECK(mock.reg[HUST_MPU_INT_ENABLE] == 0x01, "%s RAW_RDY", chip->name);
+    }
+
+    // tat / bat accel khi khong stream, cau hinh giu nguyen
+    uint8_t ctrl = mock.family == HUST_IMU_LSM6 ? mock.reg[HUST_LSM6_CTRL1_XL] : mock.reg[HUST_MPU_PWR_MGMT_1];
+    CHECK(hust_imu_power(&imu, false) == 0, "%s power off", chip->name);
+    if(mock.family == HUST_IMU_LSM6)
+    {
+        CHECK(mock.reg[HUST_LSM6_CTRL1_XL] == 0x08, "%s power-down CTRL1_XL 0x%02x", chip->name, mock.reg[HUST_LSM6_CTRL1_XL]);
+    }
+    else
+    {
+        CHECK((mock.reg[HUST_MPU_PWR_MGMT_1] & 0x40) != 0, "%s not sleeping", chip->name);
+    }
+    CHECK(hust_imu_power(&imu, true) == 0, "%s power on", chip->name);
+    CHECK((mock.family == HUST_IMU_LSM6 ? mock.reg[HUST_LSM6_CTRL1_XL] : mock.reg[HUST_MPU_PWR_MGMT_1]) == ctrl,
+          "%s power on config", chip->name);
+    CHECK(mock.errors == 0, "%s mock errors %u", chip->name, mock.errors);
+
+    // tham so sai / khong co chip
+    hust_imu_mock_init(&mock, chip->who_am_i, chip->addr);
+    CHECK(hust_imu_init(&imu, &io, rate, 0) != 0, "%s watermark 0 accepted", chip->name);
+    CHECK(hust_imu_init(&imu, &io, rate, HUST_IMU_MAX_WATERMARK + 1) != 0, "%s watermark > max accepted", chip->name);
+    CHECK(hust_imu_init(&imu, &io, mock.family == HUST_IMU_LSM6 ? 100 : 2000, watermark) != 0,
+          "%s invalid rate accepted", chip->name);
+    hust_imu_mock_init(&mock, chip->who_am_i, chip->addr);
+    mock.addr = 0x10;
+    CHECK(hust_imu_init(&imu, &io, rate, watermark) != 0, "%s init without chip", chip->name);
+}
+
+typedef struct
+{
+    uint32_t transactions;
+    uint64_t bus_bits;
+    uint64_t interrupts;
+} bench_cost_t;
+
+// doc qua FIFO nhu hust_imu_nrf: LSM6 ngat canh len INT1, MPU dem xung data ready toi watermark
+static void run_fifo(const bench_chip_t * chip, uint16_t rate, uint8_t watermark, uint32_t n_samples, bench_cost_t * cost)
+{
+    hust_imu_mock_t mock;
+    hust_imu_io_t io;
+    hust_imu_t imu;
+    uint8_t raw[HUST_IMU_MAX_WATERMARK * HUST_IMU_SAMPLE_SIZE];
+    int16_t axis[HUST_IMU_MAX_WATERMARK * IMU_CHANNEL];
+    int16_t * trace = malloc(((size_t)n_samples + 1) * IMU_CHANNEL * sizeof(int16_t));
+    uint64_t read = 0;
+    uint32_t counter = 0;
+    bool int_level = false;
+    bool mismatch = false;
+
+    hust_imu_mock_init(&mock, chip->who_am_i, chip->addr);
+    hust_imu_mock_io(&mock, &io);
+    if(trace == NULL || hust_imu_init(&imu, &io, rate, watermark) != 0)
+    {
+        CHECK(0, "%s fifo setup", chip->name);
+        free(trace);
+        return;
+    }
+    mock.trace = trace;
+    mock.transactions = 0;
+    mock.bus_bits = 0;
+    memset(cost, 0, sizeof(*cost));
+
+    for(uint32_t s = 0; s < n_samples; s++)
+    {
+        bool burst = false;
+        hust_imu_mock_advance(&mock, 1);
+        if(imu.family == HUST_IMU_LSM6)
+        {
+            bool level = hust_imu_mock_int(&mock);
+            burst = level && !int_level;
+            int_level = level;
+        }
+        else if(++counter == watermark)
+        {
+            counter = 0;                // TIMER3 COMPARE0 + SHORT CLEAR
+            burst = true;
+        }
+        while(burst)
+        {
+            cost->interrupts += 2;      // watermark + TWIM DONE
+            if(hust_imu_fifo_read(&imu, raw, watermark) != 0)
+            {
+                CHECK(0, "%s fifo read", chip->name);
+                break;
+            }
+            hust_imu_parse(&imu, raw, watermark, axis);
+            for(int i = 0; i < watermark * IMU_CHANNEL && !mismatch; i++)
+            {
+                if(read * IMU_CHANNEL + i >= mock.trace_len * IMU_CHANNEL || axis[i] != trace[read * IMU_CHANNEL + i])
+                {
+                    CHECK(0, "%s sample %llu axis %d", chip->name, (unsigned long long)(read + i / IMU_CHANNEL), i % IMU_CHANNEL);
+                    mismatch = true;
+                }
+            }
+            read += watermark;
+            // LSM6: INT1 van cao sau burst -> doc tiep (nhu hust_imu_nrf)
+            int_level = hust_imu_mock_int(&mock);
+            burst = imu.family == HUST_IMU_LSM6 && int_level;
+        }
+    }
+    CHECK(mock.fifo_overflows == 0, "%s FIFO overflow %u", chip->name, mock.fifo_overflows);
+    CHECK(mock.errors == 0, "%s mock errors %u", chip->name, mock.errors);
+    CHECK(n_samples - read < watermark, "%s read %llu of %u samples", chip->name, (unsigned long long)read, n_samples);
+    CHECK(hust_imu_fifo_count(&imu) == (int)(n_samples - read), "%s fifo_count %d", chip->name, hust_imu_fifo_count(&imu));
+    cost->transactions = mock.transactions - 1;     // bo giao dich fifo_count o tren
+    cost->bus_bits = mock.bus_bits - (1 + 9 * 2 + 1 + 9 * 3 + 1);
+    free(trace);
+}
+
+// doc thanh ghi output (x, y, z) moi sample: 1 ngat data ready + 1 DMA / sample
+static void run_poll(const bench_chip_t * chip, uint16_t rate, uint32_t n_samples, bench_cost_t * cost)
+{
+    hust_imu_mock_t mock;
+    hust_imu_io_t io;
+    hust_imu_t imu;
+    uint8_t raw[HUST_IMU_SAMPLE_SIZE];
+    int16_t axis[IMU_CHANNEL];
+
+    hust_imu_mock_init(&mock, chip->who_am_i, chip->addr);
+    hust_imu_mock_io(&mock, &io);
+    if(hust_imu_init(&imu, &io, rate, 1) != 0)
+    {
+        CHECK(0, "%s poll setup", chip->name);
+        return;
+    }
+    mock.transactions = 0;
+    mock.bus_bits = 0;
+    memset(cost, 0, sizeof(*cost));
+    for(uint32_t s = 0; s < n_samples; s++)
+    {
+        hust_imu_mock_advance(&mock, 1);
+        (void)hust_imu_reg_read(&imu, chip->out_reg, raw, HUST_IMU_SAMPLE_SIZE);
+        hust_imu_parse(&imu, raw, 1, axis);
+        CHECK(axis[0] == hust_imu_mock_value(s, 0) && axis[2] == hust_imu_mock_value(s, 2), "%s poll sample %u", chip->name, s);
+        cost->interrupts += 2;
+    }
+    cost->transactions = mock.transactions;
+    cost->bus_bits = mock.bus_bits;
+}
+
+static void print_cost(const char * name, const char * mode, const bench_cost_t * cost, uint32_t n_samples, uint16_t rate)
+{
+    double us_per_sample = (double)cost->bus_bits * 1e6 / BENCH_I2C_HZ / n_samples;
+    printf("%-9s %-6s %10.3f %12.1f %8.2f%% %12.3f\n", name, mode,
+           (double)cost->transactions / n_samples, us_per_sample, us_per_sample * rate / 1e4,
+           (double)cost->interrupts / n_samples);
+}
+
+int main(int argc, char ** argv)
+{
+    uint16_t rate = 104;
+    int watermark = 16;
+    uint32_t n_samples = 100000;
+
+    for(int i = 1; i < argc; i++)
+    {
+        if(strcmp(argv[i], "-r") == 0 && i + 1 < argc)
+        {
+            rate = (uint16_t)atoi(argv[++i]);
+        }
+        else if(strcmp(argv[i], "-w") == 0 && i + 1 < argc)
+        {
+            watermark = atoi(argv[++i]);
+        }
+        else if(strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+        {
+            n_samples = (uint32_t)atol(argv[++i]);
+        }
+        else
+        {
+            usage();
+            return 1;
+        }
+    }
+    if(watermark < 1 || watermark > HUST_IMU_MAX_WATERMARK || n_samples == 0)
+    {
+        usage();
+        return 1;
+    }
+
+    printf("rate %u Hz, watermark %d, %u samples, I2C %d kHz\n", rate, watermark, n_samples, BENCH_I2C_HZ / 1000);
+    printf("%-9s %-6s %10s %12s %9s %12s\n", "chip", "mode", "xfer/smp", "bus_us/smp", "bus", "irq/smp");
+    for(unsigned c = 0; c < sizeof(bench_chip) / sizeof(bench_chip[0]); c++)
+    {
+        const bench_chip_t * chip = &bench_chip[c];
+        bench_cost_t fifo, poll;
+
+        check_init(chip, rate, (uint8_t)watermark);
+        run_fifo(chip, rate, (uint8_t)watermark, n_samples, &fifo);
+        run_poll(chip, rate, n_samples, &poll);
+        print_cost(chip->name, "fifo", &fifo, n_samples, rate);
+        print_cost(chip->name, "poll", &poll, n_samples, rate);
+    }
+
+    // parse 1 burst tren host
+    hust_imu_t imu = { .family = HUST_IMU_LSM6 };
+    uint8_t raw[HUST_IMU_MAX_WATERMARK * HUST_IMU_SAMPLE_SIZE];
+    int16_t axis[HUST_IMU_MAX_WATERMARK * IMU_CHANNEL];
+    volatile int16_t sink = 0;
+    for(size_t i = 0; i < sizeof(raw); i++)
+    {
+        raw[i] = (uint8_t)(i * 31);
+    }
+    double t0 = time_ns();
+    for(uint32_t s = 0; s < n_samples; s += watermark)
+    {
+        hust_imu_parse(&imu, raw, watermark, axis);
+        sink += axis[s % (watermark * IMU_CHANNEL)];
+    }
+    printf("parse     %.1f ns/sample\n", (time_ns() - t0) / n_samples);
+    (void)sink;
+
+    printf("%s\n", failures == 0 ? "PASS" : "FAIL");
+    return failures == 0 ? 0 : 1;
+}
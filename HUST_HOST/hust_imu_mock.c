@@ -0,0 +1,268 @@
+#include <string.h>
+
+#include "hust_imu_mock.h"
+
+#define LSM6_OUTX_L_XL      0x28
+#define LSM6_FIFO_STATUS2   0x3B
+#define LSM6_FIFO_DATA_H    0x3F
+#define MPU_ACCEL_XOUT_H    0x3B
+#define MPU_FIFO_COUNTL     0x73
+
+static void mock_reset_regs(hust_imu_mock_t * mock)
+{
+    uint8_t who_am_i = mock->family == HUST_IMU_LSM6 ? mock->reg[HUST_LSM6_WHO_AM_I] : mock->reg[HUST_MPU_WHO_AM_I];
+
+    memset(mock->reg, 0, sizeof(mock->reg));
+    if(mock->family == HUST_IMU_LSM6)
+    {
+        mock->reg[HUST_LSM6_WHO_AM_I] = who_am_i;
+        mock->reg[HUST_LSM6_CTRL3_C] = 0x04;        // IF_INC
+    }
+    else
+    {
+        mock->reg[HUST_MPU_WHO_AM_I] = who_am_i;
+        mock->reg[HUST_MPU_PWR_MGMT_1] = 0x40;      // SLEEP
+    }
+    mock->fifo_head = 0;
+    mock->fifo_count = 0;
+}
+
+int hust_imu_mock_init(hust_imu_mock_t * mock, uint8_t who_am_i, uint8_t addr)
+{
+    memset(mock, 0, sizeof(*mock));
+    if((who_am_i == 0x69 || who_am_i == 0x6A) && (addr == HUST_LSM6_ADDR || addr == HUST_LSM6_ADDR + 1))
+    {
+        mock->family = HUST_IMU_LSM6;
+        mock->fifo_size = HUST_IMU_MOCK_FIFO_SIZE;
+        mock->reg[HUST_LSM6_WHO_AM_I] = who_am_i;
+    }
+    else if((who_am_i == 0x70 || who_am_i == 0x71 || who_am_i == 0x12) && (addr == HUST_MPU_ADDR || addr == HUST_MPU_ADDR + 1))
+    {
+        mock->family = HUST_IMU_MPU;
+        mock->fifo_size = 512;
+        mock->reg[HUST_MPU_WHO_AM_I] = who_am_i;
+    }
+    else
+    {
+        return -1;
+    }
+    mock->addr = addr;
+    mock_reset_regs(mock);
+    return 0;
+}
+
+int16_t hust_imu_mock_value(uint64_t k, int a)
+{
+    // du ca 16 bit va dau am de bat loi thu tu byte
+    return (int16_t)(uint16_t)(k * 37 + (uint64_t)a * 11113 + 0x8000);
+}
+
+static bool mock_fifo_enabled(const hust_imu_mock_t * mock)
+{
+    if(mock->family == HUST_IMU_LSM6)
+    {
+        // FIFO continuous, accel khong decimation
+        return (mock->reg[HUST_LSM6_FIFO_CTRL5] & 0x07) == 0x06 && (mock->reg[HUST_LSM6_FIFO_CTRL3] & 0x07) == 0x01;
+    }
+    return (mock->reg[HUST_MPU_USER_CTRL] & 0x40) != 0 && (mock->reg[HUST_MPU_FIFO_EN] & 0x08) != 0;
+}
+
+void hust_imu_mock_advance(hust_imu_mock_t * mock, uint32_t n)
+{
+    for(uint32_t i = 0; i < n; i++)
+    {
+        uint64_t k = mock->samples++;
+        for(int a = 0; a < IMU_CHANNEL; a++)
+        {
+            uint16_t v = (uint16_t)hust_imu_mock_value(k, a);
+            // LSM6 little-endian, MPU big-endian
+            mock->out[2 * a] = mock->family == HUST_IMU_LSM6 ? (uint8_t)v : (uint8_t)(v >> 8);
+            mock->out[2 * a + 1] = mock->family == HUST_IMU_LSM6 ? (uint8_t)(v >> 8) : (uint8_t)v;
+        }
+        if(!mock_fifo_enabled(mock))
+        {
+            continue;
+        }
+        if(mock->fifo_count + HUST_IMU_SAMPLE_SIZE > mock->fifo_size)
+        {
+            // continuous: sample cu nhat bi ghi de
+            mock->fifo_head = (uint16_t)((mock->fifo_head + HUST_IMU_SAMPLE_SIZE) % mock->fifo_size);
+            mock->fifo_count -= HUST_IMU_SAMPLE_SIZE;
+            mock->fifo_overflows++;
+        }
+        for(int b = 0; b < HUST_IMU_SAMPLE_SIZE; b++)
+        {
+            mock->fifo[(mock->fifo_head + mock->fifo_count + b) % mock->fifo_size] = mock->out[b];
+        }
+        mock->fifo_count += HUST_IMU_SAMPLE_SIZE;
+        if(mock->trace != NULL)
+        {
+            for(int a = 0; a < IMU_CHANNEL; a++)
+            {
+                mock->trace[mock->trace_len * IMU_CHANNEL + a] = hust_imu_mock_value(k, a);
+            }
+            mock->trace_len++;
+        }
+    }
+}
+
+bool hust_imu_mock_int(const hust_imu_mock_t * mock)
+{
+    if(mock->family != HUST_IMU_LSM6 || (mock->reg[HUST_LSM6_INT1_CTRL] & 0x08) == 0)
+    {
+        return false;
+    }
+    uint16_t threshold = (uint16_t)(((mock->reg[HUST_LSM6_FIFO_CTRL1 + 1] & 0x07) << 8) | mock->reg[HUST_LSM6_FIFO_CTRL1]);
+    return threshold > 0 && mock->fifo_count / 2 >= threshold;
+}
+
+static uint8_t mock_fifo_pop(hust_imu_mock_t * mock)
+{
+    if(mock->fifo_count == 0)
+    {
+        mock->errors++;
+        return 0;
+    }
+    uint8_t value = mock->fifo[mock->fifo_head];
+    mock->fifo_head = (uint16_t)((mock->fifo_head + 1) % mock->fifo_size);
+    mock->fifo_count--;
+    return value;
+}
+
+static uint8_t mock_reg_read(hust_imu_mock_t * mock, uint8_t reg)
+{
+    uint16_t words = mock->fifo_count / 2;
+
+    if(mock->family == HUST_IMU_LSM6)
+    {
+        switch(reg)
+        {
+            case HUST_LSM6_FIFO_STATUS1:    return (uint8_t)words;
+            case LSM6_FIFO_STATUS2:         return (uint8_t)(((words >> 8) & 0x07) | (hust_imu_mock_int(mock) ? 0x80 : 0)
+                                                             | (words == 0 ? 0x10 : 0));
+            case HUST_LSM6_FIFO_DATA_OUT_L:
+            case LSM6_FIFO_DATA_H:          return mock_fifo_pop(mock);
+            default:
+                break;
+        }
+        if(reg >= LSM6_OUTX_L_XL && reg < LSM6_OUTX_L_XL + HUST_IMU_SAMPLE_SIZE)
+        {
+            return mock->out[reg - LSM6_OUTX_L_XL];
+        }
+    }
+    else
+    {
+        switch(reg)
+        {
+            case HUST_MPU_FIFO_COUNTH:      return (uint8_t)(mock->fifo_count >> 8);
+            case MPU_FIFO_COUNTL:           return (uint8_t)mock->fifo_count;
+            case HUST_MPU_FIFO_R_W:         return mock_fifo_pop(mock);
+            default:
+                break;
+        }
+        if(reg >= MPU_ACCEL_XOUT_H && reg < MPU_ACCEL_XOUT_H + HUST_IMU_SAMPLE_SIZE)
+        {
+            return mock->out[reg - MPU_ACCEL_XOUT_H];
+        }
+    }
+    return mock->reg[reg & 0x7F];
+}
+
+static void mock_reg_write(hust_imu_mock_t * mock, uint8_t reg, uint8_t value)
+{
+    if(reg >= sizeof(mock->reg))
+    {
+        mock->errors++;
+        return;
+    }
+    if(mock->family == HUST_IMU_LSM6)
+    {
+        if(reg == HUST_LSM6_CTRL3_C && (value & 0x01))
+        {
+            mock_reset_regs(mock);
+            return;
+        }
+        if(reg == HUST_LSM6_FIFO_CTRL5 && (value & 0x07) == 0)
+        {
+            mock->fifo_head = 0;                    // bypass: xoa FIFO
+            mock->fifo_count = 0;
+        }
+    }
+    else
+    {
+        if(reg == HUST_MPU_PWR_MGMT_1 && (value & 0x80))
+        {
+            mock_reset_regs(mock);
+            return;
+        }
+        if(reg == HUST_MPU_USER_CTRL && (value & 0x04))
+        {
+            mock->fifo_head = 0;                    // FIFO_RST, tu xoa
+            mock->fifo_count = 0;
+            value &= (uint8_t)~0x04;
+        }
+    }
+    mock->reg[reg] = value;
+}
+
+// thanh ghi tiep theo sau 1 byte trong cung giao dich
+static uint8_t mock_next_reg(const hust_imu_mock_t * mock, uint8_t reg)
+{
+    if(mock->family == HUST_IMU_LSM6)
+    {
+        // FIFO_DATA_OUT_L/H quay vong, cac thanh ghi khac tang neu IF_INC
+        if(reg == HUST_LSM6_FIFO_DATA_OUT_L)
+        {
+            return LSM6_FIFO_DATA_H;
+        }
+        if(reg == LSM6_FIFO_DATA_H)
+        {
+            return HUST_LSM6_FIFO_DATA_OUT_L;
+        }
+        return (mock->reg[HUST_LSM6_CTRL3_C] & 0x04) ? (uint8_t)(reg + 1) : reg;
+    }
+    return reg == HUST_MPU_FIFO_R_W ? reg : (uint8_t)(reg + 1);
+}
+
+static int mock_xfer(void * p_context, uint8_t addr, const uint8_t * tx, uint16_t tx_len, uint8_t * rx, uint16_t rx_len)
+{
+    hust_imu_mock_t * mock = p_context;
+
+    // START + dia chi/ACK + tung byte/ACK (+ repeated START + dia chi/ACK) + STOP
+    mock->transactions++;
+    mock->bus_bits += 1 + 9 * (1 + tx_len) + (rx_len > 0 ? 1 + 9 * (1 + rx_len) : 0) + 1;
+    if(addr != mock->addr)
+    {
+        return -1;                                  // NACK dia chi
+    }
+    if(tx_len == 0)
+    {
+        mock->errors++;
+        return -1;
+    }
+    uint8_t reg = tx[0];
+    for(uint16_t i = 1; i < tx_len; i++)
+    {
+        mock_reg_write(mock, reg, tx[i]);
+        reg = mock_next_reg(mock, reg);
+    }
+    for(uint16_t i = 0; i < rx_len; i++)
+    {
+        rx[i] = mock_reg_read(mock, reg);
+        reg = mock_next_reg(mock, reg);
+    }
+    return 0;
+}
+
+static void mock_delay_us(void * p_context, uint32_t us)
+{
+    hust_imu_mock_t * mock = p_context;
+    mock->delay_us += us;
+}
+
+void hust_imu_mock_io(hust_imu_mock_t * mock, hust_imu_io_t * io)
+{
+    io->xfer = mock_xfer;
+    io->delay_us = mock_delay_us;
+    io->p_context = mock;
+}
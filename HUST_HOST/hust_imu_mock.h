@@ -0,0 +1,49 @@
+#ifndef HUST_IMU_MOCK_H__
+#define HUST_IMU_MOCK_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "hust_imu.h"
+
+// LSM6DS3/LSM6DSL va MPU-6500/MPU-9250 gia lap sau hust_imu_io_t: file thanh ghi, FIFO accel,
+// chan INT va dem giao dich / bit tren bus I2C, de chay driver hust_imu tren host
+
+#define HUST_IMU_MOCK_FIFO_SIZE     4096        // byte, LSM6DSL (MPU-6500: 512)
+
+typedef struct
+{
+    uint8_t reg[128];
+    hust_imu_family_t family;
+    uint8_t addr;
+    uint8_t fifo[HUST_IMU_MOCK_FIFO_SIZE];
+    uint16_t fifo_size;                 // dung luong FIFO cua chip (byte)
+    uint16_t fifo_head;                 // byte doc tiep theo
+    uint16_t fifo_count;                // byte dang co
+    uint8_t out[HUST_IMU_SAMPLE_SIZE];  // thanh ghi output cua sample moi nhat (thu tu byte cua chip)
+    uint64_t samples;                   // so sample da tao
+    uint32_t fifo_overflows;            // sample cu bi ghi de vi FIFO day
+    int16_t * trace;                    // != NULL: ghi x, y, z cua tung sample vao FIFO, tang dan
+    uint64_t trace_len;                 // so sample da ghi vao trace
+    uint32_t transactions;              // so giao dich I2C (START .. STOP)
+    uint64_t bus_bits;                  // so bit SCL (ca START/STOP, ACK) cua tat ca giao dich
+    uint64_t delay_us;
+    uint32_t errors;                    // truy cap sai (FIFO rong, thanh ghi khong ton tai...)
+} hust_imu_mock_t;
+
+// who_am_i: 0x69/0x6A (LSM6) hoac 0x70/0x71/0x12 (MPU), addr: dia chi I2C 7 bit cua chip
+// tra ve -1 neu who_am_i / addr khong hop le voi ho chip
+int hust_imu_mock_init(hust_imu_mock_t * mock, uint8_t who_am_i, uint8_t addr);
+
+void hust_imu_mock_io(hust_imu_mock_t * mock, hust_imu_io_t * io);
+
+// tao n sample moi (theo ODR), dua vao FIFO neu FIFO dang bat
+void hust_imu_mock_advance(hust_imu_mock_t * mock, uint32_t n);
+
+// muc chan INT1 (LSM6: FIFO >= threshold). MPU: so xung data ready = so sample da tao
+bool hust_imu_mock_int(const hust_imu_mock_t * mock);
+
+// gia tri truc a cua sample thu k ma mock tao ra
+int16_t hust_imu_mock_value(uint64_t k, int a);
+
+#endif // HUST_IMU_MOCK_H__
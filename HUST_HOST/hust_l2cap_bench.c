@@ -0,0 +1,425 @@
+/*
+ * So sanh stream qua notification (1 ble packet / notification, hang doi HVN) va qua kenh L2CAP CoC
+ * (hust_l2cap: nhieu packet / SDU, K-frame theo credit) tren link BLE gia lap. Thoi gian phat tung
+ * PDU + ACK theo mo hinh cua hust_link, connection event keo dai den het interval, app chi nap them
+ * packet / SDU giua 2 connection event. Central tra het credit da dung cuoi moi connection event.
+ *
+ *   hust_l2cap_bench [-q hvn_queue] [-c credits] [-v]
+ *
+ * Kich ban: nguon bao hoa (luon co packet) o 1M / 2M, interval 7.5 .. 50 ms, credit du va credit it;
+ * stream ECG 4 channel 2000 Hz (packet 239 byte, 19 sample) o 2M interval 30 ms.
+ * Kiem tra: hang doi SDU chua nhieu byte hon hang doi HVN va du credit (mac dinh) thi CoC vuot
+ * notification khi hang doi HVN gioi han (interval dai), chi kem toi da COC_MARGIN % khi thoi gian
+ * phat gioi han (interval ngan: K-frame 251 byte lam tron so PDU / connection event kem hon
+ * notification 246 byte); CoC luon it lan goi SoftDevice hon tren moi byte; it credit thi
+ * throughput CoC khong qua CREDITS_LOW K-frame / connection event; stream ECG khong mat packet va do
+ * tre CoC khong qua notification + 1 interval; moi packet nhan lai tu SDU dung thu tu, dung noi dung.
+ * Tra ve 1 neu co loi.
+ *
+ * In ra: throughput (kbps) va so lan goi SoftDevice + su kien TX / s cua tung cach (xu ly theo tung
+ * notification o ca 2 dau), do tre trung binh cua stream ECG.
+ *
+ * Build: cc -O2 -DHUST_HOST_BUILD -I../HUST_BLE hust_l2cap_bench.c ../HUST_BLE/hust_l2cap.c ../HUST_BLE/hust_link.c
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hust_l2cap.h"
+#include "hust_link.h"
+
+#define PACKET_SIZE         239         // ECG 4 channel, 19 sample / packet
+#define PACKET_SAMPLES      19
+#define ECG_RATE            2000
+#define DATA_LENGTH         251
+#define ATT_OVERHEAD        7           // header notification (3) + L2CAP (4)
+#define L2CAP_HEADER        4
+#define EVENT_MARGIN_US     600
+#define SOURCE_PACKETS      256         // packet cho gui trong app, day thi mat packet
+#define RUN_MS              20000
+#define CREDITS_LOW         4
+#define COC_MARGIN          10          // % throughput CoC duoc kem notification khi thoi gian phat gioi han
+
+static int failures = 0;
+static int verbose = 0;
+static int hvn_queue = 7;               // = hang doi HVN cau hinh cho 400 kbps (hust_link_conn_cfg)
+static int credits_max = 32;
+
+#define CHECK(cond, ...) do { if(!(cond)) { failures++; fprintf(stderr, "FAIL: " __VA_ARGS__); fprintf(stderr, "\n"); } } while(0)
+
+typedef struct
+{
+    uint32_t index;
+    uint64_t t_created;                 // us
+} packet_t;
+
+// packet cho gui: nguon ghi, transport doc
+typedef struct
+{
+    packet_t packet[SOURCE_PACKETS];
+    uint32_t head;
+    uint32_t tail;
+    uint32_t next_index;
+    uint32_t dropped;
+    uint64_t period_us;                 // 0 = bao hoa
+    uint64_t t_next;
+} source_t;
+
+typedef struct
+{
+    uint64_t bytes;                     // byte packet nhan duoc
+    uint32_t packets;
+    uint32_t next_index;                // packet tiep theo phai nhan
+    uint32_t errors;                    // sai thu tu / noi dung
+    uint64_t latency_us;                // tong do tre tao -> nhan
+    uint32_t calls;                     // lan goi SoftDevice + su kien TX cua app
+} sink_t;
+
+typedef struct
+{
+    uint8_t phy;
+    uint16_t interval;                  // 1.25 ms
+    int credits;                        // credit central cap moi connection event
+    uint64_t period_us;
+} scenario_t;
+
+typedef struct
+{
+    double notify_kbps;
+    double coc_kbps;
+    double notify_calls;
+    double coc_calls;
+    double notify_latency_ms;
+    double coc_latency_ms;
+    uint32_t notify_dropped;
+    uint32_t coc_dropped;
+} result_t;
+
+static void packet_fill(uint8_t * data, uint32_t index)
+{
+    for(int i = 0; i < PACKET_SIZE; i++)
+    {
+        data[i] = (uint8_t)(index * 31 + i);
+    }
+}
+
+static void source_run(source_t * source, uint64_t now)
+{
+    if(source->period_us == 0)
+    {
+        // bao hoa: luon du packet
+        while(source->head - source->tail < SOURCE_PACKETS)
+        {
+            packet_t * p = &source->packet[source->head++ % SOURCE_PACKETS];
+            p->index = source->next_index++;
+            p->t_created = now;
+        }
+        return;
+    }
+    while(source->t_next <= now)
+    {
+        if(source->head - source->tail >= SOURCE_PACKETS)
+        {
+            source->dropped++;
+            source->next_index++;       // bo qua packet, sink thay lo hong
+        }
+        else
+        {
+            packet_t * p = &source->packet[source->head++ % SOURCE_PACKETS];
+            p->index = source->next_index++;
+            p->t_created = source->t_next;
+        }
+        source->t_next += source->period_us;
+    }
+}
+
+static void sink_receive(sink_t * sink, const uint8_t * data, int length, uint32_t index, uint64_t t_created, uint64_t now)
+{
+    uint8_t expected[PACKET_SIZE];
+    packet_fill(expected, index);
+    if(length != PACKET_SIZE || memcmp(data, expected, PACKET_SIZE) != 0 || index < sink->next_index)
+    {
+        sink->errors++;
+    }
+    sink->next_index = index + 1;
+    sink->packets++;
+    sink->bytes += length;
+    sink->latency_us += now - t_created;
+}
+
+// thoi gian phat ll byte chia thanh PDU DATA_LENGTH byte
+static uint32_t air_us(uint8_t phy, uint32_t ll)
+{
+    uint32_t us = 0;
+    while(ll > DATA_LENGTH)
+    {
+        us += hust_link_pdu_us(phy, DATA_LENGTH);
+        ll -= DATA_LENGTH;
+    }
+    return us + hust_link_pdu_us(phy, ll);
+}
+
+static void run_notify(const scenario_t * sc, source_t * source, sink_t * sink)
+{
+    packet_t queue[32];
+    int queued = 0;
+    uint64_t interval_us = sc->interval * 1250u;
+    uint8_t data[PACKET_SIZE];
+
+    for(uint64_t t = 0; t < (uint64_t)RUN_MS * 1000; t += interval_us)
+    {
+        source_run(source, t);
+        // app nap hang doi HVN giua 2 connection event
+        while(queued < hvn_queue && source->tail != source->head)
+        {
+            queue[queued++] = source->packet[source->tail++ % SOURCE_PACKETS];
+            sink->calls++;              // sd_ble_gatts_hvx
+        }
+        uint64_t elapsed = 0;
+        int sent = 0;
+        while(sent < queued)
+        {
+            uint32_t us = air_us(sc->phy, PACKET_SIZE + ATT_OVERHEAD);
+            if(elapsed + us > interval_us - EVENT_MARGIN_US)
+            {
+                break;
+            }
+            elapsed += us;
+            packet_fill(data, queue[sent].index);
+            sink_receive(sink, data, PACKET_SIZE, queue[sent].index, queue[sent].t_created, t + elapsed);
+            sent++;
+        }
+        if(sent > 0)
+        {
+            sink->calls++;              // BLE_GATTS_EVT_HVN_TX_COMPLETE
+            memmove(queue, queue + sent, (queued - sent) * sizeof(packet_t));
+            queued -= sent;
+        }
+    }
+}
+
+static void run_coc(const scenario_t * sc, source_t * source, sink_t * sink)
+{
+    static hust_l2cap_tx_t tx;
+    // packet trong tung SDU de tinh do tre (SDU chi chua du lieu, khong chua thoi diem tao)
+    static packet_t sdu_packets[HUST_L2CAP_SDU_QUEUE][HUST_L2CAP_SDU_MAX / PACKET_SIZE + 1];
+    int sdu_count[HUST_L2CAP_SDU_QUEUE] = {0};
+    const uint8_t * sdu_data[HUST_L2CAP_SDU_QUEUE];
+    uint16_t sdu_length[HUST_L2CAP_SDU_QUEUE];
+    uint16_t sent_bytes = 0;            // byte SDU dang phat da len link (ca do dai SDU)
+    uint64_t interval_us = sc->interval * 1250u;
+    int credits = sc->credits;
+    uint8_t data[PACKET_SIZE];
+
+    hust_l2cap_tx_init(&tx, HUST_L2CAP_SDU_MAX);
+    for(uint64_t t = 0; t < (uint64_t)RUN_MS * 1000; t += interval_us)
+    {
+        source_run(source, t);
+        // app gom packet vao SDU va giao SDU giua 2 connection event
+        while(source->tail != source->head)
+        {
+            packet_t * p = &source->packet[source->tail % SOURCE_PACKETS];
+            packet_fill(data, p->index);
+            if(hust_l2cap_tx_append(&tx, data, PACKET_SIZE) != 0)
+            {
+                break;
+            }
+            uint32_t fill = tx.closed % HUST_L2CAP_SDU_QUEUE;
+            if(tx.length[fill] == HUST_L2CAP_LENGTH_SIZE + PACKET_SIZE)
+            {
+                sdu_count[fill] = 0;    // packet dau cua SDU moi
+            }
+            sdu_packets[fill][sdu_count[fill]++] = *p;
+            source->tail++;
+        }
+        const uint8_t * sdu;
+        uint16_t length;
+        while(hust_l2cap_tx_inflight(&tx) < HUST_L2CAP_SDU_QUEUE - 1 && (sdu = hust_l2cap_tx_next(&tx, &length)) != NULL)
+        {
+            uint32_t slot = tx.submitted % HUST_L2CAP_SDU_QUEUE;
+            sdu_data[slot] = sdu;
+            sdu_length[slot] = length;
+            hust_l2cap_tx_submitted(&tx);
+            sink->calls++;              // sd_ble_l2cap_ch_tx
+        }
+
+        // connection event: K-frame cua SDU cu nhat, moi K-frame 1 credit
+        uint64_t elapsed = 0;
+        int used = 0;
+        while(hust_l2cap_tx_inflight(&tx) > 0 && credits > 0)
+        {
+            uint32_t slot = tx.completed % HUST_L2CAP_SDU_QUEUE;
+            uint16_t total = sdu_length[slot] + 2;
+            uint16_t kframe = total - sent_bytes < HUST_L2CAP_MPS ? total - sent_bytes : HUST_L2CAP_MPS;
+            uint32_t us = air_us(sc->phy, kframe + L2CAP_HEADER);
+            if(elapsed + us > interval_us - EVENT_MARGIN_US)
+            {
+                break;
+            }
+            elapsed += us;
+            credits--;
+            used++;
+            sent_bytes += kframe;
+            if(sent_bytes < total)
+            {
+                continue;
+            }
+            // SDU nhan du: tach packet
+            uint16_t offset = 0;
+            const uint8_t * packet;
+            int n;
+            int k = 0;
+            while((n = hust_l2cap_sdu_next(sdu_data[slot], sdu_length[slot], &offset, &packet)) > 0)
+            {
+                if(k >= sdu_count[slot])
+                {
+                    sink->errors++;
+                    break;
+                }
+                sink_receive(sink, packet, n, sdu_packets[slot][k].index, sdu_packets[slot][k].t_created, t + elapsed);
+                k++;
+            }
+            if(n < 0 || k != sdu_count[slot])
+            {
+                sink->errors++;
+            }
+            sent_bytes = 0;
+            hust_l2cap_tx_completed(&tx);
+            sink->calls++;              // BLE_L2CAP_EVT_CH_TX
+        }
+        credits += used;                // central tra credit cuoi connection event
+        if(credits > sc->credits)
+        {
+            credits = sc->credits;
+        }
+    }
+}
+
+static result_t run(const scenario_t * sc)
+{
+    result_t r;
+    source_t source;
+    sink_t sink;
+    double seconds = RUN_MS / 1000.0;
+
+    memset(&source, 0, sizeof(source));
+    memset(&sink, 0, sizeof(sink));
+    source.period_us = sc->period_us;
+    run_notify(sc, &source, &sink);
+    CHECK(sink.errors == 0, "notify %s %.2f ms: %u packet errors", hust_link_phy_name(sc->phy), sc->interval * 1.25, sink.errors);
+    r.notify_kbps = sink.bytes * 8 / seconds / 1000;
+    r.notify_calls = sink.calls / seconds;
+    r.notify_latency_ms = sink.packets ? sink.latency_us / 1000.0 / sink.packets : 0;
+    r.notify_dropped = source.dropped;
+
+    memset(&source, 0, sizeof(source));
+    memset(&sink, 0, sizeof(sink));
+    source.period_us = sc->period_us;
+    run_coc(sc, &source, &sink);
+    CHECK(sink.errors == 0, "coc %s %.2f ms: %u packet errors", hust_link_phy_name(sc->phy), sc->interval * 1.25, sink.errors);
+    r.coc_kbps = sink.bytes * 8 / seconds / 1000;
+    r.coc_calls = sink.calls / seconds;
+    r.coc_latency_ms = sink.packets ? sink.latency_us / 1000.0 / sink.packets : 0;
+    r.coc_dropped = source.dropped;
+    return r;
+}
+
+static void print_row(const scenario_t * sc, const result_t * r)
+{
+    printf("%-5s %7.2f %7d %10.0f %10.0f %6.2f %10.0f %10.0f\n",
+           hust_link_phy_name(sc->phy), sc->interval * 1.25, sc->credits,
+           r->notify_kbps, r->coc_kbps, r->notify_kbps > 0 ? r->coc_kbps / r->notify_kbps : 0,
+           r->notify_calls, r->coc_calls);
+}
+
+int main(int argc, char ** argv)
+{
+    static const uint16_t intervals[] = {6, 12, 24, 40};   // 7.5, 15, 30, 50 ms
+    static const uint8_t phys[] = {HUST_LINK_PHY_1M, HUST_LINK_PHY_2M};
+
+    for(int i = 1; i < argc; i++)
+    {
+        if(strcmp(argv[i], "-q") == 0 && i + 1 < argc)
+        {
+            hvn_queue = atoi(argv[++i]);
+        }
+        else if(strcmp(argv[i], "-c") == 0 && i + 1 < argc)
+        {
+            credits_max = atoi(argv[++i]);
+        }
+        else if(strcmp(argv[i], "-v") == 0)
+        {
+            verbose = 1;
+        }
+        else
+        {
+            fprintf(stderr, "usage: hust_l2cap_bench [-q hvn_queue] [-c credits] [-v]\n");
+            return 1;
+        }
+    }
+    if(hvn_queue < 1 || hvn_queue > 32 || credits_max < 1)
+    {
+        fprintf(stderr, "hvn_queue 1..32, credits >= 1\n");
+        return 1;
+    }
+
+    // so sanh throughput chi co nghia khi CoC khong bi gioi han boi buffer SDU / credit truoc notification
+    bool coc_deeper = hvn_queue * PACKET_SIZE < (HUST_L2CAP_SDU_QUEUE - 1) * HUST_L2CAP_SDU_MAX
+                      && credits_max >= (HUST_L2CAP_SDU_QUEUE - 1) * hust_l2cap_kframes(HUST_L2CAP_SDU_MAX, HUST_L2CAP_MPS);
+
+    printf("saturated source, packet %u byte, hvn queue %d, SDU %u byte x %u, MPS %u\n",
+           PACKET_SIZE, hvn_queue, HUST_L2CAP_SDU_MAX, HUST_L2CAP_SDU_QUEUE - 1, HUST_L2CAP_MPS);
+    printf("%-5s %7s %7s %10s %10s %6s %10s %10s\n", "phy", "ci_ms", "credits", "notify", "coc", "ratio", "notify/s", "coc/s");
+    for(unsigned p = 0; p < sizeof(phys); p++)
+    {
+        for(unsigned i = 0; i < sizeof(intervals) / sizeof(intervals[0]); i++)
+        {
+            scenario_t sc = {phys[p], intervals[i], credits_max, 0};
+            result_t r = run(&sc);
+            print_row(&sc, &r);
+            // notification bi gioi han boi hang doi HVN (khong phai thoi gian phat): CoC phai nhanh hon
+            uint32_t event_us = sc.interval * 1250u - EVENT_MARGIN_US;
+            bool queue_bound = (uint32_t)hvn_queue * air_us(sc.phy, PACKET_SIZE + ATT_OVERHEAD) < event_us;
+            if(queue_bound && coc_deeper)
+            {
+                CHECK(r.coc_kbps > r.notify_kbps, "%s %.2f ms: coc %.0f kbps <= notify %.0f kbps (HVN queue bound)",
+                      hust_link_phy_name(sc.phy), sc.interval * 1.25, r.coc_kbps, r.notify_kbps);
+            }
+            CHECK(!coc_deeper || r.coc_kbps * 100 >= r.notify_kbps * (100 - COC_MARGIN), "%s %.2f ms: coc %.0f kbps, notify %.0f kbps",
+                  hust_link_phy_name(sc.phy), sc.interval * 1.25, r.coc_kbps, r.notify_kbps);
+            CHECK(r.coc_calls * r.notify_kbps < r.notify_calls * r.coc_kbps, "%s %.2f ms: coc %.0f calls/s for %.0f kbps, notify %.0f for %.0f",
+                  hust_link_phy_name(sc.phy), sc.interval * 1.25, r.coc_calls, r.coc_kbps, r.notify_calls, r.notify_kbps);
+
+            if(credits_max <= CREDITS_LOW)
+            {
+                continue;
+            }
+            scenario_t low = sc;
+            low.credits = CREDITS_LOW;
+            result_t r_low = run(&low);
+            if(verbose || p == 1)
+            {
+                print_row(&low, &r_low);
+            }
+            CHECK(r_low.coc_kbps <= r.coc_kbps, "%s %.2f ms: %d credits faster than %d",
+                  hust_link_phy_name(sc.phy), sc.interval * 1.25, CREDITS_LOW, credits_max);
+            // it credit: toi da CREDITS_LOW K-frame / connection event
+            double cap = CREDITS_LOW * HUST_L2CAP_MPS * 8 / (sc.interval * 1.25);
+            CHECK(r_low.coc_kbps <= cap, "%s %.2f ms: %.0f kbps above the credit limit %.0f",
+                  hust_link_phy_name(sc.phy), sc.interval * 1.25, r_low.coc_kbps, cap);
+        }
+    }
+
+    scenario_t ecg = {HUST_LINK_PHY_2M, 24, credits_max, 1000000ull * PACKET_SAMPLES / ECG_RATE};
+    result_t r = run(&ecg);
+    printf("ECG %u Hz, 2M 30 ms: notify %.0f kbps %.1f ms %u dropped, coc %.0f kbps %.1f ms %u dropped, calls/s %.0f / %.0f\n",
+           ECG_RATE, r.notify_kbps, r.notify_latency_ms, r.notify_dropped, r.coc_kbps, r.coc_latency_ms, r.coc_dropped,
+           r.notify_calls, r.coc_calls);
+    CHECK(r.notify_dropped == 0 && r.coc_dropped == 0, "ECG stream dropped packets (notify %u, coc %u)",
+          r.notify_dropped, r.coc_dropped);
+    CHECK(r.coc_latency_ms <= r.notify_latency_ms + ecg.interval * 1.25, "ECG coc latency %.1f ms, notify %.1f ms",
+          r.coc_latency_ms, r.notify_latency_ms);
+
+    printf("%s\n", failures ? "FAIL" : "PASS");
+    return failures ? 1 : 0;
+}
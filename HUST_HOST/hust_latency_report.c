@@ -0,0 +1,295 @@
+/*
+ * Bao cao latency tung giai doan tu log notification (.hcap) cua firmware build voi
+ * HUST_LATENCY_TRAILER_ENABLED=1.
+ *
+ *   hust_latency_report <log.hcap> [-p packets.tsv]
+ *
+ * Giai doan (us):
+ *   ring        lay sample dau tien -> lay sample cuoi cung cua packet
+ *   pack        lay sample cuoi cung -> giao cho SoftDevice (cho trong ring/buffer DMA + dong goi)
+ *   hvn_queue   giao cho SoftDevice -> connection event mang packet bat dau (radio notification)
+ *   ota         connection event bat dau -> BLE_GATTS_EVT_HVN_TX_COMPLETE
+ *   host_rx     HVN TX complete -> host nhan, tinh tu gia tri nho nhat (clock host/thiet bi khong dong bo)
+ *   host_decode convert_ble_packet_to_data tren host
+ *   end_to_end  tong cac giai doan tren cho sample dau tien cua packet
+ *
+ * hvn_queue/ota cua packet n den tu trailer cua packet gui sau n, packet cuoi log khong co.
+ *
+ * Build: cc -DHUST_HOST_BUILD -DHUST_LATENCY_TRAILER_ENABLED=1 -I../HUST_BLE hust_latency_report.c hust_capture.c ../HUST_BLE/hust_ble.c ../HUST_BLE/hust_latency.c
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "hust_ble.h"
+#include "hust_latency.h"
+#include "hust_capture.h"
+
+#define TICK_US(t)  ((double)(t) * 1e6 / HUST_LATENCY_TICK_HZ)
+
+typedef enum
+{
+    STAGE_RING = 0,
+    STAGE_PACK,
+    STAGE_HVN_QUEUE,
+    STAGE_OTA,
+    STAGE_HOST_RX,
+    STAGE_HOST_DECODE,
+    STAGE_END_TO_END,
+    STAGE_COUNT
+} stage_t;
+
+static const char * stage_name[STAGE_COUNT] =
+{
+    "ring", "pack", "hvn_queue", "ota", "host_rx", "host_decode", "end_to_end"
+};
+
+typedef struct
+{
+    uint8_t count;
+    uint64_t t_first;               // tick, da unwrap
+    hust_latency_trailer_t trailer;
+    uint64_t host_rx_us;
+    double decode_us;
+    bool have_txc;                  // da nhan prev_* tu packet sau
+    uint16_t d_radio;
+    uint16_t d_txc;
+} packet_info_t;
+
+static void usage(void)
+{
+    fprintf(stderr, "usage: hust_latency_report <log.hcap> [-p packets.tsv]\n");
+}
+
+static double time_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static int cmp_double(const void * a, const void * b)
+{
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static double percentile(const double * sorted, uint64_t n, double p)
+{
+    uint64_t i = (uint64_t)(p * (double)(n - 1) + 0.5);
+    return sorted[i];
+}
+
+// gia tri tick tuyet doi (tinh tu t_first) cua thoi diem HVN TX complete
+static double txc_us(const packet_info_t * pkt)
+{
+    return TICK_US(pkt->t_first + pkt->trailer.d_send + pkt->d_txc);
+}
+
+int main(int argc, char ** argv)
+{
+    hust_capture_t cap;
+    hust_capture_rec_t rec;
+    const char * tsv_path = NULL;
+
+    if(argc < 2)
+    {
+        usage();
+        return 1;
+    }
+    for(int i = 2; i < argc; i++)
+    {
+        if(strcmp(argv[i], "-p") == 0 && i + 1 < argc)
+        {
+            tsv_path = argv[++i];
+        }
+        else
+        {
+            usage();
+            return 1;
+        }
+    }
+    if(hust_capture_open(&cap, argv[1]) != 0)
+    {
+        perror(argv[1]);
+        return 1;
+    }
+
+    packet_info_t * pkt = calloc(cap.count > 0 ? cap.count : 1, sizeof(packet_info_t));
+    int64_t last_by_count[256];     // packet gan nhat co count_packet tuong ung
+    uint64_t n_pkt = 0;
+    uint64_t no_trailer = 0;
+    uint64_t tick_high = 0;
+    uint32_t last_tick = 0;
+
+    for(int i = 0; i < 256; i++)
+    {
+        last_by_count[i] = -1;
+    }
+    if(pkt == NULL)
+    {
+        hust_capture_close(&cap);
+        return 1;
+    }
+
+    while(hust_capture_read(&cap, &rec) == 0)
+    {
+        ecg_data_t ecg_data[ECG_SAMPLE_MAX];
+        imu_data_t imu_data[IMU_SAMPLE_MAX];
+        ble_packet_t ble_packet_m;
+        packet_info_t * p = &pkt[n_pkt];
+
+        ble_packet_m.ecg_data = ecg_data;
+        ble_packet_m.imu_data = imu_data;
+
+        double t0 = time_ns();
+        int err = convert_ble_packet_to_data(rec.data, rec.length, &ble_packet_m);
+        p->decode_us = (time_ns() - t0) / 1e3;
+        if(err != 0 || ble_packet_m.sensor_type == CMD_SENSOR_TYPE)
+        {
+            continue;               // tra loi lenh khong co trailer
+        }
+        int offset = BLE_PACKET_HEADER_SIZE + ble_packet_m.data_size;
+        if(hust_latency_trailer_decode(rec.data + offset, rec.length - offset, &p->trailer) != 0)
+        {
+            no_trailer++;
+            continue;
+        }
+
+        // unwrap tick RTC 24 bit
+        if(n_pkt > 0 && p->trailer.t_first < last_tick)
+        {
+            tick_high += HUST_LATENCY_TICK_MASK + 1;
+        }
+        last_tick = p->trailer.t_first;
+        p->t_first = tick_high + p->trailer.t_first;
+        p->count = ble_packet_m.count_packet;
+        p->host_rx_us = rec.t_us;
+
+        if(p->trailer.prev_d_txc != HUST_LATENCY_INVALID && last_by_count[p->trailer.prev_count] >= 0)
+        {
+            packet_info_t * prev = &pkt[last_by_count[p->trailer.prev_count]];
+            prev->have_txc = true;
+            prev->d_radio = p->trailer.prev_d_radio;
+            prev->d_txc = p->trailer.prev_d_txc;
+        }
+        last_by_count[p->count] = (int64_t)n_pkt;
+        n_pkt++;
+    }
+    hust_capture_close(&cap);
+
+    // lech clock host - thiet bi: lay packet den host nhanh nhat lam moc 0
+    bool have_offset = false;
+    double offset_us = 0;
+    for(uint64_t i = 0; i < n_pkt; i++)
+    {
+        if(pkt[i].have_txc)
+        {
+            double d = (double)pkt[i].host_rx_us - txc_us(&pkt[i]);
+            if(!have_offset || d < offset_us)
+            {
+                offset_us = d;
+                have_offset = true;
+            }
+        }
+    }
+
+    double * value[STAGE_COUNT];
+    uint64_t n_value[STAGE_COUNT] = {0};
+    for(int s = 0; s < STAGE_COUNT; s++)
+    {
+        value[s] = malloc((n_pkt > 0 ? n_pkt : 1) * sizeof(double));
+    }
+
+    FILE * tsv = NULL;
+    if(tsv_path != NULL)
+    {
+        tsv = fopen(tsv_path, "w");
+        if(tsv == NULL)
+        {
+            perror(tsv_path);
+        }
+        else
+        {
+            fprintf(tsv, "count");
+            for(int s = 0; s < STAGE_COUNT; s++)
+            {
+                fprintf(tsv, "\t%s", stage_name[s]);
+            }
+            fprintf(tsv, "\n");
+        }
+    }
+
+    for(uint64_t i = 0; i < n_pkt; i++)
+    {
+        const packet_info_t * p = &pkt[i];
+        double v[STAGE_COUNT];
+
+        v[STAGE_RING] = TICK_US(p->trailer.d_last);
+        v[STAGE_PACK] = TICK_US(p->trailer.d_send - p->trailer.d_last);
+        v[STAGE_HOST_DECODE] = p->decode_us;
+        if(p->have_txc)
+        {
+            v[STAGE_HVN_QUEUE] = TICK_US(p->d_radio);
+            v[STAGE_OTA] = TICK_US(p->d_txc - p->d_radio);
+            v[STAGE_HOST_RX] = (double)p->host_rx_us - txc_us(p) - offset_us;
+            v[STAGE_END_TO_END] = (double)p->host_rx_us + p->decode_us - offset_us - TICK_US(p->t_first);
+        }
+        if(tsv != NULL)
+        {
+            fprintf(tsv, "%u", p->count);
+        }
+        for(int s = 0; s < STAGE_COUNT; s++)
+        {
+            bool valid = p->have_txc || (s != STAGE_HVN_QUEUE && s != STAGE_OTA && s != STAGE_HOST_RX && s != STAGE_END_TO_END);
+            if(valid)
+            {
+                value[s][n_value[s]++] = v[s];
+            }
+            if(tsv != NULL)
+            {
+                if(valid)
+                {
+                    fprintf(tsv, "\t%.1f", v[s]);
+                }
+                else
+                {
+                    fprintf(tsv, "\t");
+                }
+            }
+        }
+        if(tsv != NULL)
+        {
+            fprintf(tsv, "\n");
+        }
+    }
+    if(tsv != NULL)
+    {
+        fclose(tsv);
+    }
+
+    printf("packets      %llu (no trailer %llu)\n", (unsigned long long)n_pkt, (unsigned long long)no_trailer);
+    printf("%-12s %8s %10s %10s %10s\n", "stage_us", "count", "p50", "p99", "max");
+    for(int s = 0; s < STAGE_COUNT; s++)
+    {
+        if(n_value[s] == 0)
+        {
+            printf("%-12s %8d %10s %10s %10s\n", stage_name[s], 0, "-", "-", "-");
+            free(value[s]);
+            continue;
+        }
+        qsort(value[s], n_value[s], sizeof(double), cmp_double);
+        printf("%-12s %8llu %10.1f %10.1f %10.1f\n", stage_name[s], (unsigned long long)n_value[s],
+               percentile(value[s], n_value[s], 0.50), percentile(value[s], n_value[s], 0.99),
+               value[s][n_value[s] - 1]);
+        free(value[s]);
+    }
+    if(have_offset)
+    {
+        printf("host_rx/end_to_end relative to fastest delivery (offset %.0f us)\n", offset_us);
+    }
+    free(pkt);
+    return 0;
+}
@@ -0,0 +1,311 @@
+/*
+ * Kiem tra quan ly ket noi (hust_link) voi link BLE gia lap: central chap nhan yeu cau doi PHY sau
+ * 1 s, doi interval sau 2 s (hoac tu choi 2M), ty le loi theo RSSI va PHY, stream ECG doi bitrate
+ * giua chung. Dung luong link gia lap = hust_link_capacity x (1 - loi), packet khong gui kip nam
+ * trong buffer, buffer day thi mat sample.
+ *
+ *   hust_link_bench [-q hvn_queue] [-v]
+ *
+ * Kich ban (moi pha 60 s): ECG 250 Hz, 2000 Hz, 2000 Hz RSSI -84 dBm, 250 Hz RSSI -60 dBm.
+ * Kiem tra: len 2M ngay sau khi ket noi; bitrate thap thi interval dai ra (radio bat it hon) va khong
+ * mat sample; bitrate cao thi interval ngan lai, chi mat sample trong vai giay chuyen tiep; RSSI
+ * xuong duoi nguong thi ha 1M trong 5 s, RSSI tot lai thi len lai 2M; central tu choi 2M thi o 1M
+ * va chi thu lai moi HUST_LINK_PHY_RETRY_MS; nhieu chi tren 2M (khong co RSSI) thi ha 1M theo ty le
+ * loi uoc luong; cau hinh connection (hang doi HVN, event length) tinh tu throughput muc tieu la nho
+ * nhat ma dung luong van du, bot dan khi thieu RAM ve hang doi 1.
+ * Tra ve 1 neu co loi.
+ *
+ * In ra: throughput dat duoc va thoi gian o tung cau hinh (PHY, interval), hang doi HVN / event
+ * length theo throughput muc tieu.
+ *
+ * Build: cc -O2 -DHUST_HOST_BUILD -I../HUST_BLE hust_link_bench.c ../HUST_BLE/hust_link.c
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hust_link.h"
+
+#define STEP_MS             100
+#define TICK_MS             1000
+#define PACKET_SIZE         239         // ECG 4 channel, 19 sample / packet
+#define PACKET_SAMPLES      19
+#define BUFFER_BYTES        8192        // ring sample + packet cho gui
+#define PHASE_MS            60000
+
+static int failures = 0;
+static int verbose = 0;
+
+#define CHECK(cond, ...) do { if(!(cond)) { failures++; fprintf(stderr, "FAIL: " __VA_ARGS__); fprintf(stderr, "\n"); } } while(0)
+
+typedef struct
+{
+    hust_link_t link;
+    hust_link_sample_t counters;
+    bool refuse_2m;
+    bool noise_2m;                      // nhieu chi o 2M, khong bao RSSI
+    int rssi;
+    uint32_t rate;                      // sample / s
+    uint64_t now_ms;
+    uint64_t phy_at, interval_at;       // luc central tra loi yeu cau, 0 = khong co
+    uint32_t backlog;                   // byte cho gui
+    double built_frac;
+    uint32_t phy_requests;
+    uint32_t dropped_ms;                // tong thoi gian co mat sample
+    uint64_t last_drop_ms;
+} sim_t;
+
+// ty le loi (%) theo do du RSSI so voi do nhay cua PHY
+static int sim_per(const sim_t * s, uint8_t phy)
+{
+    if(s->noise_2m)
+    {
+        return phy == HUST_LINK_PHY_2M ? 60 : 5;
+    }
+    int sensitivity = phy == HUST_LINK_PHY_2M ? -89 : -93;
+    int margin = s->rssi - sensitivity;
+    return margin >= 10 ? 0 : margin <= 0 ? 90 : (10 - margin) * 9;
+}
+
+static void sim_apply(sim_t * s, uint8_t change)
+{
+    if(change & HUST_LINK_CHANGE_PHY)
+    {
+        s->phy_at = s->now_ms + 1000;
+        s->phy_requests++;
+    }
+    if(change & HUST_LINK_CHANGE_INTERVAL)
+    {
+        s->interval_at = s->now_ms + 2000;
+    }
+}
+
+static void sim_log(const hust_link_stat_t * stat, uint64_t now_ms)
+{
+    if(stat != NULL && verbose)
+    {
+        printf("%7.1f s  %-5s %6.2f ms: %7u bps trong %u s\n", now_ms / 1000.0, hust_link_phy_name(stat->config.phy),
+               stat->config.interval * 1.25, hust_link_stat_bps(stat), stat->ms / 1000);
+    }
+}
+
+static void sim_init(sim_t * s, uint8_t queue)
+{
+    memset(s, 0, sizeof(sim_t));
+    hust_link_init(&s->link, 6, 80, queue, false);     // 7.5 .. 100 ms, S132 khong co coded
+    s->rssi = -60;
+    s->rate = 250;
+    sim_apply(s, hust_link_connected(&s->link, 24));   // central chon 30 ms
+    hust_link_payload_set(&s->link, 244, 251);
+}
+
+static void sim_run(sim_t * s, uint32_t ms)
+{
+    for(uint32_t t = 0; t < ms; t += STEP_MS)
+    {
+        s->now_ms += STEP_MS;
+        hust_link_t * link = &s->link;
+        if(s->phy_at != 0 && s->now_ms >= s->phy_at)
+        {
+            s->phy_at = 0;
+            sim_log(hust_link_phy_updated(link, s->refuse_2m ? HUST_LINK_PHY_1M : link->target.phy), s->now_ms);
+        }
+        if(s->interval_at != 0 && s->now_ms >= s->interval_at)
+        {
+            s->interval_at = 0;
+            sim_log(hust_link_interval_updated(link, link->target.interval), s->now_ms);
+        }
+
+        // stream: packet dong goi theo rate, gui toi da dung luong link x (1 - loi)
+        s->built_frac += (double)s->rate * STEP_MS / 1000 / PACKET_SAMPLES;
+        uint32_t built = (uint32_t)s->built_frac;
+        s->built_frac -= built;
+        s->counters.packets_built += built;
+        s->backlog += built * PACKET_SIZE;
+        uint64_t capacity = (uint64_t)hust_link_capacity(link, link->current) * (100 - sim_per(s, link->current.phy)) / 100;
+        uint32_t sent = (uint32_t)(capacity * STEP_MS / 8000 / PACKET_SIZE);
+        if(sent * PACKET_SIZE > s->backlog)
+        {
+            sent = s->backlog / PACKET_SIZE;
+        }
+        s->backlog -= sent * PACKET_SIZE;
+        s->counters.packets_sent += sent;
+        s->counters.bytes_sent += sent * PACKET_SIZE;
+        if(s->backlog > link->queue * PACKET_SIZE)
+        {
+            s->counters.nus_resources++;
+        }
+        if(s->backlog > BUFFER_BYTES)
+        {
+            s->counters.samples_dropped += (s->backlog - BUFFER_BYTES) / PACKET_SIZE * PACKET_SAMPLES;
+            s->backlog = BUFFER_BYTES;
+            s->dropped_ms += STEP_MS;
+            s->last_drop_ms = s->now_ms;
+        }
+
+        if(!s->noise_2m)
+        {
+            hust_link_rssi(link, (int8_t)s->rssi);
+        }
+        if(s->now_ms % TICK_MS == 0)
+        {
+            sim_apply(s, hust_link_tick(link, TICK_MS, &s->counters));
+        }
+    }
+}
+
+static void print_stats(const hust_link_t * link)
+{
+    printf("%-5s %9s %8s %9s %10s\n", "phy", "interval", "time_s", "bps", "capacity");
+    for(int i = 0; i < HUST_LINK_STATS; i++)
+    {
+        const hust_link_stat_t * stat = &link->stats[i];
+        if(stat->ms > 0)
+        {
+            printf("%-5s %6.2f ms %8u %9u %10u\n", hust_link_phy_name(stat->config.phy), stat->config.interval * 1.25,
+                   stat->ms / 1000, hust_link_stat_bps(stat), hust_link_capacity(link, stat->config));
+        }
+    }
+}
+
+static void check_scenario(uint8_t queue)
+{
+    sim_t s;
+    sim_init(&s, queue);
+
+    // pha 1: bitrate thap
+    sim_run(&s, 5000);
+    CHECK(s.link.current.phy == HUST_LINK_PHY_2M, "pha 1: PHY %s sau 5 s", hust_link_phy_name(s.link.current.phy));
+    sim_run(&s, PHASE_MS - 5000);
+    CHECK(s.link.current.interval > 24, "pha 1: interval %.2f ms khong dai ra", s.link.current.interval * 1.25);
+    CHECK(s.dropped_ms == 0, "pha 1: mat sample %u ms", s.dropped_ms);
+    uint16_t low_interval = s.link.current.interval;
+
+    // pha 2: bitrate cao
+    s.rate = 2000;
+    uint32_t dropped_before = s.dropped_ms;
+    sim_run(&s, PHASE_MS);
+    CHECK(s.link.current.interval < low_interval, "pha 2: interval %.2f ms khong ngan lai", s.link.current.interval * 1.25);
+    CHECK(s.dropped_ms - dropped_before <= 5000, "pha 2: mat sample %u ms", s.dropped_ms - dropped_before);
+    CHECK(s.last_drop_ms < s.now_ms - PHASE_MS / 2, "pha 2: van mat sample luc %.1f s", s.last_drop_ms / 1000.0);
+
+    // pha 3: RSSI yeu
+    s.rssi = -84;
+    sim_run(&s, 5000);
+    CHECK(s.link.current.phy == HUST_LINK_PHY_1M, "pha 3: PHY %s sau 5 s RSSI -84", hust_link_phy_name(s.link.current.phy));
+    sim_run(&s, PHASE_MS - 5000);
+
+    // pha 4: RSSI tot lai, bitrate thap
+    s.rssi = -60;
+    s.rate = 250;
+    sim_run(&s, HUST_LINK_PHY_RETRY_MS + 5000);
+    CHECK(s.link.current.phy == HUST_LINK_PHY_2M, "pha 4: PHY %s sau khi RSSI tot lai", hust_link_phy_name(s.link.current.phy));
+    sim_run(&s, PHASE_MS - HUST_LINK_PHY_RETRY_MS - 5000);
+    CHECK(s.link.current.interval > 24, "pha 4: interval %.2f ms", s.link.current.interval * 1.25);
+
+    printf("hang doi HVN %u:\n", queue);
+    print_stats(&s.link);
+}
+
+static void check_refuse(void)
+{
+    sim_t s;
+    sim_init(&s, 4);
+    s.refuse_2m = true;
+    sim_run(&s, 300000);
+    CHECK(s.link.current.phy == HUST_LINK_PHY_1M, "tu choi 2M: PHY %s", hust_link_phy_name(s.link.current.phy));
+    CHECK(s.phy_requests <= 1 + 300000 / HUST_LINK_PHY_RETRY_MS, "tu choi 2M: %u lan yeu cau", s.phy_requests);
+    CHECK(s.dropped_ms == 0, "tu choi 2M: mat sample %u ms", s.dropped_ms);
+}
+
+static void check_noise(void)
+{
+    sim_t s;
+    sim_init(&s, 4);
+    s.noise_2m = true;
+    s.rate = 2000;
+    sim_run(&s, 20000);
+    CHECK(s.link.current.phy == HUST_LINK_PHY_1M, "nhieu 2M: PHY %s sau 20 s", hust_link_phy_name(s.link.current.phy));
+    sim_run(&s, 40000);
+    CHECK(s.last_drop_ms < s.now_ms - 20000, "nhieu 2M: van mat sample luc %.1f s", s.last_drop_ms / 1000.0);
+}
+
+static void check_conn_cfg(void)
+{
+    static const uint32_t targets[] = {100000, 200000, 400000, 600000};
+    hust_link_t link;
+    hust_link_conn_cfg_t cfg;
+    hust_link_config_t config = {HUST_LINK_PHY_1M, 24};
+
+    printf("%10s %6s %12s %10s\n", "target", "queue", "event_ms", "capacity");
+    for(unsigned i = 0; i < sizeof(targets) / sizeof(targets[0]); i++)
+    {
+        CHECK(hust_link_conn_cfg(&cfg, targets[i], config.interval, config.phy, 244, 251, 0) == 0,
+              "conn cfg %u bps: khong dat o 30 ms", targets[i]);
+        hust_link_init(&link, 6, 80, cfg.hvn_tx_queue, false);
+        hust_link_payload_set(&link, 244, 251);
+        uint32_t capacity = hust_link_capacity(&link, config);
+        CHECK(capacity >= targets[i], "conn cfg %u bps: dung luong %u", targets[i], capacity);
+        CHECK(cfg.event_length * 1250u >= cfg.hvn_tx_queue * cfg.notification_us, "conn cfg %u bps: event length %u ngan",
+              targets[i], cfg.event_length);
+        if(cfg.hvn_tx_queue > 1)
+        {
+            hust_link_init(&link, 6, 80, cfg.hvn_tx_queue - 1, false);
+            hust_link_payload_set(&link, 244, 251);
+            CHECK(hust_link_capacity(&link, config) < targets[i], "conn cfg %u bps: hang doi %u thua", targets[i], cfg.hvn_tx_queue);
+        }
+        printf("%10u %6u %12.2f %10u\n", targets[i], cfg.hvn_tx_queue, cfg.event_length * 1.25, capacity);
+    }
+
+    // vuot thoi gian phat cua interval: lay toi da. Event length khong duoi mac dinh sdk_config (6)
+    CHECK(hust_link_conn_cfg(&cfg, 2000000, config.interval, config.phy, 244, 251, 6) == -1, "conn cfg 2 Mbps o 1M");
+    CHECK(cfg.event_length <= config.interval && cfg.hvn_tx_queue > 1, "conn cfg 2 Mbps: queue %u event length %u",
+          cfg.hvn_tx_queue, cfg.event_length);
+
+    // thieu RAM: bot dan ve 1
+    uint16_t event_length = cfg.event_length;
+    int steps = 0;
+    while(hust_link_conn_cfg_shrink(&cfg))
+    {
+        CHECK(cfg.event_length <= event_length, "shrink: event length tang");
+        event_length = cfg.event_length;
+        steps++;
+    }
+    CHECK(cfg.hvn_tx_queue == 1 && cfg.event_length == 6 && steps > 0,
+          "shrink: queue %u event length %u", cfg.hvn_tx_queue, cfg.event_length);
+}
+
+int main(int argc, char ** argv)
+{
+    int queue = 0;
+    for(int i = 1; i < argc; i++)
+    {
+        if(strcmp(argv[i], "-q") == 0 && i + 1 < argc)
+        {
+            queue = atoi(argv[++i]);
+        }
+        else if(strcmp(argv[i], "-v") == 0)
+        {
+            verbose = 1;
+        }
+        else
+        {
+            fprintf(stderr, "usage: hust_link_bench [-q hvn_queue] [-v]\n");
+            return 1;
+        }
+    }
+    if(queue > 0)
+    {
+        check_scenario((uint8_t)queue);
+    }
+    else
+    {
+        check_scenario(1);
+        check_scenario(4);
+    }
+    check_refuse();
+    check_noise();
+    check_conn_cfg();
+    printf("%s\n", failures == 0 ? "PASS" : "FAIL");
+    return failures == 0 ? 0 : 1;
+}
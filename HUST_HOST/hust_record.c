@@ -0,0 +1,723 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "hust_record.h"
+#include "hust_sched.h"
+
+#define HREC_VERSION            1
+#define HREC_CHUNK_HAS_PYR      0x01
+
+typedef struct
+{
+    char magic[4];
+    uint16_t version;
+    uint16_t n_channels;
+    uint32_t sample_rate;
+    uint32_t chunk_shift;
+    uint32_t pyr_min_shift;
+    uint32_t reserved[3];
+} hrec_header_t;
+
+typedef struct
+{
+    char magic[4];
+    uint32_t n_samples;
+    uint64_t first_sample;
+    uint32_t flags;
+    uint32_t reserved;
+} hrec_chunk_header_t;
+
+typedef struct
+{
+    char magic[4];
+    uint16_t version;
+    uint16_t n_channels;
+    uint32_t chunk_shift;
+    uint32_t n_levels;
+    uint64_t total_samples;
+} hpyr_header_t;
+
+static long chunk_record_size(const hust_record_t * rec)
+{
+    return (long)sizeof(hrec_chunk_header_t)
+         + (long)rec->n_channels * HUST_RECORD_CHUNK_SAMPLES * sizeof(int32_t)
+         + (long)rec->n_channels * HUST_PYR_CHUNK_ENTRIES * sizeof(hust_pyr_entry_t);
+}
+
+static long chunk_offset(const hust_record_t * rec, uint64_t chunk)
+{
+    return (long)sizeof(hrec_header_t) + (long)chunk * chunk_record_size(rec);
+}
+
+// vi tri cua level shift trong vung pyramid cua 1 channel trong chunk
+static uint32_t chunk_level_offset(uint32_t shift)
+{
+    return (HUST_RECORD_CHUNK_SAMPLES >> (HUST_PYR_MIN_SHIFT - 1)) - (HUST_RECORD_CHUNK_SAMPLES >> (shift - 1));
+}
+
+static char * sidecar_path(const char * path)
+{
+    size_t len = strlen(path);
+    char * p = malloc(len + 6);
+    if(p != NULL)
+    {
+        memcpy(p, path, len);
+        memcpy(p + len, ".hpyr", 6);
+    }
+    return p;
+}
+
+static void acc_reset(hust_pyr_acc_t * acc)
+{
+    acc->min = INT32_MAX;
+    acc->max = INT32_MIN;
+    acc->sum = 0;
+    acc->count = 0;
+}
+
+static void acc_add(hust_pyr_acc_t * acc, int32_t min, int32_t max, int64_t sum, uint64_t count)
+{
+    if(min < acc->min)
+    {
+        acc->min = min;
+    }
+    if(max > acc->max)
+    {
+        acc->max = max;
+    }
+    acc->sum += sum;
+    acc->count += count;
+}
+
+static hust_pyr_entry_t acc_entry(const hust_pyr_acc_t * acc)
+{
+    hust_pyr_entry_t entry;
+    entry.min = acc->min;
+    entry.max = acc->max;
+    entry.mean = (int32_t)(acc->sum / (int64_t)acc->count);
+    return entry;
+}
+
+static int level_append(hust_pyr_level_t * level, hust_pyr_entry_t entry)
+{
+    if(level->count == level->capacity)
+    {
+        uint64_t capacity = level->capacity ? level->capacity * 2 : 64;
+        hust_pyr_entry_t * p = realloc(level->entry, capacity * sizeof(hust_pyr_entry_t));
+        if(p == NULL)
+        {
+            return -1;
+        }
+        level->entry = p;
+        level->capacity = capacity;
+    }
+    level->entry[level->count++] = entry;
+    return 0;
+}
+
+static void upper_free(hust_record_t * rec)
+{
+    if(rec->upper == NULL)
+    {
+        return;
+    }
+    for(int i = 0; i < HUST_PYR_UPPER_LEVELS * rec->n_channels; i++)
+    {
+        free(rec->upper[i].entry);
+    }
+    free(rec->upper);
+    rec->upper = NULL;
+    rec->upper_valid = false;
+}
+
+static int upper_alloc(hust_record_t * rec)
+{
+    upper_free(rec);
+    rec->upper = calloc((size_t)HUST_PYR_UPPER_LEVELS * rec->n_channels, sizeof(hust_pyr_level_t));
+    return rec->upper == NULL ? -1 : 0;
+}
+
+static hust_pyr_level_t * upper_level(hust_record_t * rec, uint32_t shift, int ch)
+{
+    return &rec->upper[(shift - HUST_RECORD_CHUNK_SHIFT) * rec->n_channels + ch];
+}
+
+// dong bucket level shift: luu entry roi cong don len level shift + 1
+static void pyr_emit(hust_record_t * rec, hust_pyr_acc_t * acc, int ch, uint32_t shift)
+{
+    hust_pyr_acc_t * a = &acc[shift];
+    hust_pyr_entry_t entry = acc_entry(a);
+
+    if(shift <= HUST_RECORD_CHUNK_SHIFT && rec->chunk_pyr != NULL)
+    {
+        uint32_t index = (rec->chunk_fill - 1) >> shift;
+        rec->chunk_pyr[ch * HUST_PYR_CHUNK_ENTRIES + chunk_level_offset(shift) + index] = entry;
+    }
+    if(shift >= HUST_RECORD_CHUNK_SHIFT)
+    {
+        (void)level_append(upper_level(rec, shift, ch), entry);
+    }
+    if(shift < HUST_PYR_MAX_SHIFT)
+    {
+        hust_pyr_acc_t * parent = &acc[shift + 1];
+        acc_add(parent, a->min, a->max, a->sum, a->count);
+        acc_reset(a);
+        if(parent->count == ((uint64_t)1 << (shift + 1)))
+        {
+            pyr_emit(rec, acc, ch, shift + 1);
+        }
+    }
+    else
+    {
+        acc_reset(a);
+    }
+}
+
+// dong cac bucket chua day (chunk cuoi / cuoi recording)
+static void pyr_flush(hust_record_t * rec, hust_pyr_acc_t * acc, int ch, uint32_t from_shift)
+{
+    for(uint32_t shift = from_shift; shift <= HUST_PYR_MAX_SHIFT; shift++)
+    {
+        if(acc[shift].count > 0)
+        {
+            pyr_emit(rec, acc, ch, shift);
+        }
+    }
+}
+
+static int write_header(hust_record_t * rec)
+{
+    hrec_header_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "HREC", 4);
+    header.version = HREC_VERSION;
+    header.n_channels = rec->n_channels;
+    header.sample_rate = rec->sample_rate;
+    header.chunk_shift = HUST_RECORD_CHUNK_SHIFT;
+    header.pyr_min_shift = HUST_PYR_MIN_SHIFT;
+    if(fseek(rec->file, 0, SEEK_SET) != 0 || fwrite(&header, sizeof(header), 1, rec->file) != 1)
+    {
+        return -1;
+    }
+    return 0;
+}
+
+static int write_chunk(hust_record_t * rec)
+{
+    hrec_chunk_header_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "HCHK", 4);
+    header.n_samples = rec->chunk_fill;
+    header.first_sample = rec->total_samples - rec->chunk_fill;
+    header.flags = rec->pyramid ? HREC_CHUNK_HAS_PYR : 0;
+
+    if(fseek(rec->file, chunk_offset(rec, header.first_sample >> HUST_RECORD_CHUNK_SHIFT), SEEK_SET) != 0)
+    {
+        return -1;
+    }
+    if(fwrite(&header, sizeof(header), 1, rec->file) != 1 ||
+       fwrite(rec->chunk_data, sizeof(int32_t), (size_t)rec->n_channels * HUST_RECORD_CHUNK_SAMPLES, rec->file) != (size_t)rec->n_channels * HUST_RECORD_CHUNK_SAMPLES ||
+       fwrite(rec->chunk_pyr, sizeof(hust_pyr_entry_t), (size_t)rec->n_channels * HUST_PYR_CHUNK_ENTRIES, rec->file) != (size_t)rec->n_channels * HUST_PYR_CHUNK_ENTRIES)
+    {
+        return -1;
+    }
+    memset(rec->chunk_data, 0, (size_t)rec->n_channels * HUST_RECORD_CHUNK_SAMPLES * sizeof(int32_t));
+    memset(rec->chunk_pyr, 0, (size_t)rec->n_channels * HUST_PYR_CHUNK_ENTRIES * sizeof(hust_pyr_entry_t));
+    rec->chunk_fill = 0;
+    return 0;
+}
+
+static int write_sidecar(hust_record_t * rec)
+{
+    char * path = sidecar_path(rec->path);
+    FILE * f = path ? fopen(path, "wb") : NULL;
+    free(path);
+    if(f == NULL)
+    {
+        return -1;
+    }
+    hpyr_header_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "HPYR", 4);
+    header.version = HREC_VERSION;
+    header.n_channels = rec->n_channels;
+    header.chunk_shift = HUST_RECORD_CHUNK_SHIFT;
+    header.n_levels = HUST_PYR_UPPER_LEVELS;
+    header.total_samples = rec->total_samples;
+    int err = fwrite(&header, sizeof(header), 1, f) != 1;
+    for(uint32_t shift = HUST_RECORD_CHUNK_SHIFT; shift <= HUST_PYR_MAX_SHIFT && !err; shift++)
+    {
+        for(int ch = 0; ch < rec->n_channels && !err; ch++)
+        {
+            hust_pyr_level_t * level = upper_level(rec, shift, ch);
+            err = fwrite(&level->count, sizeof(level->count), 1, f) != 1 ||
+                  fwrite(level->entry, sizeof(hust_pyr_entry_t), level->count, f) != level->count;
+        }
+    }
+    err |= fclose(f) != 0;
+    return err ? -1 : 0;
+}
+
+static int read_sidecar(hust_record_t * rec)
+{
+    char * path = sidecar_path(rec->path);
+    FILE * f = path ? fopen(path, "rb") : NULL;
+    free(path);
+    if(f == NULL)
+    {
+        return -1;
+    }
+    hpyr_header_t header;
+    int err = fread(&header, sizeof(header), 1, f) != 1 ||
+              memcmp(header.magic, "HPYR", 4) != 0 ||
+              header.n_channels != rec->n_channels ||
+              header.chunk_shift != HUST_RECORD_CHUNK_SHIFT ||
+              header.n_levels != HUST_PYR_UPPER_LEVELS ||
+              header.total_samples != rec->total_samples;      // file .hpyr cu hon recording
+    err = err || upper_alloc(rec) != 0;
+    for(uint32_t shift = HUST_RECORD_CHUNK_SHIFT; shift <= HUST_PYR_MAX_SHIFT && !err; shift++)
+    {
+        for(int ch = 0; ch < rec->n_channels && !err; ch++)
+        {
+            hust_pyr_level_t * level = upper_level(rec, shift, ch);
+            uint64_t count;
+            err = fread(&count, sizeof(count), 1, f) != 1;
+            if(!err && count > 0)
+            {
+                level->entry = malloc(count * sizeof(hust_pyr_entry_t));
+                err = level->entry == NULL || fread(level->entry, sizeof(hust_pyr_entry_t), count, f) != count;
+                level->count = level->capacity = err ? 0 : count;
+            }
+        }
+    }
+    fclose(f);
+    if(err)
+    {
+        upper_free(rec);
+        return -1;
+    }
+    rec->upper_valid = true;
+    return 0;
+}
+
+static int read_chunk_header(hust_record_t * rec, uint64_t chunk, hrec_chunk_header_t * header)
+{
+    if(fseek(rec->file, chunk_offset(rec, chunk), SEEK_SET) != 0 ||
+       fread(header, sizeof(*header), 1, rec->file) != 1 ||
+       memcmp(header->magic, "HCHK", 4) != 0)
+    {
+        return -1;
+    }
+    return 0;
+}
+
+// doc sample tho cua channel ch, doan [first, first + n) (khong vuot qua 1 chunk)
+static int read_chunk_raw(hust_record_t * rec, int ch, uint64_t first, uint32_t n, int32_t * out)
+{
+    uint64_t chunk = first >> HUST_RECORD_CHUNK_SHIFT;
+    uint32_t local = (uint32_t)(first & (HUST_RECORD_CHUNK_SAMPLES - 1));
+    long offset = chunk_offset(rec, chunk) + (long)sizeof(hrec_chunk_header_t)
+                + ((long)ch * HUST_RECORD_CHUNK_SAMPLES + local) * (long)sizeof(int32_t);
+    if(fseek(rec->file, offset, SEEK_SET) != 0 || fread(out, sizeof(int32_t), n, rec->file) != n)
+    {
+        return -1;
+    }
+    return 0;
+}
+
+// entry [i0, i0 + n) level shift (<= chunk) cua 1 chunk, doc tu pyramid trong chunk
+// hoac tinh lai tu sample tho neu chunk khong co pyramid
+static int read_chunk_entries(hust_record_t * rec, int ch, uint64_t chunk, uint32_t shift,
+                              uint32_t i0, uint32_t n, hust_pyr_entry_t * out)
+{
+    hrec_chunk_header_t header;
+    if(read_chunk_header(rec, chunk, &header) != 0)
+    {
+        return -1;
+    }
+    if(header.flags & HREC_CHUNK_HAS_PYR)
+    {
+        long offset = chunk_offset(rec, chunk) + (long)sizeof(hrec_chunk_header_t)
+                    + (long)rec->n_channels * HUST_RECORD_CHUNK_SAMPLES * (long)sizeof(int32_t)
+                    + ((long)ch * HUST_PYR_CHUNK_ENTRIES + chunk_level_offset(shift) + i0) * (long)sizeof(hust_pyr_entry_t);
+        if(fseek(rec->file, offset, SEEK_SET) != 0 || fread(out, sizeof(hust_pyr_entry_t), n, rec->file) != n)
+        {
+            return -1;
+        }
+        return 0;
+    }
+
+    uint32_t span = (uint32_t)1 << shift;
+    int32_t * raw = malloc(span * sizeof(int32_t));
+    if(raw == NULL)
+    {
+        return -1;
+    }
+    for(uint32_t i = 0; i < n; i++)
+    {
+        uint32_t first = (i0 + i) << shift;
+        uint32_t count = header.n_samples > first ? header.n_samples - first : 0;
+        count = count < span ? count : span;
+        if(count == 0 || read_chunk_raw(rec, ch, (chunk << HUST_RECORD_CHUNK_SHIFT) + first, count, raw) != 0)
+        {
+            free(raw);
+            return -1;
+        }
+        hust_pyr_acc_t acc;
+        acc_reset(&acc);
+        for(uint32_t k = 0; k < count; k++)
+        {
+            acc_add(&acc, raw[k], raw[k], raw[k], 1);
+        }
+        out[i] = acc_entry(&acc);
+    }
+    free(raw);
+    return 0;
+}
+
+// build lai pyramid level >= 1 chunk tu cac chunk (recording cu / thieu .hpyr)
+static int rebuild_upper(hust_record_t * rec)
+{
+    if(upper_alloc(rec) != 0)
+    {
+        return -1;
+    }
+    hust_pyr_acc_t * acc = malloc(sizeof(hust_pyr_acc_t) * (HUST_PYR_MAX_SHIFT + 1));
+    if(acc == NULL)
+    {
+        return -1;
+    }
+    uint64_t n_chunks = (rec->total_samples + HUST_RECORD_CHUNK_SAMPLES - 1) >> HUST_RECORD_CHUNK_SHIFT;
+    int err = 0;
+    for(int ch = 0; ch < rec->n_channels && !err; ch++)
+    {
+        for(int i = 0; i <= HUST_PYR_MAX_SHIFT; i++)
+        {
+            acc_reset(&acc[i]);
+        }
+        for(uint64_t chunk = 0; chunk < n_chunks && !err; chunk++)
+        {
+            hrec_chunk_header_t header;
+            hust_pyr_entry_t entry;
+            err = read_chunk_header(rec, chunk, &header) != 0 ||
+                  read_chunk_entries(rec, ch, chunk, HUST_RECORD_CHUNK_SHIFT, 0, 1, &entry) != 0;
+            if(!err)
+            {
+                acc_add(&acc[HUST_RECORD_CHUNK_SHIFT], entry.min, entry.max, (int64_t)entry.mean * header.n_samples, header.n_samples);
+                pyr_emit(rec, acc, ch, HUST_RECORD_CHUNK_SHIFT);
+            }
+        }
+        pyr_flush(rec, acc, ch, HUST_RECORD_CHUNK_SHIFT + 1);
+    }
+    free(acc);
+    if(err)
+    {
+        upper_free(rec);
+        return -1;
+    }
+    rec->upper_valid = true;
+    (void)write_sidecar(rec);       // cache cho lan mo sau, bo qua neu khong ghi duoc
+    return 0;
+}
+
+static void record_free(hust_record_t * rec)
+{
+    upper_free(rec);
+    free(rec->chunk_data);
+    free(rec->chunk_pyr);
+    free(rec->acc);
+    free(rec->path);
+    memset(rec, 0, sizeof(*rec));
+}
+
+int hust_record_create(hust_record_t * rec, const char * path, uint16_t n_channels, uint32_t sample_rate, bool pyramid)
+{
+    memset(rec, 0, sizeof(*rec));
+    if(n_channels == 0 || n_channels > HUST_RECORD_MAX_CHANNEL)
+    {
+        return -1;
+    }
+    rec->n_channels = n_channels;
+    rec->sample_rate = sample_rate;
+    rec->pyramid = pyramid;
+    rec->writable = true;
+    rec->path = malloc(strlen(path) + 1);
+    rec->chunk_data = calloc((size_t)n_channels * HUST_RECORD_CHUNK_SAMPLES, sizeof(int32_t));
+    rec->chunk_pyr = calloc((size_t)n_channels * HUST_PYR_CHUNK_ENTRIES, sizeof(hust_pyr_entry_t));
+    rec->acc = malloc(sizeof(hust_pyr_acc_t) * n_channels * (HUST_PYR_MAX_SHIFT + 1));
+    if(rec->path == NULL || rec->chunk_data == NULL || rec->chunk_pyr == NULL || rec->acc == NULL || upper_alloc(rec) != 0)
+    {
+        record_free(rec);
+        return -1;
+    }
+    strcpy(rec->path, path);
+    for(int i = 0; i < n_channels * (HUST_PYR_MAX_SHIFT + 1); i++)
+    {
+        acc_reset(&rec->acc[i]);
+    }
+    rec->file = fopen(path, "w+b");
+    if(rec->file == NULL || write_header(rec) != 0)
+    {
+        if(rec->file != NULL)
+        {
+            fclose(rec->file);
+        }
+        record_free(rec);
+        return -1;
+    }
+    return 0;
+}
+
+int hust_record_write(hust_record_t * rec, const int32_t * samples, uint32_t n_frames)
+{
+    if(!rec->writable)
+    {
+        return -1;
+    }
+    for(uint32_t j = 0; j < n_frames; j++)
+    {
+        rec->chunk_fill++;
+        rec->total_samples++;
+        for(int ch = 0; ch < rec->n_channels; ch++)
+        {
+            int32_t value = samples[j * rec->n_channels + ch];
+            rec->chunk_data[ch * HUST_RECORD_CHUNK_SAMPLES + rec->chunk_fill - 1] = value;
+            if(rec->pyramid)
+            {
+                hust_pyr_acc_t * acc = &rec->acc[ch * (HUST_PYR_MAX_SHIFT + 1)];
+                acc_add(&acc[HUST_PYR_MIN_SHIFT], value, value, value, 1);
+                if(acc[HUST_PYR_MIN_SHIFT].count == (1u << HUST_PYR_MIN_SHIFT))
+                {
+                    pyr_emit(rec, acc, ch, HUST_PYR_MIN_SHIFT);
+                }
+            }
+        }
+        if(rec->chunk_fill == HUST_RECORD_CHUNK_SAMPLES && write_chunk(rec) != 0)
+        {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+int hust_record_put_packet(hust_record_t * rec, const uint8_t * ble_packet, int ble_packet_size)
+{
+    ecg_data_t ecg_data[ECG_SAMPLE_MAX];
+    imu_data_t imu_data[IMU_SAMPLE_MAX];
+    int32_t frame[HUST_RECORD_MAX_CHANNEL];
+    ble_packet_t ble_packet_m;
+
+    ble_packet_m.ecg_data = ecg_data;
+    ble_packet_m.imu_data = imu_data;
+    if(convert_ble_packet_to_data(ble_packet, ble_packet_size, &ble_packet_m) != 0)
+    {
+        return -1;
+    }
+    memset(frame, 0, sizeof(frame));
+    if(ble_packet_m.sensor_type == ALL_SENSOR_TYPE)
+    {
+        // chi ghi segment ECG, IMU co rate khac
+        const uint8_t * data = ble_packet + BLE_PACKET_HEADER_SIZE;
+        for(int offset = 0; offset < ble_packet_m.data_size; )
+        {
+            hust_sched_seg_t seg;
+            int length = hust_sched_seg_read(data + offset, ble_packet_m.data_size - offset, &seg);
+            if(length < 0)
+            {
+                return -1;
+            }
+            for(int j = 0; j < seg.n && seg.stream == HUST_STREAM_ECG; j++)
+            {
+                hust_sched_ecg_get(&seg, j, &ecg_data[0]);
+                for(int ch = 0; ch < rec->n_channels && ch < ECG_CHANNEL; ch++)
+                {
+                    frame[ch] = ecg_sample_to_int32(*ecg_channel_get(&ecg_data[0], ch));
+                }
+                if(hust_record_write(rec, frame, 1) != 0)
+                {
+                    return -1;
+                }
+            }
+            offset += length;
+        }
+        return 0;
+    }
+    sample_transfer_t sample_transfer_m = set_sample_transfer(ble_packet_m);
+    for(int j = 0; j < sample_transfer_m.ecg_sample; j++)
+    {
+        for(int ch = 0; ch < rec->n_channels && ch < ECG_CHANNEL; ch++)
+        {
+            frame[ch] = ecg_sample_to_int32(*ecg_channel_get(&ecg_data[j], ch));
+        }
+        if(hust_record_write(rec, frame, 1) != 0)
+        {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+int hust_record_open(hust_record_t * rec, const char * path)
+{
+    hrec_header_t header;
+
+    memset(rec, 0, sizeof(*rec));
+    rec->file = fopen(path, "rb");
+    if(rec->file == NULL)
+    {
+        return -1;
+    }
+    rec->path = malloc(strlen(path) + 1);
+    if(rec->path == NULL ||
+       fread(&header, sizeof(header), 1, rec->file) != 1 ||
+       memcmp(header.magic, "HREC", 4) != 0 ||
+       header.chunk_shift != HUST_RECORD_CHUNK_SHIFT ||
+       header.pyr_min_shift != HUST_PYR_MIN_SHIFT ||
+       header.n_channels == 0 || header.n_channels > HUST_RECORD_MAX_CHANNEL)
+    {
+        fclose(rec->file);
+        record_free(rec);
+        return -1;
+    }
+    strcpy(rec->path, path);
+    rec->n_channels = header.n_channels;
+    rec->sample_rate = header.sample_rate;
+
+    fseek(rec->file, 0, SEEK_END);
+    long size = ftell(rec->file);
+    uint64_t n_chunks = size > (long)sizeof(header) ? (uint64_t)(size - (long)sizeof(header)) / (uint64_t)chunk_record_size(rec) : 0;
+    if(n_chunks > 0)
+    {
+        hrec_chunk_header_t last;
+        if(read_chunk_header(rec, n_chunks - 1, &last) != 0)
+        {
+            fclose(rec->file);
+            record_free(rec);
+            return -1;
+        }
+        rec->total_samples = last.first_sample + last.n_samples;
+    }
+    (void)read_sidecar(rec);        // thieu / cu thi build lai khi query
+    return 0;
+}
+
+int hust_record_close(hust_record_t * rec)
+{
+    int err = 0;
+    if(rec->file == NULL)
+    {
+        return -1;
+    }
+    if(rec->writable)
+    {
+        if(rec->pyramid)
+        {
+            for(int ch = 0; ch < rec->n_channels; ch++)
+            {
+                pyr_flush(rec, &rec->acc[ch * (HUST_PYR_MAX_SHIFT + 1)], ch, HUST_PYR_MIN_SHIFT);
+            }
+        }
+        if(rec->chunk_fill > 0)
+        {
+            err |= write_chunk(rec);
+        }
+        if(rec->pyramid)
+        {
+            err |= write_sidecar(rec);
+        }
+    }
+    err |= fclose(rec->file) != 0;
+    record_free(rec);
+    return err ? -1 : 0;
+}
+
+int hust_record_query(hust_record_t * rec, int ch, uint64_t first_sample, uint64_t n_samples,
+                      uint32_t max_points, hust_pyr_entry_t * out, uint32_t * p_shift)
+{
+    if(rec->writable || ch < 0 || ch >= rec->n_channels || max_points == 0)
+    {
+        return -1;
+    }
+    if(first_sample >= rec->total_samples || n_samples == 0)
+    {
+        *p_shift = 0;
+        return 0;
+    }
+    if(n_samples > rec->total_samples - first_sample)
+    {
+        n_samples = rec->total_samples - first_sample;
+    }
+    uint64_t last_sample = first_sample + n_samples - 1;
+
+    // level nho nhat cho so entry <= max_points; level 1..MIN-1 khong luu nen lam tron len MIN
+    uint32_t shift = 0;
+    while((last_sample >> shift) - (first_sample >> shift) + 1 > max_points)
+    {
+        shift++;
+    }
+    if(shift > 0 && shift < HUST_PYR_MIN_SHIFT)
+    {
+        shift = HUST_PYR_MIN_SHIFT;
+    }
+    *p_shift = shift;
+
+    uint64_t i0 = first_sample >> shift;
+    uint64_t i1 = last_sample >> shift;
+    int n_out = (int)(i1 - i0 + 1);
+
+    if(shift == 0)
+    {
+        int32_t * raw = malloc((size_t)n_out * sizeof(int32_t));
+        if(raw == NULL)
+        {
+            return -1;
+        }
+        for(uint64_t s = first_sample; s <= last_sample; )
+        {
+            uint64_t chunk_end = ((s >> HUST_RECORD_CHUNK_SHIFT) + 1) << HUST_RECORD_CHUNK_SHIFT;
+            uint32_t n = (uint32_t)((chunk_end <= last_sample ? chunk_end : last_sample + 1) - s);
+            if(read_chunk_raw(rec, ch, s, n, raw + (s - first_sample)) != 0)
+            {
+                free(raw);
+                return -1;
+            }
+            s += n;
+        }
+        for(int i = 0; i < n_out; i++)
+        {
+            out[i].min = out[i].max = out[i].mean = raw[i];
+        }
+        free(raw);
+        return n_out;
+    }
+
+    if(shift <= HUST_RECORD_CHUNK_SHIFT)
+    {
+        uint32_t per_chunk = HUST_RECORD_CHUNK_SAMPLES >> shift;
+        for(uint64_t i = i0; i <= i1; )
+        {
+            uint64_t chunk = i / per_chunk;
+            uint32_t local = (uint32_t)(i % per_chunk);
+            uint64_t n = per_chunk - local;
+            n = n < i1 - i + 1 ? n : i1 - i + 1;
+            if(read_chunk_entries(rec, ch, chunk, shift, local, (uint32_t)n, out + (i - i0)) != 0)
+            {
+                return -1;
+            }
+            i += n;
+        }
+        return n_out;
+    }
+
+    if(!rec->upper_valid && rebuild_upper(rec) != 0)
+    {
+        return -1;
+    }
+    hust_pyr_level_t * level = upper_level(rec, shift, ch);
+    if(i1 >= level->count)
+    {
+        return -1;
+    }
+    memcpy(out, level->entry + i0, (size_t)n_out * sizeof(hust_pyr_entry_t));
+    return n_out;
+}
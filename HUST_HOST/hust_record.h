@@ -0,0 +1,95 @@
+#ifndef HUST_RECORD_H__
+#define HUST_RECORD_H__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "hust_ble.h"
+
+/*
+ * Recording file phia host (.hrec) + pyramid min/max/mean de zoom nhanh.
+ *
+ * .hrec : [file header][chunk 0][chunk 1]...  moi chunk co kich thuoc co dinh:
+ *         [chunk header][int32 sample x n_channels x HUST_RECORD_CHUNK_SAMPLES]
+ *         [pyramid trong chunk: level 2^HUST_PYR_MIN_SHIFT .. 2^HUST_RECORD_CHUNK_SHIFT]
+ * .hpyr : pyramid cac level lon hon 1 chunk (file di kem, ghi khi close)
+ *
+ * Chunk ghi khong co pyramid (pyramid = false) hoac thieu file .hpyr se duoc
+ * build lai luc query (lazy).
+ */
+
+#define HUST_RECORD_MAX_CHANNEL     32
+#define HUST_RECORD_CHUNK_SHIFT     12                              // 4096 sample / chunk
+#define HUST_RECORD_CHUNK_SAMPLES   (1u << HUST_RECORD_CHUNK_SHIFT)
+#define HUST_PYR_MIN_SHIFT          6                               // level nho nhat luu tru: 64 sample
+#define HUST_PYR_MAX_SHIFT          32
+#define HUST_PYR_CHUNK_LEVELS       (HUST_RECORD_CHUNK_SHIFT - HUST_PYR_MIN_SHIFT + 1)
+#define HUST_PYR_UPPER_LEVELS       (HUST_PYR_MAX_SHIFT - HUST_RECORD_CHUNK_SHIFT + 1)
+#define HUST_PYR_CHUNK_ENTRIES      ((HUST_RECORD_CHUNK_SAMPLES >> (HUST_PYR_MIN_SHIFT - 1)) - 1)  // so entry / channel / chunk
+
+typedef struct
+{
+    int32_t min;
+    int32_t max;
+    int32_t mean;
+} hust_pyr_entry_t;
+
+typedef struct
+{
+    int32_t min;
+    int32_t max;
+    int64_t sum;
+    uint64_t count;
+} hust_pyr_acc_t;
+
+typedef struct
+{
+    hust_pyr_entry_t * entry;
+    uint64_t count;
+    uint64_t capacity;
+} hust_pyr_level_t;
+
+typedef struct
+{
+    FILE * file;
+    char * path;
+    bool writable;
+    bool pyramid;                                   // ghi pyramid trong chunk
+    uint16_t n_channels;
+    uint32_t sample_rate;
+    uint64_t total_samples;
+
+    // writer
+    int32_t * chunk_data;                           // [n_channels][HUST_RECORD_CHUNK_SAMPLES]
+    hust_pyr_entry_t * chunk_pyr;                   // [n_channels][HUST_PYR_CHUNK_ENTRIES]
+    uint32_t chunk_fill;
+    hust_pyr_acc_t * acc;                           // [n_channels][HUST_PYR_MAX_SHIFT + 1]
+
+    // pyramid level >= 1 chunk, [level - HUST_RECORD_CHUNK_SHIFT][channel]
+    hust_pyr_level_t * upper;
+    bool upper_valid;
+} hust_record_t;
+
+// tao recording moi de ghi
+int hust_record_create(hust_record_t * rec, const char * path, uint16_t n_channels, uint32_t sample_rate, bool pyramid);
+
+// ghi n_frames frame, moi frame gom n_channels sample (interleaved)
+int hust_record_write(hust_record_t * rec, const int32_t * samples, uint32_t n_frames);
+
+// giai ma 1 ble packet va ghi cac sample ecg vao recording
+int hust_record_put_packet(hust_record_t * rec, const uint8_t * ble_packet, int ble_packet_size);
+
+// mo recording da co de doc/query
+int hust_record_open(hust_record_t * rec, const char * path);
+
+// ghi chunk cuoi + file .hpyr (neu dang ghi) va giai phong bo nho
+int hust_record_close(hust_record_t * rec);
+
+// lay toi da max_points entry min/max/mean cho doan [first_sample, first_sample + n_samples)
+// cua channel ch, level decimation duoc chon tu dong va tra ve qua p_shift (2^shift sample / entry)
+// tra ve so entry, -1 neu loi
+int hust_record_query(hust_record_t * rec, int ch, uint64_t first_sample, uint64_t n_samples,
+                      uint32_t max_points, hust_pyr_entry_t * out, uint32_t * p_shift);
+
+#endif // HUST_RECORD_H__
@@ -0,0 +1,336 @@
+/*
+ * Ghi lai va phat lai luong notification NUS tu thiet bi.
+ *
+ *   hust_replay capture <log.hcap>                   doc notification tu stdin (moi dong 1 packet, hex)
+ *   hust_replay replay <log.hcap> [-s N | -m] [-j] [-r out.hrec]
+ *                                                    phat lai vao decoder (+ recording writer)
+ *   hust_replay info <log.hcap>
+ *
+ * Packet ALL_SENSOR_TYPE: dem sample / chi so bi mat cua tung stream va rate thuc tinh tu moc thoi gian.
+ * Tra loi lenh (CMD_SENSOR_TYPE) khong tinh vao packet mat; START / SET_RATE thanh cong bat dau lai
+ * chi so sample nen dat lai moc thoi gian cua cac stream.
+ *
+ * Build: cc -DHUST_HOST_BUILD -I../HUST_BLE hust_replay.c hust_capture.c hust_record.c ../HUST_BLE/hust_ble.c ../HUST_BLE/hust_sched.c ../HUST_BLE/hust_cmd.c
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "hust_ble.h"
+#include "hust_capture.h"
+#include "hust_record.h"
+#include "hust_sched.h"
+#include "hust_cmd.h"
+
+typedef struct
+{
+    uint64_t samples;
+    uint64_t gaps;                  // sample bi mat (chi so nhay coc)
+    uint64_t next_index;
+    hust_sched_timeline_t timeline;
+} replay_stream_t;
+
+typedef struct
+{
+    uint64_t packets;
+    uint64_t bytes;
+    uint64_t decode_errors;
+    uint64_t lost;
+    uint64_t decode_us;
+    uint64_t responses;             // packet CMD_SENSOR_TYPE
+    bool have_count;
+    uint8_t last_count;
+    hust_record_t * rec;
+    replay_stream_t stream[HUST_STREAM_COUNT];
+} replay_stats_t;
+
+static const char * stream_name[HUST_STREAM_COUNT] = {"ecg", "imu"};
+static const double stream_rate[HUST_STREAM_COUNT] = {1000, 104};
+
+// cap nhat so sample va moc thoi gian cua tung stream trong packet ALL_SENSOR_TYPE
+static int replay_streams(replay_stats_t * stats, const uint8_t * data, int data_size)
+{
+    for(int offset = 0; offset < data_size; )
+    {
+        hust_sched_seg_t seg;
+        int length = hust_sched_seg_read(data + offset, data_size - offset, &seg);
+        if(length < 0)
+        {
+            return -1;
+        }
+        replay_stream_t * stream = &stats->stream[seg.stream];
+        bool first = !stream->timeline.have_anchor;
+        uint64_t index = hust_sched_timeline_anchor(&stream->timeline, &seg);
+        if(!first && index > stream->next_index)
+        {
+            stream->gaps += index - stream->next_index;
+        }
+        stream->next_index = index + seg.n;
+        stream->samples += seg.n;
+        offset += length;
+    }
+    return 0;
+}
+
+static void usage(void)
+{
+    fprintf(stderr,
+            "usage: hust_replay capture <log.hcap>\n"
+            "       hust_replay replay <log.hcap> [-s speed | -m] [-j] [-r out.hrec]\n"
+            "       hust_replay info <log.hcap>\n");
+}
+
+// "0a 0b ff" hoac "0a0bff" -> bytes
+static int parse_hex_line(const char * line, uint8_t * data, int max_len)
+{
+    int length = 0;
+    int nibble = -1;
+    for(const char * p = line; *p != '\0'; p++)
+    {
+        if(!isxdigit((unsigned char)*p))
+        {
+            continue;
+        }
+        int v = isdigit((unsigned char)*p) ? *p - '0' : tolower((unsigned char)*p) - 'a' + 10;
+        if(nibble < 0)
+        {
+            nibble = v;
+        }
+        else
+        {
+            if(length >= max_len)
+            {
+                return -1;
+            }
+            data[length++] = (uint8_t)((nibble << 4) | v);
+            nibble = -1;
+        }
+    }
+    return nibble < 0 ? length : -1;
+}
+
+static int capture(const char * path)
+{
+    hust_capture_t cap;
+    char line[4 * HUST_CAPTURE_MAX_DATA_LEN];
+    uint8_t data[HUST_CAPTURE_MAX_DATA_LEN];
+
+    if(hust_capture_create(&cap, path) != 0)
+    {
+        perror(path);
+        return 1;
+    }
+    while(fgets(line, sizeof(line), stdin) != NULL)
+    {
+        uint64_t t_us = hust_time_us();
+        int length = parse_hex_line(line, data, sizeof(data));
+        if(length <= 0)
+        {
+            continue;
+        }
+        if(hust_capture_write(&cap, t_us, data, (uint16_t)length) != 0)
+        {
+            perror(path);
+            hust_capture_close(&cap);
+            return 1;
+        }
+    }
+    fprintf(stderr, "captured %llu packets\n", (unsigned long long)cap.count);
+    return hust_capture_close(&cap) == 0 ? 0 : 1;
+}
+
+// tra loi lenh: START / SET_RATE thanh cong -> chi so sample cua moi stream bat dau lai tu 0
+static int replay_response(replay_stats_t * stats, const uint8_t * data, int data_size)
+{
+    hust_cmd_config_t config;
+    if(data_size < 2)
+    {
+        return -1;
+    }
+    stats->responses++;
+    if((data[0] == HUST_CMD_START || data[0] == HUST_CMD_SET_RATE) && data[1] == HUST_CMD_OK
+       && hust_cmd_config_decode(data + 2, data_size - 2, &config) == 0)
+    {
+        for(int i = 0; i < HUST_STREAM_COUNT; i++)
+        {
+            hust_sched_timeline_init(&stats->stream[i].timeline, i == HUST_STREAM_ECG ? config.rate : stream_rate[i]);
+        }
+    }
+    return 0;
+}
+
+static int replay_handler(const hust_capture_rec_t * rec, void * p_context)
+{
+    replay_stats_t * stats = p_context;
+    ecg_data_t ecg_data[ECG_SAMPLE_MAX];
+    imu_data_t imu_data[IMU_SAMPLE_MAX];
+    ble_packet_t ble_packet_m;
+
+    ble_packet_m.ecg_data = ecg_data;
+    ble_packet_m.imu_data = imu_data;
+
+    uint64_t t0 = hust_time_us();
+    int err = convert_ble_packet_to_data(rec->data, rec->length, &ble_packet_m);
+    if(err == 0 && ble_packet_m.sensor_type == CMD_SENSOR_TYPE)
+    {
+        err = replay_response(stats, rec->data + BLE_PACKET_HEADER_SIZE, ble_packet_m.data_size);
+        stats->decode_us += hust_time_us() - t0;
+        stats->packets++;
+        stats->bytes += rec->length;
+        stats->decode_errors += err != 0;
+        return 0;                   // count_packet rieng, khong tinh packet mat
+    }
+    if(err == 0 && ble_packet_m.sensor_type == ALL_SENSOR_TYPE)
+    {
+        err = replay_streams(stats, rec->data + BLE_PACKET_HEADER_SIZE, ble_packet_m.data_size);
+    }
+    if(err == 0 && stats->rec != NULL)
+    {
+        err = hust_record_put_packet(stats->rec, rec->data, rec->length);
+    }
+    stats->decode_us += hust_time_us() - t0;
+
+    stats->packets++;
+    stats->bytes += rec->length;
+    if(err != 0)
+    {
+        stats->decode_errors++;
+        return 0;
+    }
+    if(stats->have_count)
+    {
+        stats->lost += (uint8_t)(ble_packet_m.count_packet - stats->last_count - 1);
+    }
+    stats->have_count = true;
+    stats->last_count = ble_packet_m.count_packet;
+    return 0;
+}
+
+static int replay(const char * path, int argc, char ** argv)
+{
+    hust_capture_t cap;
+    hust_replay_cfg_t cfg = { .speed = 1.0, .preserve_jitter = false };
+    replay_stats_t stats;
+    hust_record_t rec;
+    const char * rec_path = NULL;
+
+    for(int i = 0; i < argc; i++)
+    {
+        if(strcmp(argv[i], "-s") == 0 && i + 1 < argc)
+        {
+            cfg.speed = atof(argv[++i]);
+        }
+        else if(strcmp(argv[i], "-m") == 0)
+        {
+            cfg.speed = 0;
+        }
+        else if(strcmp(argv[i], "-j") == 0)
+        {
+            cfg.preserve_jitter = true;
+        }
+        else if(strcmp(argv[i], "-r") == 0 && i + 1 < argc)
+        {
+            rec_path = argv[++i];
+        }
+        else
+        {
+            usage();
+            return 1;
+        }
+    }
+
+    if(hust_capture_open(&cap, path) != 0)
+    {
+        perror(path);
+        return 1;
+    }
+    memset(&stats, 0, sizeof(stats));
+    for(int i = 0; i < HUST_STREAM_COUNT; i++)
+    {
+        hust_sched_timeline_init(&stats.stream[i].timeline, stream_rate[i]);
+    }
+    if(rec_path != NULL)
+    {
+        if(hust_record_create(&rec, rec_path, ECG_CHANNEL, 1000, true) != 0)
+        {
+            perror(rec_path);
+            hust_capture_close(&cap);
+            return 1;
+        }
+        stats.rec = &rec;
+    }
+
+    uint64_t t0 = hust_time_us();
+    int err = hust_capture_replay(&cap, &cfg, replay_handler, &stats);
+    uint64_t elapsed = hust_time_us() - t0;
+    if(stats.rec != NULL)
+    {
+        err |= hust_record_close(stats.rec);
+    }
+    hust_capture_close(&cap);
+
+    printf("packets        %llu\n", (unsigned long long)stats.packets);
+    printf("bytes          %llu\n", (unsigned long long)stats.bytes);
+    printf("decode_errors  %llu\n", (unsigned long long)stats.decode_errors);
+    printf("lost           %llu\n", (unsigned long long)stats.lost);
+    printf("responses      %llu\n", (unsigned long long)stats.responses);
+    printf("elapsed_us     %llu\n", (unsigned long long)elapsed);
+    printf("decode_us      %llu\n", (unsigned long long)stats.decode_us);
+    if(stats.decode_us > 0)
+    {
+        printf("decode_pps     %.0f\n", (double)stats.packets * 1e6 / (double)stats.decode_us);
+    }
+    for(int i = 0; i < HUST_STREAM_COUNT; i++)
+    {
+        const replay_stream_t * stream = &stats.stream[i];
+        if(stream->samples > 0)
+        {
+            printf("stream_%s     %llu samples, %llu lost, %.3f Hz\n", stream_name[i], (unsigned long long)stream->samples,
+                   (unsigned long long)stream->gaps, stream->timeline.rate);
+        }
+    }
+    return err == 0 ? 0 : 1;
+}
+
+static int info(const char * path)
+{
+    hust_capture_t cap;
+    if(hust_capture_open(&cap, path) != 0)
+    {
+        perror(path);
+        return 1;
+    }
+    double duration = (double)(cap.t_last_us - cap.t_first_us) / 1e6;
+    printf("packets   %llu\n", (unsigned long long)cap.count);
+    printf("duration  %.3f s\n", duration);
+    if(duration > 0)
+    {
+        printf("rate      %.1f packet/s\n", (double)(cap.count - 1) / duration);
+    }
+    hust_capture_close(&cap);
+    return 0;
+}
+
+int main(int argc, char ** argv)
+{
+    if(argc < 3)
+    {
+        usage();
+        return 1;
+    }
+    if(strcmp(argv[1], "capture") == 0)
+    {
+        return capture(argv[2]);
+    }
+    if(strcmp(argv[1], "replay") == 0)
+    {
+        return replay(argv[2], argc - 3, argv + 3);
+    }
+    if(strcmp(argv[1], "info") == 0)
+    {
+        return info(argv[2]);
+    }
+    usage();
+    return 1;
+}
@@ -0,0 +1,168 @@
+/*
+ * Kiem tra dong ho lay mau hust_sample_clock voi RTC 24 bit 16384 Hz mo phong, nhu ecg_timer_timeout_handler
+ * trong main.c: moi lan timeout doc bo dem (tre ngat 0..2 tick), hust_sample_clock_advance roi hen gio lai
+ * bang hust_sample_clock_wait.
+ *
+ *   hust_sample_clock_bench [-t hours] [-v]
+ *
+ * Chay 250 / 500 / 1000 / 2000 Hz, moi sample 1 timeout (tick_hz 16384) va moi block 1 timeout (tick_hz
+ * 16384 x HUST_ACQ_BUFFER_FRAMES, nhu nguon gia lap), mac dinh 24 h thoi gian mo phong (~84 vong RTC).
+ * Thinh thoang timeout bi tre (SoftDevice chiem CPU), co lan tre hon 1 chu ky.
+ * Kiem tra: moi moc = anchor + hust_sample_clock_tick_of(n); timeout khong tre ra dung moc do (ke ca qua
+ * vong RTC); timeout tre hon 1 chu ky tinh vao late va dong ho quay lai dung luoi moc; sau >= 24 h so
+ * sample = rate x thoi gian va sai so tich luy < 1 tick (khong troi). Tra ve 1 neu co loi.
+ *
+ * In ra: so timeout, tre, tre > 1 chu ky, sai so cuoi (tick), troi cua cach hen gio chu ky nguyen truoc day.
+ *
+ * Build: cc -O2 -I../HUST_BLE hust_sample_clock_bench.c ../HUST_BLE/hust_sample_clock.c
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "hust_sample_clock.h"
+
+#define BUFFER_FRAMES       32          // HUST_ACQ_BUFFER_FRAMES (hust_acq.h can SDK)
+#define LATE_EVERY          4096        // ~1 / LATE_EVERY timeout bi tre
+#define LATE_MAX_PERIODS    3           // tre toi da 3 chu ky
+
+static int failures = 0;
+static int verbose = 0;
+static double hours = 24;
+
+#define CHECK(cond, ...) do { if(!(cond)) { failures++; fprintf(stderr, "FAIL: " __VA_ARGS__); fprintf(stderr, "\n"); } } while(0)
+
+static uint32_t rng = 1;
+
+static uint32_t rng_next(void)
+{
+    // xorshift32, nhanh hon rand() cho hang tram trieu timeout
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+static void clock_run(uint32_t rate, uint32_t frames)
+{
+    const uint32_t mask = HUST_SAMPLE_CLOCK_RTC_MASK;
+    const uint32_t tick_hz = HUST_SAMPLE_CLOCK_RTC_HZ * frames;
+    const uint64_t t_end = (uint64_t)(hours * 3600 * HUST_SAMPLE_CLOCK_RTC_HZ);
+    hust_sample_clock_t clock;
+    uint64_t t = mask - 1000;            // RTC sap qua vong ngay tu dau
+    uint64_t t0 = t;
+    uint32_t now = (uint32_t)(t & mask);
+    uint64_t timeouts = 0;
+    uint64_t delayed = 0;
+    uint64_t off_grid = 0;
+    uint64_t bad_deadline = 0;
+    uint64_t clamped = 0;
+
+    rng = 1;
+    if(hust_sample_clock_init(&clock, tick_hz, rate, now) != 0)
+    {
+        CHECK(0, "%u Hz x %u: init that bai", rate, frames);
+        return;
+    }
+    uint32_t period = clock.tick_int;
+    uint32_t wait = hust_sample_clock_wait(&clock, now, mask);
+    uint64_t t_fire = t + wait;
+    bool on_time = true;                    // timeout ra dung moc (khong tre, hen gio khong bi kep)
+
+    while(t_fire - t0 < t_end)
+    {
+        // ngat: tre ngat 0..2 tick, thinh thoang tre them toi LATE_MAX_PERIODS chu ky
+        t = t_fire + rng_next() % 3;
+        if(rng_next() % LATE_EVERY == 0)
+        {
+            t += rng_next() % (LATE_MAX_PERIODS * period);
+            on_time = false;
+            delayed++;
+        }
+        now = (uint32_t)(t & mask);
+        uint64_t index = hust_sample_clock_advance(&clock, now, mask);
+        timeouts++;
+        if(on_time && t_fire - t0 != hust_sample_clock_tick_of(tick_hz, rate, index))
+        {
+            off_grid++;
+        }
+        if(clock.deadline - t0 != hust_sample_clock_tick_of(tick_hz, rate, clock.sample_index))
+        {
+            bad_deadline++;
+        }
+        wait = hust_sample_clock_wait(&clock, now, mask);
+        on_time = clock.deadline - t0 == (t - t0) + wait;
+        clamped += !on_time;
+        t_fire = t + wait;
+    }
+
+    // sau t_end: moc ke tiep la sample dau tien chua den, so sample da lay = rate x thoi gian
+    double ideal = (double)(clock.sample_index + 1) * tick_hz / rate;
+    double error = (double)(clock.deadline - t0) - ideal;
+    double expected = (double)t_end * rate / tick_hz;
+    // hen gio chu ky nguyen (tick_int moi lan): cung so timeout thi lech bao nhieu giay
+    double naive_drift_s = ((double)clock.sample_index * period - (double)clock.sample_index * tick_hz / rate)
+                           / HUST_SAMPLE_CLOCK_RTC_HZ;
+
+    printf("%4u Hz x %2u  timeouts %10llu  delayed %6llu  late %6u  clamped %6llu  error %+.3f tick  "
+           "fixed period drift %+.1f s\n", rate, frames, (unsigned long long)timeouts, (unsigned long long)delayed,
+           clock.late, (unsigned long long)clamped, error, naive_drift_s);
+    if(verbose)
+    {
+        printf("             tick_int %u  tick_rem %u  samples %llu  expected %.1f\n", clock.tick_int,
+               clock.tick_rem, (unsigned long long)clock.sample_index, expected);
+    }
+    CHECK(bad_deadline == 0, "%u Hz x %u: %llu moc khac anchor + tick_of(n)", rate, frames,
+          (unsigned long long)bad_deadline);
+    CHECK(off_grid == 0, "%u Hz x %u: %llu timeout khong tre lech moc", rate, frames, (unsigned long long)off_grid);
+    CHECK(error > -1.0 && error < 1.0, "%u Hz x %u: sai so tich luy %.3f tick", rate, frames, error);
+    CHECK(clock.sample_index + 1 >= expected && clock.sample_index <= expected + 1,
+          "%u Hz x %u: %llu sample sau %.0f h, phai %.1f", rate, frames, (unsigned long long)clock.sample_index,
+          hours, expected);
+    CHECK(timeouts == clock.sample_index, "%u Hz x %u: timeouts %llu != sample %llu", rate, frames,
+          (unsigned long long)timeouts, (unsigned long long)clock.sample_index);
+    if(delayed > 0)
+    {
+        CHECK(clock.late > 0 && clamped > 0, "%u Hz x %u: timeout tre hon 1 chu ky khong tinh late", rate, frames);
+    }
+}
+
+int main(int argc, char ** argv)
+{
+    for(int i = 1; i < argc; i++)
+    {
+        if(strcmp(argv[i], "-t") == 0 && i + 1 < argc)
+        {
+            hours = atof(argv[++i]);
+        }
+        else if(strcmp(argv[i], "-v") == 0)
+        {
+            verbose = 1;
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [-t hours] [-v]\n", argv[0]);
+            return 2;
+        }
+    }
+    if(hours <= 0)
+    {
+        fprintf(stderr, "hours > 0\n");
+        return 2;
+    }
+
+    static const uint32_t rates[] = {250, 500, 1000, 2000};
+    for(size_t i = 0; i < sizeof(rates) / sizeof(rates[0]); i++)
+    {
+        clock_run(rates[i], 1);
+        clock_run(rates[i], BUFFER_FRAMES);
+    }
+    // rate ma 1 chu ky < HUST_SAMPLE_CLOCK_MIN_TICKS tick phai bi tu choi
+    hust_sample_clock_t clock;
+    CHECK(hust_sample_clock_init(&clock, HUST_SAMPLE_CLOCK_RTC_HZ, 4000, 0) != 0, "4000 Hz x 1 khong bi tu choi");
+    CHECK(hust_sample_clock_init(&clock, HUST_SAMPLE_CLOCK_RTC_HZ, 0, 0) != 0, "rate 0 khong bi tu choi");
+    printf("%.0f h simulated, RTC %d Hz 24 bit\n", hours, HUST_SAMPLE_CLOCK_RTC_HZ);
+    printf("%s\n", failures == 0 ? "PASS" : "FAIL");
+    return failures != 0;
+}
@@ -0,0 +1,387 @@
+/*
+ * Kiem tra va do hieu qua packet nhieu stream (ALL_SENSOR_TYPE, hust_sched) voi ECG + IMU mo phong.
+ *
+ *   hust_sched_bench [-e ecg_rate] [-i imu_rate] [-d imu_drift_ppm] [-m mtu] [-t seconds] [-c channel_mask]
+ *
+ * Mac dinh: ECG 1000 Hz (block DMA 32 sample), IMU 104 Hz danh nghia lech +12000 ppm (burst FIFO 16
+ * sample, tre ngat 0..2 tick), MTU 247, 60 s. Thiet bi dong goi nhu all_packet_process trong main.c,
+ * host giai ma bang hust_sched_seg_read + hust_sched_timeline_t.
+ * Kiem tra: moi sample cua ca 2 stream nhan du 1 lan, dung thu tu va gia tri; sai so thoi gian tung
+ * sample host tinh lai so voi thoi diem lay mau that (sau 2 s dau) < 1 tick RTC + tre ngat. Tra ve 1 neu co loi.
+ * channel_mask (hex, bo tri ble_packet_t.channel_mask, mac dinh 7f): channel tat khong nam trong segment,
+ * host nhan 0. Truoc mo phong con kiem tra packet ECG_SENSOR_TYPE / IMU_SENSOR_TYPE voi moi mask
+ * (so sample / packet, data_size, giai ma lai dung).
+ *
+ * Hieu qua: packet/s, sample moi stream / packet, % payload dung cho sample, so voi layout co dinh
+ * 3 ECG + 2 IMU truoc day (can bao nhieu packet/s de mang ECG, IMU bi lap / thieu bao nhieu).
+ *
+ * Build: cc -O2 -DHUST_HOST_BUILD -I../HUST_BLE hust_sched_bench.c ../HUST_BLE/hust_sched.c ../HUST_BLE/hust_ble.c
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "hust_sched.h"
+#include "hust_sample_clock.h"
+
+#define BENCH_ECG_BLOCK     32          // = HUST_ACQ_BUFFER_FRAMES
+#define BENCH_IMU_BURST     16          // = HUST_IMU_WATERMARK
+#define BENCH_RING          1024
+#define BENCH_WARMUP_S      2.0
+
+static int failures = 0;
+
+#define CHECK(cond, ...) do { if(!(cond)) { failures++; fprintf(stderr, "FAIL: " __VA_ARGS__); fprintf(stderr, "\n"); } } while(0)
+
+typedef struct
+{
+    uint64_t index[BENCH_RING];
+    uint32_t tick[BENCH_RING];          // ECG: t_acq uoc luong nhu firmware
+    uint32_t head;
+    uint32_t tail;
+} bench_ring_t;
+
+static void usage(void)
+{
+    fprintf(stderr, "usage: hust_sched_bench [-e ecg_rate] [-i imu_rate] [-d imu_drift_ppm] [-m mtu] [-t seconds] [-c channel_mask]\n");
+}
+
+static int32_t ecg_value(uint64_t k, int ch)
+{
+    return (int32_t)((k * 2654435761u + (uint64_t)ch * 40503u) & 0xFFFFFF) - 0x800000;
+}
+
+static int16_t imu_value(uint64_t k, int a)
+{
+    return (int16_t)(uint16_t)(k * 37 + (uint64_t)a * 11113 + 0x8000);
+}
+
+static void ring_push(bench_ring_t * ring, uint64_t index, uint32_t tick)
+{
+    if(ring->head - ring->tail >= BENCH_RING)
+    {
+        CHECK(0, "bench ring overflow");
+        return;
+    }
+    ring->index[ring->head % BENCH_RING] = index;
+    ring->tick[ring->head % BENCH_RING] = tick;
+    ring->head++;
+}
+
+// dong goi roi giai ma lai 1 packet ECG_SENSOR_TYPE hoac IMU_SENSOR_TYPE voi channel_mask, tra ve so sample
+static int mask_roundtrip(sensor_type_t sensor_type, uint8_t channel_mask)
+{
+    ecg_data_t ecg[ECG_SAMPLE_MAX], ecg_rx[ECG_SAMPLE_MAX];
+    imu_data_t imu[IMU_SAMPLE_MAX], imu_rx[IMU_SAMPLE_MAX];
+    ble_packet_t tx, rx;
+    uint8_t * packet;
+
+    memset(&tx, 0, sizeof(tx));
+    tx.sensor_type = sensor_type;
+    tx.channel_mask = channel_mask;
+    tx.ecg_data = ecg;
+    tx.imu_data = imu;
+    sample_transfer_t n = set_sample_transfer(tx);
+    for(int k = 0; k < n.ecg_sample; k++)
+    {
+        for(int ch = 0; ch < ECG_CHANNEL; ch++)
+        {
+            *ecg_channel_get(&ecg[k], ch) = int32_to_ecg_sample(ecg_value(k, ch));
+        }
+    }
+    for(int k = 0; k < n.imu_sample; k++)
+    {
+        for(int a = 0; a < IMU_CHANNEL; a++)
+        {
+            *imu_channel_get(&imu[k], a) = int16_to_imu_sample(imu_value(k, a));
+        }
+    }
+    tx.data_size = (uint8_t)ble_packet_data_size(tx);
+    CHECK(tx.data_size <= (sensor_type == ECG_SENSOR_TYPE ? ECG_DATA_CAPACITY : IMU_DATA_CAPACITY),
+          "mask %02x data_size %d", channel_mask, tx.data_size);
+    convert_data_to_ble_packet(tx, &packet);
+
+    rx.ecg_data = ecg_rx;
+    rx.imu_data = imu_rx;
+    if(convert_ble_packet_to_data(packet, BLE_PACKET_HEADER_SIZE + tx.data_size, &rx) != 0)
+    {
+        CHECK(0, "mask %02x decode", channel_mask);
+        free(packet);
+        return 0;
+    }
+    CHECK(rx.sensor_type == sensor_type && rx.data_size == tx.data_size, "mask %02x header", channel_mask);
+    for(int k = 0; k < n.ecg_sample; k++)
+    {
+        for(int ch = 0; ch < ECG_CHANNEL; ch++)
+        {
+            int32_t expected = (channel_mask & (1 << ch)) ? ecg_value(k, ch) : 0;
+            CHECK(ecg_sample_to_int32(*ecg_channel_get(&ecg_rx[k], ch)) == expected, "mask %02x ecg %d ch %d", channel_mask, k, ch);
+        }
+    }
+    for(int k = 0; k < n.imu_sample; k++)
+    {
+        for(int a = 0; a < IMU_CHANNEL; a++)
+        {
+            int16_t expected = (channel_mask & (1 << (IMU_CHANNEL_MASK_SHIFT + a))) ? imu_value(k, a) : 0;
+            CHECK(imu_sample_to_int16(*imu_channel_get(&imu_rx[k], a)) == expected, "mask %02x imu %d axis %d", channel_mask, k, a);
+        }
+    }
+    free(packet);
+    return n.ecg_sample + n.imu_sample;
+}
+
+int main(int argc, char ** argv)
+{
+    double ecg_rate = 1000;
+    double imu_rate = 104;
+    double drift_ppm = 12000;
+    int mtu = 247;
+    double seconds = 60;
+    uint8_t channel_mask = CHANNEL_MASK_ALL;
+
+    for(int i = 1; i < argc; i++)
+    {
+        if(strcmp(argv[i], "-e") == 0 && i + 1 < argc)
+        {
+            ecg_rate = atof(argv[++i]);
+        }
+        else if(strcmp(argv[i], "-i") == 0 && i + 1 < argc)
+        {
+            imu_rate = atof(argv[++i]);
+        }
+        else if(strcmp(argv[i], "-d") == 0 && i + 1 < argc)
+        {
+            drift_ppm = atof(argv[++i]);
+        }
+        else if(strcmp(argv[i], "-m") == 0 && i + 1 < argc)
+        {
+            mtu = atoi(argv[++i]);
+        }
+        else if(strcmp(argv[i], "-t") == 0 && i + 1 < argc)
+        {
+            seconds = atof(argv[++i]);
+        }
+        else if(strcmp(argv[i], "-c") == 0 && i + 1 < argc)
+        {
+            channel_mask = (uint8_t)strtoul(argv[++i], NULL, 16);
+        }
+        else
+        {
+            usage();
+            return 1;
+        }
+    }
+    if(ecg_rate <= 0 || imu_rate <= 0 || mtu < 23 || seconds <= BENCH_WARMUP_S
+       || ecg_channel_count(channel_mask) == 0 || imu_channel_count(channel_mask) == 0)
+    {
+        usage();
+        return 1;
+    }
+
+    // packet 1 stream: so sample / packet theo so channel bat
+    printf("mask   ecg/packet by channels:");
+    for(uint8_t m = 1; m <= ECG_CHANNEL_MASK_ALL; m++)
+    {
+        int n = mask_roundtrip(ECG_SENSOR_TYPE, (uint8_t)(m | IMU_CHANNEL_MASK_ALL));
+        if(m == 0x01 || m == 0x03 || m == 0x07 || m == ECG_CHANNEL_MASK_ALL)
+        {
+            printf(" %d:%d", ecg_channel_count(m), n);
+        }
+    }
+    printf("  imu/packet by axes:");
+    for(uint8_t m = 1; m <= (IMU_CHANNEL_MASK_ALL >> IMU_CHANNEL_MASK_SHIFT); m++)
+    {
+        int n = mask_roundtrip(IMU_SENSOR_TYPE, (uint8_t)(ECG_CHANNEL_MASK_ALL | (m << IMU_CHANNEL_MASK_SHIFT)));
+        if(m == 1 || m == 3 || m == 7)
+        {
+            printf(" %d:%d", imu_channel_count((uint8_t)(m << IMU_CHANNEL_MASK_SHIFT)), n);
+        }
+    }
+    printf("\n");
+
+    double imu_true = imu_rate * (1 + drift_ppm * 1e-6);
+    double t0 = 12.345;                 // RTC khong bat dau tu 0, co wrap 24 bit trong 1024 s
+    int capacity = mtu - 3 - BLE_PACKET_HEADER_SIZE;
+    bench_ring_t ecg_ring = {0}, imu_ring = {0};
+    uint64_t ecg_made = 0, imu_made = 0;
+    uint64_t ecg_next = 0, imu_next = 0;    // sample ke tiep host cho
+    uint64_t packets = 0, ecg_sent = 0, imu_sent = 0, payload = 0;
+    double ecg_err = 0, imu_err = 0;
+    uint64_t anchor_index = 0;
+    uint32_t anchor_tick = 0;
+    hust_sched_timeline_t tl[HUST_STREAM_COUNT];
+    unsigned seed = 1;
+
+    hust_sched_timeline_init(&tl[HUST_STREAM_ECG], ecg_rate);
+    hust_sched_timeline_init(&tl[HUST_STREAM_IMU], imu_rate);
+
+    for(double t = 0; t < seconds; t += 0.0005)
+    {
+        double now = t0 + t;
+        uint32_t now_tick = (uint32_t)(now * HUST_SAMPLE_CLOCK_RTC_HZ);
+
+        // ECG: ngat DMA moi BENCH_ECG_BLOCK sample, t_acq uoc luong lui tu luc ngat (nhu saadc_buffer_handler)
+        while((double)(ecg_made + BENCH_ECG_BLOCK) / ecg_rate <= t)
+        {
+            uint32_t irq = (uint32_t)((t0 + (double)(ecg_made + BENCH_ECG_BLOCK - 1) / ecg_rate) * HUST_SAMPLE_CLOCK_RTC_HZ);
+            for(int i = 0; i < BENCH_ECG_BLOCK; i++)
+            {
+                uint32_t tick = irq - (uint32_t)(((BENCH_ECG_BLOCK - 1 - i) * HUST_SAMPLE_CLOCK_RTC_HZ) / (uint32_t)ecg_rate);
+                ring_push(&ecg_ring, ecg_made + i, tick);
+            }
+            ecg_made += BENCH_ECG_BLOCK;
+        }
+        // IMU: ngat watermark moi BENCH_IMU_BURST sample, tre 0..2 tick
+        while((double)(imu_made + BENCH_IMU_BURST) / imu_true <= t)
+        {
+            for(int i = 0; i < BENCH_IMU_BURST; i++)
+            {
+                ring_push(&imu_ring, imu_made + i, 0);
+            }
+            imu_made += BENCH_IMU_BURST;
+            seed = seed * 1103515245u + 12345u;
+            anchor_index = imu_made - 1;
+            anchor_tick = (uint32_t)((t0 + (double)anchor_index / imu_true) * HUST_SAMPLE_CLOCK_RTC_HZ) + (seed >> 16) % 3;
+        }
+        (void)now_tick;
+
+        // dong goi nhu all_packet_process
+        for(;;)
+        {
+            hust_sched_stream_t streams[HUST_STREAM_COUNT] =
+            {
+                {hust_sched_stream_byte(HUST_STREAM_ECG, channel_mask), (uint16_t)ecg_rate, (uint16_t)(ecg_ring.head - ecg_ring.tail)},
+                {hust_sched_stream_byte(HUST_STREAM_IMU, channel_mask), (uint16_t)imu_rate, (uint16_t)(imu_ring.head - imu_ring.tail)}
+            };
+            uint8_t take[HUST_STREAM_COUNT];
+            uint8_t data[HUST_SCHED_MAX_DATA_SIZE];
+            uint8_t * p = data;
+            bool full;
+            int data_size = hust_sched_plan(streams, HUST_STREAM_COUNT, capacity, take, &full);
+            if(!full || data_size == 0)
+            {
+                break;
+            }
+            for(int i = 0; i < take[HUST_STREAM_ECG]; i++, ecg_ring.tail++)
+            {
+                uint64_t k = ecg_ring.index[ecg_ring.tail % BENCH_RING];
+                if(i == 0)
+                {
+                    hust_sched_seg_header(p, streams[HUST_STREAM_ECG].stream, take[HUST_STREAM_ECG], k, (uint16_t)ecg_rate,
+                                          k, ecg_ring.tick[ecg_ring.tail % BENCH_RING]);
+                    p += HUST_SCHED_SEG_HEADER;
+                }
+                for(int ch = 0; ch < ECG_CHANNEL; ch++)
+                {
+                    if(channel_mask & (1 << ch))
+                    {
+                        memcpy(p, int32_to_ecg_sample(ecg_value(k, ch)).byte, ECG_DATA_LENGTH);
+                        p += ECG_DATA_LENGTH;
+                    }
+                }
+            }
+            for(int i = 0; i < take[HUST_STREAM_IMU]; i++, imu_ring.tail++)
+            {
+                uint64_t k = imu_ring.index[imu_ring.tail % BENCH_RING];
+                if(i == 0)
+                {
+                    hust_sched_seg_header(p, streams[HUST_STREAM_IMU].stream, take[HUST_STREAM_IMU], k, (uint16_t)imu_rate,
+                                          anchor_index, anchor_tick);
+                    p += HUST_SCHED_SEG_HEADER;
+                }
+                for(int a = 0; a < IMU_CHANNEL; a++)
+                {
+                    if(channel_mask & (1 << (IMU_CHANNEL_MASK_SHIFT + a)))
+                    {
+                        memcpy(p, int16_to_imu_sample(imu_value(k, a)).byte, IMU_DATA_LENGTH);
+                        p += IMU_DATA_LENGTH;
+                    }
+                }
+            }
+            CHECK(p - data == data_size, "plan size %d, packed %d", data_size, (int)(p - data));
+            packets++;
+
+            // host
+            for(int offset = 0; offset < data_size; )
+            {
+                hust_sched_seg_t seg;
+                int length = hust_sched_seg_read(data + offset, data_size - offset, &seg);
+                if(length < 0)
+                {
+                    CHECK(0, "segment decode at %d", offset);
+                    break;
+                }
+                uint64_t index = hust_sched_timeline_anchor(&tl[seg.stream], &seg);
+                for(int j = 0; j < seg.n; j++)
+                {
+                    uint64_t k = index + j;
+                    double t_true, err;
+                    if(seg.stream == HUST_STREAM_ECG)
+                    {
+                        ecg_data_t ecg;
+                        hust_sched_ecg_get(&seg, j, &ecg);
+                        CHECK(k == ecg_next, "ecg index %llu, expected %llu", (unsigned long long)k, (unsigned long long)ecg_next);
+                        for(int ch = 0; ch < ECG_CHANNEL; ch++)
+                        {
+                            int32_t expected = (channel_mask & (1 << ch)) ? ecg_value(k, ch) : 0;
+                            CHECK(ecg_sample_to_int32(*ecg_channel_get(&ecg, ch)) == expected, "ecg value %llu", (unsigned long long)k);
+                        }
+                        ecg_next = k + 1;
+                        t_true = t0 + (double)k / ecg_rate;
+                    }
+                    else
+                    {
+                        imu_data_t imu;
+                        hust_sched_imu_get(&seg, j, &imu);
+                        CHECK(k == imu_next, "imu index %llu, expected %llu", (unsigned long long)k, (unsigned long long)imu_next);
+                        for(int a = 0; a < IMU_CHANNEL; a++)
+                        {
+                            int16_t expected = (channel_mask & (1 << (IMU_CHANNEL_MASK_SHIFT + a))) ? imu_value(k, a) : 0;
+                            CHECK(imu_sample_to_int16(*imu_channel_get(&imu, a)) == expected, "imu value %llu", (unsigned long long)k);
+                        }
+                        imu_next = k + 1;
+                        t_true = t0 + (double)k / imu_true;
+                    }
+                    err = fabs(hust_sched_timeline_time(&tl[seg.stream], k) - t_true);
+                    if(t_true - t0 >= BENCH_WARMUP_S)
+                    {
+                        double * max_err = seg.stream == HUST_STREAM_ECG ? &ecg_err : &imu_err;
+                        *max_err = err > *max_err ? err : *max_err;
+                    }
+                }
+                if(seg.stream == HUST_STREAM_ECG)
+                {
+                    ecg_sent += seg.n;
+                }
+                else
+                {
+                    imu_sent += seg.n;
+                }
+                payload += (uint64_t)seg.n * seg.sample_size;
+                offset += length;
+            }
+        }
+    }
+
+    double tick_s = 1.0 / HUST_SAMPLE_CLOCK_RTC_HZ;
+    CHECK(ecg_made - ecg_sent < 255 && imu_made - imu_sent < 255, "samples left behind: ecg %llu imu %llu",
+          (unsigned long long)(ecg_made - ecg_sent), (unsigned long long)(imu_made - imu_sent));
+    CHECK(ecg_err < 1.5 * tick_s, "ecg time error %.1f us", ecg_err * 1e6);
+    CHECK(imu_err < 3.5 * tick_s, "imu time error %.1f us", imu_err * 1e6);
+    CHECK(fabs(tl[HUST_STREAM_IMU].rate - imu_true) < imu_true * 1e-4, "imu rate %.4f, true %.4f",
+          tl[HUST_STREAM_IMU].rate, imu_true);
+
+    double ecg_per_pkt = (double)ecg_sent / packets;
+    double imu_per_pkt = (double)imu_sent / packets;
+    printf("ecg %.0f Hz, imu %.0f Hz (+%.0f ppm -> %.3f Hz), mtu %d, %.0f s, mask %02x\n", ecg_rate, imu_rate, drift_ppm,
+           imu_true, mtu, seconds, channel_mask);
+    printf("sched  %8.1f packet/s  %5.2f ecg + %5.2f imu / packet  payload %5.1f%% of %d byte\n",
+           packets / seconds, ecg_per_pkt, imu_per_pkt, 100.0 * payload / ((double)packets * capacity), capacity);
+    printf("fixed  %8.1f packet/s  %5d ecg + %5d imu / packet  payload %5.1f%% of %d byte, imu sent %.0f/s for %.0f Hz\n",
+           ecg_rate / 3, 3, 2, 100.0 * (3 * 12 + 2 * 6) / capacity, capacity, ecg_rate / 3 * 2, imu_true);
+    printf("time   max error ecg %.1f us, imu %.1f us (tick %.1f us), imu rate %.4f Hz\n",
+           ecg_err * 1e6, imu_err * 1e6, tick_s * 1e6, tl[HUST_STREAM_IMU].rate);
+    printf("%s\n", failures == 0 ? "PASS" : "FAIL");
+    return failures == 0 ? 0 : 1;
+}
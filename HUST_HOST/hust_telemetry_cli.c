@@ -0,0 +1,221 @@
+/*
+ * Theo doi characteristic telemetry cua thiet bi trong luc chay tai.
+ *
+ *   hust_telemetry_cli [-e "cmd"] [-i ms] [-n count] [-k kbps_full_scale] [-o out.tsv]
+ *
+ * Khong co -e: doc gia tri characteristic (hex, moi dong 1 gia tri) tu stdin, vi du notification
+ * do 1 cau noi BLE in ra. Co -e: chay lenh cmd moi -i ms (mac dinh 1000) de doc characteristic,
+ * lenh phai in gia tri hex ra stdout (vd. gatttool --char-read ...).
+ *
+ * Moi mau in 1 dong: bo dem, so tang so voi mau truoc, va bieu do cot throughput (ASCII).
+ *
+ * Build: cc -DHUST_HOST_BUILD -I../HUST_BLE hust_telemetry_cli.c hust_capture.c ../HUST_BLE/hust_telemetry.c
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+
+#include "hust_telemetry.h"
+#include "hust_capture.h"
+
+#define CHART_WIDTH 40
+
+static void usage(void)
+{
+    fprintf(stderr, "usage: hust_telemetry_cli [-e \"cmd\"] [-i ms] [-n count] [-k kbps_full_scale] [-o out.tsv]\n");
+}
+
+static int parse_hex_line(const char * line, uint8_t * data, int max_len)
+{
+    int length = 0;
+    int nibble = -1;
+    for(const char * p = line; *p != '\0'; p++)
+    {
+        if(!isxdigit((unsigned char)*p))
+        {
+            continue;
+        }
+        int v = isdigit((unsigned char)*p) ? *p - '0' : tolower((unsigned char)*p) - 'a' + 10;
+        if(nibble < 0)
+        {
+            nibble = v;
+        }
+        else
+        {
+            if(length >= max_len)
+            {
+                return -1;
+            }
+            data[length++] = (uint8_t)((nibble << 4) | v);
+            nibble = -1;
+        }
+    }
+    return nibble < 0 ? length : -1;
+}
+
+// doc 1 gia tri telemetry tu stdin hoac tu output cua lenh cmd
+static int read_sample(const char * cmd, hust_telemetry_t * telemetry)
+{
+    char line[256];
+    uint8_t data[64];
+    FILE * in = stdin;
+
+    if(cmd != NULL)
+    {
+        in = popen(cmd, "r");
+        if(in == NULL)
+        {
+            return -1;
+        }
+    }
+    int err = 1;
+    while(fgets(line, sizeof(line), in) != NULL)
+    {
+        // bo qua phan "Characteristic value/descriptor:" cua gatttool
+        const char * p = strchr(line, ':');
+        int length = parse_hex_line(p != NULL ? p + 1 : line, data, sizeof(data));
+        if(length > 0 && hust_telemetry_decode(data, length, telemetry) == 0)
+        {
+            err = 0;
+            break;
+        }
+    }
+    if(cmd != NULL)
+    {
+        pclose(in);
+    }
+    return err;
+}
+
+static const char * phy_name(uint8_t phy)
+{
+    switch(phy)
+    {
+        case 1: return "1M";
+        case 2: return "2M";
+        case 4: return "CD";
+        default: return "--";
+    }
+}
+
+static void sleep_ms(int ms)
+{
+    struct timespec ts = { .tv_sec = ms / 1000, .tv_nsec = (long)(ms % 1000) * 1000000L };
+    nanosleep(&ts, NULL);
+}
+
+int main(int argc, char ** argv)
+{
+    const char * cmd = NULL;
+    const char * tsv_path = NULL;
+    int interval_ms = 1000;
+    long max_count = -1;
+    double full_scale_kbps = 1000;
+    FILE * tsv = NULL;
+
+    for(int i = 1; i < argc; i++)
+    {
+        if(strcmp(argv[i], "-e") == 0 && i + 1 < argc)
+        {
+            cmd = argv[++i];
+        }
+        else if(strcmp(argv[i], "-i") == 0 && i + 1 < argc)
+        {
+            interval_ms = atoi(argv[++i]);
+        }
+        else if(strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+        {
+            max_count = atol(argv[++i]);
+        }
+        else if(strcmp(argv[i], "-k") == 0 && i + 1 < argc)
+        {
+            full_scale_kbps = atof(argv[++i]);
+        }
+        else if(strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+        {
+            tsv_path = argv[++i];
+        }
+        else
+        {
+            usage();
+            return 1;
+        }
+    }
+    if(tsv_path != NULL)
+    {
+        tsv = fopen(tsv_path, "w");
+        if(tsv == NULL)
+        {
+            perror(tsv_path);
+            return 1;
+        }
+        fprintf(tsv, "t_ms\tacquired\tdropped\tbuilt\tsent\tresources\terrors\tbytes\tthroughput_bps\tmtu\ttx_phy\trx_phy\thvn_inflight\thvn_high_water\tring_high_water\thistory_ms\thistory_capacity_ms\thvn_tx_queue\tevent_length\tconn_interval\n");
+    }
+
+    printf("%8s %9s %7s %7s %7s %6s %4s %4s %4s %5s %5s %6s %6s %6s %11s %8s  %s\n",
+           "t_s", "acquired", "drop+", "sent+", "res+", "err+", "hvnQ", "hvnH", "ring", "mtu", "phy",
+           "ci_ms", "hvnCfg", "evt_ms", "history_s", "kbps", "throughput");
+
+    hust_telemetry_t telemetry;
+    hust_telemetry_t last = {0};
+    bool have_last = false;
+    uint64_t t0 = hust_time_us();
+    for(long n = 0; max_count < 0 || n < max_count; n++)
+    {
+        int err = read_sample(cmd, &telemetry);
+        if(err < 0 || (err > 0 && cmd == NULL))
+        {
+            break;                      // het stdin / loi chay lenh
+        }
+        if(err == 0)
+        {
+            uint64_t t_ms = (hust_time_us() - t0) / 1000;
+            double kbps = telemetry.throughput_bps / 1000.0;
+            int bar = (int)(kbps * CHART_WIDTH / full_scale_kbps + 0.5);
+            char chart[CHART_WIDTH + 2];
+
+            bar = bar > CHART_WIDTH ? CHART_WIDTH + 1 : bar;
+            memset(chart, '#', bar);
+            if(bar > CHART_WIDTH)
+            {
+                chart[CHART_WIDTH] = '>';
+            }
+            chart[bar] = '\0';
+
+            printf("%8.1f %9u %7u %7u %7u %6u %4u %4u %4u %5u %2s/%2s %6.2f %6u %6.2f %5.1f/%5.1f %8.1f  %s\n",
+                   t_ms / 1000.0, telemetry.samples_acquired,
+                   have_last ? telemetry.samples_dropped - last.samples_dropped : telemetry.samples_dropped,
+                   have_last ? telemetry.packets_sent - last.packets_sent : telemetry.packets_sent,
+                   have_last ? telemetry.nus_resources - last.nus_resources : telemetry.nus_resources,
+                   have_last ? telemetry.nus_errors - last.nus_errors : telemetry.nus_errors,
+                   telemetry.hvn_inflight, telemetry.hvn_high_water, telemetry.ring_high_water,
+                   telemetry.mtu, phy_name(telemetry.tx_phy), phy_name(telemetry.rx_phy),
+                   telemetry.conn_interval * 1.25, telemetry.hvn_tx_queue, telemetry.event_length * 1.25,
+                   telemetry.history_ms / 1000.0, telemetry.history_capacity_ms / 1000.0, kbps, chart);
+            fflush(stdout);
+            if(tsv != NULL)
+            {
+                fprintf(tsv, "%llu\t%u\t%u\t%u\t%u\t%u\t%u\t%u\t%u\t%u\t%u\t%u\t%u\t%u\t%u\t%u\t%u\t%u\t%u\t%u\n",
+                        (unsigned long long)t_ms, telemetry.samples_acquired, telemetry.samples_dropped,
+                        telemetry.packets_built, telemetry.packets_sent, telemetry.nus_resources, telemetry.nus_errors,
+                        telemetry.bytes_sent, telemetry.throughput_bps, telemetry.mtu, telemetry.tx_phy, telemetry.rx_phy,
+                        telemetry.hvn_inflight, telemetry.hvn_high_water, telemetry.ring_high_water,
+                        telemetry.history_ms, telemetry.history_capacity_ms,
+                        telemetry.hvn_tx_queue, telemetry.event_length, telemetry.conn_interval);
+            }
+            last = telemetry;
+            have_last = true;
+        }
+        if(cmd != NULL)
+        {
+            sleep_ms(interval_ms);
+        }
+    }
+    if(tsv != NULL)
+    {
+        fclose(tsv);
+    }
+    return 0;
+}
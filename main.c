@@ -81,6 +81,29 @@
 #include "nrf_log_default_backends.h"
 
 #include "hust_ble.h"
+#include "hust_siggen.h"
+#include "hust_latency.h"
+#include "hust_prof.h"
+#include "hust_telemetry.h"
+#include "hust_sample_clock.h"
+#include "hust_ring.h"
+#include "hust_acq.h"
+#include "hust_ads_nrf.h"
+#include "hust_mc.h"
+#include "hust_imu_nrf.h"
+#include "hust_sched.h"
+#include "hust_cmd.h"
+#include "hust_state.h"
+#include "hust_flog_nrf.h"
+#include "hust_hist.h"
+#include "hust_link.h"
+#include "hust_bio.h"
+#include "hust_l2cap.h"
+#include "hust_fanout.h"
+#include "hust_bcast.h"
+#if HUST_LATENCY_TRAILER_ENABLED
+#include "ble_radio_notification.h"
+#endif
 
 #define APP_BLE_CONN_CFG_TAG            1                                           /**< A tag identifying the SoftDevice BLE configuration. */
 
@@ -94,7 +117,7 @@
 #define APP_ADV_DURATION                18000                                       /**< The advertising duration (180 seconds) in units of 10 milliseconds. */
 
 #define MIN_CONN_INTERVAL               MSEC_TO_UNITS(7.5, UNIT_1_25_MS)             /**< Minimum acceptable connection interval (20 ms), Connection interval uses 1.25 ms units. */
-#define MAX_CONN_INTERVAL               MSEC_TO_UNITS(7.5, UNIT_1_25_MS)             /**< Maximum acceptable connection interval (75 ms), Connection interval uses 1.25 ms units. */
+#define MAX_CONN_INTERVAL               (LINK_ENABLED ? MSEC_TO_UNITS(100, UNIT_1_25_MS) : MSEC_TO_UNITS(7.5, UNIT_1_25_MS))  /**< Maximum acceptable connection interval (100 ms when the link manager picks the interval, else 7.5 ms), Connection interval uses 1.25 ms units. */
 #define SLAVE_LATENCY                   0                                           /**< Slave latency. */
 #define CONN_SUP_TIMEOUT                MSEC_TO_UNITS(4000, UNIT_10_MS)             /**< Connection supervisory timeout (4 seconds), Supervision Timeout uses 10 ms units. */
 #define FIRST_CONN_PARAMS_UPDATE_DELAY  APP_TIMER_TICKS(5000)                       /**< Time from initiating event (connect or start of notification) to first time sd_ble_gap_conn_param_update is called (5 seconds). */
@@ -108,11 +131,12 @@
 
 
 BLE_NUS_DEF(m_nus, NRF_SDH_BLE_TOTAL_LINK_COUNT);                                   /**< BLE NUS service instance. */
+HUST_TELEMETRY_SERVICE_DEF(m_telemetry_service);                                    /**< Pipeline telemetry service instance. */
 NRF_BLE_GATT_DEF(m_gatt);                                                           /**< GATT module instance. */
-NRF_BLE_QWR_DEF(m_qwr);                                                             /**< Context for the Queued Write module.*/
+NRF_BLE_QWRS_DEF(m_qwr, NRF_SDH_BLE_TOTAL_LINK_COUNT);                               /**< Context for the Queued Write module, one per link.*/
 BLE_ADVERTISING_DEF(m_advertising);                                                 /**< Advertising module instance. */
 
-static uint16_t   m_conn_handle          = BLE_CONN_HANDLE_INVALID;                 /**< Handle of the current connection. */
+static uint16_t   m_conn_handle          = BLE_CONN_HANDLE_INVALID;                 /**< Handle of the primary connection (first central), the one the link manager and the UART bridge serve. */
 static uint16_t   m_ble_nus_max_data_len = BLE_GATT_ATT_MTU_DEFAULT - 3;            /**< Maximum length of data (in bytes) that can be transmitted to the peer by the Nordic UART service module. */
 static ble_uuid_t m_adv_uuids[]          =                                          /**< Universally unique service identifier. */
 {
@@ -121,7 +145,83 @@ static ble_uuid_t m_adv_uuids[]          =
 /* HUST */
 ble_packet_t ble_packet_m;
 APP_TIMER_DEF(m_ecg_timer_id);                                                  /**< ECG timer. */
-#define ECG_TIMER_INTERVAL              APP_TIMER_TICKS(1)                    /**< ECG sampling timer interval (200 ms). */
+APP_TIMER_DEF(m_telemetry_timer_id);                                            /**< Telemetry update timer. */
+#define TELEMETRY_TIMER_INTERVAL        APP_TIMER_TICKS(HUST_TELEMETRY_INTERVAL_MS)  /**< Telemetry throughput/notify interval. */
+#define ECG_SAMPLE_RATE                 1000                                  /**< ECG sampling rate (Hz): 250, 500, 1000 or 2000. */
+#define ECG_SOURCE_SIGGEN               0                                     /**< Signal generator driven by the sample clock. */
+#define ECG_SOURCE_SAADC                1                                     /**< AIN0..AIN3 sampled with TIMER1 + PPI + SAADC. */
+#define ECG_SOURCE_ADS129X              2                                     /**< ADS1298/ADS1299 on SPIM0, DRDY + PPI + EasyDMA. */
+#define ECG_SOURCE_EMG_SAADC            3                                     /**< EMG: AIN0..AIN(EMG_CHANNELS-1) with TIMER1 + PPI + SAADC, streamed as EMG_SENSOR_TYPE packets. */
+#ifndef ECG_SOURCE
+#define ECG_SOURCE                      ECG_SOURCE_SIGGEN                     /**< Source of the ECG samples. */
+#endif
+#define ECG_ADS_GAIN                    6                                     /**< ADS129x PGA gain (valid on both ADS1298 and ADS1299). */
+#ifndef ECG_ADS_DEVICES
+#define ECG_ADS_DEVICES                 1                                     /**< Daisy-chained ADS1299 count (1..4). More than 1 streams every channel as EEG_SENSOR_TYPE packets. */
+#endif
+#define EMG_SAMPLE_RATE                 2000                                  /**< EMG sampling rate (Hz), 1000..4000. */
+#define EMG_CHANNELS                    8                                     /**< Number of EMG inputs (AIN0..AIN7). */
+#define EMG_OVERSAMPLE                  NRF_SAADC_OVERSAMPLE_2X               /**< SAADC oversampling per EMG sample (burst mode), NRF_SAADC_OVERSAMPLE_DISABLED to turn off. */
+#define EMG_BUFFER_BUDGET_CYCLES        8000                                  /**< Cycle budget of emg_buffer_handler per SAADC buffer, checked by the profiler. */
+#define EEG_MODE                        (ECG_SOURCE == ECG_SOURCE_ADS129X && ECG_ADS_DEVICES > 1)
+#define EMG_MODE                        (ECG_SOURCE == ECG_SOURCE_EMG_SAADC)
+#define MC_MODE                         (EEG_MODE || EMG_MODE)                /**< Multichannel (hust_mc) packets instead of ecg_data_t packets. */
+#define ALL_MODE                        (IMU_ENABLED && !MC_MODE)             /**< ECG + IMU in ALL_SENSOR_TYPE packets, each stream at its own rate (hust_sched). */
+#define MC_MAX_CHANNELS                 (EEG_MODE ? ECG_ADS_DEVICES * HUST_ADS_MAX_CHANNELS : EMG_CHANNELS)
+#define STREAM_SAMPLE_RATE              (EMG_MODE ? EMG_SAMPLE_RATE : ECG_SAMPLE_RATE)    /**< Boot rate of the primary stream (ECG/EEG/EMG), HUST_CMD_SET_RATE changes it at runtime. */
+#define MC_CODEC                        HUST_CODEC_DELTA_VARINT               /**< Boot payload codec of multichannel packets (see hust_codec.h), cheapest to pack and densest at 32 channels. HUST_CMD_SET_CODEC changes it. */
+#define MC_CODEC_PARAM                  0                                     /**< Codec parameter of multichannel packets. */
+#define MC_PACK_FRAMES                  16                                    /**< Frames gathered per multichannel packet, the packer keeps the largest prefix that fits. */
+#define MC_RING_FRAMES                  64                                    /**< Multichannel frames buffered between the acquisition interrupt and the main loop. */
+#ifndef IMU_ENABLED
+#define IMU_ENABLED                     0                                     /**< Stream accelerometer samples (LSM6/MPU on TWIM1): with ECG in ALL_SENSOR_TYPE packets, with EEG/EMG as IMU_SENSOR_TYPE packets. */
+#endif
+#define IMU_SAMPLE_RATE                 104                                   /**< IMU output data rate (Hz), MPU parts round it to 1000 / n. */
+#define IMU_RING_SAMPLES                64                                    /**< IMU samples buffered between the TWIM interrupt and the main loop. */
+#define ACQ_BUFFER_TIMEOUT_S            60                                    /**< Seconds the sources keep sampling into the buffers after the link drops (state BUFFERING), 0 = until reconnect, < 1024 (24 bit RTC). */
+#ifndef FLOG_ENABLED
+#define FLOG_ENABLED                    1                                     /**< Store the packets built in BUFFERING in the flash log (hust_flog) and backfill them after reconnecting. */
+#endif
+#define FLOG_BACKFILL_SHARE             50                                    /**< Percentage of the sent bytes the backfill may take from the live stream after reconnecting. */
+#ifndef HIST_ENABLED
+#define HIST_ENABLED                    1                                     /**< Keep the packets built in BUFFERING in a compressed RAM history (hust_hist) first, only its overflow goes to the flash log. */
+#endif
+#define HIST_RAM_RESERVE                256                                   /**< Bytes of the free RAM between heap and stack left unused by the history. */
+#ifndef LINK_ENABLED
+#define LINK_ENABLED                    1                                     /**< Adapt PHY and connection interval to the stream (hust_link): 2M, the longest interval that sustains the measured bitrate, 1M on weak RSSI or a high error rate. */
+#endif
+#define LINK_RSSI_THRESHOLD_DBM         2                                     /**< RSSI change (dBm) reported by BLE_GAP_EVT_RSSI_CHANGED. */
+#define LINK_RSSI_SKIP_COUNT            4                                     /**< RSSI samples that must exceed the threshold before an event is reported. */
+#ifndef BIO_SERVICE_ENABLED
+#define BIO_SERVICE_ENABLED             1                                     /**< Biosignal service (hust_bio): data, event, control, schema and stats characteristics with their own CCCD. Streams go to its data characteristic when the central subscribed, else to NUS. */
+#endif
+#ifndef L2CAP_ENABLED
+#define L2CAP_ENABLED                   1                                     /**< Stream over an L2CAP credit based channel (hust_l2cap) when the central opens one to HUST_L2CAP_PSM, several packets per SDU. Without a channel the stream stays on notifications. */
+#endif
+#define FANOUT_LINKS                    NRF_SDH_BLE_PERIPHERAL_LINK_COUNT     /**< Centrals receiving the stream at the same time (hust_fanout): one packet built once, each central with its own position in the ring and its own drop count. */
+#if FANOUT_LINKS > HUST_FANOUT_LINKS_MAX
+#error "NRF_SDH_BLE_PERIPHERAL_LINK_COUNT above HUST_FANOUT_LINKS_MAX"
+#endif
+#ifndef BCAST_ENABLED
+#define BCAST_ENABLED                   0                                     /**< Broadcast the stream in extended advertising (hust_bcast) to any number of passive receivers instead of advertising for connections. Needs the S140 (pca10056, pca10100). */
+#endif
+#if BCAST_ENABLED && !defined(S140)
+#error "BCAST_ENABLED needs the extended advertising of the S140"
+#endif
+#define BCAST_INTERVAL_MS               50                                    /**< Advertising interval of the broadcast (ms), one advertising data update per interval. */
+#define BCAST_INTERVAL                  MSEC_TO_UNITS(BCAST_INTERVAL_MS, UNIT_0_625_MS)
+#define BCAST_PUBLISH_INTERVAL          APP_TIMER_TICKS(BCAST_INTERVAL_MS + 10)   /**< Advertising data update period, the advertising interval plus the 0..10 ms advDelay so every update goes on air at least once. */
+#define BCAST_DECIMATION                4                                     /**< Broadcast 1 of every BCAST_DECIMATION packets, count_packet shows the skipped ones. */
+#define BCAST_PACKET_SIZE               120                                   /**< Packet size in broadcast mode (no MTU), 2 packets per advertising data update. */
+#define BCAST_PHY                       BLE_GAP_PHY_2MBPS                     /**< PHY of the secondary advertising channel carrying the data, BLE_GAP_PHY_1MBPS for more range. */
+#define CONN_CFG_TARGET_BPS             400000                                /**< Notification throughput the SoftDevice connection configuration (HVN TX queue, GAP event length) is sized for. */
+#define CONN_CFG_INTERVAL               MSEC_TO_UNITS(30, UNIT_1_25_MS)       /**< Connection interval at which CONN_CFG_TARGET_BPS must be reached on the 1M PHY. */
+#if defined(S140)
+#define LINK_CODED                      true                                  /**< SoftDevice supports the Coded PHY as the last fallback. */
+#else
+#define LINK_CODED                      false
+#endif
+#define LATENCY_RADIO_LEAD_TICKS        13                                    /**< Radio notification fires 800 us (~13 RTC ticks) before the radio becomes active. */
 
 /**@brief Function for assert macro callback.
  *
@@ -139,41 +239,448 @@ void assert_nrf_callback(uint16_t line_num, const uint8_t * p_file_name)
     app_error_handler(DEAD_BEEF, line_num, p_file_name);
 }
 
-uint8_t ecg_temp[12] = {10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21}; // dung de dummy ecg data
+siggen_t siggen_m[ECG_CHANNEL]; // nguon ecg gia lap, moi channel 1 dao trinh (lead) khac nhau
 int ble_packet_size = 0;
 int ecg_sample_count = 0; //dem so mau ecg dua vao ble packet
 sample_transfer_t sample_transfer_m;
 bool data_array_exist = false;
 uint8_t * ble_packet_temp;
+hust_latency_t latency_m;       // moc thoi gian cua packet dang dong goi / dang nam trong hang doi HVN
+hust_telemetry_t telemetry_m;   // bo dem hieu nang pipeline
+hust_sample_clock_t sample_clock_m; // moc thoi gian tung block sample tren RTC, khong troi
+hust_ring_t ring_m;             // sample tu ngat lay mau cho vong lap main dong goi
+#define HELD_PACKETS    2               // packet IMU + packet ECG/EEG/EMG dong goi trong cung 1 vong main
+uint8_t held_packet[HELD_PACKETS][BLE_NUS_MAX_DATA_LEN];   // packet hang doi HVN het cho (NRF_ERROR_RESOURCES), gui lai truoc packet sau
+uint16_t held_packet_length[HELD_PACKETS];
+int held_packet_count = 0;
+hust_cmd_config_t stream_config_m;  // cau hinh stream hien tai, lenh NUS chi doi giua 2 packet
+hust_cmd_queue_t cmd_queue_m;   // lenh tu NUS RX cho vong lap main ap dung
+static uint8_t * cmd_response = NULL;   // tra loi lenh dang cho hang doi HVN co cho
+static uint16_t cmd_response_length;
+static uint8_t cmd_response_count = 0;
+static uint16_t cmd_response_conn;      // central gui lenh dang cho tra loi
+hust_state_t state_m;           // may trang thai lay mau (hust_state.h)
+hust_fanout_t fanout_m;         // packet dong goi 1 lan, gui cho moi central dang nhan stream
+static volatile bool fanout_nus[HUST_FANOUT_LINKS_MAX];    // central cua fanout_m.link[i] da bat notify NUS TX
+static uint16_t fanout_payload[HUST_FANOUT_LINKS_MAX];      // MTU - 3 cua central fanout_m.link[i]
+static bool acquisition_running = false;        // nguon lay mau dang chay
+#if BCAST_ENABLED
+static hust_bcast_t bcast_m;                    // PDU broadcast dang gom + advertising set
+APP_TIMER_DEF(m_bcast_timer_id);                // cap nhat du lieu advertising moi BCAST_PUBLISH_INTERVAL
+static volatile bool bcast_publish_pending = false; // den luc cap nhat du lieu advertising
+#endif
+#if FLOG_ENABLED
+hust_flog_t flog_m;             // packet dong goi luc mat ket noi, gui lai khi ket noi lai
+#endif
+#if HIST_ENABLED
+hust_hist_t hist_m;             // N giay packet moi nhat luc mat ket noi, nen trong RAM
+// RAM trong sau bien cua app: tu cuoi heap den day stack (ky hieu cua linker script)
+#if defined(__SES_ARM)
+extern uint8_t __heap_end__[];
+#define HIST_RAM_START                  __heap_end__
+#else
+extern uint8_t __HeapLimit[];
+#define HIST_RAM_START                  __HeapLimit
+#endif
+extern uint8_t __StackLimit[];
+#endif
+hust_link_conn_cfg_t conn_cfg_m;    // hang doi HVN TX / event length da cau hinh cho SoftDevice
+#if LINK_ENABLED
+hust_link_t link_m;             // PHY / interval dang dung va throughput theo tung cau hinh
+#endif
+#if L2CAP_ENABLED
+HUST_L2CAP_DEF(m_l2cap);                                                        /**< L2CAP channel of the stream. */
+#endif
+#if BIO_SERVICE_ENABLED
+HUST_BIO_SERVICE_DEF(m_bio_service);                                            /**< Biosignal service instance. */
+hust_bio_event_queue_t bio_event_queue_m;   // event cho characteristic event co cho trong hang doi HVN
+hust_cmd_queue_t bio_cmd_queue_m;   // lenh tu characteristic control
+static uint8_t bio_response[HUST_BIO_CONTROL_MAX];  // tra loi lenh control dang cho hang doi HVN co cho
+static uint16_t bio_response_length = 0;
+static volatile bool bio_schema_changed = true;     // cau hinh stream / MTU da doi, cap nhat schema
+static uint32_t bio_samples_dropped = 0;        // gia tri da bao qua event DROP / LINK
+static uint8_t bio_tx_phy = 0;
+static uint16_t bio_conn_interval = 0;
+#endif
+#if ECG_SOURCE == ECG_SOURCE_ADS129X
+hust_ads_t ads_m;               // AFE ADS129x
+uint32_t ads_status_errors = 0; // frame co header status sai (mat dong bo SPI)
+#endif
+#if MC_MODE
+HUST_MC_RING_DEF(mc_ring_m, MC_RING_FRAMES, MC_MAX_CHANNELS);      // frame EEG/EMG tu ngat lay mau
+static int32_t mc_block[MC_PACK_FRAMES * MC_MAX_CHANNELS];          // frame cho dong goi
+static int mc_block_frames = 0;
+static uint64_t mc_block_index;
+#endif
+#if IMU_ENABLED
+hust_imu_t imu_m;               // IMU tren TWIM1
+HUST_MC_RING_DEF(imu_ring_m, IMU_RING_SAMPLES, IMU_CHANNEL);        // sample imu (x, y, z) tu ngat TWIM
+static ble_packet_t imu_packet_m;                                   // packet IMU_SENSOR_TYPE, count_packet rieng
+static volatile uint64_t imu_anchor_index;                          // sample imu cuoi cung cua burst gan nhat
+static volatile uint32_t imu_anchor_tick;                           // va tick RTC luc lay mau sample do
+#endif
+
+#if ECG_SOURCE == ECG_SOURCE_SIGGEN
+static const int32_t ecg_lead_amplitude[ECG_CHANNEL] = {4000, 2800, -1200, 3300};
+
+static void siggen_init_all(void)
+{
+    for(int ch = 0; ch < ECG_CHANNEL; ch++)
+    {
+        siggen_init(&siggen_m[ch], SIGGEN_ECG, stream_config_m.rate, ch + 1);
+        siggen_m[ch].amplitude = ecg_lead_amplitude[ch];
+    }
+}
+#endif
+
+// dua 1 frame vao ring, goi tu ngat lay mau
+static void sample_push(const hust_frame_t * frame)
+{
+    if(hust_ring_push(&ring_m, frame) == 0)
+    {
+        telemetry_m.samples_acquired++;
+        hust_telemetry_ring_level(&telemetry_m, hust_ring_count(&ring_m));
+    }
+    else
+    {
+        telemetry_m.samples_dropped++;  // ring day: vong lap main khong dong goi kip
+    }
+}
+
+#if ECG_SOURCE == ECG_SOURCE_SAADC
+static const nrf_saadc_input_t ecg_saadc_input[ECG_CHANNEL] =
+{
+    NRF_SAADC_INPUT_AIN0, NRF_SAADC_INPUT_AIN1, NRF_SAADC_INPUT_AIN2, NRF_SAADC_INPUT_AIN3
+};
+
+// 1 buffer DMA day (HUST_ACQ_BUFFER_FRAMES frame), goi trong ngat SAADC
+static void saadc_buffer_handler(const nrf_saadc_value_t * buffer, uint16_t n_frames, uint64_t first_index)
+{
+    HUST_PROF_START(ecg_timer);
+    uint32_t now = app_timer_cnt_get();
+
+    for(uint16_t i = 0; i < n_frames; i++)
+    {
+        hust_frame_t frame;
+        frame.sample_index = first_index + i;
+        frame.t_acq = now - ((n_frames - 1 - i) * HUST_SAMPLE_CLOCK_RTC_HZ) / stream_config_m.rate;
+        for(int ch = 0; ch < ECG_CHANNEL; ch++)
+        {
+            // 12 bit SAADC -> thang do 24 bit cua ecg_sample_data_t
+            *ecg_channel_get(&frame.ecg, ch) = int32_to_ecg_sample((int32_t)buffer[i * ECG_CHANNEL + ch] * 256);
+        }
+        sample_push(&frame);
+    }
+    HUST_PROF_STOP(ecg_timer, HUST_PROF_ECG_TIMER);
+}
+#elif EEG_MODE
+// nua buffer DMA cua chuoi ADS1299 day: tach tung frame thang vao ring EEG, goi trong ngat TIMER2
+static void ads_buffer_handler(const uint8_t * frames, uint16_t n_frames, uint16_t frame_size, uint64_t first_index)
+{
+    HUST_PROF_START(ecg_timer);
+    for(uint16_t i = 0; i < n_frames; i++)
+    {
+        int32_t * slot = hust_mc_ring_claim(&mc_ring_m);
+        if(slot == NULL)
+        {
+            telemetry_m.samples_dropped++;  // ring day: vong lap main khong dong goi kip
+            continue;
+        }
+        if(hust_ads_demux(&ads_m, frames + i * frame_size, 1, slot) != 0)
+        {
+            ads_status_errors++;
+            telemetry_m.samples_dropped++;
+            continue;
+        }
+        hust_mc_ring_commit(&mc_ring_m, first_index + i);
+        telemetry_m.samples_acquired++;
+    }
+    hust_telemetry_ring_level(&telemetry_m, hust_mc_ring_count(&mc_ring_m));
+    HUST_PROF_STOP(ecg_timer, HUST_PROF_ECG_TIMER);
+}
+#elif ECG_SOURCE == ECG_SOURCE_ADS129X
+// nua buffer DMA cua ADS129x day (HUST_ADS_BUFFER_FRAMES frame), goi trong ngat TIMER2
+static void ads_buffer_handler(const uint8_t * frames, uint16_t n_frames, uint16_t frame_size, uint64_t first_index)
+{
+    HUST_PROF_START(ecg_timer);
+    uint32_t now = app_timer_cnt_get();
+
+    for(uint16_t i = 0; i < n_frames; i++)
+    {
+        hust_frame_t frame;
+        uint32_t status;
+        frame.sample_index = first_index + i;
+        frame.t_acq = now - ((n_frames - 1 - i) * HUST_SAMPLE_CLOCK_RTC_HZ) / stream_config_m.rate;
+        if(hust_ads_frame_to_ecg(frames + i * frame_size, &frame.ecg, &status) != 0)
+        {
+            ads_status_errors++;
+            telemetry_m.samples_dropped++;
+            continue;
+        }
+        sample_push(&frame);
+    }
+    HUST_PROF_STOP(ecg_timer, HUST_PROF_ECG_TIMER);
+}
+#elif EMG_MODE
+static const nrf_saadc_input_t emg_saadc_input[HUST_ACQ_MAX_CHANNELS] =
+{
+    NRF_SAADC_INPUT_AIN0, NRF_SAADC_INPUT_AIN1, NRF_SAADC_INPUT_AIN2, NRF_SAADC_INPUT_AIN3,
+    NRF_SAADC_INPUT_AIN4, NRF_SAADC_INPUT_AIN5, NRF_SAADC_INPUT_AIN6, NRF_SAADC_INPUT_AIN7
+};
+
+// 1 buffer DMA EMG day, goi trong ngat SAADC. Chi chep sample vao ring, khong loc / dong goi
+// de giu trong EMG_BUFFER_BUDGET_CYCLES (profiler dem so lan vuot, HUST_PROF_EMG_BUFFER)
+static void emg_buffer_handler(const nrf_saadc_value_t * buffer, uint16_t n_frames, uint64_t first_index)
+{
+    HUST_PROF_START(emg_buffer);
+    for(uint16_t i = 0; i < n_frames; i++)
+    {
+        int32_t * slot = hust_mc_ring_claim(&mc_ring_m);
+        if(slot == NULL)
+        {
+            telemetry_m.samples_dropped++;  // ring day: vong lap main khong dong goi kip
+            continue;
+        }
+        for(int ch = 0; ch < EMG_CHANNELS; ch++)
+        {
+            slot[ch] = buffer[i * EMG_CHANNELS + ch];
+        }
+        hust_mc_ring_commit(&mc_ring_m, first_index + i);
+    }
+    telemetry_m.samples_acquired += n_frames;
+    hust_telemetry_ring_level(&telemetry_m, hust_mc_ring_count(&mc_ring_m));
+    HUST_PROF_STOP(emg_buffer, HUST_PROF_EMG_BUFFER);
+}
+#else
+// tao ca block HUST_ACQ_BUFFER_FRAMES sample gia lap moi lan ngat, giong nguon DMA
 static void ecg_timer_timeout_handler(void * p_context)
 {
     UNUSED_PARAMETER(p_context);
+    HUST_PROF_START(ecg_timer);
+
+    // hen gio cho block ke tiep theo moc tuyet doi truoc khi tao sample
+    uint32_t now = app_timer_cnt_get();
+    uint64_t block = hust_sample_clock_advance(&sample_clock_m, now, HUST_SAMPLE_CLOCK_RTC_MASK);
+    ret_code_t err_code = app_timer_start(m_ecg_timer_id,
+                                          hust_sample_clock_wait(&sample_clock_m, now, HUST_SAMPLE_CLOCK_RTC_MASK),
+                                          NULL);
+    APP_ERROR_CHECK(err_code);
 
-    if(ecg_sample_count >= 0 && ecg_sample_count < sample_transfer_m.ecg_sample && data_array_exist == true)
+    for(int i = 0; i < HUST_ACQ_BUFFER_FRAMES; i++)
     {
-	//dummmy timestamp
-	for(int i = 0; i < 8; i++)
-	{
-            ble_packet_m.timestamp.byte[i] = i;
-	}
-	//dummy ecg data
-        for(int i = 0; i < ECG_DATA_LENGTH; i++)
+        hust_frame_t frame;
+        frame.sample_index = block * HUST_ACQ_BUFFER_FRAMES + i;
+        frame.t_acq = now - ((HUST_ACQ_BUFFER_FRAMES - 1 - i) * HUST_SAMPLE_CLOCK_RTC_HZ) / stream_config_m.rate;
+        for(int ch = 0; ch < ECG_CHANNEL; ch++)
         {
-            (ble_packet_m.ecg_data + ecg_sample_count)->ecg_channel1.byte[i] = ecg_temp[i];
-            (ble_packet_m.ecg_data + ecg_sample_count)->ecg_channel2.byte[i] = ecg_temp[i + ECG_DATA_LENGTH];
-            (ble_packet_m.ecg_data + ecg_sample_count)->ecg_channel3.byte[i] = ecg_temp[i + 2*ECG_DATA_LENGTH];
-            (ble_packet_m.ecg_data + ecg_sample_count)->ecg_channel4.byte[i] = ecg_temp[i + 3*ECG_DATA_LENGTH];
+            *ecg_channel_get(&frame.ecg, ch) = int32_to_ecg_sample(siggen_next(&siggen_m[ch]));
         }
-        ecg_sample_count++; // tang so mau ecg dua vao ble packet
-        if(ecg_sample_count == sample_transfer_m.ecg_sample)
+        sample_push(&frame);
+    }
+    HUST_PROF_STOP(ecg_timer, HUST_PROF_ECG_TIMER);
+}
+#endif
+
+#if IMU_ENABLED
+// 1 burst FIFO imu doc xong, goi trong ngat TWIM1
+static void imu_fifo_handler(const int16_t * axis, uint8_t n, uint64_t first_index, uint32_t t_last)
+{
+    for(uint8_t i = 0; i < n; i++)
+    {
+        int32_t * slot = hust_mc_ring_claim(&imu_ring_m);
+        if(slot == NULL)
         {
-            for(int i = 0; i < 12; i++)
-            {
-                ecg_temp[i]++;
-            }
+            telemetry_m.samples_dropped++;  // ring day: vong lap main khong dong goi kip
+            continue;
+        }
+        for(int a = 0; a < IMU_CHANNEL; a++)
+        {
+            slot[a] = axis[i * IMU_CHANNEL + a];
+        }
+        hust_mc_ring_commit(&imu_ring_m, first_index + i);
+    }
+    imu_anchor_index = first_index + n - 1;
+    imu_anchor_tick = t_last;
+}
+#endif
+
+#if LINK_ENABLED
+/**@brief Function for logging the throughput achieved in the link configuration just left.
+ *
+ * @param[in] p_stat  Statistics of the previous PHY / connection interval, NULL if it did not change.
+ */
+static void link_stat_log(const hust_link_stat_t * p_stat)
+{
+    if(p_stat != NULL && p_stat->ms > 0)
+    {
+        NRF_LOG_INFO("Link %s %u.%02u ms: %u bps for %u s", hust_link_phy_name(p_stat->config.phy),
+                     p_stat->config.interval * 125u / 100, p_stat->config.interval * 125u % 100,
+                     hust_link_stat_bps(p_stat), p_stat->ms / 1000);
+    }
+}
+
+
+/**@brief Function for requesting the PHY and connection interval chosen by the link manager.
+ *
+ * @details A request the central rejects or never answers expires in the link manager after
+ *          HUST_LINK_HOLD_MS, so a failed request is only logged.
+ *
+ * @param[in] change  HUST_LINK_CHANGE_* flags, the new configuration is in link_m.target.
+ */
+static void link_apply(uint8_t change)
+{
+    uint32_t err_code;
+
+    if(m_conn_handle == BLE_CONN_HANDLE_INVALID)
+    {
+        return;
+    }
+    if(change & HUST_LINK_CHANGE_PHY)
+    {
+        ble_gap_phys_t const phys =
+        {
+            .rx_phys = link_m.target.phy,
+            .tx_phys = link_m.target.phy,
+        };
+        err_code = sd_ble_gap_phy_update(m_conn_handle, &phys);
+        if(err_code != NRF_SUCCESS)
+        {
+            NRF_LOG_WARNING("PHY %s request failed: 0x%x", hust_link_phy_name(link_m.target.phy), err_code);
+        }
+    }
+    if(change & HUST_LINK_CHANGE_INTERVAL)
+    {
+        ble_gap_conn_params_t conn_params;
+
+        conn_params.min_conn_interval = link_m.target.interval;
+        conn_params.max_conn_interval = link_m.target.interval;
+        conn_params.slave_latency     = SLAVE_LATENCY;
+        conn_params.conn_sup_timeout  = CONN_SUP_TIMEOUT;
+        err_code = sd_ble_gap_conn_param_update(m_conn_handle, &conn_params);
+        if(err_code != NRF_SUCCESS)
+        {
+            NRF_LOG_WARNING("Connection interval request failed: 0x%x", err_code);
         }
     }
 }
+
+
+/**@brief Function for feeding the pipeline counters of the last telemetry period to the link manager.
+ */
+static void link_tick(void)
+{
+    hust_link_sample_t sample;
+
+    if(m_conn_handle == BLE_CONN_HANDLE_INVALID)
+    {
+        return;
+    }
+    sample.packets_built   = telemetry_m.packets_built;
+    sample.packets_sent    = telemetry_m.packets_sent;
+    sample.bytes_sent      = telemetry_m.bytes_sent;
+    sample.samples_dropped = telemetry_m.samples_dropped;
+    sample.nus_resources   = telemetry_m.nus_resources;
+    sample.backfill        = false;
+#if HIST_ENABLED
+    sample.backfill |= hist_m.count > 0;
+#endif
+#if FLOG_ENABLED
+    sample.backfill |= !hust_flog_empty(&flog_m);
+#endif
+    link_apply(hust_link_tick(&link_m, HUST_TELEMETRY_INTERVAL_MS, &sample));
+}
+#endif
+
+/**@brief Function for counting a notification queued in the SoftDevice.
+ *
+ * @details Every central has its own HVN queue depth in its fan-out link, the biosignal event
+ *          reserve is checked against it. The telemetry HVN queue depth follows the primary
+ *          connection only.
+ *
+ * @param[in] conn_handle  Connection the notification was queued on.
+ */
+static void hvn_queued(uint16_t conn_handle)
+{
+    hust_fanout_link_t * p_link = hust_fanout_link_find(&fanout_m, conn_handle);
+    if(p_link != NULL && conn_handle != BLE_CONN_HANDLE_INVALID)
+    {
+        hust_fanout_hvn_queued(p_link);
+    }
+    if(conn_handle == m_conn_handle)
+    {
+        hust_telemetry_hvn_queued(&telemetry_m);
+    }
+}
+
+static void telemetry_timer_timeout_handler(void * p_context)
+{
+    UNUSED_PARAMETER(p_context);
+
+    hust_telemetry_tick(&telemetry_m, HUST_TELEMETRY_INTERVAL_MS);
+#if HIST_ENABLED
+    telemetry_m.history_ms = (uint32_t)((uint64_t)hust_hist_span(&hist_m) * 1000 / HUST_SAMPLE_CLOCK_RTC_HZ);
+    telemetry_m.history_capacity_ms = (uint32_t)((uint64_t)hust_hist_capacity(&hist_m) * 1000 / HUST_SAMPLE_CLOCK_RTC_HZ);
+#endif
+#if LINK_ENABLED
+    link_tick();
+#endif
+    if(hust_telemetry_service_update(&m_telemetry_service, &telemetry_m) == NRF_SUCCESS
+       && m_telemetry_service.notify_enabled)
+    {
+        hvn_queued(m_telemetry_service.conn_handle);
+    }
+#if BIO_SERVICE_ENABLED
+    if(hust_bio_stats_update(&m_bio_service, &telemetry_m) == NRF_SUCCESS
+       && m_bio_service.stats_notify)
+    {
+        hvn_queued(m_bio_service.conn_handle);
+    }
+#endif
+}
+
+#if HUST_LATENCY_TRAILER_ENABLED
+/**@brief Radio notification handler, marks the start of each connection event for the latency tracer.
+ */
+static void radio_notification_handler(bool radio_active)
+{
+    if(radio_active)
+    {
+        hust_latency_radio_active(&latency_m, app_timer_cnt_get() + LATENCY_RADIO_LEAD_TICKS);
+    }
+}
+
+/**@brief Function for appending the latency trailer to a packed BLE packet.
+ *
+ * @param[in,out] p_ble_packet  Packet buffer, reallocated to hold the trailer.
+ * @param[in,out] p_length      Packet length, increased by the trailer size.
+ * @param[in]     t_send        RTC tick at which the packet is handed to the SoftDevice.
+ */
+static void latency_trailer_append(uint8_t ** p_ble_packet, uint16_t * p_length, uint32_t t_send)
+{
+    hust_latency_trailer_t trailer;
+    uint8_t * ble_packet = realloc(*p_ble_packet, *p_length + HUST_LATENCY_TRAILER_SIZE);
+    if(ble_packet == NULL)
+    {
+        return;
+    }
+    hust_latency_trailer_get(&latency_m, t_send, &trailer);
+    hust_latency_trailer_encode(&trailer, ble_packet + *p_length);
+    *p_ble_packet = ble_packet;
+    *p_length += HUST_LATENCY_TRAILER_SIZE;
+}
+#endif
+#if BCAST_ENABLED
+/**@brief Function for handling the broadcast timer timeout.
+ *
+ * @details The main loop, which builds the broadcast PDU, hands it to the advertising set.
+ */
+static void bcast_timer_timeout_handler(void * p_context)
+{
+    UNUSED_PARAMETER(p_context);
+
+    bcast_publish_pending = true;
+}
+#endif
 /**@brief Function for initializing the timer module.
  */
 static void timers_init(void)
@@ -181,21 +688,180 @@ static void timers_init(void)
     ret_code_t err_code = app_timer_init();
     APP_ERROR_CHECK(err_code);
 
+#if ECG_SOURCE == ECG_SOURCE_SIGGEN
      // Create ecg timer.
     err_code = app_timer_create(&m_ecg_timer_id,
-                                APP_TIMER_MODE_REPEATED,
+                                APP_TIMER_MODE_SINGLE_SHOT,
                                 ecg_timer_timeout_handler);
     APP_ERROR_CHECK(err_code); 
+#endif
+
+    err_code = app_timer_create(&m_telemetry_timer_id,
+                                APP_TIMER_MODE_REPEATED,
+                                telemetry_timer_timeout_handler);
+    APP_ERROR_CHECK(err_code);
+#if BCAST_ENABLED
+    err_code = app_timer_create(&m_bcast_timer_id,
+                                APP_TIMER_MODE_REPEATED,
+                                bcast_timer_timeout_handler);
+    APP_ERROR_CHECK(err_code);
+#endif
+}
+
+/**@brief Function for starting the sample sources with the current stream configuration.
+ *
+ * @details Sample indices (and the siggen waveform) restart from 0.
+ */
+static ret_code_t acquisition_start(void)
+{
+    ret_code_t err_code;
+
+#if ECG_SOURCE == ECG_SOURCE_SAADC || EMG_MODE
+    err_code = hust_acq_start();
+#elif ECG_SOURCE == ECG_SOURCE_ADS129X
+    err_code = hust_ads_nrf_start();
+#else
+    // 1 "sample" cua dong ho = 1 block HUST_ACQ_BUFFER_FRAMES sample
+    uint32_t now = app_timer_cnt_get();
+    if(hust_sample_clock_init(&sample_clock_m, HUST_SAMPLE_CLOCK_RTC_HZ * HUST_ACQ_BUFFER_FRAMES, stream_config_m.rate, now) != 0)
+    {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+    siggen_init_all();
+    err_code = app_timer_start(m_ecg_timer_id,
+                               hust_sample_clock_wait(&sample_clock_m, now, HUST_SAMPLE_CLOCK_RTC_MASK),
+                               NULL);
+#endif
+#if IMU_ENABLED
+    if(err_code == NRF_SUCCESS)
+    {
+        err_code = hust_imu_nrf_start();
+    }
+#endif
+    return err_code;
+}
+
+/**@brief Function for stopping the sample sources and dropping the samples waiting to be packed.
+ */
+static void acquisition_stop(void)
+{
+#if ECG_SOURCE == ECG_SOURCE_SAADC || EMG_MODE
+    hust_acq_stop();
+#elif ECG_SOURCE == ECG_SOURCE_ADS129X
+    hust_ads_nrf_stop();
+#else
+    (void)app_timer_stop(m_ecg_timer_id);
+#endif
+#if IMU_ENABLED
+    hust_imu_nrf_stop();
+    (void)hust_mc_ring_init(&imu_ring_m, IMU_CHANNEL);
+#endif
+    // nguon da dung, dat lai ring an toan
+    hust_ring_init(&ring_m);
+#if MC_MODE
+    (void)hust_mc_ring_init(&mc_ring_m, mc_ring_m.n_channels);
+    mc_block_frames = 0;
+#endif
+}
+
+/**@brief Function for changing the primary stream rate while the sources are stopped.
+ *
+ * @return HUST_CMD_OK, or HUST_CMD_ERR_PARAM if the source cannot sample at this rate.
+ */
+static uint8_t acquisition_rate_set(uint16_t rate)
+{
+#if ECG_SOURCE == ECG_SOURCE_SAADC || EMG_MODE
+    return hust_acq_set_rate(rate) == NRF_SUCCESS ? HUST_CMD_OK : HUST_CMD_ERR_PARAM;
+#elif ECG_SOURCE == ECG_SOURCE_ADS129X
+    return hust_ads_set_rate(&ads_m, rate) == 0 ? HUST_CMD_OK : HUST_CMD_ERR_PARAM;
+#else
+    hust_sample_clock_t clock;
+    return hust_sample_clock_init(&clock, HUST_SAMPLE_CLOCK_RTC_HZ * HUST_ACQ_BUFFER_FRAMES, rate, 0) == 0
+           ? HUST_CMD_OK : HUST_CMD_ERR_PARAM;
+#endif
+}
+
+/**@brief Function for getting the channel mask with every channel enabled.
+ *
+ * @details EEG/EMG: bit i = channel i of the primary stream. ECG (+ IMU): bit layout of
+ *          ble_packet_t.channel_mask, ECG channels in bits 0..3 and IMU axes in bits 4..6.
+ */
+static uint32_t stream_channel_mask_all(void)
+{
+#if MC_MODE
+    int n_channels = mc_ring_m.n_channels;
+    return n_channels >= 32 ? 0xFFFFFFFF : (1u << n_channels) - 1;
+#elif IMU_ENABLED
+    return CHANNEL_MASK_ALL;
+#else
+    return ECG_CHANNEL_MASK_ALL;
+#endif
+}
+
+/**@brief Function for applying the stream channel mask to the ECG and IMU packet layouts.
+ *
+ * @details Disabled channels are left out of ECG_SENSOR_TYPE, IMU_SENSOR_TYPE and ALL_SENSOR_TYPE
+ *          packets and the number of samples per packet grows accordingly (see hust_ble.h).
+ */
+static void stream_packet_mask_set(void)
+{
+#if MC_MODE
+    ble_packet_m.channel_mask = CHANNEL_MASK_ALL;   // bo channel EEG/EMG chua ho tro
+#else
+    ble_packet_m.channel_mask = (uint8_t)(stream_config_m.channel_mask | (IMU_ENABLED ? 0 : IMU_CHANNEL_MASK_ALL));
+#endif
+#if IMU_ENABLED
+    imu_packet_m.channel_mask = (uint8_t)(ble_packet_m.channel_mask | ECG_CHANNEL_MASK_ALL);
+#endif
 }
 
-/**@brief Function for starting timers.
+/**@brief Function for initializing the sample sources and starting timers.
+ *
+ * @details The sources are left stopped (sensors powered down), acquisition_state_update starts
+ *          them once a central enables notifications.
  */
 static void application_timers_start(void)
 {
     ret_code_t  err_code;
 
-    err_code = app_timer_start(m_ecg_timer_id, ECG_TIMER_INTERVAL, NULL);
+#if ECG_SOURCE == ECG_SOURCE_SAADC
+    err_code = hust_acq_init(stream_config_m.rate, ecg_saadc_input, ECG_CHANNEL, NRF_SAADC_OVERSAMPLE_DISABLED,
+                             saadc_buffer_handler);
+    APP_ERROR_CHECK(err_code);
+#elif EMG_MODE
+    if(hust_mc_ring_init(&mc_ring_m, EMG_CHANNELS) != 0)
+    {
+        APP_ERROR_CHECK(NRF_ERROR_INVALID_PARAM);
+    }
+    HUST_PROF_BUDGET(HUST_PROF_EMG_BUFFER, EMG_BUFFER_BUDGET_CYCLES);
+    err_code = hust_acq_init(stream_config_m.rate, emg_saadc_input, EMG_CHANNELS, EMG_OVERSAMPLE, emg_buffer_handler);
+    APP_ERROR_CHECK(err_code);
+#elif ECG_SOURCE == ECG_SOURCE_ADS129X
+    err_code = hust_ads_nrf_init(&ads_m, ECG_ADS_DEVICES, stream_config_m.rate, ECG_ADS_GAIN, ads_buffer_handler);
+    APP_ERROR_CHECK(err_code);
+    NRF_LOG_INFO("ADS129x id 0x%02x, %d channels", ads_m.id, ads_m.n_channels);
+#if EEG_MODE
+    if(hust_mc_ring_init(&mc_ring_m, ads_m.n_channels) != 0)
+    {
+        APP_ERROR_CHECK(NRF_ERROR_INVALID_PARAM);
+    }
+#endif
+#endif
+#if IMU_ENABLED
+    err_code = hust_imu_nrf_init(&imu_m, IMU_SAMPLE_RATE, imu_fifo_handler);
+    APP_ERROR_CHECK(err_code);
+    NRF_LOG_INFO("IMU id 0x%02x at 0x%02x, %d Hz", imu_m.who_am_i, imu_m.addr, imu_m.rate);
+#endif
+    stream_config_m.channel_mask = stream_channel_mask_all();
+    stream_packet_mask_set();
+    // nguon lay mau chi chay khi may trang thai cho phep (acquisition_state_update)
+
+    err_code = app_timer_start(m_telemetry_timer_id, TELEMETRY_TIMER_INTERVAL, NULL);
+    APP_ERROR_CHECK(err_code);
+#if BCAST_ENABLED
+    err_code = app_timer_start(m_bcast_timer_id, BCAST_PUBLISH_INTERVAL, NULL);
     APP_ERROR_CHECK(err_code);
+#endif
 }
 
 
@@ -242,44 +908,78 @@ static void nrf_qwr_error_handler(uint32_t nrf_error)
 }
 
 
-/**@brief Function for handling the data from the Nordic UART Service.
+/**@brief Function for queueing the stream control commands of a received write.
  *
- * @details This function will process the data received from the Nordic UART BLE Service and send
- *          it to the UART module.
- *
- * @param[in] p_evt       Nordic UART Service event.
+ * @param[in] p_queue  Queue of the service the commands were written to.
+ * @param[in] source   Connection the commands came from, the response goes back to it.
+ * @param[in] p_data   One or more commands (see hust_cmd.h).
+ * @param[in] length   Length of p_data.
  */
-/**@snippet [Handling the data received over BLE] */
-static void nus_data_handler(ble_nus_evt_t * p_evt)
+static void cmd_receive(hust_cmd_queue_t * p_queue, uint16_t source, const uint8_t * p_data, int length)
 {
-
-    if (p_evt->type == BLE_NUS_EVT_RX_DATA)
+    while (length > 0)
     {
-        uint32_t err_code;
-
-        NRF_LOG_DEBUG("Received data from BLE NUS. Writing data on UART.");
-        NRF_LOG_HEXDUMP_DEBUG(p_evt->params.rx_data.p_data, p_evt->params.rx_data.length);
-
-        for (uint32_t i = 0; i < p_evt->params.rx_data.length; i++)
+        hust_cmd_t cmd;
+        int n = hust_cmd_parse(p_data, length, &cmd);
+        if (n < 0)
         {
-            do
-            {
-                err_code = app_uart_put(p_evt->params.rx_data.p_data[i]);
-                if ((err_code != NRF_SUCCESS) && (err_code != NRF_ERROR_BUSY))
-                {
-                    NRF_LOG_ERROR("Failed receiving NUS message. Error 0x%x. ", err_code);
-                    APP_ERROR_CHECK(err_code);
-                }
-            } while (err_code == NRF_ERROR_BUSY);
+            NRF_LOG_WARNING("Truncated command.");
+            break;
         }
-        if (p_evt->params.rx_data.p_data[p_evt->params.rx_data.length - 1] == '\r')
+        cmd.source = source;
+        if (hust_cmd_queue_push(p_queue, &cmd) != 0)
         {
-            while (app_uart_put('\n') == NRF_ERROR_BUSY);
+            NRF_LOG_WARNING("Command queue full, opcode 0x%02x dropped.", cmd.opcode);
         }
+        p_data += n;
+        length -= n;
     }
-
 }
-/**@snippet [Handling the data received over BLE] */
+
+#if BIO_SERVICE_ENABLED
+/**@brief Function for handling the commands written to the biosignal control characteristic.
+ *
+ * @details Same commands as NUS RX, answered on the control characteristic by cmd_process.
+ */
+static void bio_control_handler(const uint8_t * p_data, uint16_t length)
+{
+    NRF_LOG_DEBUG("Received command on the control characteristic.");
+    NRF_LOG_HEXDUMP_DEBUG(p_data, length);
+
+    cmd_receive(&bio_cmd_queue_m, m_bio_service.conn_handle, p_data, length);
+}
+#endif
+
+/**@brief Function for handling the data from the Nordic UART Service.
+ *
+ * @details Received data carries stream control commands (see hust_cmd.h). They are queued here
+ *          and applied by the main loop between two packets. COMM_STARTED/COMM_STOPPED (CCCD of
+ *          the TX characteristic) start and stop the stream to that central.
+ *
+ * @param[in] p_evt       Nordic UART Service event.
+ */
+/**@snippet [Handling the data received over BLE] */
+static void nus_data_handler(ble_nus_evt_t * p_evt)
+{
+
+    if (p_evt->type == BLE_NUS_EVT_RX_DATA)
+    {
+        NRF_LOG_DEBUG("Received command from BLE NUS.");
+        NRF_LOG_HEXDUMP_DEBUG(p_evt->params.rx_data.p_data, p_evt->params.rx_data.length);
+
+        cmd_receive(&cmd_queue_m, p_evt->conn_handle, p_evt->params.rx_data.p_data, p_evt->params.rx_data.length);
+    }
+    else if (p_evt->type == BLE_NUS_EVT_COMM_STARTED || p_evt->type == BLE_NUS_EVT_COMM_STOPPED)
+    {
+        hust_fanout_link_t * p_link = hust_fanout_link_find(&fanout_m, p_evt->conn_handle);
+        if (p_link != NULL)
+        {
+            fanout_nus[p_link - fanout_m.link] = p_evt->type == BLE_NUS_EVT_COMM_STARTED;
+        }
+    }
+
+}
+/**@snippet [Handling the data received over BLE] */
 
 
 /**@brief Function for initializing services that will be used by the application.
@@ -293,8 +993,11 @@ static void services_init(void)
     // Initialize Queued Write Module.
     qwr_init.error_handler = nrf_qwr_error_handler;
 
-    err_code = nrf_ble_qwr_init(&m_qwr, &qwr_init);
-    APP_ERROR_CHECK(err_code);
+    for (uint32_t i = 0; i < NRF_SDH_BLE_TOTAL_LINK_COUNT; i++)
+    {
+        err_code = nrf_ble_qwr_init(&m_qwr[i], &qwr_init);
+        APP_ERROR_CHECK(err_code);
+    }
 
     // Initialize NUS.
     memset(&nus_init, 0, sizeof(nus_init));
@@ -303,6 +1006,16 @@ static void services_init(void)
 
     err_code = ble_nus_init(&m_nus, &nus_init);
     APP_ERROR_CHECK(err_code);
+
+    // Initialize telemetry service, sharing the NUS base UUID.
+    err_code = hust_telemetry_service_init(&m_telemetry_service, m_nus.uuid_type);
+    APP_ERROR_CHECK(err_code);
+
+#if BIO_SERVICE_ENABLED
+    // Initialize biosignal service, sharing the NUS base UUID.
+    err_code = hust_bio_service_init(&m_bio_service, m_nus.uuid_type, bio_control_handler);
+    APP_ERROR_CHECK(err_code);
+#endif
 }
 
 
@@ -381,6 +1094,7 @@ static void sleep_mode_enter(void)
 }
 
 
+#if !BCAST_ENABLED
 /**@brief Function for handling advertising events.
  *
  * @details This function will be called for advertising events which are passed to the application.
@@ -398,12 +1112,208 @@ static void on_adv_evt(ble_adv_evt_t ble_adv_evt)
             APP_ERROR_CHECK(err_code);
             break;
         case BLE_ADV_EVT_IDLE:
-            sleep_mode_enter();
+            if (hust_fanout_count(&fanout_m) == 0)
+            {
+                sleep_mode_enter();
+            }
             break;
         default:
             break;
     }
 }
+#endif
+
+
+/**@brief Function for advertising again after a connection or a disconnection.
+ *
+ * @details Keeps advertising while fewer than FANOUT_LINKS centrals are connected, so a second
+ *          central can join the stream. Advertising already running or all links in use is not an
+ *          error.
+ */
+static void advertising_continue(void)
+{
+    uint32_t err_code = ble_advertising_start(&m_advertising, BLE_ADV_MODE_FAST);
+    if ((err_code != NRF_ERROR_INVALID_STATE) && (err_code != NRF_ERROR_CONN_COUNT))
+    {
+        APP_ERROR_CHECK(err_code);
+    }
+}
+
+
+/**@brief Function for sizing the packets for the centrals receiving the stream.
+ *
+ * @details Packets are built once for every central, so they fit the smallest MTU among the
+ *          centrals receiving the stream (among all connected centrals while none receives it).
+ */
+static void fanout_payload_update(void)
+{
+    uint16_t payload = 0;
+    bool ready = hust_fanout_ready_count(&fanout_m) > 0;
+
+    for(int i = 0; i < HUST_FANOUT_LINKS_MAX; i++)
+    {
+        hust_fanout_link_t const * p_link = &fanout_m.link[i];
+        if(p_link->conn_handle != BLE_CONN_HANDLE_INVALID && (p_link->ready || !ready)
+           && (payload == 0 || fanout_payload[i] < payload))
+        {
+            payload = fanout_payload[i];
+        }
+    }
+    if(payload == 0)
+    {
+        return;                             // khong con central nao: giu kich thuoc cu cho lich su
+    }
+    if(payload != m_ble_nus_max_data_len)
+    {
+        m_ble_nus_max_data_len = payload;
+        NRF_LOG_INFO("Data len is set to 0x%X(%d)", m_ble_nus_max_data_len, m_ble_nus_max_data_len);
+#if BIO_SERVICE_ENABLED
+        bio_schema_changed = true;          // max_packet
+#endif
+    }
+#if LINK_ENABLED
+    hust_link_payload_set(&link_m, m_ble_nus_max_data_len, 0);
+#endif
+}
+
+
+/**@brief Function for checking whether a central listens to the stream.
+ *
+ * @param[in] p_link  Fan-out link of the central.
+ *
+ * @return true if the central holds the L2CAP channel, subscribed to the biosignal data
+ *         characteristic or to NUS TX.
+ */
+static bool fanout_link_receiving(hust_fanout_link_t const * p_link)
+{
+#if L2CAP_ENABLED
+    if(hust_l2cap_open(&m_l2cap) && m_l2cap.conn_handle == p_link->conn_handle)
+    {
+        return true;
+    }
+#endif
+#if BIO_SERVICE_ENABLED
+    if(m_bio_service.data_notify && m_bio_service.conn_handle == p_link->conn_handle)
+    {
+        return true;
+    }
+#endif
+    return fanout_nus[p_link - fanout_m.link];
+}
+
+
+/**@brief Function for updating which centrals receive the stream.
+ *
+ * @details A central starts at the next packet built after it subscribed.
+ *
+ * @return Number of centrals receiving the stream.
+ */
+static uint8_t fanout_ready_update(void)
+{
+    uint8_t ready_count = hust_fanout_ready_count(&fanout_m);
+
+    for(int i = 0; i < HUST_FANOUT_LINKS_MAX; i++)
+    {
+        hust_fanout_link_t * p_link = &fanout_m.link[i];
+        if(p_link->conn_handle != BLE_CONN_HANDLE_INVALID)
+        {
+            hust_fanout_link_ready(&fanout_m, p_link, fanout_link_receiving(p_link));
+        }
+    }
+    if(hust_fanout_ready_count(&fanout_m) != ready_count)
+    {
+        fanout_payload_update();
+        ready_count = hust_fanout_ready_count(&fanout_m);
+    }
+    return ready_count;
+}
+
+
+/**@brief Function for sending one packet to one central.
+ *
+ * @details Goes to the L2CAP channel when this central opened it, else to the data characteristic
+ *          of the biosignal service when this central subscribed to it, else to NUS TX. While the
+ *          central listens to biosignal events, data packets leave HUST_BIO_EVENT_RESERVE entries of
+ *          the HVN queue free so an event never waits behind the data backlog.
+ *
+ * @param[in,out] p_link    Fan-out link of the central, its HVN queue depth.
+ * @param[in]     p_packet  Packet in the fan-out ring, copied by the SoftDevice.
+ * @param[in,out] p_length  Packet length, set to the number of bytes queued.
+ */
+static uint32_t fanout_link_send(hust_fanout_link_t * p_link, uint8_t * p_packet, uint16_t * p_length)
+{
+    uint16_t conn_handle = p_link->conn_handle;
+    uint32_t err_code;
+
+#if L2CAP_ENABLED
+    if(hust_l2cap_open(&m_l2cap) && m_l2cap.conn_handle == conn_handle)
+    {
+        return hust_l2cap_send(&m_l2cap, p_packet, *p_length);
+    }
+#endif
+#if BIO_SERVICE_ENABLED
+    if(m_bio_service.data_notify && m_bio_service.conn_handle == conn_handle)
+    {
+        if(m_bio_service.event_notify && conn_cfg_m.hvn_tx_queue > HUST_BIO_EVENT_RESERVE
+           && p_link->hvn_inflight + HUST_BIO_EVENT_RESERVE >= conn_cfg_m.hvn_tx_queue)
+        {
+            return NRF_ERROR_RESOURCES;     // cho con lai danh cho event
+        }
+        err_code = hust_bio_data_send(&m_bio_service, p_packet, p_length);
+    }
+    else
+#endif
+    {
+        err_code = ble_nus_data_send(&m_nus, p_packet, p_length, conn_handle);
+    }
+    if(err_code == NRF_SUCCESS)
+    {
+        hvn_queued(conn_handle);
+    }
+    return err_code;
+}
+
+
+/**@brief Function for sending the packets of the fan-out ring to every central receiving the stream.
+ *
+ * @details Every central is sent the same ring slot, the SoftDevice copies it, so a packet is built
+ *          and stored once whatever the number of centrals. A central stops at its first
+ *          NRF_ERROR_RESOURCES and goes on in the next call (after its HVN TX complete or L2CAP TX)
+ *          without holding back the others, a packet it failed to send counts as dropped for it.
+ */
+static void fanout_process(void)
+{
+    if(fanout_ready_update() == 0)
+    {
+        return;
+    }
+    HUST_PROF_START(nus_send);
+    for(int i = 0; i < HUST_FANOUT_LINKS_MAX; i++)
+    {
+        hust_fanout_link_t * p_link = &fanout_m.link[i];
+        uint8_t const * p_packet;
+        uint16_t length;
+
+        if(p_link->conn_handle == BLE_CONN_HANDLE_INVALID || !p_link->ready)
+        {
+            continue;
+        }
+        while((p_packet = hust_fanout_peek(&fanout_m, p_link, &length)) != NULL)
+        {
+            uint32_t err_code = fanout_link_send(p_link, (uint8_t *)p_packet, &length);
+            if(err_code == NRF_ERROR_RESOURCES)
+            {
+                break;                      // thu lai sau HVN TX complete / L2CAP TX
+            }
+            if(err_code != NRF_SUCCESS)
+            {
+                telemetry_m.nus_errors++;
+            }
+            hust_fanout_advance(p_link, err_code == NRF_SUCCESS);
+        }
+    }
+    HUST_PROF_STOP(nus_send, HUST_PROF_NUS_SEND);
+}
 
 
 /**@brief Function for handling BLE events.
@@ -418,41 +1328,137 @@ static void ble_evt_handler(ble_evt_t const * p_ble_evt, void * p_context)
     switch (p_ble_evt->header.evt_id)
     {
         case BLE_GAP_EVT_CONNECTED:
-            NRF_LOG_INFO("Connected");
+        {
+            uint16_t conn_handle = p_ble_evt->evt.gap_evt.conn_handle;
+            hust_fanout_link_t * p_link = hust_fanout_link_add(&fanout_m, conn_handle);
+            NRF_LOG_INFO("Connected 0x%x, %u of %u centrals", conn_handle, hust_fanout_count(&fanout_m), FANOUT_LINKS);
             err_code = bsp_indication_set(BSP_INDICATE_CONNECTED);
             APP_ERROR_CHECK(err_code);
-            m_conn_handle = p_ble_evt->evt.gap_evt.conn_handle;
-            err_code = nrf_ble_qwr_conn_handle_assign(&m_qwr, m_conn_handle);
+            if (p_link == NULL)
+            {
+                // SoftDevice cho toi da FANOUT_LINKS ket noi, khong xay ra
+                err_code = sd_ble_gap_disconnect(conn_handle, BLE_HCI_REMOTE_USER_TERMINATED_CONNECTION);
+                APP_ERROR_CHECK(err_code);
+                break;
+            }
+            err_code = nrf_ble_qwr_conn_handle_assign(&m_qwr[p_link - fanout_m.link], conn_handle);
             APP_ERROR_CHECK(err_code);
-            break;
+            fanout_nus[p_link - fanout_m.link] = false;
+            fanout_payload[p_link - fanout_m.link] = BLE_GATT_ATT_MTU_DEFAULT - OPCODE_LENGTH - HANDLE_LENGTH;
+            fanout_payload_update();
+            if (hust_fanout_count(&fanout_m) < FANOUT_LINKS)
+            {
+                advertising_continue();     // con cho cho central khac
+            }
+            if (m_conn_handle != BLE_CONN_HANDLE_INVALID)
+            {
+                break;                      // central phu: chi nhan stream
+            }
+            m_conn_handle = conn_handle;
+            telemetry_m.mtu = BLE_GATT_ATT_MTU_DEFAULT;
+            telemetry_m.tx_phy = BLE_GAP_PHY_1MBPS;
+            telemetry_m.rx_phy = BLE_GAP_PHY_1MBPS;
+            telemetry_m.conn_interval = p_ble_evt->evt.gap_evt.params.connected.conn_params.max_conn_interval;
+#if LINK_ENABLED
+            // RSSI cho quan ly ket noi, yeu cau 2M ngay
+            err_code = sd_ble_gap_rssi_start(m_conn_handle, LINK_RSSI_THRESHOLD_DBM, LINK_RSSI_SKIP_COUNT);
+            APP_ERROR_CHECK(err_code);
+            link_apply(hust_link_connected(&link_m, p_ble_evt->evt.gap_evt.params.connected.conn_params.max_conn_interval));
+#endif
+        } break;
 
         case BLE_GAP_EVT_DISCONNECTED:
-            NRF_LOG_INFO("Disconnected");
+        {
+            uint16_t conn_handle = p_ble_evt->evt.gap_evt.conn_handle;
+            hust_fanout_link_t * p_link = hust_fanout_link_find(&fanout_m, conn_handle);
+            if (p_link != NULL)
+            {
+                NRF_LOG_INFO("Disconnected 0x%x: %u packets sent, %u dropped", conn_handle, p_link->sent, p_link->dropped);
+                fanout_nus[p_link - fanout_m.link] = false;
+                hust_fanout_link_remove(&fanout_m, conn_handle);
+                fanout_payload_update();
+            }
             // LED indication will be changed when advertising starts.
+            advertising_continue();
+            if (conn_handle != m_conn_handle)
+            {
+                break;
+            }
             m_conn_handle = BLE_CONN_HANDLE_INVALID;
+            hust_latency_reset(&latency_m);
+            telemetry_m.hvn_inflight = 0;
+#if BIO_SERVICE_ENABLED
+            bio_tx_phy = 0;                 // bao lai PHY / interval o ket noi sau
+            bio_conn_interval = 0;
+#endif
+        } break;
+
+        case BLE_GAP_EVT_PHY_UPDATE:
+            if (p_ble_evt->evt.gap_evt.conn_handle != m_conn_handle)
+            {
+                break;                      // telemetry / quan ly ket noi theo central chinh
+            }
+            telemetry_m.tx_phy = p_ble_evt->evt.gap_evt.params.phy_update.tx_phy;
+            telemetry_m.rx_phy = p_ble_evt->evt.gap_evt.params.phy_update.rx_phy;
+#if LINK_ENABLED
+            // that bai: giu PHY cu, huy yeu cau
+            link_stat_log(hust_link_phy_updated(&link_m,
+                                                p_ble_evt->evt.gap_evt.params.phy_update.status == BLE_HCI_STATUS_CODE_SUCCESS
+                                                ? p_ble_evt->evt.gap_evt.params.phy_update.tx_phy : link_m.current.phy));
+#endif
             break;
 
         case BLE_GAP_EVT_PHY_UPDATE_REQUEST:
         {
             NRF_LOG_DEBUG("PHY update request.");
+#if LINK_ENABLED
+            // central de nghi PHY: tra loi bang PHY quan ly ket noi dang chon
+            ble_gap_phys_t const phys =
+            {
+                .rx_phys = link_m.target.phy,
+                .tx_phys = link_m.target.phy,
+            };
+#else
             ble_gap_phys_t const phys =
             {
                 .rx_phys = BLE_GAP_PHY_AUTO,
                 .tx_phys = BLE_GAP_PHY_AUTO,
             };
+#endif
             err_code = sd_ble_gap_phy_update(p_ble_evt->evt.gap_evt.conn_handle, &phys);
             APP_ERROR_CHECK(err_code);
         } break;
 
+        case BLE_GAP_EVT_CONN_PARAM_UPDATE:
+            if (p_ble_evt->evt.gap_evt.conn_handle != m_conn_handle)
+            {
+                break;
+            }
+            telemetry_m.conn_interval = p_ble_evt->evt.gap_evt.params.conn_param_update.conn_params.max_conn_interval;
+#if LINK_ENABLED
+            link_stat_log(hust_link_interval_updated(&link_m, telemetry_m.conn_interval));
+#endif
+            break;
+
+#if LINK_ENABLED
+        case BLE_GAP_EVT_RSSI_CHANGED:
+            if (p_ble_evt->evt.gap_evt.conn_handle != m_conn_handle)
+            {
+                break;
+            }
+            hust_link_rssi(&link_m, p_ble_evt->evt.gap_evt.params.rssi_changed.rssi);
+            break;
+
+#endif
         case BLE_GAP_EVT_SEC_PARAMS_REQUEST:
             // Pairing not supported
-            err_code = sd_ble_gap_sec_params_reply(m_conn_handle, BLE_GAP_SEC_STATUS_PAIRING_NOT_SUPP, NULL, NULL);
+            err_code = sd_ble_gap_sec_params_reply(p_ble_evt->evt.gap_evt.conn_handle, BLE_GAP_SEC_STATUS_PAIRING_NOT_SUPP, NULL, NULL);
             APP_ERROR_CHECK(err_code);
             break;
 
         case BLE_GATTS_EVT_SYS_ATTR_MISSING:
             // No system attributes have been stored.
-            err_code = sd_ble_gatts_sys_attr_set(m_conn_handle, NULL, 0, 0);
+            err_code = sd_ble_gatts_sys_attr_set(p_ble_evt->evt.gatts_evt.conn_handle, NULL, 0, 0);
             APP_ERROR_CHECK(err_code);
             break;
 
@@ -463,6 +1469,21 @@ static void ble_evt_handler(ble_evt_t const * p_ble_evt, void * p_context)
             APP_ERROR_CHECK(err_code);
             break;
 
+        case BLE_GATTS_EVT_HVN_TX_COMPLETE:
+        {
+            hust_fanout_link_t * p_link = hust_fanout_link_find(&fanout_m, p_ble_evt->evt.gatts_evt.conn_handle);
+            if (p_link != NULL)
+            {
+                hust_fanout_hvn_complete(p_link, p_ble_evt->evt.gatts_evt.params.hvn_tx_complete.count);
+            }
+            if (p_ble_evt->evt.gatts_evt.conn_handle != m_conn_handle)
+            {
+                break;                      // hang doi HVN cua central phu: fanout_process gui tiep
+            }
+            hust_latency_tx_complete(&latency_m, p_ble_evt->evt.gatts_evt.params.hvn_tx_complete.count, app_timer_cnt_get());
+            hust_telemetry_hvn_complete(&telemetry_m, p_ble_evt->evt.gatts_evt.params.hvn_tx_complete.count);
+        } break;
+
         case BLE_GATTS_EVT_TIMEOUT:
             // Disconnect on GATT Server timeout event.
             err_code = sd_ble_gap_disconnect(p_ble_evt->evt.gatts_evt.conn_handle,
@@ -477,9 +1498,50 @@ static void ble_evt_handler(ble_evt_t const * p_ble_evt, void * p_context)
 }
 
 
+/**@brief Function for setting the connection configuration sized from the throughput target.
+ *
+ * @details Sets the HVN TX queue (BLE_CONN_CFG_GATTS) and the GAP event length (BLE_CONN_CFG_GAP)
+ *          from conn_cfg_m, and the L2CAP channel of the stream (BLE_CONN_CFG_L2CAP), on top of the
+ *          defaults of nrf_sdh_ble_default_cfg_set().
+ *
+ * @param[in] ram_start  Application RAM start from the linker script.
+ *
+ * @return NRF_SUCCESS, or NRF_ERROR_NO_MEM if the SoftDevice RAM below ram_start is too small.
+ */
+static ret_code_t conn_cfg_set(uint32_t ram_start)
+{
+    ret_code_t err_code;
+    ble_cfg_t  ble_cfg;
+
+    memset(&ble_cfg, 0, sizeof(ble_cfg));
+    ble_cfg.conn_cfg.conn_cfg_tag                     = APP_BLE_CONN_CFG_TAG;
+    ble_cfg.conn_cfg.params.gap_conn_cfg.conn_count   = NRF_SDH_BLE_TOTAL_LINK_COUNT;
+    ble_cfg.conn_cfg.params.gap_conn_cfg.event_length = conn_cfg_m.event_length;
+    err_code = sd_ble_cfg_set(BLE_CONN_CFG_GAP, &ble_cfg, ram_start);
+    if(err_code != NRF_SUCCESS)
+    {
+        return err_code;
+    }
+
+    memset(&ble_cfg, 0, sizeof(ble_cfg));
+    ble_cfg.conn_cfg.conn_cfg_tag                            = APP_BLE_CONN_CFG_TAG;
+    ble_cfg.conn_cfg.params.gatts_conn_cfg.hvn_tx_queue_size = conn_cfg_m.hvn_tx_queue;
+    err_code = sd_ble_cfg_set(BLE_CONN_CFG_GATTS, &ble_cfg, ram_start);
+#if L2CAP_ENABLED
+    if(err_code == NRF_SUCCESS)
+    {
+        err_code = hust_l2cap_conn_cfg_set(APP_BLE_CONN_CFG_TAG, ram_start);
+    }
+#endif
+    return err_code;
+}
+
+
 /**@brief Function for the SoftDevice initialization.
  *
- * @details This function initializes the SoftDevice and the BLE event interrupt.
+ * @details This function initializes the SoftDevice and the BLE event interrupt. The HVN TX queue
+ *          and the GAP event length are sized for CONN_CFG_TARGET_BPS and reduced one notification
+ *          at a time until the SoftDevice fits below the RAM origin of the linker script.
  */
 static void ble_stack_init(void)
 {
@@ -493,24 +1555,70 @@ static void ble_stack_init(void)
     uint32_t ram_start = 0;
     err_code = nrf_sdh_ble_default_cfg_set(APP_BLE_CONN_CFG_TAG, &ram_start);
     APP_ERROR_CHECK(err_code);
+    uint32_t const ram_origin = ram_start;
+
+    if(hust_link_conn_cfg(&conn_cfg_m, CONN_CFG_TARGET_BPS, CONN_CFG_INTERVAL, BLE_GAP_PHY_1MBPS,
+                          NRF_SDH_BLE_GATT_MAX_MTU_SIZE - OPCODE_LENGTH - HANDLE_LENGTH, NRF_SDH_BLE_GAP_DATA_LENGTH,
+                          NRF_SDH_BLE_GAP_EVENT_LENGTH) != 0)
+    {
+        NRF_LOG_WARNING("%u bps does not fit a %u ms interval", CONN_CFG_TARGET_BPS, CONN_CFG_INTERVAL * 5 / 4);
+    }
 
     // Enable BLE stack.
-    err_code = nrf_sdh_ble_enable(&ram_start);
+    for(;;)
+    {
+        // sd_ble_enable tra ve RAM SoftDevice can: vuot goc RAM cua linker thi bot hang doi, thu lai
+        ram_start = ram_origin;
+        err_code = conn_cfg_set(ram_start);
+        if(err_code == NRF_SUCCESS)
+        {
+            err_code = nrf_sdh_ble_enable(&ram_start);
+        }
+        if(err_code != NRF_ERROR_NO_MEM || !hust_link_conn_cfg_shrink(&conn_cfg_m))
+        {
+            break;
+        }
+        NRF_LOG_WARNING("SoftDevice RAM above 0x%x, HVN TX queue reduced to %u", ram_origin, conn_cfg_m.hvn_tx_queue);
+    }
     APP_ERROR_CHECK(err_code);
+    NRF_LOG_INFO("HVN TX queue %u, event length %u x 1.25 ms, %u bytes RAM spare",
+                 conn_cfg_m.hvn_tx_queue, conn_cfg_m.event_length, ram_origin - ram_start);
+    telemetry_m.hvn_tx_queue = conn_cfg_m.hvn_tx_queue;
+    telemetry_m.event_length = conn_cfg_m.event_length;
 
     // Register a handler for BLE events.
     NRF_SDH_BLE_OBSERVER(m_ble_observer, APP_BLE_OBSERVER_PRIO, ble_evt_handler, NULL);
+
+#if LINK_ENABLED
+    // connection event keo dai toi het interval khi con du lieu: interval dai van gui du packet
+    ble_opt_t opt;
+    memset(&opt, 0, sizeof(opt));
+    opt.common_opt.conn_evt_ext.enable = 1;
+    err_code = sd_ble_opt_set(BLE_COMMON_OPT_CONN_EVT_EXT, &opt);
+    APP_ERROR_CHECK(err_code);
+#endif
 }
 
 
 /**@brief Function for handling events from the GATT library. */
 void gatt_evt_handler(nrf_ble_gatt_t * p_gatt, nrf_ble_gatt_evt_t const * p_evt)
 {
-    if ((m_conn_handle == p_evt->conn_handle) && (p_evt->evt_id == NRF_BLE_GATT_EVT_ATT_MTU_UPDATED))
+    hust_fanout_link_t * p_link = hust_fanout_link_find(&fanout_m, p_evt->conn_handle);
+    if ((p_link != NULL) && (p_evt->evt_id == NRF_BLE_GATT_EVT_ATT_MTU_UPDATED))
     {
-        m_ble_nus_max_data_len = p_evt->params.att_mtu_effective - OPCODE_LENGTH - HANDLE_LENGTH;
-        NRF_LOG_INFO("Data len is set to 0x%X(%d)", m_ble_nus_max_data_len, m_ble_nus_max_data_len);
+        fanout_payload[p_link - fanout_m.link] = p_evt->params.att_mtu_effective - OPCODE_LENGTH - HANDLE_LENGTH;
+        if (m_conn_handle == p_evt->conn_handle)
+        {
+            telemetry_m.mtu = p_evt->params.att_mtu_effective;
+        }
+        fanout_payload_update();
+    }
+#if LINK_ENABLED
+    if ((m_conn_handle == p_evt->conn_handle) && (p_evt->evt_id == NRF_BLE_GATT_EVT_DATA_LENGTH_UPDATED))
+    {
+        hust_link_payload_set(&link_m, 0, p_evt->params.data_length);
     }
+#endif
     NRF_LOG_DEBUG("ATT MTU exchange completed. central 0x%x peripheral 0x%x",
                   p_gatt->att_mtu_desired_central,
                   p_gatt->att_mtu_desired_periph);
@@ -600,6 +1708,10 @@ void uart_event_handle(app_uart_evt_t * p_event)
                     {
                         uint16_t length = (uint16_t)index;
                         err_code = ble_nus_data_send(&m_nus, data_array, &length, m_conn_handle);
+                        if (err_code == NRF_SUCCESS)
+                        {
+                            hvn_queued(m_conn_handle);
+                        }
                         if ((err_code != NRF_ERROR_INVALID_STATE) &&
                             (err_code != NRF_ERROR_RESOURCES) &&
                             (err_code != NRF_ERROR_NOT_FOUND))
@@ -661,10 +1773,19 @@ static void uart_init(void)
 
 
 /**@brief Function for initializing the Advertising functionality.
+ *
+ * @details With BCAST_ENABLED the only advertising set carries the broadcast stream, the device
+ *          is not connectable.
  */
 static void advertising_init(void)
 {
     uint32_t               err_code;
+#if BCAST_ENABLED
+    err_code = hust_bcast_init(&bcast_m, BCAST_INTERVAL, BCAST_DECIMATION, BCAST_PHY);
+    APP_ERROR_CHECK(err_code);
+    m_ble_nus_max_data_len = BCAST_PACKET_SIZE;
+    UNUSED_VARIABLE(m_adv_uuids);           // khong quang cao de ket noi
+#else
     ble_advertising_init_t init;
 
     memset(&init, 0, sizeof(init));
@@ -676,6 +1797,7 @@ static void advertising_init(void)
     init.srdata.uuids_complete.uuid_cnt = sizeof(m_adv_uuids) / sizeof(m_adv_uuids[0]);
     init.srdata.uuids_complete.p_uuids  = m_adv_uuids;
 
+    init.config.ble_adv_on_disconnect_disabled = true;     // advertising_continue
     init.config.ble_adv_fast_enabled  = true;
     init.config.ble_adv_fast_interval = APP_ADV_INTERVAL;
     init.config.ble_adv_fast_timeout  = APP_ADV_DURATION;
@@ -685,6 +1807,7 @@ static void advertising_init(void)
     APP_ERROR_CHECK(err_code);
 
     ble_advertising_conn_cfg_tag_set(&m_advertising, APP_BLE_CONN_CFG_TAG);
+#endif
 }
 
 
@@ -744,69 +1867,1168 @@ static void idle_state_handle(void)
  */
 static void advertising_start(void)
 {
+#if BCAST_ENABLED
+    uint32_t err_code = hust_bcast_start(&bcast_m);
+#else
     uint32_t err_code = ble_advertising_start(&m_advertising, BLE_ADV_MODE_FAST);
+#endif
     APP_ERROR_CHECK(err_code);
 }
 
-/**@brief Application main function.
+#if HIST_ENABLED || FLOG_ENABLED
+/**@brief Function for keeping a packet built while the link is down.
+ *
+ * @details The packet goes to the compressed RAM history first. When the history is full its
+ *          oldest packets move to the flash log (dropped without FLOG_ENABLED), so a short outage
+ *          does not write the flash at all.
+ *
+ * @return NRF_SUCCESS, or NRF_ERROR_NO_MEM if the packet was dropped.
  */
-int main(void)
+static uint32_t history_store(const uint8_t * p_ble_packet, uint16_t length)
 {
-    bool erase_bonds;
-    ble_packet_m.count_packet = 0;
-    // Initialize.
-    uart_init();
-    log_init();
-    timers_init();
-    buttons_leds_init(&erase_bonds);
-    power_management_init();
-    ble_stack_init();
-    gap_params_init();
-    gatt_init();
-    services_init();
-    advertising_init();
-    conn_params_init();
-
-    // Start execution.
-    printf("\r\nUART started.\r\n");
-    NRF_LOG_INFO("Debug logging for UART over RTT started.");
-    application_timers_start();
-    advertising_start();
+#if HIST_ENABLED
+    uint8_t oldest[HUST_HIST_PACKET_MAX];
 
-    // chon type ble packet muon truyen 
-    ble_packet_m.sensor_type = ECG_SENSOR_TYPE;
-    // Enter main loop.
-    for (;;)
+    for(;;)
     {
-        if(ecg_sample_count == 0 && data_array_exist == false)
+        if(hust_hist_push(&hist_m, p_ble_packet, length, app_timer_cnt_get()) == 0)
         {
-            // update so sample va data_size theo type of ble packet
-            sample_transfer_m = set_sample_transfer(ble_packet_m);
-            ble_packet_m.data_size = sample_transfer_m.ecg_sample * ECG_DATA_LENGTH * ECG_CHANNEL + sample_transfer_m.imu_sample*IMU_DATA_LENGTH*IMU_CHANNEL;
-            ble_packet_size = 8 + 1 + 1 + 1 + ble_packet_m.data_size;  // sizeof(timestamp) + sizeof(sensor_type) + sizeof(data_size) + sizeof(count_packet) + sizeof(data)
-
-            ble_packet_m.ecg_data = malloc(sizeof(ecg_data_t)*sample_transfer_m.ecg_sample);
-            ble_packet_m.imu_data = malloc(sizeof(imu_data_t)*sample_transfer_m.imu_sample);
-            data_array_exist = true;
+            return NRF_SUCCESS;
         }
-        
-        if(ecg_sample_count == sample_transfer_m.ecg_sample)
+        int oldest_length = hust_hist_pop(&hist_m, oldest, sizeof(oldest));
+        if(oldest_length == 0)
         {
-            uint8_t * ble_packet_temp;
-            ble_packet_m.count_packet++;
-
-            convert_data_to_ble_packet(ble_packet_m, &ble_packet_temp);
-            //print_ble_packet_data(&ble_packet_temp, ble_packet_size);
-            ble_nus_data_send(&m_nus, ble_packet_temp, (uint16_t *)&ble_packet_size, m_conn_handle);
-
-            free(ble_packet_m.ecg_data);
-            free(ble_packet_m.imu_data);
-            free(ble_packet_temp);
-            data_array_exist = false;
-            ecg_sample_count = 0;
+            break;                          // lich su rong ma van khong du cho: ghi thang xuong flash
+        }
+#if FLOG_ENABLED
+        (void)hust_flog_append(&flog_m, oldest, (uint16_t)oldest_length);
+#endif
+    }
+#endif
+#if FLOG_ENABLED
+    return hust_flog_append(&flog_m, p_ble_packet, length) == 0 ? NRF_SUCCESS : NRF_ERROR_NO_MEM;
+#else
+    return NRF_ERROR_NO_MEM;
+#endif
+}
+#endif
+
+/**@brief Function for handing a packed BLE packet to the centrals receiving the stream.
+ *
+ * @details The packet is copied once into the fan-out ring and sent to every central by
+ *          fanout_process. NRF_ERROR_RESOURCES only when every central still has HUST_FANOUT_SLOTS
+ *          packets to send, a slower central loses its oldest packets instead. With BCAST_ENABLED
+ *          the packet goes into the broadcast PDU instead, NRF_ERROR_RESOURCES while that PDU is
+ *          full. Updates the pipeline telemetry counters with the result.
+ *
+ * @param[in]     p_ble_packet  Packed BLE packet.
+ * @param[in,out] p_length      Packet length.
+ */
+static uint32_t ble_packet_send(uint8_t * p_ble_packet, uint16_t * p_length)
+{
+#if HIST_ENABLED || FLOG_ENABLED
+    if(state_m.state == HUST_STATE_BUFFERING)
+    {
+        // mat ket noi: packet vao lich su RAM / log flash, backfill_process gui lai khi ket noi lai
+        return history_store(p_ble_packet, *p_length);
+    }
+#endif
+    uint32_t err_code;
+#if BCAST_ENABLED
+    switch(hust_bcast_tx_offer(&bcast_m.tx, p_ble_packet, *p_length))
+    {
+        case 0:
+            err_code = NRF_SUCCESS;         // vao PDU dang gom hoac bo qua theo BCAST_DECIMATION
+            break;
+        case -1:
+            err_code = NRF_ERROR_RESOURCES; // PDU day, dua lai sau lan cap nhat advertising
+            break;
+#else
+    switch(hust_fanout_push(&fanout_m, p_ble_packet, *p_length))
+    {
+        case 0:
+            err_code = NRF_SUCCESS;
+            fanout_process();               // gui ngay cho central con cho trong hang doi
+            break;
+        case -1:
+            err_code = NRF_ERROR_RESOURCES; // moi central deu con HUST_FANOUT_SLOTS packet chua gui
+            break;
+#endif
+        default:
+            err_code = NRF_ERROR_DATA_SIZE;
+            break;
+    }
+    if(err_code == NRF_SUCCESS)
+    {
+        telemetry_m.packets_sent++;
+        telemetry_m.bytes_sent += *p_length;
+#if FLOG_ENABLED
+        hust_flog_sent(&flog_m, *p_length);
+#endif
+    }
+    else if(err_code == NRF_ERROR_RESOURCES)
+    {
+        telemetry_m.nus_resources++;
+    }
+    else
+    {
+        telemetry_m.nus_errors++;
+    }
+    return err_code;
+}
+
+/**@brief Function for handing a live packet to ble_packet_send, keeping it if the queue is full.
+ *
+ * @details A packet refused with NRF_ERROR_RESOURCES is copied to held_packet instead of being
+ *          dropped and held_packet_send sends it again before the next packet is built. While a
+ *          packet is held the next one is held behind it, so packets go out in order.
+ *
+ * @param[in]     p_ble_packet  Packed BLE packet.
+ * @param[in,out] p_length      Packet length.
+ */
+static uint32_t ble_packet_send_or_hold(uint8_t * p_ble_packet, uint16_t * p_length)
+{
+    uint32_t err_code = held_packet_count == 0 ? ble_packet_send(p_ble_packet, p_length) : NRF_ERROR_RESOURCES;
+    if(err_code == NRF_ERROR_RESOURCES && held_packet_count < HELD_PACKETS)
+    {
+        memcpy(held_packet[held_packet_count], p_ble_packet, *p_length);
+        held_packet_length[held_packet_count] = *p_length;
+        held_packet_count++;
+    }
+    return err_code;
+}
+
+/**@brief Function for resending the packets that did not fit in the HVN queue, oldest first.
+ *
+ * @details No new packet is built until the held packets go out, the samples meanwhile wait in
+ *          the sample rings.
+ *
+ * @return true if no packet is held any more.
+ */
+static bool held_packet_send(void)
+{
+    while(held_packet_count > 0)
+    {
+        uint16_t length = held_packet_length[0];
+        uint32_t err_code = ble_packet_send(held_packet[0], &length);
+        if(err_code == NRF_ERROR_RESOURCES)
+        {
+            return false;                   // thu lai sau HVN TX complete
+        }
+#if HUST_LATENCY_TRAILER_ENABLED
+        if(err_code == NRF_SUCCESS)
+        {
+            hust_latency_sent(&latency_m, held_packet[0][BLE_PACKET_HEADER_SIZE - 1], app_timer_cnt_get());
+        }
+#endif
+        // gui xong, hoac loi khac (mat ket noi): bo packet
+        held_packet_count--;
+        memmove(held_packet[0], held_packet[1], held_packet_count * sizeof(held_packet[0]));
+        memmove(held_packet_length, held_packet_length + 1, held_packet_count * sizeof(held_packet_length[0]));
+    }
+    return true;
+}
+
+#if HIST_ENABLED || FLOG_ENABLED
+/**@brief Function for sending the packets stored while the link was down.
+ *
+ * @details Stored packets go out unchanged (timestamp and count_packet of when they were built)
+ *          between the live packets, oldest first: the flash log, then the RAM history. With the
+ *          flash log the backfill is limited to FLOG_BACKFILL_SHARE percent of the bytes sent since
+ *          reconnecting, without it only fills the HVN queue when no live packet is ready. A packet
+ *          stays stored until the SoftDevice accepts it, packets larger than the current MTU wait
+ *          for the MTU exchange.
+ *
+ * @param[in] live_pending  A live packet can be sent right away.
+ *
+ * @return true if another stored packet can be sent right away.
+ */
+static bool backfill_process(bool live_pending)
+{
+    uint8_t data[HUST_HIST_PACKET_MAX];
+    int length = 0;
+
+#if FLOG_ENABLED
+    UNUSED_PARAMETER(live_pending);
+    if(!hust_flog_backfill_turn(&flog_m))
+    {
+        return false;
+    }
+    length = hust_flog_peek(&flog_m, data, sizeof(data));
+    if(length == 0 && !hust_flog_empty(&flog_m))
+    {
+        // phan cuoi con trong RAM: ghi len flash roi doc lai
+        hust_flog_flush(&flog_m);
+        return false;
+    }
+    bool from_flash = length > 0;
+#else
+    if(live_pending)
+    {
+        return false;
+    }
+#endif
+#if HIST_ENABLED
+    if(length == 0)
+    {
+        length = hust_hist_peek(&hist_m, data, sizeof(data));
+    }
+#endif
+    if(length == 0 || length > m_ble_nus_max_data_len)
+    {
+        return false;
+    }
+    uint16_t ble_packet_length = (uint16_t)length;
+    if(ble_packet_send(data, &ble_packet_length) != NRF_SUCCESS)
+    {
+        return false;                       // thu lai sau HVN TX complete
+    }
+#if HUST_LATENCY_TRAILER_ENABLED
+    // giu hang doi HVN cua latency_m dung thu tu, trailer cu trong packet khong con y nghia
+    hust_latency_sent(&latency_m, data[BLE_PACKET_HEADER_SIZE - 1], app_timer_cnt_get());
+#endif
+#if FLOG_ENABLED
+    if(from_flash)
+    {
+        hust_flog_consume(&flog_m, (uint16_t)length);
+        return true;
+    }
+    hust_flog_backfill_add(&flog_m, (uint16_t)length);     // lich su RAM tinh chung share
+#endif
+#if HIST_ENABLED
+    hust_hist_consume(&hist_m);
+#endif
+    return true;
+}
+#endif
+
+#if MC_MODE
+/**@brief Function for packing buffered EEG/EMG frames into multichannel (hust_mc) packets.
+ *
+ * @details Gathers MC_PACK_FRAMES frames, packs the largest prefix that fits the current MTU
+ *          (hust_mc format) and keeps the rest for the next packet.
+ */
+static void mc_packet_process(void)
+{
+    int n_channels = mc_ring_m.n_channels;
+    uint64_t sample_index;
+
+    while(mc_block_frames < MC_PACK_FRAMES
+          && hust_mc_ring_pop(&mc_ring_m, mc_block + mc_block_frames * n_channels, &sample_index) == 0)
+    {
+        if(mc_block_frames == 0)
+        {
+            mc_block_index = sample_index;
+        }
+        mc_block_frames++;
+    }
+    if(mc_block_frames < MC_PACK_FRAMES)
+    {
+        return;
+    }
+
+    uint8_t data[HUST_MC_MAX_DATA_SIZE];
+    int data_size = m_ble_nus_max_data_len - BLE_PACKET_HEADER_SIZE;
+    int length;
+    HUST_PROF_START(pack);
+    int n = hust_mc_pack(mc_block, n_channels, mc_block_frames, (hust_codec_t)stream_config_m.codec, stream_config_m.codec_param,
+                         data, data_size < HUST_MC_MAX_DATA_SIZE ? data_size : HUST_MC_MAX_DATA_SIZE, &length);
+    if(n <= 0)
+    {
+        // MTU chua du cho 1 frame (truoc khi trao doi MTU): bo block
+        HUST_PROF_STOP(pack, HUST_PROF_PACK);
+        telemetry_m.samples_dropped += mc_block_frames;
+        mc_block_frames = 0;
+        return;
+    }
+
+    uint8_t * ble_packet_temp;
+    ble_packet_m.count_packet++;
+    timestamp_set(&ble_packet_m.timestamp, mc_block_index);
+    ble_packet_m.data_size = (uint8_t)length;
+    convert_data_to_ble_packet(ble_packet_m, &ble_packet_temp);     // chi ghi header voi sensor_type nhieu channel
+    memcpy(ble_packet_temp + BLE_PACKET_HEADER_SIZE, data, length);
+    HUST_PROF_STOP(pack, HUST_PROF_PACK);
+    telemetry_m.packets_built++;
+
+    uint16_t ble_packet_length = BLE_PACKET_HEADER_SIZE + length;
+    (void)ble_packet_send_or_hold(ble_packet_temp, &ble_packet_length);
+    free(ble_packet_temp);
+
+    // frame chua dong goi chuyen len dau block
+    mc_block_frames -= n;
+    mc_block_index += n;
+    memmove(mc_block, mc_block + n * n_channels, mc_block_frames * n_channels * sizeof(int32_t));
+}
+#endif
+
+#if ALL_MODE
+/**@brief Function for packing pending ECG and IMU samples into one ALL_SENSOR_TYPE packet.
+ *
+ * @details Each stream keeps its own rate and sample clock. hust_sched_plan gives the IMU all its
+ *          pending samples and fills the rest of the MTU with ECG, the packet is sent once full.
+ *          Every segment carries its first sample index and the RTC tick of that sample as the
+ *          timestamp anchor of its stream (see hust_sched.h).
+ *
+ * @return true if a packet was built, false if not enough samples are pending yet.
+ */
+static bool all_packet_process(void)
+{
+    hust_sched_stream_t streams[HUST_STREAM_COUNT] =
+    {
+        {hust_sched_stream_byte(HUST_STREAM_ECG, ble_packet_m.channel_mask), stream_config_m.rate,
+         (uint16_t)hust_ring_count(&ring_m)},
+        {hust_sched_stream_byte(HUST_STREAM_IMU, ble_packet_m.channel_mask), imu_m.rate,
+         (uint16_t)hust_mc_ring_count(&imu_ring_m)}
+    };
+    uint8_t take[HUST_STREAM_COUNT];
+    uint8_t data[HUST_SCHED_MAX_DATA_SIZE];
+    uint8_t * p = data;
+    bool full;
+#if HUST_LATENCY_TRAILER_ENABLED
+    int capacity = m_ble_nus_max_data_len - BLE_PACKET_HEADER_SIZE - HUST_LATENCY_TRAILER_SIZE;
+#else
+    int capacity = m_ble_nus_max_data_len - BLE_PACKET_HEADER_SIZE;
+#endif
+
+    int data_size = hust_sched_plan(streams, HUST_STREAM_COUNT, capacity, take, &full);
+    if(!full || data_size == 0)
+    {
+        return false;
+    }
+
+    HUST_PROF_START(pack);
+    for(int i = 0; i < take[HUST_STREAM_ECG]; i++)
+    {
+        hust_frame_t frame;
+        (void)hust_ring_pop(&ring_m, &frame);
+        if(i == 0)
+        {
+            hust_sched_seg_header(p, streams[HUST_STREAM_ECG].stream, take[HUST_STREAM_ECG], frame.sample_index, stream_config_m.rate,
+                                  frame.sample_index, frame.t_acq);
+            p += HUST_SCHED_SEG_HEADER;
+#if HUST_LATENCY_TRAILER_ENABLED
+            hust_latency_first_sample(&latency_m, frame.t_acq);
+#endif
+        }
+#if HUST_LATENCY_TRAILER_ENABLED
+        if(i == take[HUST_STREAM_ECG] - 1)
+        {
+            hust_latency_last_sample(&latency_m, frame.t_acq);
+        }
+#endif
+        for(int ch = 0; ch < ECG_CHANNEL; ch++)
+        {
+            if(ble_packet_m.channel_mask & (1 << ch))
+            {
+                memcpy(p, ecg_channel_get(&frame.ecg, ch)->byte, ECG_DATA_LENGTH);
+                p += ECG_DATA_LENGTH;
+            }
+        }
+    }
+    for(int i = 0; i < take[HUST_STREAM_IMU]; i++)
+    {
+        int32_t axis[IMU_CHANNEL];
+        uint64_t sample_index;
+        (void)hust_mc_ring_pop(&imu_ring_m, axis, &sample_index);
+        if(i == 0)
+        {
+            // moc = sample cuoi cua burst moi nhat, tick do luc ngat watermark
+            uint64_t anchor_index;
+            uint32_t anchor_tick;
+            CRITICAL_REGION_ENTER();
+            anchor_index = imu_anchor_index;
+            anchor_tick = imu_anchor_tick;
+            CRITICAL_REGION_EXIT();
+            hust_sched_seg_header(p, streams[HUST_STREAM_IMU].stream, take[HUST_STREAM_IMU], sample_index, imu_m.rate,
+                                  anchor_index, anchor_tick);
+            p += HUST_SCHED_SEG_HEADER;
+        }
+        for(int a = 0; a < IMU_CHANNEL; a++)
+        {
+            if(ble_packet_m.channel_mask & (1 << (IMU_CHANNEL_MASK_SHIFT + a)))
+            {
+                imu_sample_data_t sample = int16_to_imu_sample((int16_t)axis[a]);
+                memcpy(p, sample.byte, IMU_DATA_LENGTH);
+                p += IMU_DATA_LENGTH;
+            }
+        }
+    }
+
+    // timestamp header = chi so sample dau tien cua segment dau tien
+    hust_sched_seg_t seg;
+    (void)hust_sched_seg_read(data, data_size, &seg);
+    timestamp_set(&ble_packet_m.timestamp, seg.first_index);
+
+    uint8_t * ble_packet_temp;
+    ble_packet_m.count_packet++;
+    ble_packet_m.data_size = (uint8_t)data_size;
+    convert_data_to_ble_packet(ble_packet_m, &ble_packet_temp);     // chi ghi header voi ALL_SENSOR_TYPE
+    memcpy(ble_packet_temp + BLE_PACKET_HEADER_SIZE, data, data_size);
+    HUST_PROF_STOP(pack, HUST_PROF_PACK);
+    telemetry_m.packets_built++;
+
+    uint16_t ble_packet_length = BLE_PACKET_HEADER_SIZE + data_size;
+#if HUST_LATENCY_TRAILER_ENABLED
+    hust_latency_packed(&latency_m, app_timer_cnt_get());
+    uint32_t t_send = app_timer_cnt_get();
+    latency_trailer_append(&ble_packet_temp, &ble_packet_length, t_send);
+    if(ble_packet_send_or_hold(ble_packet_temp, &ble_packet_length) == NRF_SUCCESS)
+    {
+        hust_latency_sent(&latency_m, ble_packet_m.count_packet, t_send);
+    }
+#else
+    (void)ble_packet_send_or_hold(ble_packet_temp, &ble_packet_length);
+#endif
+    free(ble_packet_temp);
+    return true;
+}
+#endif
+
+#if IMU_ENABLED
+#define IMU_PACKET_READY()  (hust_mc_ring_count(&imu_ring_m) >= set_sample_transfer(imu_packet_m).imu_sample)
+
+/**@brief Function for sending buffered IMU samples as IMU_SENSOR_TYPE packets.
+ *
+ * @details Sent between the EEG/EMG packets, or alone with sensor_type IMU_SENSOR_TYPE, once one
+ *          packet of samples is buffered (IMU_SAMPLE_IMU_SENSOR_TYPE with every axis enabled, more
+ *          with a channel mask). The packet timestamp is the IMU sample index (IMU sample clock).
+ */
+static void imu_packet_process(void)
+{
+    imu_data_t imu_data[IMU_SAMPLE_MAX];
+    int32_t axis[IMU_CHANNEL];
+    uint64_t sample_index;
+    int imu_sample = set_sample_transfer(imu_packet_m).imu_sample;
+
+    if(!IMU_PACKET_READY())
+    {
+        return;
+    }
+    for(int i = 0; i < imu_sample; i++)
+    {
+        (void)hust_mc_ring_pop(&imu_ring_m, axis, &sample_index);
+        if(i == 0)
+        {
+            timestamp_set(&imu_packet_m.timestamp, sample_index);
+        }
+        imu_data[i].imu_channel1 = int16_to_imu_sample((int16_t)axis[0]);
+        imu_data[i].imu_channel2 = int16_to_imu_sample((int16_t)axis[1]);
+        imu_data[i].imu_channel3 = int16_to_imu_sample((int16_t)axis[2]);
+    }
+
+    uint8_t * ble_packet_temp;
+    imu_packet_m.imu_data = imu_data;
+    imu_packet_m.data_size = (uint8_t)ble_packet_data_size(imu_packet_m);
+    imu_packet_m.count_packet++;
+    convert_data_to_ble_packet(imu_packet_m, &ble_packet_temp);
+    telemetry_m.packets_built++;
+
+    uint16_t ble_packet_length = BLE_PACKET_HEADER_SIZE + imu_packet_m.data_size;
+    (void)ble_packet_send_or_hold(ble_packet_temp, &ble_packet_length);
+    free(ble_packet_temp);
+}
+#else
+#define IMU_PACKET_READY()  false
+#endif
+
+#if !MC_MODE
+/**@brief Function for packing buffered ECG samples into ECG_SENSOR_TYPE packets.
+ *
+ * @details A packet is filled over several calls as samples arrive and sent once it holds
+ *          ECG_SAMPLE_ECG_SENSOR_TYPE samples, or more when channels are masked out.
+ *
+ * @return true if samples are still waiting in the ring.
+ */
+static bool ecg_packet_process(void)
+{
+    if(ecg_sample_count == 0 && data_array_exist == false)
+    {
+        // update so sample va data_size theo type of ble packet
+        sample_transfer_m = set_sample_transfer(ble_packet_m);
+        ble_packet_m.data_size = (uint8_t)ble_packet_data_size(ble_packet_m);     // chi cac channel bat
+        ble_packet_size = 8 + 1 + 1 + 1 + ble_packet_m.data_size;  // sizeof(timestamp) + sizeof(sensor_type) + sizeof(data_size) + sizeof(count_packet) + sizeof(data)
+
+        ble_packet_m.ecg_data = malloc(sizeof(ecg_data_t)*sample_transfer_m.ecg_sample);
+        ble_packet_m.imu_data = malloc(sizeof(imu_data_t)*sample_transfer_m.imu_sample);
+        data_array_exist = true;
+    }
+
+    // lay sample tu ring vao ble packet
+    hust_frame_t frame;
+    while(data_array_exist == true && ecg_sample_count < sample_transfer_m.ecg_sample
+          && hust_ring_pop(&ring_m, &frame) == 0)
+    {
+        if(ecg_sample_count == 0)
+        {
+            timestamp_set(&ble_packet_m.timestamp, frame.sample_index);
+#if HUST_LATENCY_TRAILER_ENABLED
+            hust_latency_first_sample(&latency_m, frame.t_acq);
+#endif
+        }
+        ble_packet_m.ecg_data[ecg_sample_count] = frame.ecg;
+        ecg_sample_count++; // tang so mau ecg dua vao ble packet
+#if HUST_LATENCY_TRAILER_ENABLED
+        if(ecg_sample_count == sample_transfer_m.ecg_sample)
+        {
+            hust_latency_last_sample(&latency_m, frame.t_acq);
+        }
+#endif
+    }
+
+    if(ecg_sample_count == sample_transfer_m.ecg_sample)
+    {
+        uint8_t * ble_packet_temp;
+        ble_packet_m.count_packet++;
+
+        HUST_PROF_START(pack);
+        convert_data_to_ble_packet(ble_packet_m, &ble_packet_temp);
+        HUST_PROF_STOP(pack, HUST_PROF_PACK);
+        //print_ble_packet_data(&ble_packet_temp, ble_packet_size);
+        telemetry_m.packets_built++;
+        uint16_t ble_packet_length = ble_packet_size;
+#if HUST_LATENCY_TRAILER_ENABLED
+        hust_latency_packed(&latency_m, app_timer_cnt_get());
+        uint32_t t_send = app_timer_cnt_get();
+        latency_trailer_append(&ble_packet_temp, &ble_packet_length, t_send);
+#endif
+#if HUST_LATENCY_TRAILER_ENABLED
+        if(ble_packet_send_or_hold(ble_packet_temp, &ble_packet_length) == NRF_SUCCESS)
+        {
+            hust_latency_sent(&latency_m, ble_packet_m.count_packet, t_send);
+        }
+#else
+        (void)ble_packet_send_or_hold(ble_packet_temp, &ble_packet_length);
+#endif
+#if HUST_PROF_ENABLED
+        if(ble_packet_m.count_packet == 0)
+        {
+            hust_prof_dump();   // in ra RTT moi 256 packet
+        }
+#endif
+
+        free(ble_packet_m.ecg_data);
+        free(ble_packet_m.imu_data);
+        free(ble_packet_temp);
+        data_array_exist = false;
+        ecg_sample_count = 0;
+    }
+
+    // chi ngu khi ring rong, neu con sample thi dong goi tiep packet sau
+    return hust_ring_count(&ring_m) != 0;
+}
+#endif
+
+#if !MC_MODE || IMU_ENABLED
+/**@brief Function for dropping samples of streams not carried by the current sensor_type.
+ */
+static void stream_discard(bool primary, bool imu)
+{
+    if(primary)
+    {
+#if MC_MODE
+        int32_t frame[MC_MAX_CHANNELS];
+        uint64_t sample_index;
+        while(hust_mc_ring_pop(&mc_ring_m, frame, &sample_index) == 0)
+        {
+        }
+#else
+        hust_frame_t frame;
+        while(hust_ring_pop(&ring_m, &frame) == 0)
+        {
+        }
+#endif
+    }
+#if IMU_ENABLED
+    int32_t axis[IMU_CHANNEL];
+    uint64_t imu_index;
+    while(imu && hust_mc_ring_pop(&imu_ring_m, axis, &imu_index) == 0)
+    {
+    }
+#else
+    UNUSED_PARAMETER(imu);
+#endif
+}
+#endif
+
+/**@brief Function for building the packets of the current sensor_type.
+ *
+ * @return true if samples are still waiting to be packed.
+ */
+static bool stream_process(void)
+{
+    switch(stream_config_m.sensor_type)
+    {
+#if ALL_MODE
+        case ALL_SENSOR_TYPE:
+            return all_packet_process();
+#endif
+#if !MC_MODE
+        case ECG_SENSOR_TYPE:
+            stream_discard(false, true);
+            return ecg_packet_process();
+#endif
+#if EEG_MODE
+        case EEG_SENSOR_TYPE:
+#elif EMG_MODE
+        case EMG_SENSOR_TYPE:
+#endif
+#if MC_MODE
+#if IMU_ENABLED
+            imu_packet_process();
+#endif
+            mc_packet_process();
+            return hust_mc_ring_count(&mc_ring_m) != 0 || IMU_PACKET_READY();
+#endif
+#if IMU_ENABLED
+        case IMU_SENSOR_TYPE:
+            stream_discard(true, false);
+            imu_packet_process();
+            return IMU_PACKET_READY();
+#endif
+        default:
+            return false;
+    }
+}
+
+/**@brief Function for checking that a sensor_type can be streamed by this build.
+ */
+static bool stream_sensor_type_supported(uint8_t sensor_type)
+{
+    switch(sensor_type)
+    {
+#if EEG_MODE
+        case EEG_SENSOR_TYPE:
+#elif EMG_MODE
+        case EMG_SENSOR_TYPE:
+#elif ALL_MODE
+        case ALL_SENSOR_TYPE:
+        case ECG_SENSOR_TYPE:
+#else
+        case ECG_SENSOR_TYPE:
+#endif
+#if IMU_ENABLED
+        case IMU_SENSOR_TYPE:
+#endif
+            return true;
+        default:
+            return false;
+    }
+}
+
+/**@brief Function for checking that no packet is half filled, so that a command can be applied.
+ */
+static bool stream_packet_boundary(void)
+{
+#if !MC_MODE
+    return ecg_sample_count == 0;
+#else
+    return true;
+#endif
+}
+
+/**@brief Function for dropping the half filled ECG packet, after the sources restarted from sample 0
+ *        or the packet layout changed.
+ */
+static void stream_packet_reset(void)
+{
+#if !MC_MODE
+    if(data_array_exist)
+    {
+        free(ble_packet_m.ecg_data);
+        free(ble_packet_m.imu_data);
+        data_array_exist = false;
+    }
+    ecg_sample_count = 0;
+#endif
+}
+
+/**@brief Function for running the acquisition state machine and making the sample sources follow it.
+ *
+ * @details Inputs are the START/STOP command, the connection and the NUS TX CCCD (see hust_state.h).
+ *          Sources and sensors run in STREAMING and BUFFERING only. Going back to BUFFERING keeps
+ *          the half filled packet and every sample in the rings, stopping drops them.
+ */
+static void acquisition_state_update(void)
+{
+    hust_state_input_t input;
+    hust_state_id_t previous = state_m.state;
+
+    input.enabled = stream_config_m.streaming;
+#if BCAST_ENABLED
+    input.connected = true;                 // broadcast: luon co may thu
+    input.notifying = true;
+#else
+    input.connected = hust_fanout_count(&fanout_m) > 0;
+    input.notifying = fanout_ready_update() > 0;
+#endif
+    hust_state_id_t state = hust_state_update(&state_m, &input, app_timer_cnt_get());
+    stream_config_m.state = (uint8_t)state;
+    if(state == previous)
+    {
+        return;
+    }
+    NRF_LOG_INFO("Acquisition %s -> %s", hust_state_name(previous), hust_state_name(state));
+#if BIO_SERVICE_ENABLED
+    uint8_t payload[2] = {(uint8_t)state, (uint8_t)previous};
+    (void)hust_bio_event_push(&bio_event_queue_m, HUST_BIO_EVENT_STATE, app_timer_cnt_get(), payload, sizeof(payload));
+#endif
+#if HIST_ENABLED || FLOG_ENABLED
+    if(state == HUST_STATE_STREAMING)
+    {
+#if HIST_ENABLED
+        NRF_LOG_INFO("History %u packets, %u ms", hist_m.count,
+                     (uint32_t)((uint64_t)hust_hist_span(&hist_m) * 1000 / HUST_SAMPLE_CLOCK_RTC_HZ));
+#endif
+#if FLOG_ENABLED
+        NRF_LOG_INFO("Backfill %u bytes, %u packets dropped", hust_flog_stored(&flog_m), flog_m.records_dropped);
+        hust_flog_share_reset(&flog_m);
+#endif
+        hust_latency_reset(&latency_m);     // packet dong goi luc BUFFERING khong vao hang doi HVN
+    }
+#endif
+
+    if(hust_state_sampling(state) && !acquisition_running)
+    {
+        ret_code_t err_code = acquisition_start();
+        APP_ERROR_CHECK(err_code);
+        acquisition_running = true;
+    }
+    else if(!hust_state_sampling(state) && acquisition_running)
+    {
+        acquisition_stop();
+        stream_packet_reset();
+#if HIST_ENABLED
+        hust_hist_clear(&hist_m);           // sample index chay lai tu 0 khi bat nguon
+#endif
+#if FLOG_ENABLED
+        hust_flog_clear(&flog_m);
+#endif
+        acquisition_running = false;
+    }
+}
+
+/**@brief Function for applying one stream control command.
+ *
+ * @details The configuration only changes if the whole command succeeds. Rate changes stop the
+ *          sources, reprogram them and start again from sample index 0.
+ *
+ * @return hust_cmd_status_t of the command.
+ */
+static uint8_t cmd_apply(const hust_cmd_t * cmd)
+{
+    hust_cmd_config_t config = stream_config_m;
+    uint8_t status = hust_cmd_apply(&config, cmd);
+    ret_code_t err_code;
+
+    if(status != HUST_CMD_OK)
+    {
+        return status;
+    }
+    switch(cmd->opcode)
+    {
+        case HUST_CMD_START:
+        case HUST_CMD_STOP:
+            break;                          // nguon theo may trang thai (acquisition_state_update)
+        case HUST_CMD_SET_SENSOR_TYPE:
+            if(!stream_sensor_type_supported(config.sensor_type))
+            {
+                return HUST_CMD_ERR_UNSUPPORTED;
+            }
+            break;
+        case HUST_CMD_SET_RATE:
+            if(config.rate == stream_config_m.rate)
+            {
+                break;
+            }
+            if(acquisition_running)
+            {
+                acquisition_stop();
+                stream_packet_reset();
+#if HIST_ENABLED
+                hust_hist_clear(&hist_m);
+#endif
+#if FLOG_ENABLED
+                hust_flog_clear(&flog_m);
+#endif
+            }
+            status = acquisition_rate_set(config.rate);
+            if(status != HUST_CMD_OK)
+            {
+                config.rate = stream_config_m.rate;
+            }
+            stream_config_m.rate = config.rate;
+            if(acquisition_running)
+            {
+                err_code = acquisition_start();
+                APP_ERROR_CHECK(err_code);
+            }
+            break;
+        case HUST_CMD_SET_CODEC:
+#if !MC_MODE
+            if(config.codec != HUST_CODEC_RAW)
+            {
+                return HUST_CMD_ERR_UNSUPPORTED;    // packet ECG / ALL chi co sample tho
+            }
+#endif
+            break;
+        case HUST_CMD_SET_CHANNEL_MASK:
+            if((config.channel_mask & ~stream_channel_mask_all()) != 0)
+            {
+                return HUST_CMD_ERR_PARAM;
+            }
+#if MC_MODE
+            if(config.channel_mask != stream_channel_mask_all())
+            {
+                return HUST_CMD_ERR_UNSUPPORTED;    // hust_mc chua bo duoc channel
+            }
+#else
+            // moi stream phai con it nhat 1 channel
+            if(ecg_channel_count((uint8_t)config.channel_mask) == 0
+               || (IMU_ENABLED && imu_channel_count((uint8_t)config.channel_mask) == 0))
+            {
+                return HUST_CMD_ERR_PARAM;
+            }
+#endif
+            break;
+        default:
+            break;
+    }
+    if(status == HUST_CMD_OK)
+    {
+        stream_config_m = config;
+        ble_packet_m.sensor_type = (sensor_type_t)config.sensor_type;
+        stream_packet_mask_set();
+        if(cmd->opcode == HUST_CMD_SET_SENSOR_TYPE || cmd->opcode == HUST_CMD_SET_CHANNEL_MASK)
+        {
+            // packet ECG da cap phat theo sensor_type / channel mask cu
+            stream_packet_reset();
+        }
+    }
+    return status;
+}
+
+/**@brief Function for applying queued commands and sending their responses.
+ *
+ * @details Called between two packets. Each NUS command is answered by one CMD_SENSOR_TYPE packet,
+ *          each command of the biosignal control characteristic by a notification of the same
+ *          characteristic without the packet header. The next command is only applied once the
+ *          previous response is queued in the SoftDevice so responses keep the command order when
+ *          the HVN queue is full.
+ */
+static void cmd_process(void)
+{
+    for(;;)
+    {
+        if(cmd_response != NULL)
+        {
+            uint32_t err_code = ble_nus_data_send(&m_nus, cmd_response, &cmd_response_length, cmd_response_conn);
+            if(err_code == NRF_ERROR_RESOURCES)
+            {
+                return;                     // thu lai sau HVN TX complete
+            }
+            if(err_code == NRF_SUCCESS)
+            {
+                hvn_queued(cmd_response_conn);
+            }
+            free(cmd_response);             // da gui, hoac mat ket noi / MTU chua du: bo tra loi
+            cmd_response = NULL;
+        }
+#if BIO_SERVICE_ENABLED
+        if(bio_response_length != 0)
+        {
+            uint32_t err_code = hust_bio_control_send(&m_bio_service, bio_response, &bio_response_length);
+            if(err_code == NRF_ERROR_RESOURCES)
+            {
+                return;
+            }
+            if(err_code == NRF_SUCCESS)
+            {
+                hvn_queued(m_bio_service.conn_handle);
+            }
+            bio_response_length = 0;
+        }
+#endif
+
+        hust_cmd_queue_t * queue = &cmd_queue_m;
+        const hust_cmd_t * cmd = hust_cmd_queue_peek(queue);
+#if BIO_SERVICE_ENABLED
+        if(cmd == NULL)
+        {
+            queue = &bio_cmd_queue_m;
+            cmd = hust_cmd_queue_peek(queue);
+        }
+#endif
+        if(cmd == NULL)
+        {
+            return;
+        }
+        uint8_t data[2 + HUST_TELEMETRY_SIZE];
+        int data_size = 2;
+        data[0] = cmd->opcode;
+        data[1] = cmd_apply(cmd);
+        acquisition_state_update();         // START / STOP co hieu luc ngay, tra loi mang state moi
+        if(cmd->opcode == HUST_CMD_GET_STATS && data[1] == HUST_CMD_OK)
+        {
+            hust_telemetry_encode(&telemetry_m, data + 2);
+            data_size += HUST_TELEMETRY_SIZE;
+        }
+        else
+        {
+            hust_cmd_config_encode(&stream_config_m, data + 2);
+            data_size += HUST_CMD_CONFIG_SIZE;
+        }
+        NRF_LOG_INFO("Command 0x%02x: %s", cmd->opcode, hust_cmd_status_name(data[1]));
+#if BIO_SERVICE_ENABLED
+        if(data[1] == HUST_CMD_OK && cmd->opcode >= HUST_CMD_SET_SENSOR_TYPE && cmd->opcode <= HUST_CMD_SET_CHANNEL_MASK)
+        {
+            (void)hust_bio_event_push(&bio_event_queue_m, HUST_BIO_EVENT_CONFIG, app_timer_cnt_get(), NULL, 0);
+            bio_schema_changed = true;
+        }
+        if(queue == &bio_cmd_queue_m)
+        {
+            hust_cmd_queue_pop(queue);
+            memcpy(bio_response, data, data_size);
+            bio_response_length = (uint16_t)data_size;
+            continue;
+        }
+#endif
+        hust_cmd_queue_pop(queue);
+
+        ble_packet_t response;
+        timestamp_set(&response.timestamp, 0);
+        response.sensor_type = CMD_SENSOR_TYPE;
+        response.data_size = (uint8_t)data_size;
+        response.count_packet = cmd_response_count++;
+        convert_data_to_ble_packet(response, &cmd_response);       // chi ghi header voi CMD_SENSOR_TYPE
+        memcpy(cmd_response + BLE_PACKET_HEADER_SIZE, data, data_size);
+        cmd_response_length = BLE_PACKET_HEADER_SIZE + data_size;
+        cmd_response_conn = cmd->source;
+    }
+}
+
+#if BIO_SERVICE_ENABLED
+/**@brief Function for updating the schema characteristic from the current stream configuration.
+ */
+static void bio_schema_update(void)
+{
+    hust_bio_schema_t schema;
+
+    schema.header_size = BLE_PACKET_HEADER_SIZE;
+    schema.sensor_type = stream_config_m.sensor_type;
+    schema.rate = stream_config_m.rate;
+    schema.channel_mask = stream_config_m.channel_mask;
+    schema.codec = stream_config_m.codec;
+    schema.codec_param = stream_config_m.codec_param;
+#if MC_MODE || ALL_MODE
+    schema.samples_per_packet = 0;      // hust_mc / hust_sched: so sample theo tung packet
+#else
+    schema.samples_per_packet = set_sample_transfer(ble_packet_m).ecg_sample;
+#endif
+    schema.max_packet = m_ble_nus_max_data_len;
+#if IMU_ENABLED
+    schema.imu_rate = imu_m.rate;
+#else
+    schema.imu_rate = 0;
+#endif
+    if(hust_bio_schema_update(&m_bio_service, &schema) == NRF_SUCCESS && m_bio_service.schema_notify)
+    {
+        hvn_queued(m_bio_service.conn_handle);
+    }
+}
+
+/**@brief Function for raising and sending the biosignal events.
+ *
+ * @details DROP and LINK events come from the telemetry counters, STATE and CONFIG are pushed where
+ *          they happen. Called before the stream each loop: the data characteristic leaves
+ *          HUST_BIO_EVENT_RESERVE entries of the HVN queue free, so a queued event goes out in the
+ *          next connection event. Events are dropped while nobody listens.
+ */
+static void bio_event_process(void)
+{
+    if(bio_schema_changed)
+    {
+        bio_schema_changed = false;
+        bio_schema_update();
+    }
+    uint32_t samples_dropped = telemetry_m.samples_dropped;
+    if(samples_dropped != bio_samples_dropped)
+    {
+        uint8_t payload[4] = {(uint8_t)samples_dropped, (uint8_t)(samples_dropped >> 8),
+                              (uint8_t)(samples_dropped >> 16), (uint8_t)(samples_dropped >> 24)};
+        bio_samples_dropped = samples_dropped;
+        (void)hust_bio_event_push(&bio_event_queue_m, HUST_BIO_EVENT_DROP, app_timer_cnt_get(), payload, sizeof(payload));
+    }
+    if(m_conn_handle != BLE_CONN_HANDLE_INVALID
+       && (telemetry_m.tx_phy != bio_tx_phy || telemetry_m.conn_interval != bio_conn_interval))
+    {
+        bio_tx_phy = telemetry_m.tx_phy;
+        bio_conn_interval = telemetry_m.conn_interval;
+        uint8_t payload[3] = {bio_tx_phy, (uint8_t)bio_conn_interval, (uint8_t)(bio_conn_interval >> 8)};
+        (void)hust_bio_event_push(&bio_event_queue_m, HUST_BIO_EVENT_LINK, app_timer_cnt_get(), payload, sizeof(payload));
+    }
+
+    const hust_bio_event_t * event;
+    while((event = hust_bio_event_peek(&bio_event_queue_m)) != NULL)
+    {
+        uint32_t err_code = hust_bio_event_send(&m_bio_service, event);
+        if(err_code == NRF_ERROR_RESOURCES)
+        {
+            return;                         // thu lai sau HVN TX complete
+        }
+        if(err_code == NRF_SUCCESS)
+        {
+            hvn_queued(m_bio_service.conn_handle);
+        }
+        hust_bio_event_pop(&bio_event_queue_m);
+    }
+}
+#endif
+
+/**@brief Application main function.
+ */
+int main(void)
+{
+    bool erase_bonds;
+#if HUST_LATENCY_TRAILER_ENABLED || FLOG_ENABLED
+    uint32_t err_code;
+#endif
+    ble_packet_m.count_packet = 0;
+    ble_packet_m.channel_mask = CHANNEL_MASK_ALL;
+#if IMU_ENABLED
+    imu_packet_m.sensor_type = IMU_SENSOR_TYPE;
+    imu_packet_m.channel_mask = CHANNEL_MASK_ALL;
+#endif
+    // cau hinh stream luc khoi dong, doi luc chay bang lenh NUS (hust_cmd.h)
+    stream_config_m.streaming = true;
+#if EEG_MODE
+    stream_config_m.sensor_type = EEG_SENSOR_TYPE;
+#elif EMG_MODE
+    stream_config_m.sensor_type = EMG_SENSOR_TYPE;
+#elif ALL_MODE
+    stream_config_m.sensor_type = ALL_SENSOR_TYPE;
+#else
+    stream_config_m.sensor_type = ECG_SENSOR_TYPE;
+#endif
+    stream_config_m.rate = STREAM_SAMPLE_RATE;
+#if MC_MODE
+    stream_config_m.codec = MC_CODEC;
+    stream_config_m.codec_param = MC_CODEC_PARAM;
+#else
+    stream_config_m.codec = HUST_CODEC_RAW;
+    stream_config_m.codec_param = 0;
+#endif
+    stream_config_m.state = HUST_STATE_IDLE;
+    hust_state_init(&state_m, ACQ_BUFFER_TIMEOUT_S * HUST_SAMPLE_CLOCK_RTC_HZ, HUST_SAMPLE_CLOCK_RTC_MASK);
+    hust_cmd_queue_init(&cmd_queue_m);
+#if BIO_SERVICE_ENABLED
+    hust_cmd_queue_init(&bio_cmd_queue_m);
+    hust_bio_event_queue_init(&bio_event_queue_m);
+#endif
+    hust_ring_init(&ring_m);
+    hust_fanout_init(&fanout_m);
+    HUST_PROF_INIT();
+    // Initialize.
+    uart_init();
+    log_init();
+    timers_init();
+    buttons_leds_init(&erase_bonds);
+    power_management_init();
+    ble_stack_init();
+#if FLOG_ENABLED
+    err_code = hust_flog_nrf_init(&flog_m, FLOG_BACKFILL_SHARE);
+    APP_ERROR_CHECK(err_code);
+#endif
+#if HIST_ENABLED
+    // RAM con lai sau vung RAM cua SoftDevice, bien, heap; vung qua nho thi chi dung log flash
+    uint32_t hist_size = (uint32_t)(__StackLimit - HIST_RAM_START);
+    hist_size = hist_size > HIST_RAM_RESERVE ? hist_size - HIST_RAM_RESERVE : 0;
+    if(hust_hist_init(&hist_m, HIST_RAM_START, hist_size, HUST_SAMPLE_CLOCK_RTC_MASK) != 0)
+    {
+        NRF_LOG_WARNING("No RAM for the history (%u bytes)", hist_size);
+    }
+    else
+    {
+        NRF_LOG_INFO("History %u bytes RAM", hist_size);
+    }
+#endif
+#if L2CAP_ENABLED
+    hust_l2cap_init(&m_l2cap);
+#endif
+#if LINK_ENABLED
+    hust_link_init(&link_m, MIN_CONN_INTERVAL, MAX_CONN_INTERVAL, conn_cfg_m.hvn_tx_queue, LINK_CODED);
+#endif
+#if HUST_LATENCY_TRAILER_ENABLED
+    err_code = ble_radio_notification_init(APP_IRQ_PRIORITY_LOW,
+                                           NRF_RADIO_NOTIFICATION_DISTANCE_800US,
+                                           radio_notification_handler);
+    APP_ERROR_CHECK(err_code);
+#endif
+    gap_params_init();
+    gatt_init();
+    services_init();
+    advertising_init();
+    conn_params_init();
+
+    // Start execution.
+    printf("\r\nUART started.\r\n");
+    NRF_LOG_INFO("Debug logging for UART over RTT started.");
+    application_timers_start();
+    advertising_start();
+
+    // chon type ble packet muon truyen 
+    ble_packet_m.sensor_type = (sensor_type_t)stream_config_m.sensor_type;
+    // Enter main loop.
+    for (;;)
+    {
+        bool pending = false;
+
+        // lenh NUS chi ap dung giua 2 packet (hoac khi khong gui packet)
+        if(stream_packet_boundary() || !hust_state_sending(state_m.state))
+        {
+            cmd_process();
+        }
+        acquisition_state_update();
+#if BIO_SERVICE_ENABLED
+        bio_event_process();                // event truoc packet data
+#endif
+        fanout_process();                   // packet con trong ring cho central vua co cho
+#if BCAST_ENABLED
+        if(bcast_publish_pending)
+        {
+            bcast_publish_pending = false;
+            (void)hust_bcast_publish(&bcast_m);     // loi: PDU mat, may thu thay seq nhay
+        }
+#endif
+        // packet chua gui duoc di truoc, sample moi cho trong ring
+        bool held = !held_packet_send();
+#if HIST_ENABLED || FLOG_ENABLED
+        // BUFFERING: van dong goi, ble_packet_send luu packet vao lich su RAM / log flash
+        if(!held && hust_state_sampling(state_m.state))
+        {
+            pending = stream_process();
+        }
+        if(hust_state_sending(state_m.state))
+        {
+            pending |= backfill_process(pending || held);
+        }
+#if FLOG_ENABLED
+        hust_flog_poll(&flog_m);
+#endif
+#else
+        if(!held && hust_state_sending(state_m.state))
+        {
+            pending = stream_process();
+        }
+#endif
+#if L2CAP_ENABLED
+        // SDU dang gom di ngay khi SDU truoc phat xong
+        (void)hust_l2cap_poll(&m_l2cap);
+#endif
+        if(!pending)
+        {
+            idle_state_handle();
         }
-        
-        idle_state_handle();
     }
 }
 